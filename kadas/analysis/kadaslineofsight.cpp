@@ -19,12 +19,14 @@
 #include <gdal.h>
 
 #include <qgis/qgscoordinatetransform.h>
+#include <qgis/qgspoint.h>
 #include <qgis/qgsproject.h>
 #include <qgis/qgsrasterlayer.h>
 #include <qgis/qgsunittypes.h>
 
 #include "kadas/analysis/kadaslineofsight.h"
 #include "kadas/core/kadas.h"
+#include "kadas/core/kadasheightmap.h"
 
 
 bool KadasLineOfSight::computeTargetVisibility( const QgsPoint &observerPos, const QgsPoint &targetPos, const QgsCoordinateReferenceSystem &crs, double nTerrainSamples, bool observerPosAbsolute, bool targetPosAbsolute )
@@ -134,3 +136,38 @@ bool KadasLineOfSight::computeTargetVisibility( const QgsPoint &observerPos, con
   GDALClose( raster );
   return visible;
 }
+
+QgsPoint KadasLineOfSight::findTerrainIntersection( KadasHeightmap &heightmap, const QgsPoint &observerPos, const QgsPoint &targetPos, const QgsCoordinateReferenceSystem &crs, double resolution )
+{
+  if ( !heightmap.isValid() )
+  {
+    // Assume no intersection if no terrain model available
+    return targetPos;
+  }
+
+  QgsCoordinateTransform crst( crs, heightmap.crs(), heightmap.transformContext() );
+  QgsPointXY obsPosRaster = crst.transform( observerPos );
+  QgsPointXY targetPosRaster = crst.transform( targetPos );
+  double dist = std::sqrt( obsPosRaster.sqrDist( targetPosRaster ) );
+  double zConv = QgsUnitTypes::fromUnitToUnitFactor( crs.mapUnits(), Qgis::DistanceUnit::Meters );
+
+  // Same earth curvature correction as in computeTargetVisibility
+  double earthRadius = 6370000;
+  int nSteps = std::ceil( observerPos.distance( targetPos ) / resolution );
+  for ( int i = 1; i <= nSteps; ++i )
+  {
+    double lambda = double( i ) / nSteps;
+    double k = lambda * dist;
+    QgsPointXY pRaster( obsPosRaster.x() + lambda * ( targetPosRaster.x() - obsPosRaster.x() ), obsPosRaster.y() + lambda * ( targetPosRaster.y() - obsPosRaster.y() ) );
+    bool ok = false;
+    double terrainHeight = heightmap.heightAt( pRaster, &ok ) - 0.87 * k * k / ( 2 * earthRadius );
+    double rayHeight = ( observerPos.z() + lambda * ( targetPos.z() - observerPos.z() ) ) * zConv;
+    if ( ok && rayHeight < terrainHeight )
+    {
+      // Intersection lies between previous and current step
+      double mu = ( i - 0.5 ) / nSteps;
+      return QgsPoint( observerPos.x() + mu * ( targetPos.x() - observerPos.x() ), observerPos.y() + mu * ( targetPos.y() - observerPos.y() ), observerPos.z() + mu * ( targetPos.z() - observerPos.z() ) );
+    }
+  }
+  return targetPos;
+}
@@ -21,11 +21,16 @@
 
 class QgsCoordinateReferenceSystem;
 class QgsPoint;
+class KadasHeightmap;
 
 class KADAS_ANALYSIS_EXPORT KadasLineOfSight
 {
   public:
     static bool computeTargetVisibility( const QgsPoint &observerPos, const QgsPoint &targetPos, const QgsCoordinateReferenceSystem &crs, double nTarrainSamples, bool observerPosAbsolute = false, bool targetPosAbsolute = false );
+#ifndef SIP_RUN
+    // Marches along the ray from observerPos to targetPos (absolute heights) in steps of resolution map units, returns the first point below the terrain or targetPos
+    static QgsPoint findTerrainIntersection( KadasHeightmap &heightmap, const QgsPoint &observerPos, const QgsPoint &targetPos, const QgsCoordinateReferenceSystem &crs, double resolution );
+#endif
 };
 
 #endif // KADAS_LINE_OF_SIGHT
@@ -27,6 +27,7 @@
 
 #include "kadas/core/kadas.h"
 #include "kadas/analysis/kadasninecellfilter.h"
+#include "kadas/analysis/kadasrasteroutput.h"
 
 
 KadasNineCellFilter::KadasNineCellFilter( const QgsRasterLayer *layer, const QString &outputFile, const QString &outputFormat, const QgsRectangle &region, const QgsCoordinateReferenceSystem &regionCrs )
@@ -366,9 +367,7 @@ GDALDatasetH KadasNineCellFilter::openOutputFile( GDALDatasetH inputDataset, con
   }
 
   //open output file
-  char **papszOptions = NULL;
-  papszOptions = CSLSetNameValue( papszOptions, "COMPRESS", "LZW" );
-  GDALDatasetH outputDataset = GDALCreate( outputDriver, mOutputFile.toUtf8().constData(), xSize, ySize, 1, GDT_Float32, papszOptions );
+  GDALDatasetH outputDataset = KadasRasterOutput::createDataset( mOutputFile, mOutputFormat, xSize, ySize, GDT_Float32 );
   if ( outputDataset == NULL )
   {
     return outputDataset;
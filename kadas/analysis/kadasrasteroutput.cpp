@@ -0,0 +1,113 @@
+/***************************************************************************
+    kadasrasteroutput.cpp
+    ---------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QApplication>
+#include <QVector>
+
+#include <cpl_string.h>
+
+#include <qgis/qgsapplication.h>
+#include <qgis/qgslogger.h>
+#include <qgis/qgsproject.h>
+#include <qgis/qgsrasterdataprovider.h>
+#include <qgis/qgsrasterlayer.h>
+
+#include "kadas/analysis/kadasrasteroutput.h"
+
+// Block size of tiled outputs and minimum size of the smallest overview
+static constexpr int sTileSize = 256;
+
+
+GDALDatasetH KadasRasterOutput::createDataset( const QString &outputFile, const QString &outputFormat, int xSize, int ySize, int dataType )
+{
+  GDALDriverH outputDriver = GDALGetDriverByName( outputFormat.toLocal8Bit().data() );
+  if ( !outputDriver )
+  {
+    return nullptr;
+  }
+  char **papszOptions = nullptr;
+  papszOptions = CSLSetNameValue( papszOptions, "COMPRESS", "LZW" );
+  if ( outputFormat == "GTiff" )
+  {
+    // Tiled layout, so that zoomed in views only need to decode the visible tiles
+    papszOptions = CSLSetNameValue( papszOptions, "TILED", "YES" );
+    papszOptions = CSLSetNameValue( papszOptions, "BLOCKXSIZE", QByteArray::number( sTileSize ).constData() );
+    papszOptions = CSLSetNameValue( papszOptions, "BLOCKYSIZE", QByteArray::number( sTileSize ).constData() );
+    papszOptions = CSLSetNameValue( papszOptions, "PREDICTOR", GDALDataTypeIsFloating( static_cast<GDALDataType>( dataType ) ) ? "3" : "2" );
+    papszOptions = CSLSetNameValue( papszOptions, "BIGTIFF", "IF_SAFER" );
+  }
+  GDALDatasetH outputDataset = GDALCreate( outputDriver, outputFile.toUtf8().constData(), xSize, ySize, 1, static_cast<GDALDataType>( dataType ), papszOptions );
+  CSLDestroy( papszOptions );
+  return outputDataset;
+}
+
+
+KadasBuildOverviewsTask::KadasBuildOverviewsTask( QgsRasterLayer *layer, const QString &resampling )
+  : QgsTask( QApplication::translate( "KadasBuildOverviewsTask", "Building overviews for %1" ).arg( layer->name() ) )
+  , mLayer( layer )
+  , mFile( layer->source() )
+  , mResampling( resampling )
+{
+  setDependentLayers( { layer } );
+}
+
+KadasBuildOverviewsTask *KadasBuildOverviewsTask::start( QgsRasterLayer *layer, const QString &resampling )
+{
+  QgsProject::instance()->addMapLayer( layer );
+  KadasBuildOverviewsTask *task = new KadasBuildOverviewsTask( layer, resampling );
+  QgsApplication::taskManager()->addTask( task );
+  return task;
+}
+
+bool KadasBuildOverviewsTask::run()
+{
+  GDALDatasetH dataset = GDALOpen( mFile.toUtf8().constData(), GA_Update );
+  if ( !dataset )
+  {
+    QgsDebugMsgLevel( QString( "Failed to open %1 for building overviews" ).arg( mFile ), 2 );
+    return false;
+  }
+  int maxSize = std::max( GDALGetRasterXSize( dataset ), GDALGetRasterYSize( dataset ) );
+  QVector<int> levels;
+  for ( int level = 2; maxSize / level >= sTileSize; level *= 2 )
+  {
+    levels.append( level );
+  }
+  CPLErr err = CE_None;
+  if ( !levels.isEmpty() )
+  {
+    err = GDALBuildOverviews( dataset, mResampling.toLatin1().constData(), levels.size(), levels.data(), 0, nullptr, progressCallback, this );
+  }
+  GDALClose( dataset );
+  return err == CE_None;
+}
+
+void KadasBuildOverviewsTask::finished( bool result )
+{
+  if ( result && mLayer && mLayer->dataProvider() )
+  {
+    // Reopen the dataset to pick up the overviews
+    mLayer->dataProvider()->reloadData();
+    mLayer->triggerRepaint();
+  }
+}
+
+int CPL_STDCALL KadasBuildOverviewsTask::progressCallback( double complete, const char * /*message*/, void *data )
+{
+  KadasBuildOverviewsTask *task = static_cast<KadasBuildOverviewsTask *>( data );
+  task->setProgress( 100. * complete );
+  return !task->isCanceled();
+}
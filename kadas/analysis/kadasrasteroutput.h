@@ -0,0 +1,65 @@
+/***************************************************************************
+    kadasrasteroutput.h
+    -------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASRASTEROUTPUT_H
+#define KADASRASTEROUTPUT_H
+
+#include <QPointer>
+
+#include <gdal.h>
+
+#include <qgis/qgstaskmanager.h>
+
+#include "kadas/analysis/kadas_analysis.h"
+
+class QgsRasterLayer;
+
+class KADAS_ANALYSIS_EXPORT KadasRasterOutput
+{
+  public:
+    //! Creates a single band output dataset, tiled and compressed for fast display if the format supports it
+    static GDALDatasetH createDataset( const QString &outputFile, const QString &outputFormat, int xSize, int ySize, int dataType );
+};
+
+/**
+ * Builds internal overviews for the file of a raster layer in the background.
+ * The layer is shown right away, and reloaded with the overviews once they
+ * are built. Removing the layer from the project cancels the task.
+ */
+class KADAS_ANALYSIS_EXPORT KadasBuildOverviewsTask : public QgsTask
+{
+    Q_OBJECT
+
+  public:
+    KadasBuildOverviewsTask( QgsRasterLayer *layer, const QString &resampling = "AVERAGE" );
+
+    //! Adds the layer to the project and starts building overviews for it in the application task manager
+    static KadasBuildOverviewsTask *start( QgsRasterLayer *layer, const QString &resampling = "AVERAGE" );
+
+    bool run() override;
+
+  protected:
+    void finished( bool result ) override;
+
+  private:
+    QPointer<QgsRasterLayer> mLayer;
+    QString mFile;
+    QString mResampling;
+
+    static int CPL_STDCALL progressCallback( double complete, const char *message, void *data );
+};
+
+#endif // KADASRASTEROUTPUT_H
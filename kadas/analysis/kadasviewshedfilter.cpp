@@ -28,6 +28,7 @@
 #include <qgis/qgsunittypes.h>
 
 #include "kadas/core/kadas.h"
+#include "kadas/analysis/kadasrasteroutput.h"
 #include "kadas/analysis/kadasviewshedfilter.h"
 
 
@@ -51,7 +52,93 @@ static inline double pixelToGeoY( double gtrans[6], double px, double py )
   return gtrans[3] + px * gtrans[4] + py * gtrans[5];
 }
 
+// Rasterizes the polygon (even-odd rule) into a mask covering the pixel window starting at colStart, rowStart
+static QVector<unsigned char> rasterizeFilterRegion( const QPolygon &poly, int colStart, int rowStart, int width, int height )
+{
+  QVector<unsigned char> mask( width * height, 0 );
+  QVector<double> crossings;
+  for ( int y = 0; y < height; ++y )
+  {
+    double py = rowStart + y;
+    crossings.clear();
+    for ( int i = 0, n = poly.size(); i < n; ++i )
+    {
+      const QPoint &a = poly[i];
+      const QPoint &b = poly[( i + 1 ) % n];
+      if ( ( a.y() <= py ) != ( b.y() <= py ) )
+      {
+        crossings.append( a.x() + ( py - a.y() ) * ( b.x() - a.x() ) / double( b.y() - a.y() ) );
+      }
+    }
+    std::sort( crossings.begin(), crossings.end() );
+    for ( int i = 0; i + 1 < crossings.size(); i += 2 )
+    {
+      int x0 = std::max( 0, int( std::ceil( crossings[i] ) ) - colStart );
+      int x1 = std::min( width - 1, int( std::floor( crossings[i + 1] ) ) - colStart );
+      if ( x0 <= x1 )
+      {
+        std::memset( mask.data() + y * width + x0, 1, x1 - x0 + 1 );
+      }
+    }
+  }
+  return mask;
+}
+
+// If the polygon is a sector with apex at the observer, computes its angular range as seen from the observer
+static bool filterRegionAngularRange( const QPolygon &poly, const QPoint &obs, double &startAngle, double &span )
+{
+  QVector<double> angles;
+  bool hasApex = false;
+  for ( const QPoint &p : poly )
+  {
+    int dx = p.x() - obs.x();
+    int dy = p.y() - obs.y();
+    if ( dx * dx + dy * dy <= 1 )
+    {
+      hasApex = true;
+    }
+    else
+    {
+      angles.append( std::atan2( dy, dx ) );
+    }
+  }
+  if ( !hasApex || angles.size() < 2 )
+  {
+    return false;
+  }
+  std::sort( angles.begin(), angles.end() );
+  // The sector covers everything but the largest angular gap between its vertices
+  double maxGap = angles.front() + 2 * M_PI - angles.back();
+  startAngle = angles.front();
+  for ( int i = 1, n = angles.size(); i < n; ++i )
+  {
+    if ( angles[i] - angles[i - 1] > maxGap )
+    {
+      maxGap = angles[i] - angles[i - 1];
+      startAngle = angles[i];
+    }
+  }
+  span = 2 * M_PI - maxGap;
+  return true;
+}
+
 bool KadasViewshedFilter::computeViewshed( const QgsRasterLayer *layer, const QString &outputFile, const QString &outputFormat, QgsPointXY observerPos, const QgsCoordinateReferenceSystem &observerPosCrs, double observerHeight, double targetHeight, bool observerHeightRelToTerr, bool targetHeightRelToTerr, double observerMinVertAngle, double observerMaxVertAngle, double radius, const Qgis::DistanceUnit distanceElevUnit, QProgressDialog *progress, QString *errMsg, const QVector<QgsPointXY> &filterRegion, int accuracyFactor )
+{
+  Heightmap heightmap;
+  if ( !loadHeightmap( layer, observerPos, observerPosCrs, radius, distanceElevUnit, heightmap, progress, errMsg ) )
+  {
+    return false;
+  }
+  Parameters params = heightmapParameters( heightmap, observerPos, observerPosCrs, observerHeight, targetHeight, observerHeightRelToTerr, targetHeightRelToTerr, observerMinVertAngle, observerMaxVertAngle, radius, distanceElevUnit, filterRegion );
+  Result result;
+  if ( !computeViewshed( heightmap, params, accuracyFactor, result, progress, errMsg ) )
+  {
+    return false;
+  }
+  return writeViewshed( heightmap, result, outputFile, outputFormat, errMsg );
+}
+
+bool KadasViewshedFilter::loadHeightmap( const QgsRasterLayer *layer, QgsPointXY center, const QgsCoordinateReferenceSystem &centerCrs, double radius, Qgis::DistanceUnit radiusUnit, Heightmap &heightmap, QProgressDialog *progress, QString *errMsg )
 {
   // Open input file
   GDALDatasetH inputDataset = Kadas::gdalOpenForLayer( layer );
@@ -70,16 +157,13 @@ bool KadasViewshedFilter::computeViewshed( const QgsRasterLayer *layer, const QS
     GDALClose( inputDataset );
     return false;
   }
-  QgsCoordinateTransform ct( observerPosCrs, datasetCrs, QgsProject::instance() );
-  observerPos = ct.transform( observerPos );
-  if ( datasetCrs.mapUnits() != distanceElevUnit )
+  QgsCoordinateTransform ct( centerCrs, datasetCrs, QgsProject::instance() );
+  center = ct.transform( center );
+  if ( datasetCrs.mapUnits() != radiusUnit )
   {
-    observerHeight *= QgsUnitTypes::fromUnitToUnitFactor( distanceElevUnit, datasetCrs.mapUnits() );
-    targetHeight *= QgsUnitTypes::fromUnitToUnitFactor( distanceElevUnit, datasetCrs.mapUnits() );
-    radius *= QgsUnitTypes::fromUnitToUnitFactor( distanceElevUnit, datasetCrs.mapUnits() );
+    radius *= QgsUnitTypes::fromUnitToUnitFactor( radiusUnit, datasetCrs.mapUnits() );
   }
 
-
   // Open input band
   GDALRasterBandH inputBand = GDALGetRasterBand( inputDataset, 1 );
   if ( inputBand == NULL )
@@ -90,32 +174,22 @@ bool KadasViewshedFilter::computeViewshed( const QgsRasterLayer *layer, const QS
   }
   float noDataValue = GDALGetRasterNoDataValue( inputBand, NULL );
 
-
   // Compute window of raster to read
   double gtrans[6] = {};
   if ( GDALGetGeoTransform( inputDataset, &gtrans[0] ) != CE_None )
   {
+    GDALClose( inputDataset );
     *errMsg = QApplication::translate( "KadasViewshedFilter", "Failed to query input dataset geotransform" );
     return false;
   }
   int terWidth = GDALGetRasterXSize( inputDataset );
   int terHeight = GDALGetRasterYSize( inputDataset );
 
-  int obs[2] = {
-    qRound( geoToPixelX( gtrans, observerPos.x(), observerPos.y() ) ),
-    qRound( geoToPixelY( gtrans, observerPos.x(), observerPos.y() ) )
-  };
-  double earthRadius = 6370000;
-  if ( datasetCrs.mapUnits() != Qgis::DistanceUnit::Meters )
-  {
-    earthRadius *= QgsUnitTypes::fromUnitToUnitFactor( Qgis::DistanceUnit::Meters, datasetCrs.mapUnits() );
-  }
-
   QList<QgsPointXY> cornerPoints = QList<QgsPointXY>()
-                                   << QgsPointXY( observerPos.x() - radius, observerPos.y() - radius )
-                                   << QgsPointXY( observerPos.x() + radius, observerPos.y() - radius )
-                                   << QgsPointXY( observerPos.x() + radius, observerPos.y() + radius )
-                                   << QgsPointXY( observerPos.x() - radius, observerPos.y() + radius );
+                                   << QgsPointXY( center.x() - radius, center.y() - radius )
+                                   << QgsPointXY( center.x() + radius, center.y() - radius )
+                                   << QgsPointXY( center.x() + radius, center.y() + radius )
+                                   << QgsPointXY( center.x() - radius, center.y() + radius );
   int colStart = std::numeric_limits<int>::max();
   int rowStart = std::numeric_limits<int>::max();
   int colEnd = -std::numeric_limits<int>::max();
@@ -135,54 +209,40 @@ bool KadasViewshedFilter::computeViewshed( const QgsRasterLayer *layer, const QS
   rowEnd = std::min( terHeight - 1, rowEnd );
   int hmapWidth = colEnd - colStart + 1;
   int hmapHeight = rowEnd - rowStart + 1;
-  QPolygon filterPoly;
-  for ( int i = 0, n = filterRegion.size(); i < n; ++i )
-  {
-    QgsPointXY p = ct.transform( filterRegion[i] );
-    filterPoly.append( QPoint( qRound( geoToPixelX( gtrans, p.x(), p.y() ) ), qRound( geoToPixelY( gtrans, p.x(), p.y() ) ) ) );
-  }
-
-  if ( obs[0] < colStart || obs[0] > colEnd || obs[1] < rowStart || obs[1] > rowEnd )
+  if ( hmapWidth <= 0 || hmapHeight <= 0 )
   {
     GDALClose( inputDataset );
     *errMsg = QApplication::translate( "KadasViewshedFilter", "Observer pos is outside vieweshed area, reprojection distortion?" );
     return false;
   }
 
-  int scaledHmapHeight = hmapHeight / accuracyFactor;
-  int scaledHmapWidth = hmapWidth / accuracyFactor;
-
-  // Read input heightmap
-  // Allow at most 1GB allocated
-  if ( scaledHmapWidth * scaledHmapHeight * sizeof( float ) > 1073741824 )
+  if ( progress )
   {
-    GDALClose( inputDataset );
-    *errMsg = QApplication::translate( "KadasViewshedFilter", "Too much memory required" );
-    return false;
+    progress->setLabelText( QApplication::translate( "KadasViewshedFilter", "Loading elevation data..." ) );
+    progress->setRange( 0, hmapHeight );
   }
 
-  progress->setLabelText( QApplication::translate( "KadasViewshedFilter", "Loading elevation data..." ) );
-  progress->setRange( 0, hmapHeight );
-
   // Read in lines of 4096 pixels max
-  CPLErr err = CE_None;
-  QVector<float> fullheightMap( hmapWidth * hmapHeight, noDataValue );
+  QVector<float> data( hmapWidth * hmapHeight, noDataValue );
   int maxLineSize = std::min( 4096, hmapWidth );
   for ( int y = 0; y < hmapHeight; ++y )
   {
-    if ( progress->wasCanceled() )
+    if ( progress )
     {
-      GDALClose( inputDataset );
-      return false;
+      if ( progress->wasCanceled() )
+      {
+        GDALClose( inputDataset );
+        return false;
+      }
+      progress->setValue( y );
+      QApplication::processEvents();
     }
-    progress->setValue( y );
-    QApplication::processEvents();
 
     for ( int x = 0; x < hmapWidth; x += maxLineSize )
     {
       int lineSize = std::min( maxLineSize, hmapWidth - x );
       int bufOff = ( y * hmapWidth + x );
-      err = GDALRasterIOEx( inputBand, GF_Read, colStart + x, rowStart + y, lineSize, 1, &fullheightMap.data()[bufOff], lineSize, 1, GDT_Float32, 0, 0, nullptr );
+      CPLErr err = GDALRasterIOEx( inputBand, GF_Read, colStart + x, rowStart + y, lineSize, 1, &data.data()[bufOff], lineSize, 1, GDT_Float32, 0, 0, nullptr );
       if ( err != CE_None )
       {
         GDALClose( inputDataset );
@@ -192,130 +252,206 @@ bool KadasViewshedFilter::computeViewshed( const QgsRasterLayer *layer, const QS
     }
   }
 
-  // In-memory dataset from full heightmap
-  GDALDriverH driver = GDALGetDriverByName( "MEM" );
-  GDALDatasetH memdataset = GDALCreate( driver, "", hmapWidth, hmapHeight, 1, GDT_Float32, nullptr );
-  GDALRasterBandH memband = GDALGetRasterBand( memdataset, 1 );
-  int bsX, bsY;
-  GDALGetBlockSize( memband, &bsX, &bsY );
-  Q_ASSERT( bsY == 1 ); // Vertical block size for MEM dataset should be 1
-  int nXBlocks = ( hmapWidth + bsX - 1 ) / bsX;
-  for ( int y = 0; y < hmapHeight && err == CE_None; ++y )
-  {
-    for ( int iXBlock = 0; iXBlock < nXBlocks && err == CE_None; ++iXBlock )
-    {
-      err = GDALWriteBlock( memband, iXBlock, y, fullheightMap.data() + y * hmapWidth + iXBlock * bsX );
-    }
+  heightmap.crs = datasetCrs;
+  heightmap.projectionWkt = QString( GDALGetProjectionRef( inputDataset ) );
+  std::memcpy( heightmap.gtrans, gtrans, sizeof( gtrans ) );
+  // Shift for origin of window
+  heightmap.gtrans[0] += colStart * gtrans[1] + rowStart * gtrans[2];
+  heightmap.gtrans[3] += colStart * gtrans[4] + rowStart * gtrans[5];
+  heightmap.width = hmapWidth;
+  heightmap.height = hmapHeight;
+  heightmap.noDataValue = noDataValue;
+  heightmap.data = data;
+  heightmap.scaledData.clear();
+  heightmap.requestedExtent = QgsRectangle( center.x() - radius, center.y() - radius, center.x() + radius, center.y() + radius );
+
+  GDALClose( inputDataset );
+  return true;
+}
+
+KadasViewshedFilter::Parameters KadasViewshedFilter::heightmapParameters( const Heightmap &heightmap, const QgsPointXY &observerPos, const QgsCoordinateReferenceSystem &observerPosCrs, double observerHeight, double targetHeight, bool observerHeightRelToTerr, bool targetHeightRelToTerr, double observerMinVertAngle, double observerMaxVertAngle, double radius, Qgis::DistanceUnit distanceElevUnit, const QVector<QgsPointXY> &filterRegion )
+{
+  Parameters params;
+  QgsCoordinateTransform ct( observerPosCrs, heightmap.crs, QgsProject::instance() );
+  params.observerPos = ct.transform( observerPos );
+  params.observerHeight = observerHeight;
+  params.targetHeight = targetHeight;
+  params.radius = radius;
+  if ( heightmap.crs.mapUnits() != distanceElevUnit )
+  {
+    double factor = QgsUnitTypes::fromUnitToUnitFactor( distanceElevUnit, heightmap.crs.mapUnits() );
+    params.observerHeight *= factor;
+    params.targetHeight *= factor;
+    params.radius *= factor;
   }
+  params.observerHeightRelToTerr = observerHeightRelToTerr;
+  params.targetHeightRelToTerr = targetHeightRelToTerr;
+  params.observerMinVertAngle = observerMinVertAngle;
+  params.observerMaxVertAngle = observerMaxVertAngle;
+  params.filterRegion.reserve( filterRegion.size() );
+  for ( const QgsPointXY &p : filterRegion )
+  {
+    params.filterRegion.append( ct.transform( p ) );
+  }
+  return params;
+}
 
-  if ( err != CE_None )
+// Downscales the heightmap with GDAL's average resampling, as the viewshed was always computed
+static bool downscaleHeightmap( const QVector<float> &data, int width, int height, int factor, float noDataValue, QVector<float> &scaled )
+{
+  int scaledWidth = width / factor;
+  int scaledHeight = height / factor;
+  scaled = QVector<float>( scaledWidth * scaledHeight, noDataValue );
+
+  // In-memory dataset on the full heightmap
+  GDALDriverH driver = GDALGetDriverByName( "MEM" );
+  GDALDatasetH memdataset = GDALCreate( driver, "", width, height, 0, GDT_Float32, nullptr );
+  if ( !memdataset )
   {
-    GDALClose( memdataset );
-    GDALClose( inputDataset );
-    *errMsg = QApplication::translate( "KadasViewshedFilter", "Failed to fetch raster pixels" );
     return false;
   }
+  char **papszOptions = CSLSetNameValue( nullptr, "DATAPOINTER", QByteArray::number( reinterpret_cast<quintptr>( data.constData() ) ).constData() );
+  CPLErr err = GDALAddBand( memdataset, GDT_Float32, papszOptions );
+  CSLDestroy( papszOptions );
 
-  // Downscale heightmap with rasterio
-  QVector<float> heightmap( scaledHmapWidth * scaledHmapHeight, noDataValue );
-  GDALRasterIOExtraArg rioargs;
-  INIT_RASTERIO_EXTRA_ARG( rioargs );
-  rioargs.eResampleAlg = GRIORA_Average;
-
-  err = GDALRasterIOEx( memband, GF_Read, 0, 0, hmapWidth, hmapHeight, heightmap.data(), scaledHmapWidth, scaledHmapHeight, GDT_Float32, 0, 0, &rioargs );
+  if ( err == CE_None )
+  {
+    GDALRasterIOExtraArg rioargs;
+    INIT_RASTERIO_EXTRA_ARG( rioargs );
+    rioargs.eResampleAlg = GRIORA_Average;
+    err = GDALRasterIOEx( GDALGetRasterBand( memdataset, 1 ), GF_Read, 0, 0, width, height, scaled.data(), scaledWidth, scaledHeight, GDT_Float32, 0, 0, &rioargs );
+  }
   GDALClose( memdataset );
+  return err == CE_None;
+}
 
-  if ( err != CE_None )
+bool KadasViewshedFilter::computeViewshed( Heightmap &heightmap, const Parameters &params, int accuracyFactor, Result &result, QProgressDialog *progress, QString *errMsg, QgsFeedback *feedback )
+{
+  int hmapWidth = heightmap.width / accuracyFactor;
+  int hmapHeight = heightmap.height / accuracyFactor;
+
+  // Allow at most 1GB allocated
+  if ( hmapWidth * hmapHeight * sizeof( float ) > 1073741824 )
   {
-    GDALClose( inputDataset );
-    *errMsg = QApplication::translate( "KadasViewshedFilter", "Failed to fetch raster pixels" );
+    *errMsg = QApplication::translate( "KadasViewshedFilter", "Too much memory required" );
     return false;
   }
 
-  // Adjust for reduced resolution
+  // Downscaled heightmaps are kept with the heightmap for repeated computations
+  if ( accuracyFactor > 1 && !heightmap.scaledData.contains( accuracyFactor ) )
+  {
+    QVector<float> scaled;
+    if ( !downscaleHeightmap( heightmap.data, heightmap.width, heightmap.height, accuracyFactor, heightmap.noDataValue, scaled ) )
+    {
+      *errMsg = QApplication::translate( "KadasViewshedFilter", "Failed to fetch raster pixels" );
+      return false;
+    }
+    heightmap.scaledData.insert( accuracyFactor, scaled );
+  }
+  const QVector<float> &hmap = accuracyFactor > 1 ? heightmap.scaledData[accuracyFactor] : heightmap.data;
+  float noDataValue = heightmap.noDataValue;
+
+  // Geotransform for reduced resolution
+  double gtrans[6] = {};
+  std::memcpy( gtrans, heightmap.gtrans, sizeof( gtrans ) );
   gtrans[1] *= accuracyFactor;
   gtrans[2] *= accuracyFactor;
   gtrans[4] *= accuracyFactor;
   gtrans[5] *= accuracyFactor;
-  colStart /= accuracyFactor;
-  colEnd /= accuracyFactor;
-  rowStart /= accuracyFactor;
-  rowEnd /= accuracyFactor;
-  obs[0] /= accuracyFactor;
-  obs[1] /= accuracyFactor;
-  hmapWidth = scaledHmapWidth;
-  hmapHeight = scaledHmapHeight;
-  for ( int i = 0, n = filterPoly.size(); i < n; ++i )
+
+  // Compute window of the heightmap covering the observer radius
+  QgsPointXY observerPos = params.observerPos;
+  double radius = params.radius;
+  QList<QgsPointXY> cornerPoints = QList<QgsPointXY>()
+                                   << QgsPointXY( observerPos.x() - radius, observerPos.y() - radius )
+                                   << QgsPointXY( observerPos.x() + radius, observerPos.y() - radius )
+                                   << QgsPointXY( observerPos.x() + radius, observerPos.y() + radius )
+                                   << QgsPointXY( observerPos.x() - radius, observerPos.y() + radius );
+  int colStart = std::numeric_limits<int>::max();
+  int rowStart = std::numeric_limits<int>::max();
+  int colEnd = -std::numeric_limits<int>::max();
+  int rowEnd = -std::numeric_limits<int>::max();
+  for ( const QgsPointXY &p : cornerPoints )
   {
-    filterPoly[i] = QPoint( filterPoly[i].x() / accuracyFactor, filterPoly[i].y() / accuracyFactor );
+    double x = geoToPixelX( gtrans, p.x(), p.y() );
+    double y = geoToPixelY( gtrans, p.x(), p.y() );
+    colStart = std::min( colStart, static_cast<int>( std::floor( x ) ) );
+    colEnd = std::max( colEnd, static_cast<int>( std::ceil( x ) ) );
+    rowStart = std::min( rowStart, static_cast<int>( std::floor( y ) ) );
+    rowEnd = std::max( rowEnd, static_cast<int>( std::ceil( y ) ) );
   }
+  colStart = std::max( 0, colStart );
+  colEnd = std::min( hmapWidth - 1, colEnd );
+  rowStart = std::max( 0, rowStart );
+  rowEnd = std::min( hmapHeight - 1, rowEnd );
+  int winWidth = colEnd - colStart + 1;
+  int winHeight = rowEnd - rowStart + 1;
 
-  // Prepare output
-  GDALDriverH outputDriver = GDALGetDriverByName( outputFormat.toLocal8Bit().data() );
-  if ( outputDriver == 0 )
+  int obs[2] = {
+    qRound( geoToPixelX( heightmap.gtrans, observerPos.x(), observerPos.y() ) ) / accuracyFactor,
+    qRound( geoToPixelY( heightmap.gtrans, observerPos.x(), observerPos.y() ) ) / accuracyFactor
+  };
+  if ( winWidth <= 0 || winHeight <= 0 || obs[0] < colStart || obs[0] > colEnd || obs[1] < rowStart || obs[1] > rowEnd )
   {
-    GDALClose( inputDataset );
-    *errMsg = QApplication::translate( "KadasViewshedFilter", "Failed to get driver for output" );
+    *errMsg = QApplication::translate( "KadasViewshedFilter", "Observer pos is outside vieweshed area, reprojection distortion?" );
     return false;
   }
-  if ( !CSLFetchBoolean( GDALGetMetadata( outputDriver, NULL ), GDAL_DCAP_CREATE, false ) )
+
+  double earthRadius = 6370000;
+  if ( heightmap.crs.mapUnits() != Qgis::DistanceUnit::Meters )
   {
-    GDALClose( inputDataset );
-    *errMsg = QApplication::translate( "KadasViewshedFilter", "Driver for output does not support creation" );
-    return false;
+    earthRadius *= QgsUnitTypes::fromUnitToUnitFactor( Qgis::DistanceUnit::Meters, heightmap.crs.mapUnits() );
   }
-  char **papszOptions = CSLSetNameValue( 0, "COMPRESS", "LZW" );
-  GDALDatasetH outputDataset = GDALCreate( outputDriver, outputFile.toLocal8Bit().data(), hmapWidth, hmapHeight, 1, GDT_Byte, papszOptions );
-  if ( outputDataset == NULL )
+
+  QPolygon filterPoly;
+  for ( const QgsPointXY &p : params.filterRegion )
   {
-    GDALClose( inputDataset );
-    *errMsg = QApplication::translate( "KadasViewshedFilter", "Failed to open output dataset" );
-    return false;
+    filterPoly.append( QPoint( qRound( geoToPixelX( heightmap.gtrans, p.x(), p.y() ) ) / accuracyFactor, qRound( geoToPixelY( heightmap.gtrans, p.x(), p.y() ) ) / accuracyFactor ) );
   }
 
-  double outgtrans[6];
-  std::memcpy( outgtrans, gtrans, sizeof( gtrans ) );
-
-  // Shift for origin of window
-  outgtrans[0] += colStart * outgtrans[1] + rowStart * outgtrans[2];
-  outgtrans[3] += colStart * outgtrans[4] + rowStart * outgtrans[5];
-
-  GDALSetGeoTransform( outputDataset, outgtrans );
-  GDALSetProjection( outputDataset, GDALGetProjectionRef( inputDataset ) );
-
-  GDALRasterBandH outputBand = GDALGetRasterBand( outputDataset, 1 );
-  if ( outputBand == 0 )
+  // Rasterize the filter region once, and only cast rays within the angular range of sectors
+  QVector<unsigned char> filterMask;
+  double sectorStart = 0;
+  double sectorSpan = 2 * M_PI;
+  bool clipRays = false;
+  if ( !filterPoly.isEmpty() )
   {
-    GDALClose( inputDataset );
-    GDALClose( outputDataset );
-    *errMsg = QApplication::translate( "KadasViewshedFilter", "Failed to get output dataset band 1" );
-    return false;
+    filterMask = rasterizeFilterRegion( filterPoly, colStart, rowStart, winWidth, winHeight );
+    clipRays = filterRegionAngularRange( filterPoly, QPoint( obs[0], obs[1] ), sectorStart, sectorSpan );
   }
-  GDALSetRasterNoDataValue( outputBand, 127 );
 
   // Offset observer elevation by position at point
-  if ( observerHeightRelToTerr )
+  double observerHeight = params.observerHeight;
+  if ( params.observerHeightRelToTerr )
   {
-    observerHeight += heightmap[( obs[1] - rowStart ) * hmapWidth + ( obs[0] - colStart )];
+    observerHeight += hmap[obs[1] * hmapWidth + obs[0]];
   }
 
 
   // Compute viewshed
-  int roi = std::sqrt( std::pow( hmapWidth, 2 ) + std::pow( hmapHeight, 2 ) );
-  progress->setLabelText( QApplication::translate( "KadasViewshedFilter", "Computing viewshed..." ) );
-  progress->setRange( 0, 8 * roi );
+  int roi = std::sqrt( std::pow( winWidth, 2 ) + std::pow( winHeight, 2 ) );
+  if ( progress )
+  {
+    progress->setLabelText( QApplication::translate( "KadasViewshedFilter", "Computing viewshed..." ) );
+    progress->setRange( 0, 8 * roi );
+  }
 
-  QVector<unsigned char> viewshed( hmapWidth * hmapHeight, 127 );
+  QVector<unsigned char> viewshed( winWidth * winHeight, 127 );
   for ( int radiusNumber = 0; radiusNumber < 8 * roi; ++radiusNumber )
   {
-    if ( progress->wasCanceled() )
+    if ( progress )
+    {
+      if ( progress->wasCanceled() )
+      {
+        return false;
+      }
+      progress->setValue( radiusNumber );
+      QApplication::processEvents();
+    }
+    if ( feedback && feedback->isCanceled() )
     {
-      GDALClose( inputDataset );
-      GDALClose( outputDataset );
       return false;
     }
-    progress->setValue( radiusNumber );
-    QApplication::processEvents();
 
     int target[2];
     if ( radiusNumber <= roi )
@@ -350,6 +486,18 @@ bool KadasViewshedFilter::computeViewshed( const QgsRasterLayer *layer, const QS
 
     // Line of sight from observer to target.
     int delta[2] = { target[0] - obs[0], target[1] - obs[1] };
+
+    if ( clipRays )
+    {
+      // Allow a margin of about two target steps so that cells along the sector edges are covered
+      double margin = 2. / roi;
+      double offset = std::fmod( std::atan2( delta[1], delta[0] ) - sectorStart + 4 * M_PI, 2 * M_PI );
+      if ( offset > sectorSpan + margin && offset < 2 * M_PI - margin )
+      {
+        continue;
+      }
+    }
+
     int inciny = qAbs( delta[0] ) < qAbs( delta[1] );
 
     // Step along coord (X or Y) that varies most from observer to target.
@@ -384,17 +532,13 @@ bool KadasViewshedFilter::computeViewshed( const QgsRasterLayer *layer, const QS
       {
         break;
       }
-      if ( !filterPoly.isEmpty() && !filterPoly.containsPoint( QPoint( p[0], p[1] ), Qt::OddEvenFill ) )
-      {
-        continue;
-      }
 
-      int idx = ( p[1] - rowStart ) * hmapWidth + ( p[0] - colStart );
-      if ( idx >= heightmap.size() )
+      int idx = ( p[1] - rowStart ) * winWidth + ( p[0] - colStart );
+      if ( !filterMask.isEmpty() && !filterMask[idx] )
       {
         continue;
       }
-      float pElev = heightmap[idx];
+      float pElev = hmap[p[1] * hmapWidth + p[0]];
       if ( pElev == noDataValue )
       {
         continue;
@@ -412,8 +556,8 @@ bool KadasViewshedFilter::computeViewshed( const QgsRasterLayer *layer, const QS
       horizon_slope = std::max( horizon_slope, s );
 
       double horizon_alt = observerHeight + horizon_slope * qAbs( p[inciny] - obs[inciny] );
-      double tHeight = targetHeight;
-      if ( targetHeightRelToTerr )
+      double tHeight = params.targetHeight;
+      if ( params.targetHeightRelToTerr )
       {
         tHeight += pElev;
       }
@@ -425,23 +569,68 @@ bool KadasViewshedFilter::computeViewshed( const QgsRasterLayer *layer, const QS
       double n = std::sqrt( vx * vx + vy * vy + vz * vz );
       double vangle = std::asin( vz / n ) / M_PI * 180.;
 
-      if ( tHeight >= horizon_alt && vangle >= observerMinVertAngle && vangle <= observerMaxVertAngle )
+      if ( tHeight >= horizon_alt && vangle >= params.observerMinVertAngle && vangle <= params.observerMaxVertAngle )
       {
-        viewshed[( p[1] - rowStart ) * hmapWidth + ( p[0] - colStart )] = 255;
+        viewshed[idx] = 255;
       }
       else
       {
-        viewshed[( p[1] - rowStart ) * hmapWidth + ( p[0] - colStart )] = 0;
+        viewshed[idx] = 0;
       }
     }
   }
   // The observer is always visible from itself
-  viewshed[( obs[1] - rowStart ) * hmapWidth + ( obs[0] - colStart )] = 255;
+  viewshed[( obs[1] - rowStart ) * winWidth + ( obs[0] - colStart )] = 255;
+
+  result.viewshed = viewshed;
+  result.width = winWidth;
+  result.height = winHeight;
+  result.colOffset = colStart;
+  result.rowOffset = rowStart;
+  std::memcpy( result.gtrans, gtrans, sizeof( gtrans ) );
+  // Shift for origin of window
+  result.gtrans[0] += colStart * gtrans[1] + rowStart * gtrans[2];
+  result.gtrans[3] += colStart * gtrans[4] + rowStart * gtrans[5];
+  return true;
+}
 
+bool KadasViewshedFilter::writeViewshed( const Heightmap &heightmap, const Result &result, const QString &outputFile, const QString &outputFormat, QString *errMsg )
+{
+  // Prepare output
+  GDALDriverH outputDriver = GDALGetDriverByName( outputFormat.toLocal8Bit().data() );
+  if ( outputDriver == 0 )
+  {
+    *errMsg = QApplication::translate( "KadasViewshedFilter", "Failed to get driver for output" );
+    return false;
+  }
+  if ( !CSLFetchBoolean( GDALGetMetadata( outputDriver, NULL ), GDAL_DCAP_CREATE, false ) )
+  {
+    *errMsg = QApplication::translate( "KadasViewshedFilter", "Driver for output does not support creation" );
+    return false;
+  }
+  GDALDatasetH outputDataset = KadasRasterOutput::createDataset( outputFile, outputFormat, result.width, result.height, GDT_Byte );
+  if ( outputDataset == NULL )
+  {
+    *errMsg = QApplication::translate( "KadasViewshedFilter", "Failed to open output dataset" );
+    return false;
+  }
+
+  double outgtrans[6];
+  std::memcpy( outgtrans, result.gtrans, sizeof( outgtrans ) );
+  GDALSetGeoTransform( outputDataset, outgtrans );
+  GDALSetProjection( outputDataset, heightmap.projectionWkt.toLocal8Bit().data() );
+
+  GDALRasterBandH outputBand = GDALGetRasterBand( outputDataset, 1 );
+  if ( outputBand == 0 )
+  {
+    GDALClose( outputDataset );
+    *errMsg = QApplication::translate( "KadasViewshedFilter", "Failed to get output dataset band 1" );
+    return false;
+  }
+  GDALSetRasterNoDataValue( outputBand, 127 );
 
   // Write output
-  err = GDALRasterIO( outputBand, GF_Write, 0, 0, hmapWidth, hmapHeight, viewshed.data(), hmapWidth, hmapHeight, GDT_Byte, 0, 0 );
-  GDALClose( inputDataset );
+  CPLErr err = GDALRasterIO( outputBand, GF_Write, 0, 0, result.width, result.height, const_cast<unsigned char *>( result.viewshed.data() ), result.width, result.height, GDT_Byte, 0, 0 );
   GDALClose( outputDataset );
   if ( err != CE_None )
   {
@@ -450,3 +639,28 @@ bool KadasViewshedFilter::computeViewshed( const QgsRasterLayer *layer, const QS
   }
   return true;
 }
+
+
+KadasViewshedTask::KadasViewshedTask( std::shared_ptr<KadasViewshedFilter::Heightmap> heightmap, const KadasViewshedFilter::Parameters &params, int accuracyFactor, const QString &outputFile )
+  : QgsTask( QApplication::translate( "KadasViewshedTask", "Computing viewshed" ), QgsTask::CanCancel | QgsTask::Silent )
+  , mHeightmap( heightmap )
+  , mParams( params )
+  , mAccuracyFactor( accuracyFactor )
+  , mOutputFile( outputFile )
+{
+}
+
+bool KadasViewshedTask::run()
+{
+  if ( !KadasViewshedFilter::computeViewshed( *mHeightmap, mParams, mAccuracyFactor, mResult, nullptr, &mErrorMessage, &mFeedback ) )
+  {
+    return false;
+  }
+  return !isCanceled() && KadasViewshedFilter::writeViewshed( *mHeightmap, mResult, mOutputFile, "GTiff", &mErrorMessage );
+}
+
+void KadasViewshedTask::cancel()
+{
+  mFeedback.cancel();
+  QgsTask::cancel();
+}
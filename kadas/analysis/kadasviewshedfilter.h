@@ -18,9 +18,15 @@
 #ifndef KADASVIEWSHEDFILTER_H
 #define KADASVIEWSHEDFILTER_H
 
+#include <QMap>
 #include <QVector>
 
+#include <memory>
+
 #include <qgis/qgscoordinatereferencesystem.h>
+#include <qgis/qgsfeedback.h>
+#include <qgis/qgsrectangle.h>
+#include <qgis/qgstaskmanager.h>
 
 #include "kadas/analysis/kadas_analysis.h"
 
@@ -32,6 +38,88 @@ class KADAS_ANALYSIS_EXPORT KadasViewshedFilter
 {
   public:
     static bool computeViewshed( const QgsRasterLayer *layer, const QString &outputFile, const QString &outputFormat, QgsPointXY observerPos, const QgsCoordinateReferenceSystem &observerPosCrs, double observerHeight, double targetHeight, bool observerHeightRelToTerr, bool targetHeightRelToTerr, double observerMinVertAngle, double observerMaxVertAngle, double radius, const Qgis::DistanceUnit distanceElevUnit, QProgressDialog *progress, QString *errMsg, const QVector<QgsPointXY> &filterRegion = QVector<QgsPointXY>(), int accuracyFactor = 1 );
+
+#ifndef SIP_RUN
+    // Elevation data loaded for a window of the input raster, kept resident for repeated computations
+    struct Heightmap
+    {
+        QgsCoordinateReferenceSystem crs;
+        QString projectionWkt;
+        double gtrans[6] = {}; // Geotransform of the window, at full resolution
+        int width = 0;
+        int height = 0;
+        float noDataValue = 0;
+        QVector<float> data;
+        QMap<int, QVector<float>> scaledData; // Downscaled data, by accuracy factor
+        QgsRectangle requestedExtent;          // Region requested when loading, the data may be clipped to the raster bounds
+
+        bool covers( const QgsRectangle &rect ) const { return !data.isEmpty() && requestedExtent.contains( rect ); }
+    };
+
+    // Viewshed parameters, in heightmap CRS and units
+    struct Parameters
+    {
+        QgsPointXY observerPos;
+        double observerHeight = 0;
+        double targetHeight = 0;
+        bool observerHeightRelToTerr = true;
+        bool targetHeightRelToTerr = true;
+        double observerMinVertAngle = -90;
+        double observerMaxVertAngle = 90;
+        double radius = 0;
+        QVector<QgsPointXY> filterRegion;
+    };
+
+    struct Result
+    {
+        QVector<unsigned char> viewshed;
+        int width = 0;
+        int height = 0;
+        double gtrans[6] = {};
+        int colOffset = 0;
+        int rowOffset = 0;
+    };
+
+    static bool loadHeightmap( const QgsRasterLayer *layer, QgsPointXY center, const QgsCoordinateReferenceSystem &centerCrs, double radius, Qgis::DistanceUnit radiusUnit, Heightmap &heightmap, QProgressDialog *progress, QString *errMsg );
+    static Parameters heightmapParameters( const Heightmap &heightmap, const QgsPointXY &observerPos, const QgsCoordinateReferenceSystem &observerPosCrs, double observerHeight, double targetHeight, bool observerHeightRelToTerr, bool targetHeightRelToTerr, double observerMinVertAngle, double observerMaxVertAngle, double radius, Qgis::DistanceUnit distanceElevUnit, const QVector<QgsPointXY> &filterRegion = QVector<QgsPointXY>() );
+    // Computes the viewshed over the part of the heightmap within the observer radius. Progress and feedback may be null.
+    static bool computeViewshed( Heightmap &heightmap, const Parameters &params, int accuracyFactor, Result &result, QProgressDialog *progress, QString *errMsg, QgsFeedback *feedback = nullptr );
+    static bool writeViewshed( const Heightmap &heightmap, const Result &result, const QString &outputFile, const QString &outputFormat, QString *errMsg );
+#endif
+};
+
+#ifndef SIP_RUN
+
+/**
+ * Computes a viewshed on a loaded heightmap in the background and writes it to a GeoTIFF.
+ * The heightmap must not be modified while the task runs, and at most one task may
+ * use it at a time, since downscaled data is cached in it.
+ */
+class KADAS_ANALYSIS_EXPORT KadasViewshedTask : public QgsTask
+{
+    Q_OBJECT
+
+  public:
+    KadasViewshedTask( std::shared_ptr<KadasViewshedFilter::Heightmap> heightmap, const KadasViewshedFilter::Parameters &params, int accuracyFactor, const QString &outputFile );
+
+    bool run() override;
+    void cancel() override;
+
+    int accuracyFactor() const { return mAccuracyFactor; }
+    const QString &outputFile() const { return mOutputFile; }
+    const KadasViewshedFilter::Result &result() const { return mResult; }
+    const QString &errorMessage() const { return mErrorMessage; }
+
+  private:
+    std::shared_ptr<KadasViewshedFilter::Heightmap> mHeightmap;
+    KadasViewshedFilter::Parameters mParams;
+    int mAccuracyFactor = 1;
+    QString mOutputFile;
+    KadasViewshedFilter::Result mResult;
+    QString mErrorMessage;
+    QgsFeedback mFeedback;
 };
 
+#endif
+
 #endif // KADASVIEWSHEDFILTER_H
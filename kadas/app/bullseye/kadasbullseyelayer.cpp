@@ -15,8 +15,6 @@
  ***************************************************************************/
 
 #include <QAction>
-#include <QApplication>
-#include <QDesktopWidget>
 #include <QMenu>
 
 #include <GeographicLib/Geodesic.hpp>
@@ -30,6 +28,7 @@
 #include <qgis/qgssymbollayerutils.h>
 #include <qgis/qgsunittypes.h>
 
+#include "kadas/gui/kadasrendersnapshot.h"
 #include <bullseye/kadasbullseyelayer.h>
 #include <bullseye/kadasmaptoolbullseye.h>
 
@@ -46,6 +45,7 @@ class KadasBullseyeLayer::Renderer : public QgsMapLayerRenderer
     {
       mDa.setEllipsoid( "WGS84" );
       mDa.setSourceCrs( QgsCoordinateReferenceSystem( "EPSG:4326" ), renderContext()->transformContext() );
+      KadasRenderSnapshot::capture().store( rendererContext );
     }
 
     bool render() override
@@ -56,7 +56,7 @@ class KadasBullseyeLayer::Renderer : public QgsMapLayerRenderer
       }
 
       const QgsMapToPixel &mapToPixel = renderContext()->mapToPixel();
-      double dpiScale = double( renderContext()->painter()->device()->logicalDpiX() ) / qApp->desktop()->logicalDpiX();
+      double dpiScale = KadasRenderSnapshot::outputDpiScale( *renderContext() );
 
       renderContext()->painter()->save();
       renderContext()->painter()->setOpacity( mRenderOpacity );
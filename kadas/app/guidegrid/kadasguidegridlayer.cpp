@@ -14,8 +14,6 @@
  *                                                                         *
  ***************************************************************************/
 
-#include <QApplication>
-#include <QDesktopWidget>
 #include <QMenu>
 
 #include <qgis/qgsapplication.h>
@@ -25,6 +23,7 @@
 #include <qgis/qgspolygon.h>
 #include <qgis/qgssymbollayerutils.h>
 
+#include "kadas/gui/kadasrendersnapshot.h"
 #include <guidegrid/kadasguidegridlayer.h>
 
 static QString gridLabel( QChar firstChar, int offset )
@@ -55,7 +54,9 @@ class KadasGuideGridLayer::Renderer : public QgsMapLayerRenderer
       : QgsMapLayerRenderer( layer->id(), &rendererContext )
       , mRenderGridConfig( layer->mGridConfig )
       , mRenderOpacity( layer->opacity() )
-    {}
+    {
+      KadasRenderSnapshot::capture().store( rendererContext );
+    }
 
     bool render() override
     {
@@ -75,7 +76,7 @@ class KadasGuideGridLayer::Renderer : public QgsMapLayerRenderer
       bool adaptLabelsToScreen = !( flags["globe"].toBool() || flags["kml"].toBool() );
 
       QColor bufferColor = ( 0.2126 * mRenderGridConfig.color.red() + 0.7152 * mRenderGridConfig.color.green() + 0.0722 * mRenderGridConfig.color.blue() ) > 128 ? Qt::black : Qt::white;
-      double dpiScale = double( renderContext()->painter()->device()->logicalDpiX() ) / qApp->desktop()->logicalDpiX();
+      double dpiScale = KadasRenderSnapshot::outputDpiScale( *renderContext() );
 
       QFont smallFont;
       smallFont.setPixelSize( 0.5 * mRenderGridConfig.fontSize * dpiScale );
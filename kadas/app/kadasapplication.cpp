@@ -26,6 +26,8 @@
 #include <QSplashScreen>
 #include <QStatusBar>
 #include <QUrlQuery>
+#include <QtConcurrentRun>
+#include <quazip/quazip.h>
 #include <quazip/quazipfile.h>
 
 #include <qgis/qgsauthguiutils.h>
@@ -82,6 +84,7 @@
 #include "kadasapplication.h"
 #include "kadasapplayerhandling.h"
 #include "kadascanvascontextmenu.h"
+#include "kadascapabilitiesprefetchtask.h"
 #ifdef WITH_CRASHREPORT
 #include "kadascrashrpt.h"
 #endif
@@ -96,6 +99,7 @@
 #include "kadasplugininterfaceimpl.h"
 #include "kadaspluginmanager.h"
 #include "kadaspythonintegration.h"
+#include "kadasstartupprofiler.h"
 #include "kadasbullseyelayer.h"
 #include "kadasguidegridlayer.h"
 #include "kadasmapgridlayer.h"
@@ -169,6 +173,7 @@ KadasApplication::~KadasApplication()
 {
   delete mMainWindow;
   delete mProjectTempDir;
+  delete mStartupProfiler;
 
   for ( QgsPluginLayerType *layerType : mKadasPluginLayerTypes )
   {
@@ -178,11 +183,15 @@ KadasApplication::~KadasApplication()
 
 void KadasApplication::init()
 {
+  mStartupProfiler = new KadasStartupProfiler( arguments() );
+  mStartupProfiler->beginPhase( "qgsapplication_init" );
+
   QgsApplication::init();
 
   QgsSettings settings;
 
   // Translations
+  mStartupProfiler->beginPhase( "translations" );
   QString locale = QLocale::system().name();
   if ( settings.value( "/locale/overrideFlag", false ).toBool() )
   {
@@ -209,8 +218,12 @@ void KadasApplication::init()
   KadasCrashRpt::install();
 #endif
 
+  mStartupProfiler->beginPhase( "init_qgis" );
   QgsApplication::initQgis();
 
+  // Import SSL certificates in the background, it is waited for before any startup network request is issued
+  mSslImportFuture = QtConcurrent::run( Kadas::importSslCertificates );
+
   QgsCoordinateTransform::setCustomMissingRequiredGridHandler( [=]( const QgsCoordinateReferenceSystem &sourceCrs, const QgsCoordinateReferenceSystem &destinationCrs, const QgsDatumTransform::GridDetails &grid ) {
     mMainWindow->messageBar()->pushWarning( tr( "Transform unavailable" ), tr( "Transform between %1 and %2 requires missing grid %3." ).arg( sourceCrs.authid() ).arg( destinationCrs.authid() ).arg( grid.shortName ) );
   } );
@@ -228,6 +241,7 @@ void KadasApplication::init()
   } );
 
   // Setup application style
+  mStartupProfiler->beginPhase( "style_and_settings" );
   setWindowIcon( QIcon( ":/kadas/logo" ) );
   QFile styleSheet( ":/stylesheet" );
   if ( styleSheet.open( QIODevice::ReadOnly ) )
@@ -277,9 +291,6 @@ void KadasApplication::init()
   // Ensure network access manager uses the correct proxy settings
   QgsNetworkAccessManager::instance()->setupDefaultProxyAndCache();
 
-  Kadas::importSslCertificates();
-
-
   // Add token injector
   QgsNetworkAccessManager::setRequestPreprocessor( injectAuthToken );
 
@@ -289,6 +300,7 @@ void KadasApplication::init()
   } );
 
   // Create main window
+  mStartupProfiler->beginPhase( "main_window" );
   QSplashScreen splash( QPixmap( ":/kadas/splash" ) );
   splash.show();
   mMainWindow = new KadasMainWindow();
@@ -333,6 +345,7 @@ void KadasApplication::init()
 
 
   // Register plugin layers
+  mStartupProfiler->beginPhase( "plugin_layers" );
   mKadasPluginLayerTypes.append( new KadasItemLayerType() );
   mKadasPluginLayerTypes.append( new KadasMilxLayerType() );
   mKadasPluginLayerTypes.append( new KadasBullseyeLayerType( mMainWindow->actionBullseye() ) );
@@ -344,19 +357,26 @@ void KadasApplication::init()
     pluginLayerRegistry()->addPluginLayerType( layerType );
   }
 
-  // Load python support
-#ifdef WITH_BINDINGS
-  mPythonInterface = new KadasPluginInterfaceImpl( this );
-  loadPythonSupport();
-#endif
-
   // Layer refresh manager
   mLayerRefreshManager = new KadasLayerRefreshManager( this );
 
+  mStartupProfiler->beginPhase( "show_main_window" );
   mMainWindow->show();
   splash.finish( mMainWindow );
   processEvents();
 
+  // Plugins may issue network requests, the default SSL configuration must be complete by then
+  mStartupProfiler->beginPhase( "ssl_certificates_wait" );
+  mSslImportFuture.waitForFinished();
+
+  // Load python support once the window is shown, but before the startup project, since plugins may provide layer types
+#ifdef WITH_BINDINGS
+  mStartupProfiler->beginPhase( "python" );
+  mPythonInterface = new KadasPluginInterfaceImpl( this );
+  loadPythonSupport();
+  processEvents();
+#endif
+
   // Setup layout item widgets
   QgsLayoutGuiUtils::registerGuiForKnownItemTypes( mMainWindow->mapCanvas() );
 
@@ -364,6 +384,7 @@ void KadasApplication::init()
   KadasItemLayerRegistry::init();
 
   // Extract portal token if necessary before loading startup project
+  mStartupProfiler->beginPhase( "startup_project" );
   QString tokenUrl = settingsPortalTokenUrl->value();
   if ( !tokenUrl.isEmpty() )
   {
@@ -378,9 +399,6 @@ void KadasApplication::init()
     loadStartupProject();
   }
 
-  // Show news popup
-  KadasNewsPopup::showIfNewsAvailable();
-
   // Continue loading application after exec()
   QTimer::singleShot( 1, this, &KadasApplication::initAfterExec );
 }
@@ -445,9 +463,11 @@ void KadasApplication::loadStartupProject()
 
   // Open startup project
   QgsProject::instance()->setDirty( false );
-  if ( arguments().size() >= 2 && QFile::exists( arguments()[1] ) )
+  QStringList args = arguments().mid( 1 );
+  args.erase( std::remove_if( args.begin(), args.end(), []( const QString &arg ) { return arg.startsWith( KadasStartupProfiler::COMMAND_LINE_OPTION ); } ), args.end() );
+  if ( !args.isEmpty() && QFile::exists( args[0] ) )
   {
-    projectOpen( arguments()[1] );
+    projectOpen( args[0] );
     QgsProject::instance()->setDirty( false );
   }
   else
@@ -520,6 +540,9 @@ void KadasApplication::loadStartupProject()
   QObject::connect( this, &QApplication::lastWindowClosed, this, &QApplication::quit );
   mAutosaveTimer.setSingleShot( true );
   connect( &mAutosaveTimer, &QTimer::timeout, this, &KadasApplication::autosave );
+  connect( &mAutosaveWatcher, &QFutureWatcher<bool>::finished, this, &KadasApplication::autosaveFinished );
+
+  mStartupProfiler->finish();
 }
 
 QgsRasterLayer *KadasApplication::addRasterLayer( const QString &uri, const QString &layerName, const QString &providerKey, bool quiet, int insOffset, bool adjustInsertionPoint ) const
@@ -584,25 +607,45 @@ QgsPointCloudLayer *KadasApplication::addPointCloudLayer( const QString &uri, co
 
 QPair<KadasMapItem *, KadasItemLayerRegistry::StandardLayer> KadasApplication::addImageItem( const QString &filename ) const
 {
-  QString attachedPath = QgsProject::instance()->createAttachedFile( QFileInfo( filename ).fileName() );
-  QFile( attachedPath ).remove();
-  QFile( filename ).copy( attachedPath );
-  QgsSettings().setValue( "/UI/lastImportExportDir", QFileInfo( filename ).absolutePath() );
+  return addImageItems( QStringList() << filename ).front();
+}
+
+QList<QPair<KadasMapItem *, KadasItemLayerRegistry::StandardLayer>> KadasApplication::addImageItems( const QStringList &filenames ) const
+{
   QgsCoordinateReferenceSystem crs( "EPSG:3857" );
   QgsCoordinateTransform crst( mMainWindow->mapCanvas()->mapSettings().destinationCrs(), crs, QgsProject::instance()->transformContext() );
-  if ( filename.endsWith( ".svg", Qt::CaseInsensitive ) )
-  {
-    KadasSymbolItem *item = new KadasSymbolItem( crs );
-    item->setup( attachedPath, 0.5, 0.5, 0, 64 );
-    item->setPosition( KadasItemPos::fromPoint( crst.transform( mMainWindow->mapCanvas()->extent().center() ) ) );
-    return qMakePair( item, KadasItemLayerRegistry::StandardLayer::SymbolsLayer );
+  KadasItemPos pos = KadasItemPos::fromPoint( crst.transform( mMainWindow->mapCanvas()->extent().center() ) );
+
+  QList<QPair<KadasMapItem *, KadasItemLayerRegistry::StandardLayer>> result;
+  QList<int> pictureIndices;
+  QStringList picturePaths;
+  for ( const QString &filename : filenames )
+  {
+    QString attachedPath = QgsProject::instance()->createAttachedFile( QFileInfo( filename ).fileName() );
+    QFile( attachedPath ).remove();
+    QFile( filename ).copy( attachedPath );
+    QgsSettings().setValue( "/UI/lastImportExportDir", QFileInfo( filename ).absolutePath() );
+    if ( filename.endsWith( ".svg", Qt::CaseInsensitive ) )
+    {
+      KadasSymbolItem *item = new KadasSymbolItem( crs );
+      item->setup( attachedPath, 0.5, 0.5, 0, 64 );
+      item->setPosition( pos );
+      result.append( qMakePair( item, KadasItemLayerRegistry::StandardLayer::SymbolsLayer ) );
+    }
+    else
+    {
+      // Pictures are created together below, so that their footprints are computed in parallel
+      pictureIndices.append( result.size() );
+      picturePaths.append( attachedPath );
+      result.append( qMakePair( static_cast<KadasMapItem *>( nullptr ), KadasItemLayerRegistry::StandardLayer::PicturesLayer ) );
+    }
   }
-  else
+  QList<KadasPictureItem *> pictureItems = KadasPictureItem::createItems( picturePaths, crs, pos );
+  for ( int i = 0, n = pictureItems.size(); i < n; ++i )
   {
-    KadasPictureItem *item = new KadasPictureItem( crs );
-    item->setup( attachedPath, KadasItemPos::fromPoint( crst.transform( mMainWindow->mapCanvas()->extent().center() ) ) );
-    return qMakePair( item, KadasItemLayerRegistry::StandardLayer::PicturesLayer );
+    result[pictureIndices[i]].first = pictureItems[i];
   }
+  return result;
 }
 
 KadasItemLayer *KadasApplication::selectPasteTargetItemLayer( const QList<KadasMapItem *> &items )
@@ -749,8 +792,17 @@ bool KadasApplication::projectOpen( const QString &projectFile )
 
   QgsProjectDirtyBlocker dirtyBlocker( QgsProject::instance() );
 
+  QElapsedTimer loadTimer;
+  loadTimer.start();
+  QElapsedTimer phaseTimer;
+  phaseTimer.start();
+
   QStringList filesToAttach;
   QString migratedFileName = KadasProjectMigration::migrateProject( openFileName, filesToAttach );
+  QgsDebugMsgLevel( QString( "Project open: migration took %1 ms" ).arg( phaseTimer.restart() ), 1 );
+
+  // Fetch the capabilities of the remote layers in the background while the project is read
+  mCapabilitiesPrefetchTask = KadasCapabilitiesPrefetchTask::start( migratedFileName, [this]( const QString &path ) { return migrateDatasource( path ); } );
 
   QString attachResolverId = QgsPathResolver::setPathPreprocessor( [filesToAttach]( const QString &path ) {
     if ( filesToAttach.contains( path ) )
@@ -764,6 +816,9 @@ bool KadasApplication::projectOpen( const QString &projectFile )
   } );
   bool success = QgsProject::instance()->read( migratedFileName );
   QgsPathResolver::removePathPreprocessor( attachResolverId );
+  // All providers have requested their capabilities by now
+  cancelCapabilitiesPrefetch();
+  QgsDebugMsgLevel( QString( "Project open: reading %1 layers took %2 ms" ).arg( QgsProject::instance()->count() ).arg( phaseTimer.restart() ), 1 );
 
   if ( success )
   {
@@ -791,6 +846,7 @@ bool KadasApplication::projectOpen( const QString &projectFile )
   mMainWindow->mapCanvas()->freeze( false );
   mMainWindow->mapCanvas()->refresh();
   QApplication::restoreOverrideCursor();
+  QgsDebugMsgLevel( QString( "Project open: canvas setup took %1 ms" ).arg( phaseTimer.restart() ), 1 );
 
   if ( !success )
   {
@@ -843,12 +899,14 @@ bool KadasApplication::projectOpen( const QString &projectFile )
       }
     }
   }
+  QgsDebugMsgLevel( QString( "Project open: %1 loaded in %2 ms" ).arg( fileName ).arg( loadTimer.elapsed() ), 1 );
 
   return success;
 }
 
 void KadasApplication::projectClose()
 {
+  cancelCapabilitiesPrefetch();
   cleanupAutosave();
 
   emit projectWillBeClosed();
@@ -1232,18 +1290,83 @@ void KadasApplication::autosave()
   {
     if ( !QgsProject::instance()->fileName().isEmpty() )
     {
+      if ( mAutosaveWatcher.isRunning() )
+      {
+        // Previous autosave is still being written, try again later
+        mAutosaveTimer.start( 5000 );
+        return;
+      }
       mAutosaving = true;
+      mAutosaveElapsed.start();
       mMainWindow->statusBar()->showMessage( tr( "Autosaving project..." ), 3000 );
       QString prevFilename = QgsProject::instance()->fileName();
       QFileInfo finfo( prevFilename );
-      QgsProject::instance()->setFileName( finfo.dir().absoluteFilePath( QString( "~%1" ).arg( finfo.fileName() ) ) );
-      QgsProject::instance()->write();
+      QString autosaveFile = finfo.dir().absoluteFilePath( QString( "~%1" ).arg( finfo.fileName() ) );
+
+      // Only serialize the project on the GUI thread, compressing the archive is done in the background
+      bool compress = QgsZipUtils::isZipFile( prevFilename );
+      QString stagingFile = compress ? finfo.dir().absoluteFilePath( QString( "~%1.qgs" ).arg( finfo.completeBaseName() ) ) : autosaveFile;
+      // Auxiliary storage written by QgsProject next to the staged .qgs
+      QString stagingAuxFile = finfo.dir().absoluteFilePath( QString( "~%1.qgd" ).arg( finfo.completeBaseName() ) );
+
+      int changedItemLayers = 0;
+      const QMap<QString, QgsMapLayer *> layers = QgsProject::instance()->mapLayers();
+      for ( QgsMapLayer *layer : layers )
+      {
+        KadasItemLayer *itemLayer = qobject_cast<KadasItemLayer *>( layer );
+        if ( itemLayer && itemLayer->pendingItemChanges() > 0 )
+        {
+          ++changedItemLayers;
+        }
+      }
+
+      QgsProject::instance()->setFileName( stagingFile );
+      bool success = QgsProject::instance()->write();
       // Immediately remove the backup created by QgsProject::write
       QFile( QgsProject::instance()->fileName() + "~" ).remove();
       QgsProject::instance()->setFileName( prevFilename );
       QgsProject::instance()->setDirty();
       mAutosaveTimer.stop(); // Stop timer triggered by projectDirtyChanged()
       mAutosaving = false;
+      mAutosaveSerializeTime = mAutosaveElapsed.elapsed();
+      QgsDebugMsgLevel( QString( "Autosave: project serialized in %1 ms, %2 item layer(s) with changes" ).arg( mAutosaveSerializeTime ).arg( changedItemLayers ), 1 );
+
+      if ( !compress || !success )
+      {
+        if ( !success && compress )
+        {
+          QFile( stagingFile ).remove();
+          QFile( stagingAuxFile ).remove();
+        }
+        reportAutosave( success );
+        return;
+      }
+
+      // Attachments of the staged .qgs are written by QgsProject next to it, they are taken from the project archive instead
+      QFile( finfo.dir().absoluteFilePath( QString( "~%1_attachments.zip" ).arg( finfo.completeBaseName() ) ) ).remove();
+      QStringList files = QStringList() << stagingFile;
+      if ( QFile::exists( stagingAuxFile ) )
+      {
+        files << stagingAuxFile;
+      }
+      files << QgsProject::instance()->attachedFiles();
+      mAutosaveWatcher.setFuture( QtConcurrent::run( [files, stagingFile, stagingAuxFile, autosaveFile] {
+        QString partFile = autosaveFile + ".part";
+        QFile( partFile ).remove();
+        bool success = QgsZipUtils::zip( partFile, files );
+        QFile( stagingFile ).remove();
+        QFile( stagingAuxFile ).remove();
+        if ( success )
+        {
+          QFile( autosaveFile ).remove();
+          success = QFile::rename( partFile, autosaveFile );
+        }
+        else
+        {
+          QFile( partFile ).remove();
+        }
+        return success;
+      } ) );
     }
     else
     {
@@ -1252,13 +1375,44 @@ void KadasApplication::autosave()
   }
 }
 
+void KadasApplication::autosaveFinished()
+{
+  reportAutosave( mAutosaveWatcher.result() );
+}
+
+void KadasApplication::reportAutosave( bool success )
+{
+  qint64 elapsed = mAutosaveElapsed.elapsed();
+  QgsDebugMsgLevel( QString( "Autosave: %1 after %2 ms (%3 ms on the GUI thread)" ).arg( success ? "done" : "failed" ).arg( elapsed ).arg( mAutosaveSerializeTime ), 1 );
+  if ( success )
+  {
+    mMainWindow->statusBar()->showMessage( tr( "Project autosaved (%1 ms)" ).arg( elapsed ), 3000 );
+  }
+  else
+  {
+    mMainWindow->statusBar()->showMessage( tr( "Autosaving project failed" ), 3000 );
+  }
+}
+
+void KadasApplication::cancelCapabilitiesPrefetch()
+{
+  if ( mCapabilitiesPrefetchTask )
+  {
+    mCapabilitiesPrefetchTask->cancel();
+  }
+  mCapabilitiesPrefetchTask.clear();
+}
+
 void KadasApplication::cleanupAutosave()
 {
   mAutosaveTimer.stop();
+  // Ensure a pending background write does not recreate the backup after it was removed
+  mAutosaveWatcher.waitForFinished();
   QFileInfo finfo( QgsProject::instance()->fileName() );
   if ( finfo.exists() )
   {
     QFile( finfo.dir().absoluteFilePath( QString( "~%1" ).arg( finfo.fileName() ) ) ).remove();
+    QFile( finfo.dir().absoluteFilePath( QString( "~%1.qgd" ).arg( finfo.completeBaseName() ) ) ).remove();
   }
 }
 
@@ -1447,9 +1601,18 @@ void KadasApplication::unsetMapTool()
 
 void KadasApplication::initAfterExec()
 {
-  // Update plugins
-  mainWindow()->pluginManager()->loadPlugins();
-  mainWindow()->pluginManager()->updateAllPlugins();
+  // Show news popup
+  KadasNewsPopup::showIfNewsAvailable();
+
+  // Update plugins once the plugin repository was fetched in the background
+  KadasPluginManager *pluginManager = mainWindow()->pluginManager();
+  mStartupProfiler->beginPhase( "plugin_repository" );
+  connect( pluginManager, &KadasPluginManager::pluginsLoaded, this, [this, pluginManager] {
+    mStartupProfiler->beginPhase( "plugin_updates" );
+    pluginManager->updateAllPlugins();
+    mStartupProfiler->endPhase();
+  } );
+  pluginManager->loadPlugins();
 }
 
 void KadasApplication::extentChanged()
@@ -1645,7 +1808,10 @@ void KadasApplication::loadPythonSupport()
 
 void KadasApplication::showPythonConsole()
 {
-  mPythonIntegration->showConsole();
+  if ( mPythonIntegration )
+  {
+    mPythonIntegration->showConsole();
+  }
 }
 
 QgsMessageOutput *KadasApplication::messageOutputViewer()
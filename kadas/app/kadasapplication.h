@@ -18,6 +18,10 @@
 #define KADASAPPLICATION_H
 
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QPointer>
 #include <QTimer>
 
 #include <qgis/qgis.h>
@@ -40,6 +44,7 @@ class QgsRasterLayer;
 class QgsVectorLayer;
 class QgsVectorTileLayer;
 
+class KadasCapabilitiesPrefetchTask;
 class KadasClipboard;
 class KadasGpxIntegration;
 class KadasLayerRefreshManager;
@@ -49,6 +54,7 @@ class KadasMessageLogViewer;
 class KadasPluginInterface;
 class KadasPythonIntegration;
 class KadasRedliningIntegration;
+class KadasStartupProfiler;
 
 #define kApp KadasApplication::instance()
 
@@ -79,6 +85,7 @@ class KadasApplication : public QgsApplication
     QgsVectorTileLayer *addVectorTileLayer( const QString &url, const QString &baseName, bool quiet = false );
     QgsPointCloudLayer *addPointCloudLayer( const QString &uri, const QString &baseName, const QString &providerKey, bool quiet = false );
     QPair<KadasMapItem *, KadasItemLayerRegistry::StandardLayer> addImageItem( const QString &filename ) const;
+    QList<QPair<KadasMapItem *, KadasItemLayerRegistry::StandardLayer>> addImageItems( const QStringList &filenames ) const;
     KadasItemLayer *selectPasteTargetItemLayer( const QList<KadasMapItem *> &items );
     bool askUserForDatumTransform( const QgsCoordinateReferenceSystem &sourceCrs, const QgsCoordinateReferenceSystem &destinationCrs, const QgsMapLayer *layer );
     bool checkTasksDependOnProject();
@@ -147,13 +154,21 @@ class KadasApplication : public QgsApplication
     QList<QgsMapLayerConfigWidgetFactory *> mMapLayerPanelFactories;
     QTimer mAutosaveTimer;
     bool mAutosaving = false;
+    QFutureWatcher<bool> mAutosaveWatcher;
+    qint64 mAutosaveSerializeTime = 0;
+    QElapsedTimer mAutosaveElapsed;
     QList<QgsPluginLayerType *> mKadasPluginLayerTypes;
     QTemporaryDir *mProjectTempDir = nullptr;
+    KadasStartupProfiler *mStartupProfiler = nullptr;
+    QFuture<void> mSslImportFuture;
+    QPointer<KadasCapabilitiesPrefetchTask> mCapabilitiesPrefetchTask;
 
     void loadPythonSupport();
     QString migrateDatasource( const QString &path ) const;
     DataSourceMigrations dataSourceMigrationMap() const;
+    void cancelCapabilitiesPrefetch();
     void cleanupAutosave();
+    void reportAutosave( bool success );
     int dialogPanelIndex( const QString &name, QStackedWidget *stackedWidget );
     void mergeChildSettingsGroups( QgsSettings &settings, QgsSettings &newSettings );
 
@@ -164,6 +179,7 @@ class KadasApplication : public QgsApplication
     void extractPortalToken();
     void loadStartupProject();
     void autosave();
+    void autosaveFinished();
     void onActiveLayerChanged( QgsMapLayer *layer );
     void onFocusChanged( QWidget * /*old*/, QWidget *now );
     void onMapToolChanged( QgsMapTool *newTool, QgsMapTool *oldTool );
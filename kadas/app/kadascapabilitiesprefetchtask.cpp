@@ -0,0 +1,155 @@
+/***************************************************************************
+    kadascapabilitiesprefetchtask.cpp
+    ---------------------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QApplication>
+#include <QFile>
+#include <QNetworkRequest>
+#include <QSet>
+#include <QXmlStreamReader>
+#include <QtConcurrentMap>
+#include <quazip/quazip.h>
+#include <quazip/quazipfile.h>
+
+#include <qgis/qgsapplication.h>
+#include <qgis/qgsblockingnetworkrequest.h>
+#include <qgis/qgsdatasourceuri.h>
+#include <qgis/qgslogger.h>
+#include <qgis/qgsziputils.h>
+
+#include "kadascapabilitiesprefetchtask.h"
+
+
+KadasCapabilitiesPrefetchTask::KadasCapabilitiesPrefetchTask( const QString &projectFile, const DatasourceMigrator &migrateDatasource )
+  : QgsTask( QApplication::translate( "KadasCapabilitiesPrefetchTask", "Prefetching layer capabilities" ) )
+  , mProjectFile( projectFile )
+  , mMigrateDatasource( migrateDatasource )
+{
+}
+
+KadasCapabilitiesPrefetchTask *KadasCapabilitiesPrefetchTask::start( const QString &projectFile, const DatasourceMigrator &migrateDatasource )
+{
+  KadasCapabilitiesPrefetchTask *task = new KadasCapabilitiesPrefetchTask( projectFile, migrateDatasource );
+  QgsApplication::taskManager()->addTask( task );
+  return task;
+}
+
+bool KadasCapabilitiesPrefetchTask::run()
+{
+  QList<CapabilitiesRequest> requests = capabilitiesRequests( readProjectData() );
+  if ( requests.isEmpty() || isCanceled() )
+  {
+    return !isCanceled();
+  }
+
+  // Fetch all capabilities concurrently, each request is aborted when the task is canceled
+  QgsDebugMsgLevel( QString( "Prefetching %1 capabilities documents" ).arg( requests.size() ), 1 );
+  QtConcurrent::blockingMap( requests, [this]( const CapabilitiesRequest &capabilitiesRequest ) {
+    if ( mFeedback.isCanceled() )
+    {
+      return;
+    }
+    QNetworkRequest request( capabilitiesRequest.url );
+    request.setAttribute( QNetworkRequest::CacheSaveControlAttribute, true );
+    // Same headers as the provider request, so that the cached response matches it
+    capabilitiesRequest.headers.updateNetworkRequest( request );
+    QgsBlockingNetworkRequest bnr;
+    bnr.setAuthCfg( capabilitiesRequest.authcfg );
+    if ( bnr.get( request, false, &mFeedback ) != QgsBlockingNetworkRequest::NoError )
+    {
+      QgsDebugMsgLevel( QString( "Prefetching %1 failed: %2" ).arg( capabilitiesRequest.url, bnr.errorMessage() ), 2 );
+    }
+  } );
+  return !isCanceled();
+}
+
+void KadasCapabilitiesPrefetchTask::cancel()
+{
+  mFeedback.cancel();
+  QgsTask::cancel();
+}
+
+QByteArray KadasCapabilitiesPrefetchTask::readProjectData() const
+{
+  QByteArray data;
+  if ( QgsZipUtils::isZipFile( mProjectFile ) )
+  {
+    QuaZip zip( mProjectFile );
+    if ( zip.open( QuaZip::mdUnzip ) )
+    {
+      for ( bool more = zip.goToFirstFile(); more; more = zip.goToNextFile() )
+      {
+        if ( zip.getCurrentFileName().endsWith( ".qgs", Qt::CaseInsensitive ) )
+        {
+          QuaZipFile zipFile( &zip );
+          if ( zipFile.open( QIODevice::ReadOnly ) )
+          {
+            data = zipFile.readAll();
+          }
+          break;
+        }
+      }
+    }
+  }
+  else
+  {
+    QFile file( mProjectFile );
+    if ( file.open( QIODevice::ReadOnly ) )
+    {
+      data = file.readAll();
+    }
+  }
+  return data;
+}
+
+QList<KadasCapabilitiesPrefetchTask::CapabilitiesRequest> KadasCapabilitiesPrefetchTask::capabilitiesRequests( const QByteArray &data ) const
+{
+  QList<CapabilitiesRequest> requests;
+  QSet<QString> urls;
+  QXmlStreamReader reader( data );
+  while ( !reader.atEnd() && !isCanceled() )
+  {
+    if ( reader.readNext() != QXmlStreamReader::StartElement || reader.name() != QLatin1String( "datasource" ) )
+    {
+      continue;
+    }
+    QgsDataSourceUri uri;
+    uri.setEncodedUri( mMigrateDatasource( reader.readElementText() ) );
+    QString url = uri.param( "url" );
+    if ( !uri.hasParam( "layers" ) || uri.param( "type" ) == "xyz" || !url.startsWith( "http", Qt::CaseInsensitive ) )
+    {
+      continue;
+    }
+    // Build the URL as the QGIS WMS provider does, so that it is served the prefetched response from the network cache
+    if ( !url.contains( "SERVICE=WMTS", Qt::CaseInsensitive ) && !url.contains( "/WMTSCapabilities.xml", Qt::CaseInsensitive ) )
+    {
+      if ( !url.contains( "?" ) )
+      {
+        url += "?";
+      }
+      else if ( !url.endsWith( "?" ) && !url.endsWith( "&" ) )
+      {
+        url += "&";
+      }
+      url += "SERVICE=WMS&REQUEST=GetCapabilities";
+    }
+    if ( !urls.contains( url ) )
+    {
+      urls.insert( url );
+      requests.append( { url, uri.authConfigId(), uri.httpHeaders() } );
+    }
+  }
+  return requests;
+}
@@ -0,0 +1,64 @@
+/***************************************************************************
+    kadascapabilitiesprefetchtask.h
+    -------------------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASCAPABILITIESPREFETCHTASK_H
+#define KADASCAPABILITIESPREFETCHTASK_H
+
+#include <functional>
+
+#include <qgis/qgsfeedback.h>
+#include <qgis/qgshttpheaders.h>
+#include <qgis/qgstaskmanager.h>
+
+/**
+ * Requests the capabilities documents of all WMS/WMTS layers of a project
+ * concurrently in the background, while the project is being read. The WMS
+ * provider then gets them from the network cache instead of fetching them one
+ * after another. Canceling the task aborts all pending requests.
+ */
+class KadasCapabilitiesPrefetchTask : public QgsTask
+{
+    Q_OBJECT
+
+  public:
+    //! Migrates a datasource of the project file to its current form
+    typedef std::function<QString( const QString & )> DatasourceMigrator;
+
+    KadasCapabilitiesPrefetchTask( const QString &projectFile, const DatasourceMigrator &migrateDatasource );
+
+    //! Starts prefetching the capabilities of the project in the application task manager
+    static KadasCapabilitiesPrefetchTask *start( const QString &projectFile, const DatasourceMigrator &migrateDatasource );
+
+    bool run() override;
+    void cancel() override;
+
+  private:
+    struct CapabilitiesRequest
+    {
+        QString url;
+        QString authcfg;
+        QgsHttpHeaders headers;
+    };
+
+    QString mProjectFile;
+    DatasourceMigrator mMigrateDatasource;
+    QgsFeedback mFeedback;
+
+    QByteArray readProjectData() const;
+    QList<CapabilitiesRequest> capabilitiesRequests( const QByteArray &data ) const;
+};
+
+#endif // KADASCAPABILITIESPREFETCHTASK_H
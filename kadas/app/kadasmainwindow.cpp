@@ -575,6 +575,7 @@ void KadasMainWindow::dropEvent( QDropEvent *event )
       { "tiff", "tfw" }
     };
 
+    QStringList imageItemFiles;
     for ( const QUrl &url : event->mimeData()->urls() )
     {
       QString fileName = url.toLocalFile();
@@ -609,8 +610,7 @@ void KadasMainWindow::dropEvent( QDropEvent *event )
       }
       if ( addAsMapItem )
       {
-        QPair<KadasMapItem *, KadasItemLayerRegistry::StandardLayer> pair = kApp->addImageItem( fileName );
-        KadasItemLayerRegistry::getOrCreateItemLayer( pair.second )->addItem( pair.first );
+        imageItemFiles.append( fileName );
       }
       else
       {
@@ -618,6 +618,14 @@ void KadasMainWindow::dropEvent( QDropEvent *event )
         KadasAppLayerHandling::openLayer( fileName, ok, true, true );
       }
     }
+    // Add all image items at once, so that picture footprints are computed in parallel
+    if ( !imageItemFiles.isEmpty() )
+    {
+      for ( const QPair<KadasMapItem *, KadasItemLayerRegistry::StandardLayer> &pair : kApp->addImageItems( imageItemFiles ) )
+      {
+        KadasItemLayerRegistry::getOrCreateItemLayer( pair.second )->addItem( pair.first );
+      }
+    }
   }
 }
 
@@ -104,18 +104,37 @@ KadasPluginManager::KadasPluginManager( QgsMapCanvas *canvas, QAction *action )
 
 void KadasPluginManager::loadPlugins()
 {
-  KadasPythonIntegration *p = KadasApplication::instance()->pythonIntegration();
-  if ( !p )
+  if ( !KadasApplication::instance()->pythonIntegration() )
   {
     qWarning() << "KadasPluginManager needs the python integration";
     return;
   }
 
+  QgsSettings s;
+  QString repoUrl = s.value( "/PythonPluginRepository/repositoryUrl", "http://pkg.sourcepole.ch/kadas/plugins/qgis-repo.xml" ).toString();
+  QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( QNetworkRequest( QUrl( repoUrl ) ) );
+  connect( reply, &QNetworkReply::finished, this, [this, reply, repoUrl] {
+    reply->deleteLater();
+    if ( reply->error() == QNetworkReply::NoError )
+    {
+      mAvailablePlugins = parseAvailablePlugins( reply->readAll(), repoUrl );
+    }
+    else
+    {
+      mAvailablePlugins.clear();
+    }
+    populatePluginLists();
+    emit pluginsLoaded();
+  } );
+}
+
+void KadasPluginManager::populatePluginLists()
+{
+  KadasPythonIntegration *p = KadasApplication::instance()->pythonIntegration();
+
   mInstalledTreeWidget->clear();
   mAvailableTreeWidget->clear();
 
-  mAvailablePlugins = availablePlugins();
-
   //detect user plugins
   QDir userPluginDir( p->homePluginsPath() );
   QStringList installedUserPlugins = userPluginDir.entryList( QDir::Dirs | QDir::NoDotAndDotDot );
@@ -225,24 +244,10 @@ KadasPluginManager::KadasPluginManager()
 {
 }
 
-QMap<QString, KadasPluginManager::PluginInfo> KadasPluginManager::availablePlugins()
+QMap<QString, KadasPluginManager::PluginInfo> KadasPluginManager::parseAvailablePlugins( const QByteArray &response, const QString &repoUrl )
 {
-  QgsSettings s;
-  QString repoUrl = s.value( "/PythonPluginRepository/repositoryUrl", "http://pkg.sourcepole.ch/kadas/plugins/qgis-repo.xml" ).toString();
-  QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( QNetworkRequest( QUrl( repoUrl ) ) );
-  QEventLoop evLoop;
-  connect( reply, &QNetworkReply::finished, &evLoop, &QEventLoop::quit );
-  evLoop.exec( QEventLoop::ExcludeUserInputEvents );
-  reply->deleteLater();
-
   QMap<QString, PluginInfo> pluginMap;
 
-  if ( reply->error() != QNetworkReply::NoError )
-  {
-    return pluginMap;
-  }
-  QByteArray response = reply->readAll();
-
   QDomDocument xml;
   QJsonParseError err;
 
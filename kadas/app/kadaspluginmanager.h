@@ -53,9 +53,13 @@ class KadasPluginManager : public KadasBottomBar, private Ui::KadasPluginManager
   public:
     KadasPluginManager( QgsMapCanvas *canvas, QAction *action );
 
+    // Fetches the plugin repository in the background, pluginsLoaded is emitted once done
     void loadPlugins();
     void updateAllPlugins();
 
+  signals:
+    void pluginsLoaded();
+
   private slots:
     void installButtonClicked();
     void updateButtonClicked();
@@ -78,7 +82,8 @@ class KadasPluginManager : public KadasBottomBar, private Ui::KadasPluginManager
 
     QMap<QString, PluginInfo> mAvailablePlugins;
 
-    QMap<QString, PluginInfo> availablePlugins();
+    void populatePluginLists();
+    static QMap<QString, PluginInfo> parseAvailablePlugins( const QByteArray &response, const QString &repoUrl );
     bool installPlugin( const QString &pluginName, const QString &downloadUrl, const QString &pluginTooltip, const QString &pluginVersion, KadasPluginManagerInstallButton *b );
     bool uninstallPlugin( const QString &pluginName, const QString &moduleName, KadasPluginManagerInstallButton *b );
     bool updatePlugin( const QString &pluginName, const QString &moduleName, const QString &downloadUrl, const QString &pluginTooltip, const QString &pluginVersion, KadasPluginManagerInstallButton *b );
@@ -0,0 +1,118 @@
+/***************************************************************************
+    kadasstartupprofiler.cpp
+    ------------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <qgis/qgslogger.h>
+
+#include "kadas/core/kadas.h"
+#include "kadasstartupprofiler.h"
+
+
+KadasStartupProfiler::KadasStartupProfiler( const QStringList &arguments )
+{
+  QString defaultOutputFile = QDir( Kadas::configPath() ).absoluteFilePath( "startup_profile.json" );
+  for ( const QString &argument : arguments )
+  {
+    if ( argument == COMMAND_LINE_OPTION )
+    {
+      mOutputFile = defaultOutputFile;
+    }
+    else if ( argument.startsWith( QString( "%1=" ).arg( COMMAND_LINE_OPTION ) ) )
+    {
+      mOutputFile = argument.mid( argument.indexOf( '=' ) + 1 );
+    }
+  }
+  if ( mOutputFile.isEmpty() && qEnvironmentVariableIsSet( "KADAS_PROFILE_STARTUP" ) )
+  {
+    mOutputFile = qEnvironmentVariable( "KADAS_PROFILE_STARTUP" );
+    if ( mOutputFile.isEmpty() || mOutputFile == "1" )
+    {
+      mOutputFile = defaultOutputFile;
+    }
+  }
+  mTimer.start();
+}
+
+void KadasStartupProfiler::beginPhase( const QString &name )
+{
+  endPhase();
+  Phase phase;
+  phase.name = name;
+  phase.start = mTimer.elapsed();
+  mPhases.append( phase );
+}
+
+void KadasStartupProfiler::endPhase()
+{
+  if ( mPhases.isEmpty() || mPhases.last().duration >= 0 )
+  {
+    return;
+  }
+  Phase &phase = mPhases.last();
+  phase.duration = mTimer.elapsed() - phase.start;
+  QgsDebugMsgLevel( QString( "Startup phase %1 took %2 ms" ).arg( phase.name ).arg( phase.duration ), 1 );
+  if ( mUsableAfter >= 0 )
+  {
+    write();
+  }
+}
+
+void KadasStartupProfiler::finish()
+{
+  endPhase();
+  if ( mUsableAfter < 0 )
+  {
+    mUsableAfter = mTimer.elapsed();
+    QgsDebugMsgLevel( QString( "Startup: application usable after %1 ms" ).arg( mUsableAfter ), 1 );
+    write();
+  }
+}
+
+void KadasStartupProfiler::write() const
+{
+  if ( !isEnabled() )
+  {
+    return;
+  }
+  QJsonArray phases;
+  for ( const Phase &phase : mPhases )
+  {
+    QJsonObject entry;
+    entry["name"] = phase.name;
+    entry["start_ms"] = phase.start;
+    entry["duration_ms"] = phase.duration;
+    phases.append( entry );
+  }
+  QJsonObject profile;
+  profile["version"] = Kadas::KADAS_FULL_RELEASE_NAME;
+  profile["usable_after_ms"] = mUsableAfter;
+  profile["phases"] = phases;
+
+  QFile file( mOutputFile );
+  if ( file.open( QIODevice::WriteOnly ) )
+  {
+    file.write( QJsonDocument( profile ).toJson() );
+  }
+  else
+  {
+    QgsDebugMsgLevel( QString( "Could not write startup profile to %1" ).arg( mOutputFile ), 1 );
+  }
+}
@@ -0,0 +1,63 @@
+/***************************************************************************
+    kadasstartupprofiler.h
+    ----------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASSTARTUPPROFILER_H
+#define KADASSTARTUPPROFILER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+/**
+ * Records the duration of the application startup phases.
+ *
+ * Profiling is enabled by passing --profile-startup[=<file>] on the command line,
+ * or by setting KADAS_PROFILE_STARTUP=<file>. The phase breakdown is then written
+ * as JSON to the specified file, or to startup_profile.json in the config dir.
+ */
+class KadasStartupProfiler
+{
+  public:
+    static constexpr const char *COMMAND_LINE_OPTION = "--profile-startup";
+
+    KadasStartupProfiler( const QStringList &arguments );
+
+    bool isEnabled() const { return !mOutputFile.isEmpty(); }
+
+    // Starts a new phase, the previous phase is ended
+    void beginPhase( const QString &name );
+    void endPhase();
+
+    // Marks the application as usable and writes the profile, phases ending later update the written profile
+    void finish();
+
+  private:
+    struct Phase
+    {
+        QString name;
+        qint64 start = 0;
+        qint64 duration = -1;
+    };
+
+    QString mOutputFile;
+    QElapsedTimer mTimer;
+    QList<Phase> mPhases;
+    qint64 mUsableAfter = -1;
+
+    void write() const;
+};
+
+#endif // KADASSTARTUPPROFILER_H
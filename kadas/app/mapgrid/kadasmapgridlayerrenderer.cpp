@@ -14,21 +14,22 @@
  *                                                                         *
  ***************************************************************************/
 
-#include <QApplication>
-#include <QDesktopWidget>
 #include <QPainter>
 #include <qgsrendercontext.h>
 #include <qgsgeometryutils.h>
 
 #include "kadasmapgridlayerrenderer.h"
 #include "kadas/core/kadaslatlontoutm.h"
+#include "kadas/gui/kadasrendersnapshot.h"
 
 
 KadasMapGridLayerRenderer::KadasMapGridLayerRenderer( KadasMapGridLayer *layer, QgsRenderContext &rendererContext )
   : QgsMapLayerRenderer( layer->id(), &rendererContext )
   , mRenderGridConfig( layer->gridConfig() )
   , mRenderOpacity( layer->opacity() )
-{}
+{
+  KadasRenderSnapshot::capture().store( rendererContext );
+}
 
 bool KadasMapGridLayerRenderer::render()
 {
@@ -199,7 +200,7 @@ void KadasMapGridLayerRenderer::drawCrsGrid( const QString &crs, double segmentL
 
   if ( drawLabels && mRenderGridConfig.labelingMode == KadasMapGridLayer::LabelingEnabled )
   {
-    double dpiScale = double( renderContext()->painter()->device()->logicalDpiX() ) / qApp->desktop()->logicalDpiX();
+    double dpiScale = KadasRenderSnapshot::outputDpiScale( *renderContext() );
     QFont font = renderContext()->painter()->font();
     font.setBold( true );
     font.setPointSizeF( mRenderGridConfig.fontSize * dpiScale );
@@ -348,7 +349,7 @@ void KadasMapGridLayerRenderer::drawMgrsGrid()
 
   double gridLabelSize = mRenderGridConfig.fontSize;
   QColor bufferColor = ( 0.2126 * mRenderGridConfig.color.red() + 0.7152 * mRenderGridConfig.color.green() + 0.0722 * mRenderGridConfig.color.blue() ) > 128 ? Qt::black : Qt::white;
-  double dpiScale = double( renderContext()->painter()->device()->logicalDpiX() ) / qApp->desktop()->logicalDpiX();
+  double dpiScale = KadasRenderSnapshot::outputDpiScale( *renderContext() );
   renderContext()->painter()->setBrush( mRenderGridConfig.color );
 
   QFont font = renderContext()->painter()->font();
@@ -19,10 +19,15 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QPlainTextEdit>
+#include <QPointer>
+#include <QProgressDialog>
 #include <QSlider>
 #include <QTabWidget>
 #include <quazip/quazipfile.h>
 
+#include <memory>
+
+#include <qgis/qgsapplication.h>
 #include <qgis/qgslogger.h>
 #include <qgis/qgsmessagebar.h>
 #include <qgis/qgsproject.h>
@@ -31,6 +36,7 @@
 #include "kadas/gui/maptools/kadasmaptoolcreateitem.h"
 #include "kadas/gui/milx/kadasmilxclient.h"
 #include "kadas/gui/milx/kadasmilxeditor.h"
+#include "kadas/gui/milx/kadasmilximporttask.h"
 #include "kadas/gui/milx/kadasmilxitem.h"
 #include "kadas/gui/milx/kadasmilxlayer.h"
 #include "kadas/gui/milx/kadasmilxlayerpropertiespage.h"
@@ -525,103 +531,67 @@ void KadasMilxIntegration::openMilxly()
   }
   QgsSettings().setValue( "/UI/lastImportExportDir", QFileInfo( filename ).absolutePath() );
 
-  QString errorMsg;
-  if ( !importMilxly( filename, errorMsg ) )
-  {
-    kApp->mainWindow()->messageBar()->pushMessage( tr( "MilX import failed" ), errorMsg, Qgis::Critical, 5 );
-  }
-  else
-  {
-    kApp->mainWindow()->messageBar()->pushMessage( tr( "MilX import completed" ), "", Qgis::Info, 5 );
-  }
+  importMilxly( filename );
 }
 
-bool KadasMilxIntegration::importMilxly( const QString &filename, QString &errorMsg )
+void KadasMilxIntegration::importMilxly( const QString &filename )
 {
-  QIODevice *dev = 0;
-  if ( filename.endsWith( ".milxlyz", Qt::CaseInsensitive ) )
-  {
-    dev = new QuaZipFile( filename, "Layer.milxly", QuaZip::csInsensitive );
-  }
-  else
-  {
-    dev = new QFile( filename );
-  }
-  if ( !dev->open( QIODevice::ReadOnly ) )
-  {
-    delete dev;
-    errorMsg = tr( "Failed to open the input file." );
-    return false;
-  }
-  QString inputXml = QString::fromUtf8( dev->readAll().data() );
-  delete dev;
-  QString outputXml;
-  bool valid = false;
-  QString messages;
-  if ( !KadasMilxClient::upgradeMilXFile( inputXml, outputXml, valid, messages ) )
-  {
-    errorMsg = tr( "Failed to read input file." );
-    return false;
-  }
-  if ( !valid )
-  {
-    if ( !messages.isEmpty() )
-    {
-      showMessageDialog( tr( "Import Failed" ), tr( "The import failed:" ), messages );
-    }
-    errorMsg = tr( "MilX upgrade failed" );
-    return false;
-  }
-
-  QDomDocument doc;
-  doc.setContent( outputXml );
-
-  if ( doc.isNull() )
-  {
-    errorMsg = tr( "The file could not be parsed." );
-    return false;
-  }
-
-  QDomElement milxDocumentEl = doc.firstChildElement( "MilXDocument_Layer" );
-  QDomElement milxVersionEl = milxDocumentEl.firstChildElement( "MssLibraryVersionTag" );
-  QString fileMssVer = milxVersionEl.text();
-
-  QString verTag;
-  KadasMilxClient::getCurrentLibraryVersionTag( verTag );
-  if ( fileMssVer != verTag )
-  {
-    errorMsg = tr( "Unexpected MSS library version tag." );
-    return false;
-  }
   int dpi = kApp->mainWindow()->mapCanvas()->mapSettings().outputDpi();
+  KadasMilxImportTask *task = new KadasMilxImportTask( filename, dpi );
+
+  QPointer<QProgressDialog> progress = new QProgressDialog( tr( "Importing %1..." ).arg( QFileInfo( filename ).fileName() ), tr( "Abort" ), 0, 100, kApp->mainWindow() );
+  progress->setWindowTitle( tr( "MilX import" ) );
+  progress->setAttribute( Qt::WA_DeleteOnClose );
+  progress->setMinimumDuration( 500 );
+  connect( progress, &QProgressDialog::canceled, task, &QgsTask::cancel );
+  connect( task, &QgsTask::progressChanged, progress, [progress]( double value ) {
+    progress->setValue( value );
+  } );
 
-  QDomNodeList milxLayerEls = milxDocumentEl.elementsByTagName( "MilXLayer" );
-  QList<KadasMilxLayer *> importedLayers;
-  QList<QPair<QString, QString>> cartouches;
-  for ( int iLayer = 0, nLayers = milxLayerEls.count(); iLayer < nLayers; ++iLayer )
-  {
-    QDomElement milxLayerEl = milxLayerEls.at( iLayer ).toElement();
-    KadasMilxLayer *layer = new KadasMilxLayer();
-    if ( !layer->importFromMilxly( milxLayerEl, dpi, errorMsg ) )
+  // Layers are added to the project with their first chunk of items and populated progressively
+  std::shared_ptr<QList<QPointer<KadasMilxLayer>>> layers = std::make_shared<QList<QPointer<KadasMilxLayer>>>();
+  auto addChunks = [task, layers] {
+    for ( const KadasMilxImportTask::Chunk &chunk : task->takeChunks() )
     {
-      break;
+      while ( layers->size() <= chunk.layer )
+      {
+        KadasMilxImportTask::LayerInfo info = task->layerInfo( layers->size() );
+        KadasMilxLayer *layer = new KadasMilxLayer( info.name );
+        layer->setApproved( info.approved );
+        QgsProject::instance()->addMapLayer( layer );
+        layers->append( layer );
+      }
+      KadasMilxLayer *layer = layers->at( chunk.layer );
+      if ( !layer )
+      {
+        // Removed by the user meanwhile
+        qDeleteAll( chunk.items );
+        continue;
+      }
+      for ( KadasMilxItem *item : chunk.items )
+      {
+        layer->addItem( item );
+      }
     }
-    importedLayers.append( layer );
-    QDomNodeList cartoucheEls = milxLayerEl.elementsByTagName( "Legend" );
-    if ( !cartoucheEls.isEmpty() )
+  };
+  connect( task, &KadasMilxImportTask::chunksAvailable, task, addChunks );
+
+  connect( task, &QgsTask::taskCompleted, task, [task, layers, addChunks, progress] {
+    addChunks();
+    if ( progress )
     {
-      QString cartouche;
-      QTextStream ts( &cartouche );
-      cartoucheEls.at( 0 ).save( ts, 2 );
-      cartouches.append( qMakePair( layer->name(), cartouche ) );
+      progress->close();
     }
-  }
+    kApp->mainWindow()->messageBar()->pushMessage( tr( "MilX import completed" ), "", Qgis::Info, 5 );
 
-  if ( errorMsg.isEmpty() )
-  {
-    for ( KadasMilxLayer *layer : importedLayers )
+    QList<QPair<QString, QString>> cartouches;
+    for ( int i = 0, n = layers->size(); i < n; ++i )
     {
-      QgsProject::instance()->addMapLayer( layer );
+      KadasMilxImportTask::LayerInfo info = task->layerInfo( i );
+      if ( !info.cartouche.isEmpty() )
+      {
+        cartouches.append( qMakePair( info.name, info.cartouche ) );
+      }
     }
     if ( !cartouches.isEmpty() )
     {
@@ -652,16 +622,37 @@ bool KadasMilxIntegration::importMilxly( const QString &filename, QString &error
       }
     }
 
-    if ( !messages.isEmpty() )
+    if ( !task->messages().isEmpty() )
     {
-      showMessageDialog( tr( "Import Messages" ), tr( "The following messages were emitted while importing:" ), messages );
+      showMessageDialog( tr( "Import Messages" ), tr( "The following messages were emitted while importing:" ), task->messages() );
     }
-  }
-  else
-  {
-    qDeleteAll( importedLayers );
-  }
-  return true;
+  } );
+
+  connect( task, &QgsTask::taskTerminated, task, [task, layers, progress] {
+    if ( progress )
+    {
+      progress->close();
+    }
+    // The import is all or nothing, drop the layers populated so far
+    for ( const QPointer<KadasMilxLayer> &layer : std::as_const( *layers ) )
+    {
+      if ( layer )
+      {
+        QgsProject::instance()->removeMapLayer( layer->id() );
+      }
+    }
+    if ( task->isCanceled() )
+    {
+      return;
+    }
+    kApp->mainWindow()->messageBar()->pushMessage( tr( "MilX import failed" ), task->errorMessage(), Qgis::Critical, 5 );
+    if ( !task->messages().isEmpty() )
+    {
+      showMessageDialog( tr( "Import Failed" ), tr( "The import failed:" ), task->messages() );
+    }
+  } );
+
+  QgsApplication::taskManager()->addTask( task );
 }
 
 void KadasMilxIntegration::showMessageDialog( const QString &title, const QString &body, const QString &messages )
@@ -698,26 +689,11 @@ bool KadasMilxDropHandler::handleMimeDataV2( const QMimeData *data )
   for ( const QUrl &url : data->urls() )
   {
     QString path = url.toLocalFile();
-    QStringList errors;
     if ( path.endsWith( ".milxly", Qt::CaseInsensitive ) || path.endsWith( ".milxlyz", Qt::CaseInsensitive ) )
     {
+      // Completion and errors are reported by the import
       ++handled;
-      QString errMsg;
-      if ( !KadasMilxIntegration::importMilxly( path, errMsg ) )
-      {
-        errors.append( QString( "%1: %2" ).arg( QFileInfo( path ).fileName() ).arg( errMsg ) );
-      }
-    }
-    if ( handled > 0 )
-    {
-      if ( errors.isEmpty() )
-      {
-        kApp->mainWindow()->messageBar()->pushMessage( tr( "MilX import completed" ), Qgis::Info, 5 );
-      }
-      else
-      {
-        QMessageBox::critical( kApp->mainWindow(), tr( "MilX import failed" ), tr( "The following files could not be imported:\n%1" ).arg( errors.join( "\n" ) ) );
-      }
+      KadasMilxIntegration::importMilxly( path );
     }
   }
   return handled > 0;
@@ -73,7 +73,8 @@ class KadasMilxIntegration : public QObject
     KadasMilxIntegration( const MilxUi &ui, QObject *parent = nullptr );
     ~KadasMilxIntegration();
 
-    static bool importMilxly( const QString &filename, QString &errorMsg );
+    //! Imports the MilX layers of the file in the background, reporting completion or errors in the message bar
+    static void importMilxly( const QString &filename );
 
   private:
     MilxUi mUi;
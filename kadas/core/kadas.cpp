@@ -188,6 +188,13 @@ GDALDatasetH Kadas::gdalOpenForLayer( const QgsRasterLayer *layer, QString *errM
     }
   }
 
+  return gdalOpenLayerSource( providerType, layerSource, errMsg );
+}
+
+GDALDatasetH Kadas::gdalOpenLayerSource( const QString &providerType, const QString &layerSource, QString *errMsg )
+{
+  QgsDataSourceUri uri;
+  uri.setEncodedUri( layerSource );
   if ( providerType == "gdal" )
   {
     return GDALOpen( layerSource.toUtf8().data(), GA_ReadOnly );
@@ -70,6 +70,9 @@ class KADAS_CORE_EXPORT Kadas
     // Returns gdal source string for raster layer or null string in case of error
     static GDALDatasetH gdalOpenForLayer( const QgsRasterLayer *layer, QString *errMsg = nullptr );
 
+    // Opens the source of a raster layer as gdalOpenForLayer, but without setting up the GDAL proxy environment, can be called from any thread
+    static GDALDatasetH gdalOpenLayerSource( const QString &providerType, const QString &layerSource, QString *errMsg = nullptr );
+
     // Import SSL certificates from the certificate directory and from the system store (on Windows)
     static void importSslCertificates();
 };
@@ -14,7 +14,13 @@
  *                                                                         *
  ***************************************************************************/
 
-#include <gdal.h>
+#include <QCache>
+#include <QMutex>
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+
 #include <zonedetect/zonedetect.h>
 
 #include <qgis/qgscoordinateformatter.h>
@@ -24,110 +30,199 @@
 
 #include "kadas/core/kadas.h"
 #include "kadas/core/kadascoordinateutils.h"
+#include "kadas/core/kadasheightmap.h"
 #include "kadas/core/kadaslatlontoutm.h"
 
+
+// Long-lived handle to the project heightmap, reopened whenever the heightmap layer or its source changes
+struct HeightmapCache
+{
+    QMutex mutex;
+    QString layerId;
+    QString layerSource;
+    std::unique_ptr<KadasHeightmap> heightmap;
+    QString errMsg;
+    QgsCoordinateReferenceSystem crs;
+    QgsCoordinateTransformContext transformContext;
+    QgsCoordinateTransform transform;
+};
+
+static HeightmapCache &heightmapCache()
+{
+  static HeightmapCache cache;
+  return cache;
+}
+
 double KadasCoordinateUtils::getHeightAtPos( const QgsPointXY &p, const QgsCoordinateReferenceSystem &crs, Qgis::DistanceUnit unit, QString *errMsg )
 {
+  return getHeightsAtPos( QVector<QgsPointXY>() << p, crs, unit, errMsg ).front();
+}
+
+QVector<double> KadasCoordinateUtils::getHeightsAtPos( const QVector<QgsPointXY> &points, const QgsCoordinateReferenceSystem &crs, Qgis::DistanceUnit unit, QString *errMsg )
+{
+  QVector<double> heights( points.size(), 0 );
+
+  HeightmapCache &cache = heightmapCache();
+  QMutexLocker locker( &cache.mutex );
+
   QString layerid = QgsProject::instance()->readEntry( "Heightmap", "layer" );
   QgsMapLayer *layer = QgsProject::instance()->mapLayer( layerid );
-  if ( !layer || layer->type() != Qgis::LayerType::Raster )
+  QString layerSource = layer ? layer->source() : QString();
+  if ( !cache.heightmap || layerid != cache.layerId || layerSource != cache.layerSource )
+  {
+    cache.layerId = layerid;
+    cache.layerSource = layerSource;
+    cache.errMsg.clear();
+    cache.heightmap.reset( new KadasHeightmap( &cache.errMsg ) );
+    cache.crs = QgsCoordinateReferenceSystem();
+  }
+  if ( !cache.heightmap->isValid() )
   {
     if ( errMsg )
     {
-      *errMsg = QObject::tr( "No heightmap is defined in the project. Right-click a raster layer in the layer tree and select it to be used as heightmap." );
+      *errMsg = cache.errMsg;
     }
-    return 0;
+    return heights;
   }
 
-  GDALDatasetH raster = Kadas::gdalOpenForLayer( static_cast<QgsRasterLayer *>( layer ), errMsg );
-  if ( !raster )
+  QgsCoordinateTransformContext transformContext = QgsProject::instance()->transformContext();
+  if ( crs != cache.crs || transformContext != cache.transformContext )
   {
-    return 0;
+    cache.crs = crs;
+    cache.transformContext = transformContext;
+    cache.transform = QgsCoordinateTransform( crs, cache.heightmap->crs(), transformContext );
   }
 
-  double gtrans[6] = {};
-  if ( GDALGetGeoTransform( raster, &gtrans[0] ) != CE_None )
+  double heightConversion = QgsUnitTypes::fromUnitToUnitFactor( Qgis::DistanceUnit::Meters, unit );
+  for ( int i = 0, n = points.size(); i < n; ++i )
   {
-    if ( errMsg )
+    bool ok = false;
+    double height = cache.heightmap->heightAt( cache.transform.transform( points[i] ), &ok );
+    if ( !ok )
     {
-      *errMsg = QObject::tr( "Failed to get raster geotransform" );
+      if ( errMsg )
+      {
+        *errMsg = QObject::tr( "Failed to read pixel values" );
+      }
+      continue;
     }
-    GDALClose( raster );
-    return 0;
+    heights[i] = height * heightConversion;
   }
+  return heights;
+}
 
-  QString proj( GDALGetProjectionRef( raster ) );
-  QgsCoordinateReferenceSystem rasterCrs = QgsCoordinateReferenceSystem::fromWkt( proj );
-  if ( !rasterCrs.isValid() )
-  {
-    if ( errMsg )
+// Process-wide timezone database, kept open (and thus mapped) for the lifetime of the application
+struct TimezoneDatabase
+{
+    ~TimezoneDatabase()
     {
-      *errMsg = QObject::tr( "Failed to get raster CRS" );
+      if ( zd )
+      {
+        ZDCloseDatabase( zd );
+      }
     }
-    GDALClose( raster );
-    return 0;
-  }
 
-  GDALRasterBandH band = GDALGetRasterBand( raster, 1 );
-  if ( !raster )
+    // Size of the lookup cache cells, in degrees
+    static constexpr double sCellSize = 0.01;
+
+    QMutex mutex;
+    ZoneDetect *zd = nullptr;
+    bool initialized = false;
+    QCache<quint64, QByteArray> cellCache { 10000 };
+    QgsCoordinateReferenceSystem crs;
+    QgsCoordinateTransformContext transformContext;
+    QgsCoordinateTransform transform;
+};
+
+static TimezoneDatabase &timezoneDatabase()
+{
+  static TimezoneDatabase database;
+  return database;
+}
+
+// The zone name of the first lookup result, composed like ZDHelperSimpleLookupString does
+static QByteArray zoneName( const ZoneDetectResult *results )
+{
+  if ( !results || results[0].lookupResult == ZD_LOOKUP_END )
   {
-    if ( errMsg )
+    return QByteArray();
+  }
+  QByteArray prefix;
+  QByteArray id;
+  for ( unsigned int i = 0; i < results[0].numFields; ++i )
+  {
+    if ( !results[0].fieldNames[i] || !results[0].data[i] )
+    {
+      continue;
+    }
+    if ( std::strcmp( results[0].fieldNames[i], "TimezoneIdPrefix" ) == 0 )
     {
-      *errMsg = QObject::tr( "Failed to open raster band 0" );
+      prefix = results[0].data[i];
+    }
+    else if ( std::strcmp( results[0].fieldNames[i], "TimezoneId" ) == 0 || std::strcmp( results[0].fieldNames[i], "Name" ) == 0 )
+    {
+      id = results[0].data[i];
     }
-    GDALClose( raster );
-    return 0;
   }
+  return prefix + id;
+}
 
-  // Get vertical unit
-  Qgis::DistanceUnit vertUnit = strcmp( GDALGetRasterUnitType( band ), "ft" ) == 0 ? Qgis::DistanceUnit::Feet : Qgis::DistanceUnit::Meters;
-
-  // Transform geo position to raster CRS
-  QgsPointXY pRaster = QgsCoordinateTransform( crs, rasterCrs, QgsProject::instance() ).transform( p );
+QByteArray KadasCoordinateUtils::getTimezoneAtPos( const QgsPointXY &p, const QgsCoordinateReferenceSystem &crs )
+{
+  return getTimezonesAtPos( QVector<QgsPointXY>() << p, crs ).front();
+}
 
-  // Transform raster geo position to pixel coordinates
-  double row = ( -gtrans[0] * gtrans[4] + gtrans[1] * gtrans[3] - gtrans[1] * pRaster.y() + gtrans[4] * pRaster.x() ) / ( gtrans[2] * gtrans[4] - gtrans[1] * gtrans[5] );
-  double col = ( -gtrans[0] * gtrans[5] + gtrans[2] * gtrans[3] - gtrans[2] * pRaster.y() + gtrans[5] * pRaster.x() ) / ( gtrans[1] * gtrans[5] - gtrans[2] * gtrans[4] );
+QList<QByteArray> KadasCoordinateUtils::getTimezonesAtPos( const QVector<QgsPointXY> &points, const QgsCoordinateReferenceSystem &crs )
+{
+  QList<QByteArray> zones;
 
-  double pixValues[4] = {};
-  if ( CE_None != GDALRasterIO( band, GF_Read, std::floor( col ), std::floor( row ), 2, 2, &pixValues[0], 2, 2, GDT_Float64, 0, 0 ) )
+  TimezoneDatabase &database = timezoneDatabase();
+  QMutexLocker locker( &database.mutex );
+  if ( !database.initialized )
   {
-    if ( errMsg )
+    QString db = QDir( Kadas::pkgResourcePath() ).absoluteFilePath( "timezone21.bin" );
+    database.zd = ZDOpenDatabase( db.toLocal8Bit().data() );
+    database.initialized = true;
+  }
+  if ( !database.zd )
+  {
+    for ( int i = 0, n = points.size(); i < n; ++i )
     {
-      *errMsg = QObject::tr( "Failed to read pixel values" );
+      zones.append( "" );
     }
-    GDALClose( raster );
-    return 0;
+    return zones;
   }
 
-  GDALClose( raster );
-
-  // Interpolate values
-  double lambdaR = row - std::floor( row );
-  double lambdaC = col - std::floor( col );
-
-  double value = ( pixValues[0] * ( 1. - lambdaC ) + pixValues[1] * lambdaC ) * ( 1. - lambdaR )
-                 + ( pixValues[2] * ( 1. - lambdaC ) + pixValues[3] * lambdaC ) * ( lambdaR );
-  if ( rasterCrs.mapUnits() != unit )
+  QgsCoordinateTransformContext transformContext = QgsProject::instance()->transformContext();
+  if ( crs != database.crs || transformContext != database.transformContext )
   {
-    value *= QgsUnitTypes::fromUnitToUnitFactor( vertUnit, unit );
+    database.crs = crs;
+    database.transformContext = transformContext;
+    database.transform = QgsCoordinateTransform( crs, QgsCoordinateReferenceSystem( "EPSG:4326" ), transformContext );
   }
-  return value;
-}
 
-QByteArray KadasCoordinateUtils::getTimezoneAtPos( const QgsPointXY &p, const QgsCoordinateReferenceSystem &crs )
-{
-  QString db = QDir( Kadas::pkgResourcePath() ).absoluteFilePath( "timezone21.bin" );
-  ZoneDetect *zd = ZDOpenDatabase( db.toLocal8Bit().data() );
-  if ( !zd )
+  for ( const QgsPointXY &p : points )
   {
-    return "";
-  }
-  QgsPointXY pLatLon = QgsCoordinateTransform( crs, QgsCoordinateReferenceSystem( "EPSG:4326" ), QgsProject::instance() ).transform( p );
+    QgsPointXY pLatLon = database.transform.transform( p );
 
-  char *zone = ZDHelperSimpleLookupString( zd, pLatLon.y(), pLatLon.x() );
-  QByteArray zoneStr = QByteArray( zone );
-  free( zone );
-  ZDCloseDatabase( zd );
-  return zoneStr;
+    quint64 cellKey = ( quint64( quint32( std::floor( pLatLon.y() / TimezoneDatabase::sCellSize ) ) ) << 32 ) | quint32( std::floor( pLatLon.x() / TimezoneDatabase::sCellSize ) );
+    if ( QByteArray *zone = database.cellCache.object( cellKey ) )
+    {
+      zones.append( *zone );
+      continue;
+    }
+
+    float safezone = 0;
+    ZoneDetectResult *results = ZDLookup( database.zd, pLatLon.y(), pLatLon.x(), &safezone );
+    QByteArray zoneStr = zoneName( results );
+    ZDFreeResults( results );
+    zones.append( zoneStr );
+
+    // Only cache the result for the cell if the entire cell lies within the same zone
+    if ( safezone > 1.5 * TimezoneDatabase::sCellSize )
+    {
+      database.cellCache.insert( cellKey, new QByteArray( zoneStr ) );
+    }
+  }
+  return zones;
 }
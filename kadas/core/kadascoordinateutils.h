@@ -17,6 +17,8 @@
 #ifndef KADASCOORDINATEUTILS_H
 #define KADASCOORDINATEUTILS_H
 
+#include <QVector>
+
 #include <qgis/qgsunittypes.h>
 
 #include "kadas/core/kadas_core.h"
@@ -28,7 +30,9 @@ class KADAS_CORE_EXPORT KadasCoordinateUtils
 {
   public:
     static double getHeightAtPos( const QgsPointXY &p, const QgsCoordinateReferenceSystem &crs, Qgis::DistanceUnit unit, QString *errMsg = 0 );
+    static QVector<double> getHeightsAtPos( const QVector<QgsPointXY> &points, const QgsCoordinateReferenceSystem &crs, Qgis::DistanceUnit unit, QString *errMsg = 0 );
     static QByteArray getTimezoneAtPos( const QgsPointXY &p, const QgsCoordinateReferenceSystem &crs );
+    static QList<QByteArray> getTimezonesAtPos( const QVector<QgsPointXY> &points, const QgsCoordinateReferenceSystem &crs );
 };
 
 #endif // KADASCOORDINATEUTILS_H
@@ -0,0 +1,206 @@
+/***************************************************************************
+    kadasheightmap.cpp
+    ------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <gdal.h>
+
+#include <cmath>
+
+#include <qgis/qgslogger.h>
+#include <qgis/qgspointxy.h>
+#include <qgis/qgsproject.h>
+#include <qgis/qgsrasterlayer.h>
+#include <qgis/qgsunittypes.h>
+
+#include "kadas/core/kadas.h"
+#include "kadas/core/kadasheightmap.h"
+
+
+KadasHeightmap::KadasHeightmap( QString *errMsg )
+{
+  // Cache up to 32 MB of raster blocks (cost in KB)
+  mBlockCache.setMaxCost( 32 * 1024 );
+
+  QString layerid = QgsProject::instance()->readEntry( "Heightmap", "layer" );
+  QgsMapLayer *layer = QgsProject::instance()->mapLayer( layerid );
+  if ( !layer || layer->type() != Qgis::LayerType::Raster )
+  {
+    if ( errMsg )
+    {
+      *errMsg = QObject::tr( "No heightmap is defined in the project. Right-click a raster layer in the layer tree and select it to be used as heightmap." );
+    }
+    return;
+  }
+
+  mSource.providerType = static_cast<QgsRasterLayer *>( layer )->providerType();
+  mSource.layerSource = layer->source();
+  mSource.transformContext = QgsProject::instance()->transformContext();
+  GDALDatasetH raster = Kadas::gdalOpenForLayer( static_cast<QgsRasterLayer *>( layer ), errMsg );
+  if ( raster )
+  {
+    init( raster, errMsg );
+  }
+}
+
+KadasHeightmap::KadasHeightmap( const KadasHeightmap::Source &source, QString *errMsg )
+  : mSource( source )
+{
+  mBlockCache.setMaxCost( 32 * 1024 );
+  if ( source.layerSource.isEmpty() )
+  {
+    return;
+  }
+
+  // Opened like the project heightmap (i.e. with the WCS cache), the GDAL proxy environment was set up by then
+  GDALDatasetH raster = Kadas::gdalOpenLayerSource( source.providerType, source.layerSource, errMsg );
+  if ( !raster )
+  {
+    if ( errMsg && errMsg->isEmpty() )
+    {
+      *errMsg = QObject::tr( "Failed to open raster file" );
+    }
+    return;
+  }
+  init( raster, errMsg );
+}
+
+KadasHeightmap::~KadasHeightmap()
+{
+  if ( mRaster )
+  {
+    GDALClose( mRaster );
+  }
+}
+
+void KadasHeightmap::init( GDALDatasetH raster, QString *errMsg )
+{
+  if ( GDALGetGeoTransform( raster, &mGtrans[0] ) != CE_None )
+  {
+    if ( errMsg )
+    {
+      *errMsg = QObject::tr( "Failed to get raster geotransform" );
+    }
+    GDALClose( raster );
+    return;
+  }
+
+  QString proj( GDALGetProjectionRef( raster ) );
+  mCrs = QgsCoordinateReferenceSystem::fromWkt( proj );
+  if ( !mCrs.isValid() )
+  {
+    if ( errMsg )
+    {
+      *errMsg = QObject::tr( "Failed to get raster CRS" );
+    }
+    GDALClose( raster );
+    return;
+  }
+
+  GDALRasterBandH band = GDALGetRasterBand( raster, 1 );
+  if ( !band )
+  {
+    if ( errMsg )
+    {
+      *errMsg = QObject::tr( "Failed to open raster band 0" );
+    }
+    GDALClose( raster );
+    return;
+  }
+
+  // Get vertical unit
+  Qgis::DistanceUnit vertUnit = strcmp( GDALGetRasterUnitType( band ), "ft" ) == 0 ? Qgis::DistanceUnit::Feet : Qgis::DistanceUnit::Meters;
+  mHeightConversion = QgsUnitTypes::fromUnitToUnitFactor( vertUnit, Qgis::DistanceUnit::Meters );
+
+  int hasNoData = 0;
+  double noData = GDALGetRasterNoDataValue( band, &hasNoData );
+  mHasNoData = hasNoData != 0;
+  mNoData = static_cast<float>( noData );
+
+  mRaster = raster;
+  mBand = band;
+  mWidth = GDALGetRasterXSize( raster );
+  mHeight = GDALGetRasterYSize( raster );
+}
+
+double KadasHeightmap::heightAt( const QgsPointXY &pRaster, bool *ok )
+{
+  if ( ok )
+  {
+    *ok = false;
+  }
+  if ( !mRaster )
+  {
+    return 0;
+  }
+
+  // Transform raster geo position to pixel coordinates
+  double col = ( -mGtrans[0] * mGtrans[5] + mGtrans[2] * mGtrans[3] - mGtrans[2] * pRaster.y() + mGtrans[5] * pRaster.x() ) / ( mGtrans[1] * mGtrans[5] - mGtrans[2] * mGtrans[4] );
+  double row = ( -mGtrans[0] * mGtrans[4] + mGtrans[1] * mGtrans[3] - mGtrans[1] * pRaster.y() + mGtrans[4] * pRaster.x() ) / ( mGtrans[2] * mGtrans[4] - mGtrans[1] * mGtrans[5] );
+
+  int col0 = std::floor( col );
+  int row0 = std::floor( row );
+  double pixValues[4] = {};
+  if ( !pixelValue( col0, row0, pixValues[0] ) || !pixelValue( col0 + 1, row0, pixValues[1] ) || !pixelValue( col0, row0 + 1, pixValues[2] ) || !pixelValue( col0 + 1, row0 + 1, pixValues[3] ) )
+  {
+    return 0;
+  }
+
+  // Interpolate values
+  double lambdaR = row - row0;
+  double lambdaC = col - col0;
+
+  double value = ( pixValues[0] * ( 1. - lambdaC ) + pixValues[1] * lambdaC ) * ( 1. - lambdaR )
+                 + ( pixValues[2] * ( 1. - lambdaC ) + pixValues[3] * lambdaC ) * ( lambdaR );
+  if ( ok )
+  {
+    *ok = true;
+  }
+  return value * mHeightConversion;
+}
+
+bool KadasHeightmap::pixelValue( int col, int row, double &value )
+{
+  if ( col < 0 || row < 0 || col >= mWidth || row >= mHeight )
+  {
+    return false;
+  }
+  int blockCol = col / sBlockSize;
+  int blockRow = row / sBlockSize;
+  qint64 key = qint64( blockRow ) * ( mWidth / sBlockSize + 1 ) + blockCol;
+  QVector<float> *block = mBlockCache.object( key );
+  if ( !block )
+  {
+    int x0 = blockCol * sBlockSize;
+    int y0 = blockRow * sBlockSize;
+    int w = std::min( sBlockSize, mWidth - x0 );
+    int h = std::min( sBlockSize, mHeight - y0 );
+    block = new QVector<float>( sBlockSize * sBlockSize );
+    if ( CE_None != GDALRasterIO( mBand, GF_Read, x0, y0, w, h, block->data(), w, h, GDT_Float32, 0, sBlockSize * sizeof( float ) ) )
+    {
+      QgsDebugMsgLevel( "Failed to read pixel values", 2 );
+      delete block;
+      return false;
+    }
+    mBlockCache.insert( key, block, sBlockSize * sBlockSize * sizeof( float ) / 1024 );
+  }
+  float pixel = block->at( ( row % sBlockSize ) * sBlockSize + col % sBlockSize );
+  // Values are compared as read, as floats
+  if ( mHasNoData && ( pixel == mNoData || ( std::isnan( mNoData ) && std::isnan( pixel ) ) ) )
+  {
+    return false;
+  }
+  value = pixel;
+  return true;
+}
@@ -0,0 +1,97 @@
+/***************************************************************************
+    kadasheightmap.h
+    ----------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASHEIGHTMAP_H
+#define KADASHEIGHTMAP_H
+
+#include <QCache>
+#include <QVector>
+
+#include <qgis/qgscoordinatereferencesystem.h>
+#include <qgis/qgscoordinatetransformcontext.h>
+
+#include "kadas/core/kadas_core.h"
+
+class QgsPointXY;
+
+#ifndef SIP_RUN
+typedef void *GDALDatasetH;
+typedef void *GDALRasterBandH;
+#endif
+
+/**
+ * Sampling access to the project heightmap. The raster is read in blocks which are
+ * cached in memory, so that sampling many nearby positions only hits GDAL once per block.
+ * Instances are not thread safe, use a separate instance (see source()) per thread.
+ */
+class KADAS_CORE_EXPORT KadasHeightmap
+{
+  public:
+#ifndef SIP_RUN
+    // What is needed to open the heightmap again from another thread
+    struct Source
+    {
+        QString providerType;
+        QString layerSource;
+        QgsCoordinateTransformContext transformContext;
+    };
+#endif
+
+    // Opens the heightmap configured in the current project, must be called from the main thread
+    explicit KadasHeightmap( QString *errMsg = nullptr );
+#ifndef SIP_RUN
+    // Opens the heightmap from a source returned by source(), can be called from any thread
+    explicit KadasHeightmap( const KadasHeightmap::Source &source, QString *errMsg = nullptr );
+#endif
+    ~KadasHeightmap();
+    KadasHeightmap( const KadasHeightmap & ) = delete;
+    KadasHeightmap &operator=( const KadasHeightmap & ) = delete;
+
+    bool isValid() const { return mRaster != nullptr; }
+#ifndef SIP_RUN
+    const KadasHeightmap::Source &source() const { return mSource; }
+#endif
+    const QgsCoordinateReferenceSystem &crs() const { return mCrs; }
+    // Transform context of the project the heightmap was opened from
+    const QgsCoordinateTransformContext &transformContext() const { return mSource.transformContext; }
+
+    // Terrain height in meters at the specified position in heightmap CRS, bilinearly interpolated. Positions next to nodata pixels have no valid height.
+    double heightAt( const QgsPointXY &pRaster, bool *ok SIP_OUT = nullptr );
+
+  private:
+#ifdef SIP_RUN
+    KadasHeightmap( const KadasHeightmap &other );
+#endif
+
+    static constexpr int sBlockSize = 256;
+
+    Source mSource;
+    GDALDatasetH mRaster = nullptr;
+    GDALRasterBandH mBand = nullptr;
+    QgsCoordinateReferenceSystem mCrs;
+    double mGtrans[6] = {};
+    int mWidth = 0;
+    int mHeight = 0;
+    double mHeightConversion = 1.;
+    bool mHasNoData = false;
+    float mNoData = 0.f;
+    QCache<qint64, QVector<float>> mBlockCache;
+
+    void init( GDALDatasetH raster, QString *errMsg );
+    bool pixelValue( int col, int row, double &value );
+};
+
+#endif // KADASHEIGHTMAP_H
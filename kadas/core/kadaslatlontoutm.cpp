@@ -15,6 +15,12 @@
  ***************************************************************************/
 
 #include <QDebug>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <cmath>
+#include <functional>
+#include <limits>
 
 #include <qgis/qgsdistancearea.h>
 #include <qgis/qgspoint.h>
@@ -26,37 +32,19 @@ const int KadasLatLonToUTM::NUM_100K_SETS = 6;
 const QString KadasLatLonToUTM::SET_ORIGIN_COLUMN_LETTERS = "AJSAJS";
 const QString KadasLatLonToUTM::SET_ORIGIN_ROW_LETTERS = "AFAFAF";
 
-QgsPointXY KadasLatLonToUTM::UTM2LL( const UTMCoo &utm, bool &ok )
+// Inverse transverse mercator series. y must not include the false northing of the southern hemisphere.
+static inline void utm2llSeries( double easting, double y, int zoneNumber, double &lon, double &lat )
 {
-  ok = false;
-
-  // check whether the ZoneNummber and ZoneLetter are valid
-  if ( utm.zoneNumber < 0 || utm.zoneNumber > 60 || utm.zoneLetter.isEmpty() )
-  {
-    return QgsPointXY();
-  }
-
   const double k0 = 0.9996;
   const double a = 6378137.0;           //ellip.radius;
   const double eccSquared = 0.00669438; //ellip.eccsq;
   double e1 = ( 1 - std::sqrt( 1 - eccSquared ) ) / ( 1 + std::sqrt( 1 - eccSquared ) );
 
   // remove 500,000 meter offset for longitude
-  double x = utm.easting - 500000.0;
-  double y = utm.northing;
-
-  // We must know somehow if we are in the Northern or Southern
-  // hemisphere, this is the only time we use the letter So even
-  // if the Zone letter isn't exactly correct it should indicate
-  // the hemisphere correctly
-  if ( utm.zoneLetter.at( 0 ) < 'N' )
-  {
-    y -= 10000000.0; // remove 10,000,000 meter offset used
-    // for southern hemisphere
-  }
+  double x = easting - 500000.0;
 
   // There are 60 zones with zone 1 being at West -180 to -174
-  double LongOrigin = ( utm.zoneNumber - 1 ) * 6 - 180 + 3; // +3 puts origin in middle of zone
+  double LongOrigin = ( zoneNumber - 1 ) * 6 - 180 + 3; // +3 puts origin in middle of zone
 
   double eccPrimeSquared = ( eccSquared ) / ( 1 - eccSquared );
 
@@ -72,27 +60,22 @@ QgsPointXY KadasLatLonToUTM::UTM2LL( const UTMCoo &utm, bool &ok )
   double R1 = a * ( 1 - eccSquared ) / std::pow( 1 - eccSquared * std::sin( phi1Rad ) * std::sin( phi1Rad ), 1.5 );
   double D = x / ( N1 * k0 );
 
-  double lat = phi1Rad - ( N1 * std::tan( phi1Rad ) / R1 ) * ( D * D / 2 - ( 5 + 3 * T1 + 10 * C1 - 4 * C1 * C1 - 9 * eccPrimeSquared ) * D * D * D * D / 24 + ( 61 + 90 * T1 + 298 * C1 + 45 * T1 * T1 - 252 * eccPrimeSquared - 3 * C1 * C1 ) * D * D * D * D * D * D / 720 );
+  lat = phi1Rad - ( N1 * std::tan( phi1Rad ) / R1 ) * ( D * D / 2 - ( 5 + 3 * T1 + 10 * C1 - 4 * C1 * C1 - 9 * eccPrimeSquared ) * D * D * D * D / 24 + ( 61 + 90 * T1 + 298 * C1 + 45 * T1 * T1 - 252 * eccPrimeSquared - 3 * C1 * C1 ) * D * D * D * D * D * D / 720 );
   lat = lat / M_PI * 180.;
 
-  double lon = ( D - ( 1 + 2 * T1 + C1 ) * D * D * D / 6 + ( 5 - 2 * C1 + 28 * T1 - 3 * C1 * C1 + 8 * eccPrimeSquared + 24 * T1 * T1 ) * D * D * D * D * D / 120 ) / std::cos( phi1Rad );
+  lon = ( D - ( 1 + 2 * T1 + C1 ) * D * D * D / 6 + ( 5 - 2 * C1 + 28 * T1 - 3 * C1 * C1 + 8 * eccPrimeSquared + 24 * T1 * T1 ) * D * D * D * D * D / 120 ) / std::cos( phi1Rad );
   lon = LongOrigin + lon / M_PI * 180.;
-
-  ok = true;
-  return QgsPointXY( lon, lat );
 }
 
-KadasLatLonToUTM::UTMCoo KadasLatLonToUTM::LL2UTM( const QgsPointXY &pLatLong )
+// Transverse mercator series. The returned northing does not include the false northing of the southern hemisphere.
+static inline void ll2utmSeries( double Long, double Lat, int ZoneNumber, double &easting, double &northing )
 {
   const double a = 6378137.0;       //ellip.radius;
   const double eccSqr = 0.00669438; //ellip.eccsq;
   const double k0 = 0.9996;
 
-  double Long = pLatLong.x();
-  double Lat = pLatLong.y();
   double LatRad = Lat / 180. * M_PI;
   double LongRad = Long / 180. * M_PI;
-  int ZoneNumber = zoneNumber( Long, Lat );
 
   //+3 puts origin in middle of zone
   double LongOriginRad = ( ( ZoneNumber - 1 ) * 6 - 180 + 3 ) / 180. * M_PI;
@@ -105,145 +88,290 @@ KadasLatLonToUTM::UTMCoo KadasLatLonToUTM::LL2UTM( const QgsPointXY &pLatLong )
   double A = std::cos( LatRad ) * ( LongRad - LongOriginRad );
   double M = a * ( ( 1 - eccSqr / 4 - 3 * eccSqr * eccSqr / 64 - 5 * eccSqr * eccSqr * eccSqr / 256 ) * LatRad - ( 3 * eccSqr / 8 + 3 * eccSqr * eccSqr / 32 + 45 * eccSqr * eccSqr * eccSqr / 1024 ) * std::sin( 2 * LatRad ) + ( 15 * eccSqr * eccSqr / 256 + 45 * eccSqr * eccSqr * eccSqr / 1024 ) * std::sin( 4 * LatRad ) - ( 35 * eccSqr * eccSqr * eccSqr / 3072 ) * std::sin( 6 * LatRad ) );
 
-  UTMCoo coo;
-
-  coo.easting = ( k0 * N * ( A + ( 1 - T + C ) * A * A * A / 6.0 + ( 5 - 18 * T + T * T + 72 * C - 58 * eccPrimeSquared ) * A * A * A * A * A / 120.0 ) + 500000.0 );
+  easting = ( k0 * N * ( A + ( 1 - T + C ) * A * A * A / 6.0 + ( 5 - 18 * T + T * T + 72 * C - 58 * eccPrimeSquared ) * A * A * A * A * A / 120.0 ) + 500000.0 );
 
-  coo.northing = ( k0 * ( M + N * std::tan( LatRad ) * ( A * A / 2 + ( 5 - T + 9 * C + 4 * C * C ) * A * A * A * A / 24.0 + ( 61 - 58 * T + T * T + 600 * C - 330 * eccPrimeSquared ) * A * A * A * A * A * A / 720.0 ) ) );
-  if ( Lat < 0.0 )
-  {
-    coo.northing += 10000000.0; //10000000 meter offset for southern hemisphere
-  }
-
-  coo.zoneNumber = ZoneNumber;
-  coo.zoneLetter = hemisphereLetter( Lat );
-  return coo;
+  northing = ( k0 * ( M + N * std::tan( LatRad ) * ( A * A / 2 + ( 5 - T + 9 * C + 4 * C * C ) * A * A * A * A / 24.0 + ( 61 - 58 * T + T * T + 600 * C - 330 * eccPrimeSquared ) * A * A * A * A * A * A / 720.0 ) ) );
 }
 
-int KadasLatLonToUTM::zoneNumber( double lon, double lat )
-{
-  int zoneNumber = std::floor( ( lon + 180. ) / 6. ) + 1;
-
-  //Make sure the longitude 180.00 is in Zone 60
-  if ( lon >= 180.0 )
-  {
-    zoneNumber = 60;
-  }
-
-  // Special zone for Norway
-  if ( lat >= 56.0 && lat < 64.0 && lon >= 3.0 && lon < 12.0 )
-  {
-    zoneNumber = 32;
-  }
-
-  // Special zones for Svalbard
-  if ( lat >= 72.0 && lat < 84.0 )
-  {
-    if ( lon >= 0.0 && lon < 9.0 )
-    {
-      zoneNumber = 31;
-    }
-    else if ( lon >= 9.0 && lon < 21.0 )
-    {
-      zoneNumber = 33;
-    }
-    else if ( lon >= 21.0 && lon < 33.0 )
-    {
-      zoneNumber = 35;
-    }
-    else if ( lon >= 33.0 && lon < 42.0 )
-    {
-      zoneNumber = 37;
-    }
-  }
-  return zoneNumber;
-}
-
-QString KadasLatLonToUTM::hemisphereLetter( double lat )
+static char hemisphereLetterChar( double lat )
 {
   if ( ( 84 >= lat ) && ( lat >= 72 ) )
   {
-    return "X";
+    return 'X';
   }
   else if ( ( 72 > lat ) && ( lat >= 64 ) )
   {
-    return "W";
+    return 'W';
   }
   else if ( ( 64 > lat ) && ( lat >= 56 ) )
   {
-    return "V";
+    return 'V';
   }
   else if ( ( 56 > lat ) && ( lat >= 48 ) )
   {
-    return "U";
+    return 'U';
   }
   else if ( ( 48 > lat ) && ( lat >= 40 ) )
   {
-    return "T";
+    return 'T';
   }
   else if ( ( 40 > lat ) && ( lat >= 32 ) )
   {
-    return "S";
+    return 'S';
   }
   else if ( ( 32 > lat ) && ( lat >= 24 ) )
   {
-    return "R";
+    return 'R';
   }
   else if ( ( 24 > lat ) && ( lat >= 16 ) )
   {
-    return "Q";
+    return 'Q';
   }
   else if ( ( 16 > lat ) && ( lat >= 8 ) )
   {
-    return "P";
+    return 'P';
   }
   else if ( ( 8 > lat ) && ( lat >= 0 ) )
   {
-    return "N";
+    return 'N';
   }
   else if ( ( 0 > lat ) && ( lat >= -8 ) )
   {
-    return "M";
+    return 'M';
   }
   else if ( ( -8 > lat ) && ( lat >= -16 ) )
   {
-    return "L";
+    return 'L';
   }
   else if ( ( -16 > lat ) && ( lat >= -24 ) )
   {
-    return "K";
+    return 'K';
   }
   else if ( ( -24 > lat ) && ( lat >= -32 ) )
   {
-    return "J";
+    return 'J';
   }
   else if ( ( -32 > lat ) && ( lat >= -40 ) )
   {
-    return "H";
+    return 'H';
   }
   else if ( ( -40 > lat ) && ( lat >= -48 ) )
   {
-    return "G";
+    return 'G';
   }
   else if ( ( -48 > lat ) && ( lat >= -56 ) )
   {
-    return "F";
+    return 'F';
   }
   else if ( ( -56 > lat ) && ( lat >= -64 ) )
   {
-    return "E";
+    return 'E';
   }
   else if ( ( -64 > lat ) && ( lat >= -72 ) )
   {
-    return "D";
+    return 'D';
   }
   else if ( ( -72 > lat ) && ( lat >= -80 ) )
   {
-    return "C";
+    return 'C';
   }
 
   //This is an error flag to show that the Latitude is outside MGRS limits
-  return "Z";
+  return 'Z';
+}
+
+// Runs func( begin, end ) over chunks of the range [0, count), in parallel for large inputs
+static void processChunked( int count, const std::function<void( int, int )> &func )
+{
+  static constexpr int sChunkSize = 16384;
+  if ( count <= sChunkSize )
+  {
+    func( 0, count );
+    return;
+  }
+  QVector<int> chunkStarts;
+  for ( int i = 0; i < count; i += sChunkSize )
+  {
+    chunkStarts.append( i );
+  }
+  QtConcurrent::blockingMap( chunkStarts, [&func, count]( int begin ) { func( begin, std::min( begin + sChunkSize, count ) ); } );
+}
+
+// Passes the positions start + i * ( stepEasting, stepNorthing ), i = 0, 1, ..., to visit until it returns false.
+// The positions are converted in batches, which start small since grid lines often only have few vertices.
+static void walkGridLine( const KadasLatLonToUTM::UTMCoo &start, int stepEasting, int stepNorthing, const std::function<bool( const QgsPointXY &pos, bool ok )> &visit )
+{
+  // visit may modify the coordinate passed as start
+  const double startEasting = start.easting;
+  const double startNorthing = start.northing;
+  const int zone = start.zoneNumber;
+  const char zoneLetter = start.zoneLetter.isEmpty() ? '\0' : start.zoneLetter.at( 0 ).toLatin1();
+  QVector<double> easting, northing, lon, lat;
+  QVector<int> zoneNumbers;
+  QVector<char> zoneLetters;
+  for ( int first = 0, batch = 16;; first += batch, batch = std::min( 2 * batch, 256 ) )
+  {
+    easting.resize( batch );
+    northing.resize( batch );
+    lon.resize( batch );
+    lat.resize( batch );
+    zoneNumbers.fill( zone, batch );
+    zoneLetters.fill( zoneLetter, batch );
+    for ( int i = 0; i < batch; ++i )
+    {
+      easting[i] = startEasting + double( first + i ) * stepEasting;
+      northing[i] = startNorthing + double( first + i ) * stepNorthing;
+    }
+    KadasLatLonToUTM::UTM2LL( easting.constData(), northing.constData(), zoneNumbers.constData(), zoneLetters.constData(), batch, lon.data(), lat.data() );
+    for ( int i = 0; i < batch; ++i )
+    {
+      // Same result as the scalar conversion for invalid zones
+      bool ok = !std::isnan( lon[i] );
+      if ( !visit( ok ? QgsPointXY( lon[i], lat[i] ) : QgsPointXY(), ok ) )
+      {
+        return;
+      }
+    }
+  }
+}
+
+QgsPointXY KadasLatLonToUTM::UTM2LL( const UTMCoo &utm, bool &ok )
+{
+  ok = false;
+
+  // check whether the ZoneNummber and ZoneLetter are valid
+  if ( utm.zoneNumber < 0 || utm.zoneNumber > 60 || utm.zoneLetter.isEmpty() )
+  {
+    return QgsPointXY();
+  }
+
+  double y = utm.northing;
+
+  // We must know somehow if we are in the Northern or Southern
+  // hemisphere, this is the only time we use the letter So even
+  // if the Zone letter isn't exactly correct it should indicate
+  // the hemisphere correctly
+  if ( utm.zoneLetter.at( 0 ) < 'N' )
+  {
+    y -= 10000000.0; // remove 10,000,000 meter offset used
+    // for southern hemisphere
+  }
+
+  double lon = 0;
+  double lat = 0;
+  utm2llSeries( utm.easting, y, utm.zoneNumber, lon, lat );
+
+  ok = true;
+  return QgsPointXY( lon, lat );
+}
+
+KadasLatLonToUTM::UTMCoo KadasLatLonToUTM::LL2UTM( const QgsPointXY &pLatLong )
+{
+  double Long = pLatLong.x();
+  double Lat = pLatLong.y();
+  int ZoneNumber = zoneNumber( Long, Lat );
+
+  double easting = 0;
+  double northing = 0;
+  ll2utmSeries( Long, Lat, ZoneNumber, easting, northing );
+
+  UTMCoo coo;
+  coo.easting = easting;
+  coo.northing = northing;
+  if ( Lat < 0.0 )
+  {
+    coo.northing += 10000000.0; //10000000 meter offset for southern hemisphere
+  }
+
+  coo.zoneNumber = ZoneNumber;
+  coo.zoneLetter = hemisphereLetter( Lat );
+  return coo;
+}
+
+void KadasLatLonToUTM::LL2UTM( const double *lon, const double *lat, int count, double *easting, double *northing, int *zoneNumbers, char *zoneLetters )
+{
+  processChunked( count, [=]( int begin, int end ) {
+    // Zone lookup is branchy, keep it out of the series loop so that the latter can be vectorized
+    for ( int i = begin; i < end; ++i )
+    {
+      zoneNumbers[i] = zoneNumber( lon[i], lat[i] );
+    }
+    for ( int i = begin; i < end; ++i )
+    {
+      ll2utmSeries( lon[i], lat[i], zoneNumbers[i], easting[i], northing[i] );
+      northing[i] += lat[i] < 0.0 ? 10000000.0 : 0.0;
+    }
+    if ( zoneLetters )
+    {
+      for ( int i = begin; i < end; ++i )
+      {
+        zoneLetters[i] = hemisphereLetterChar( lat[i] );
+      }
+    }
+  } );
+}
+
+void KadasLatLonToUTM::UTM2LL( const double *easting, const double *northing, const int *zoneNumbers, const char *zoneLetters, int count, double *lon, double *lat )
+{
+  processChunked( count, [=]( int begin, int end ) {
+    for ( int i = begin; i < end; ++i )
+    {
+      double y = northing[i] - ( zoneLetters[i] < 'N' ? 10000000.0 : 0.0 );
+      utm2llSeries( easting[i], y, zoneNumbers[i], lon[i], lat[i] );
+    }
+    for ( int i = begin; i < end; ++i )
+    {
+      if ( zoneNumbers[i] < 0 || zoneNumbers[i] > 60 || zoneLetters[i] == '\0' )
+      {
+        lon[i] = std::numeric_limits<double>::quiet_NaN();
+        lat[i] = std::numeric_limits<double>::quiet_NaN();
+      }
+    }
+  } );
+}
+
+int KadasLatLonToUTM::zoneNumber( double lon, double lat )
+{
+  int zoneNumber = std::floor( ( lon + 180. ) / 6. ) + 1;
+
+  //Make sure the longitude 180.00 is in Zone 60
+  if ( lon >= 180.0 )
+  {
+    zoneNumber = 60;
+  }
+
+  // Special zone for Norway
+  if ( lat >= 56.0 && lat < 64.0 && lon >= 3.0 && lon < 12.0 )
+  {
+    zoneNumber = 32;
+  }
+
+  // Special zones for Svalbard
+  if ( lat >= 72.0 && lat < 84.0 )
+  {
+    if ( lon >= 0.0 && lon < 9.0 )
+    {
+      zoneNumber = 31;
+    }
+    else if ( lon >= 9.0 && lon < 21.0 )
+    {
+      zoneNumber = 33;
+    }
+    else if ( lon >= 21.0 && lon < 33.0 )
+    {
+      zoneNumber = 35;
+    }
+    else if ( lon >= 33.0 && lon < 42.0 )
+    {
+      zoneNumber = 37;
+    }
+  }
+  return zoneNumber;
+}
+
+QString KadasLatLonToUTM::hemisphereLetter( double lat )
+{
+  return QString( QChar( hemisphereLetterChar( lat ) ) );
 }
 
 QString KadasLatLonToUTM::zoneName( double lon, double lat )
@@ -271,6 +399,29 @@ KadasLatLonToUTM::MGRSCoo KadasLatLonToUTM::UTM2MGRS( const UTMCoo &utmcoo )
   return mgrscoo;
 }
 
+void KadasLatLonToUTM::UTM2MGRS( const double *easting, const double *northing, const int *zoneNumbers, int count, int *mgrsEasting, int *mgrsNorthing, char *letter100kIDs )
+{
+  processChunked( count, [=]( int begin, int end ) {
+    for ( int i = begin; i < end; ++i )
+    {
+      int setParm = zoneNumbers[i] % NUM_100K_SETS;
+      if ( setParm == 0 )
+      {
+        setParm = NUM_100K_SETS;
+      }
+      // Same integer semantics as the scalar conversion
+      int e = easting[i];
+      int n = northing[i];
+      mgrsEasting[i] = e % 100000;
+      mgrsNorthing[i] = n % 100000;
+      if ( !mgrsLetter100kID( e / 100000, ( n / 100000 ) % 20, setParm, letter100kIDs + 2 * i ) )
+      {
+        letter100kIDs[2 * i] = letter100kIDs[2 * i + 1] = '\0';
+      }
+    }
+  } );
+}
+
 KadasLatLonToUTM::UTMCoo KadasLatLonToUTM::MGRS2UTM( const MGRSCoo &mgrs, bool &ok )
 {
   UTMCoo utm;
@@ -451,16 +602,26 @@ double KadasLatLonToUTM::minNorthing( int zoneLetter )
 }
 
 QString KadasLatLonToUTM::mgrsLetter100kID( int column, int row, int parm )
+{
+  char id[2];
+  if ( !mgrsLetter100kID( column, row, parm, id ) )
+  {
+    return QString();
+  }
+  return QString( "%1%2" ).arg( QChar( id[0] ) ).arg( QChar( id[1] ) );
+}
+
+bool KadasLatLonToUTM::mgrsLetter100kID( int column, int row, int parm, char *id )
 {
   // colOrigin and rowOrigin are the letters at the origin of the set
   int index = parm - 1;
   if ( index < 0 || index >= SET_ORIGIN_COLUMN_LETTERS.length() )
   {
-    return QString();
+    return false;
   }
   if ( index < 0 || index >= SET_ORIGIN_ROW_LETTERS.length() )
   {
-    return QString();
+    return false;
   }
 
   int colOrigin = SET_ORIGIN_COLUMN_LETTERS.at( index ).unicode();
@@ -527,7 +688,9 @@ QString KadasLatLonToUTM::mgrsLetter100kID( int column, int row, int parm )
     rowInt = rowInt - 'V' + 'A' - 1;
   }
 
-  return QString( "%1%2" ).arg( QChar( colInt ) ).arg( QChar( rowInt ) );
+  id[0] = colInt;
+  id[1] = rowInt;
+  return true;
 }
 
 static inline QPolygonF polyGridLineX( double x, double y1, double y2, double stepY )
@@ -915,11 +1078,15 @@ KadasLatLonToUTM::Grid KadasLatLonToUTM::computeSubGrid( int cellSize, Level lev
     // Draw remaining segments of grid line
     if ( yMin >= 0 )
     {
-      while ( !truncated && ( q = UTM2LL( xcoo, ok ) ).y() < yMax && ok )
-      {
+      walkGridLine( xcoo, 0, cellSize, [&]( const QgsPointXY &pos, bool posOk ) {
+        q = pos;
+        if ( q.y() >= yMax || !posOk )
+        {
+          return false;
+        }
         xLine.append( truncateGridLineYMax( xLine.back(), QPointF( q.x(), q.y() ), xMin, xMax, yMax, truncated ) );
-        xcoo.northing += cellSize;
-      }
+        return !truncated;
+      } );
       if ( !truncated )
       {
         xLine.append( truncateGridLineYMax( xLine.back(), QPointF( q.x(), q.y() ), xMin, xMax, yMax, truncated ) );
@@ -927,11 +1094,15 @@ KadasLatLonToUTM::Grid KadasLatLonToUTM::computeSubGrid( int cellSize, Level lev
     }
     else
     {
-      while ( !truncated && ( q = UTM2LL( xcoo, ok ) ).y() > yMin && ok )
-      {
+      walkGridLine( xcoo, 0, -cellSize, [&]( const QgsPointXY &pos, bool posOk ) {
+        q = pos;
+        if ( q.y() <= yMin || !posOk )
+        {
+          return false;
+        }
         xLine.append( truncateGridLineYMin( xLine.back(), QPointF( q.x(), q.y() ), xMin, xMax, yMin, truncated ) );
-        xcoo.northing -= cellSize;
-      }
+        return !truncated;
+      } );
       if ( !truncated )
       {
         xLine.append( truncateGridLineYMin( xLine.back(), QPointF( q.x(), q.y() ), xMin, xMax, yMin, truncated ) );
@@ -979,8 +1150,12 @@ KadasLatLonToUTM::Grid KadasLatLonToUTM::computeSubGrid( int cellSize, Level lev
       subGrid.zoneLabels << zoneLabelCallback( yLine.last().x(), std::max( xMin, yLine.last().y() ), maxPos.x(), maxPos.y() );
     }
     // Draw remaining segments of grid line
-    while ( ( q = UTM2LL( ycoo, ok ) ).x() < xMax && ok )
-    {
+    walkGridLine( ycoo, cellSize, 0, [&]( const QgsPointXY &pos, bool posOk ) {
+      q = pos;
+      if ( q.x() >= xMax || !posOk )
+      {
+        return false;
+      }
       yLine.append( QPointF( q.x(), q.y() ) );
       if ( zoneLabelCallback )
       {
@@ -993,7 +1168,8 @@ KadasLatLonToUTM::Grid KadasLatLonToUTM::computeSubGrid( int cellSize, Level lev
         subGrid.zoneLabels.append( zoneLabelCallback( q.x(), q.y(), maxPos.x(), maxPos.y() ) );
       }
       ycoo.easting += cellSize;
-    }
+      return true;
+    } );
     coo.northing += cellSize;
     yLine.append( truncateGridLineXMax( yLine.back(), QPointF( q.x(), q.y() ), xMax ) );
     subGrid.lines.append( { level, yLine } );
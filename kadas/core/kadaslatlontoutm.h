@@ -111,6 +111,16 @@ class KADAS_CORE_EXPORT KadasLatLonToUTM
     static MGRSCoo UTM2MGRS( const UTMCoo &utmcoo );
     static UTMCoo MGRS2UTM( const MGRSCoo &mgrs, bool &ok );
 
+    // Batch conversions of contiguous coordinate buffers, which must hold count values each.
+    // Large inputs are split into chunks which are converted in parallel.
+
+    //! Converts WGS84 lon/lat to UTM. Zone letters are only computed if zoneLetters is not null.
+    static void LL2UTM( const double *lon, const double *lat, int count, double *easting, double *northing, int *zoneNumbers, char *zoneLetters = nullptr ) SIP_SKIP;
+    //! Converts UTM to WGS84 lon/lat. Invalid coordinates result in NaN values.
+    static void UTM2LL( const double *easting, const double *northing, const int *zoneNumbers, const char *zoneLetters, int count, double *lon, double *lat ) SIP_SKIP;
+    //! Converts UTM to MGRS. letter100kIDs must hold 2 * count chars, invalid IDs are set to '\0'.
+    static void UTM2MGRS( const double *easting, const double *northing, const int *zoneNumbers, int count, int *mgrsEasting, int *mgrsNorthing, char *letter100kIDs ) SIP_SKIP;
+
     static int zoneNumber( double lon, double lat );
     static QString hemisphereLetter( double lat );
     static QString zoneName( double lon, double lat );
@@ -129,6 +139,7 @@ class KADAS_CORE_EXPORT KadasLatLonToUTM
     static const QString SET_ORIGIN_ROW_LETTERS;
 
     static QString mgrsLetter100kID( int column, int row, int parm );
+    static bool mgrsLetter100kID( int column, int row, int parm, char *id );
     static double minNorthing( int zoneLetter );
     typedef ZoneLabel( zoneLabelCallback_t )( double, double, double, double );
     typedef GridLabel( gridLabelCallback_t )( double, double, int, bool, int );
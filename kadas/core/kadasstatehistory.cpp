@@ -14,13 +14,19 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <QElapsedTimer>
+
+#include <qgis/qgslogger.h>
 #include <qgis/qgsproject.h>
+#include <qgis/qgssettings.h>
 
 #include "kadas/core/kadasstatehistory.h"
 
 KadasStateHistory::KadasStateHistory( QObject *parent )
   : QObject( parent )
-{}
+{
+  mMemoryBudget = QgsSettings().value( "/kadas/undo_memory_budget_mb", 64 ).toLongLong() * 1024 * 1024;
+}
 
 KadasStateHistory::~KadasStateHistory()
 {
@@ -29,8 +35,7 @@ KadasStateHistory::~KadasStateHistory()
 
 void KadasStateHistory::clear()
 {
-  qDeleteAll( mStates );
-  mStates.clear();
+  truncate( 0 );
   mCurrent = -1;
   emit canUndoChanged( false );
   emit canRedoChanged( false );
@@ -40,8 +45,11 @@ void KadasStateHistory::undo()
 {
   if ( canUndo() )
   {
+    QElapsedTimer timer;
+    timer.start();
     --mCurrent;
     emit stateChanged( ChangeType::Undo, mStates[mCurrent], mStates[mCurrent + 1] );
+    changeApplied( timer.nsecsElapsed() / 1E6 );
   }
   emit canUndoChanged( canUndo() );
   emit canRedoChanged( canRedo() );
@@ -51,8 +59,11 @@ void KadasStateHistory::redo()
 {
   if ( canRedo() )
   {
+    QElapsedTimer timer;
+    timer.start();
     ++mCurrent;
     emit stateChanged( ChangeType::Redo, mStates[mCurrent], mStates[mCurrent - 1] );
+    changeApplied( timer.nsecsElapsed() / 1E6 );
   }
   emit canUndoChanged( canUndo() );
   emit canRedoChanged( canRedo() );
@@ -60,10 +71,74 @@ void KadasStateHistory::redo()
 
 void KadasStateHistory::push( State *state )
 {
-  mStates.resize( ++mCurrent );
+  QElapsedTimer timer;
+  timer.start();
+  // Discard redo states
+  truncate( ++mCurrent );
+  // States are stored as implicitly shared copies, only count what is not shared with the previous state
+  qint64 memoryUsage = state->memoryUsage( mStates.isEmpty() ? nullptr : mStates.last() );
   mStates.append( state );
+  mMemoryUsage.append( memoryUsage );
+  mTotalMemoryUsage += memoryUsage;
+  enforceMemoryBudget();
+  mLastPushMs = timer.nsecsElapsed() / 1E6;
+
   emit canUndoChanged( canUndo() );
   emit canRedoChanged( canRedo() );
 
   QgsProject::instance()->setDirty( true );
 }
+
+void KadasStateHistory::setMemoryBudget( qint64 bytes )
+{
+  mMemoryBudget = bytes;
+  enforceMemoryBudget();
+  emit canUndoChanged( canUndo() );
+}
+
+KadasStateHistory::Stats KadasStateHistory::stats() const
+{
+  Stats stats;
+  stats.entries = mStates.size();
+  stats.memoryUsage = mTotalMemoryUsage;
+  stats.memoryBudget = mMemoryBudget;
+  stats.evicted = mEvicted;
+  stats.lastPushMs = mLastPushMs;
+  stats.lastChangeMs = mLastChangeMs;
+  stats.maxChangeMs = mMaxChangeMs;
+  return stats;
+}
+
+void KadasStateHistory::truncate( int size )
+{
+  for ( int i = size, n = mStates.size(); i < n; ++i )
+  {
+    mTotalMemoryUsage -= mMemoryUsage[i];
+    delete mStates[i];
+  }
+  mStates.resize( std::min( size, mStates.size() ) );
+  mMemoryUsage.resize( mStates.size() );
+}
+
+void KadasStateHistory::enforceMemoryBudget()
+{
+  // Drop the oldest states, but always keep the current one
+  while ( mMemoryBudget > 0 && mTotalMemoryUsage > mMemoryBudget && mCurrent > 0 )
+  {
+    mTotalMemoryUsage -= mMemoryUsage.takeFirst();
+    delete mStates.takeFirst();
+    --mCurrent;
+    ++mEvicted;
+    // Data previously shared with the dropped state is now fully owned by the new oldest state
+    mTotalMemoryUsage -= mMemoryUsage[0];
+    mMemoryUsage[0] = mStates[0]->memoryUsage( nullptr );
+    mTotalMemoryUsage += mMemoryUsage[0];
+  }
+}
+
+void KadasStateHistory::changeApplied( double ms )
+{
+  mLastChangeMs = ms;
+  mMaxChangeMs = std::max( mMaxChangeMs, ms );
+  QgsDebugMsgLevel( QString( "Undo history: state applied in %1 ms, %2 states using %3 kB" ).arg( ms ).arg( mStates.size() ).arg( mTotalMemoryUsage / 1024 ), 3 );
+}
@@ -31,6 +31,12 @@ class KADAS_CORE_EXPORT KadasStateHistory : public QObject
     struct State
     {
         virtual ~State() {}
+        //! Returns the approximate memory used by the state, excluding data implicitly shared with the previous state (if not null)
+        virtual qint64 memoryUsage( const KadasStateHistory::State *previous ) const
+        {
+          Q_UNUSED( previous );
+          return 0;
+        }
     };
     enum class ChangeType : int
     {
@@ -38,6 +44,17 @@ class KADAS_CORE_EXPORT KadasStateHistory : public QObject
       Redo
     };
 
+    struct Stats
+    {
+        int entries = 0;
+        qint64 memoryUsage = 0;
+        qint64 memoryBudget = 0;
+        int evicted = 0;            // Entries dropped to stay within the memory budget
+        double lastPushMs = 0;      // Time spent recording the last state
+        double lastChangeMs = 0;    // Time spent applying the last undo/redo
+        double maxChangeMs = 0;     // Maximum time spent applying an undo/redo
+    };
+
     KadasStateHistory( QObject *parent = 0 );
     ~KadasStateHistory();
     void clear();
@@ -47,6 +64,11 @@ class KADAS_CORE_EXPORT KadasStateHistory : public QObject
     bool canUndo() const { return mCurrent > 0; }
     bool canRedo() const { return mCurrent < mStates.length() - 1; }
 
+    //! Sets the memory budget in bytes, the oldest states are dropped when it is exceeded
+    void setMemoryBudget( qint64 bytes );
+    qint64 memoryBudget() const { return mMemoryBudget; }
+    Stats stats() const;
+
   signals:
     void canUndoChanged( bool );
     void canRedoChanged( bool );
@@ -54,7 +76,18 @@ class KADAS_CORE_EXPORT KadasStateHistory : public QObject
 
   private:
     QVector<State *> mStates;
+    QVector<qint64> mMemoryUsage;
     int mCurrent = -1;
+    qint64 mMemoryBudget = 0;
+    qint64 mTotalMemoryUsage = 0;
+    int mEvicted = 0;
+    double mLastPushMs = 0;
+    double mLastChangeMs = 0;
+    double mMaxChangeMs = 0;
+
+    void truncate( int size );
+    void enforceMemoryBudget();
+    void changeApplied( double ms );
 };
 
 #endif // KADASSTATEHISTORY_H
@@ -15,19 +15,48 @@
  ***************************************************************************/
 
 #include <QHBoxLayout>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QLabel>
 #include <QMenu>
+#include <QPainter>
 #include <QSlider>
+#include <QThreadPool>
 #include <QWidgetAction>
+#include <QtConcurrentMap>
 
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include <qgis/qgsexception.h>
+#include <qgis/qgsfeature.h>
 #include <qgis/qgsmaplayerrenderer.h>
 #include <qgis/qgsmapsettings.h>
 #include <qgis/qgsproject.h>
 #include <qgis/qgsrendercontext.h>
 #include <qgis/qgssettings.h>
+#include <qgis/qgsspatialindex.h>
 
 #include "kadas/gui/kadasitemlayer.h"
+#include "kadas/gui/kadasitemsearchindex.h"
+#include "kadas/gui/kadasrendersnapshot.h"
 #include "kadas/gui/mapitems/kadasmapitem.h"
+#include "kadas/gui/mapitems/kadassymbolitem.h"
+
+
+static QJsonObject parseItemData( const QByteArray &data )
+{
+  return QJsonDocument::fromJson( data ).object();
+}
+
+// Number of candidate items above which exact hit tests are run in parallel
+static constexpr int sParallelHitTestThreshold = 256;
+// Number of items above which the layer is rendered in parallel bands
+static constexpr int sParallelRenderThreshold = 2000;
+static constexpr int sMinRenderBandHeight = 128;
 
 
 class KadasItemLayer::Renderer : public QgsMapLayerRenderer
@@ -42,20 +71,23 @@ class KadasItemLayer::Renderer : public QgsMapLayerRenderer
       }
       std::stable_sort( mRenderItems.begin(), mRenderItems.end(), []( KadasMapItem *a, KadasMapItem *b ) { return a->zIndex() < b->zIndex(); } );
       mRenderOpacity = layer->opacity();
+      // Items render from the render context only, capture the application state they need here on the GUI thread
+      KadasRenderSnapshot snapshot = KadasRenderSnapshot::capture();
+      snapshot.store( rendererContext );
+      if ( mRenderItems.size() >= sParallelRenderThreshold )
+      {
+        prepareBands( rendererContext, snapshot.screenDpi );
+      }
+    }
+    ~Renderer() override
+    {
+      qDeleteAll( mRenderItems );
     }
     bool render() override
     {
-      bool omitSinglePoint = renderContext()->customProperties().contains( "globe" );
-      for ( const KadasMapItem *item : std::as_const( mRenderItems ) )
+      if ( mBandItems.isEmpty() || !renderBands() )
       {
-        if ( item && item->isVisible() && ( !omitSinglePoint || !item->isPointSymbol() ) )
-        {
-          renderContext()->painter()->save();
-          renderContext()->painter()->setOpacity( mRenderOpacity );
-          renderContext()->setCoordinateTransform( QgsCoordinateTransform( item->crs(), renderContext()->coordinateTransform().destinationCrs(), renderContext()->transformContext() ) );
-          item->render( *renderContext() );
-          renderContext()->painter()->restore();
-        }
+        renderItems( *renderContext(), mRenderItems );
       }
       return true;
     }
@@ -63,21 +95,191 @@ class KadasItemLayer::Renderer : public QgsMapLayerRenderer
   private:
     QList<KadasMapItem *> mRenderItems;
     double mRenderOpacity = 1.;
+
+    // Layout of the horizontal bands, for a map image of mBandLayoutHeight logical pixels
+    int mBandLayoutHeight = 0;
+    int mBandHeight = 0;
+    QVector<QList<KadasMapItem *>> mBandItems;
+    // Items painted by several bands are cloned for each additional band
+    std::vector<std::unique_ptr<KadasMapItem>> mBandClones;
+
+    void renderItems( QgsRenderContext &context, const QList<KadasMapItem *> &items ) const
+    {
+      bool omitSinglePoint = context.customProperties().contains( "globe" );
+      for ( const KadasMapItem *item : items )
+      {
+        if ( item && item->isVisible() && ( !omitSinglePoint || !item->isPointSymbol() ) )
+        {
+          context.painter()->save();
+          context.painter()->setOpacity( mRenderOpacity );
+          context.setCoordinateTransform( QgsCoordinateTransform( item->crs(), context.coordinateTransform().destinationCrs(), context.transformContext() ) );
+          item->render( context );
+          context.painter()->restore();
+        }
+      }
+    }
+
+    // Assigns the items to horizontal bands of the map image. Items may cache render state lazily,
+    // so an item touching several bands is cloned for each additional band rather than being rendered
+    // concurrently. The clones are created here on the GUI thread, like the render items themselves.
+    void prepareBands( const QgsRenderContext &context, double screenDpi )
+    {
+      int height = context.mapToPixel().mapHeight();
+      int bandCount = std::min( QThreadPool::globalInstance()->maxThreadCount(), height / sMinRenderBandHeight );
+      if ( bandCount < 2 )
+      {
+        return;
+      }
+      int bandHeight = ( height + bandCount - 1 ) / bandCount;
+
+      // Screen rows covered by the item bounds, unbounded if they cannot be transformed
+      struct ItemRows
+      {
+          KadasMapItem *item;
+          double top;
+          double bottom;
+      };
+      QVector<ItemRows> itemRows;
+      itemRows.reserve( mRenderItems.size() );
+      int maxItemMargin = 0;
+      const QgsMapToPixel &mapToPixel = context.mapToPixel();
+      QgsCoordinateTransform crst;
+      for ( KadasMapItem *item : std::as_const( mRenderItems ) )
+      {
+        if ( !item->isVisible() )
+        {
+          continue;
+        }
+        ItemRows rows { item, -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity() };
+        try
+        {
+          if ( item->crs() != crst.sourceCrs() || !crst.isValid() )
+          {
+            crst = QgsCoordinateTransform( item->crs(), context.coordinateTransform().destinationCrs(), context.transformContext() );
+          }
+          QgsRectangle bbox = crst.transformBoundingBox( item->boundingBox() );
+          double top = std::numeric_limits<double>::max();
+          double bottom = std::numeric_limits<double>::lowest();
+          for ( const QgsPointXY &corner : { QgsPointXY( bbox.xMinimum(), bbox.yMinimum() ), QgsPointXY( bbox.xMinimum(), bbox.yMaximum() ), QgsPointXY( bbox.xMaximum(), bbox.yMinimum() ), QgsPointXY( bbox.xMaximum(), bbox.yMaximum() ) } )
+          {
+            double y = mapToPixel.transform( corner ).y();
+            top = std::min( top, y );
+            bottom = std::max( bottom, y );
+          }
+          if ( std::isfinite( top ) && std::isfinite( bottom ) )
+          {
+            rows.top = top;
+            rows.bottom = bottom;
+          }
+        }
+        catch ( const QgsCsException & )
+        {
+          // Painted in all bands
+        }
+        KadasMapItem::Margin margin = item->margin();
+        maxItemMargin = std::max( maxItemMargin, std::max( std::max( margin.left, margin.right ), std::max( margin.top, margin.bottom ) ) );
+        itemRows.append( rows );
+      }
+
+      // Items may extend beyond their bounds by up to the maximum item margin, which grows with the output dpi,
+      // plus a pixel of antialiasing
+      double padding = maxItemMargin * std::max( 1., context.scaleFactor() * 25.4 / screenDpi ) + 1;
+      mBandItems.resize( bandCount );
+      for ( const ItemRows &rows : std::as_const( itemRows ) )
+      {
+        KadasMapItem *item = rows.item;
+        for ( int band = 0; band < bandCount; ++band )
+        {
+          int top = band * bandHeight;
+          int bottom = std::min( top + bandHeight, height );
+          if ( top >= height || rows.bottom + padding < top || rows.top - padding > bottom )
+          {
+            continue;
+          }
+          if ( !item )
+          {
+            mBandClones.emplace_back( rows.item->clone() );
+            item = mBandClones.back().get();
+          }
+          mBandItems[band].append( item );
+          item = nullptr;
+        }
+      }
+      mBandLayoutHeight = height;
+      mBandHeight = bandHeight;
+    }
+
+    // Renders the horizontal bands of the layer image in parallel, each band painting its items
+    // in z-order directly into its rows. Returns false if the painter does not allow it.
+    bool renderBands()
+    {
+      QPainter *painter = renderContext()->painter();
+      if ( painter->device()->devType() != QInternal::Image )
+      {
+        return false;
+      }
+      QImage *image = static_cast<QImage *>( painter->device() );
+      if ( image->depth() != 32 || painter->hasClipping() || !painter->transform().isIdentity() || painter->compositionMode() != QPainter::CompositionMode_SourceOver )
+      {
+        return false;
+      }
+      // Bands start at whole logical pixels, so that items are rasterized exactly as when painted at once
+      int dpr = qRound( image->devicePixelRatioF() );
+      if ( dpr < 1 || !qgsDoubleNear( image->devicePixelRatioF(), dpr ) )
+      {
+        return false;
+      }
+      int height = image->height() / dpr;
+      if ( height != mBandLayoutHeight )
+      {
+        return false;
+      }
+
+      uchar *bits = image->bits();
+      QVector<int> bands( mBandItems.size() );
+      std::iota( bands.begin(), bands.end(), 0 );
+      QtConcurrent::blockingMap( bands, [&]( int band ) {
+        int top = band * mBandHeight;
+        int rows = std::min( mBandHeight, height - top );
+        if ( rows <= 0 )
+        {
+          return;
+        }
+        // The band image shares the rows of the layer image
+        QImage bandImage( bits + qsizetype( top ) * dpr * image->bytesPerLine(), image->width(), rows * dpr, image->bytesPerLine(), image->format() );
+        bandImage.setDevicePixelRatio( image->devicePixelRatioF() );
+        QPainter bandPainter( &bandImage );
+        bandPainter.setRenderHints( painter->renderHints() );
+        bandPainter.setPen( painter->pen() );
+        bandPainter.setBrush( painter->brush() );
+        bandPainter.setFont( painter->font() );
+        bandPainter.translate( 0, -top );
+        QgsRenderContext context( *renderContext() );
+        context.setPainter( &bandPainter );
+        renderItems( context, mBandItems[band] );
+      } );
+      return true;
+    }
 };
 
 
 KadasItemLayer::KadasItemLayer( const QString &name, const QgsCoordinateReferenceSystem &crs )
   : KadasPluginLayer( layerType(), name )
+  , mSearchIndex( std::make_shared<KadasItemSearchIndex>() )
 {
   setCrs( crs );
   mValid = true;
+  // Serialized file paths are relative to the project home
+  connect( QgsProject::instance(), &QgsProject::homePathChanged, this, &KadasItemLayer::clearItemXmlCache );
 }
 
 KadasItemLayer::KadasItemLayer( const QString &name, const QgsCoordinateReferenceSystem &crs, const QString &layerType )
   : KadasPluginLayer( layerType, name )
+  , mSearchIndex( std::make_shared<KadasItemSearchIndex>() )
 {
   setCrs( crs );
   mValid = true;
+  connect( QgsProject::instance(), &QgsProject::homePathChanged, this, &KadasItemLayer::clearItemXmlCache );
 }
 
 KadasItemLayer::~KadasItemLayer()
@@ -85,6 +287,12 @@ KadasItemLayer::~KadasItemLayer()
   qDeleteAll( mItems );
 }
 
+QgsRectangle KadasItemLayer::computeItemBounds( const KadasMapItem *item ) const
+{
+  QgsCoordinateTransform trans( item->crs(), crs(), mTransformContext );
+  return trans.transformBoundingBox( item->boundingBox() );
+}
+
 KadasItemLayer::ItemId KadasItemLayer::addItem( KadasMapItem *item )
 {
   ItemId id = ITEM_ID_NULL;
@@ -99,9 +307,9 @@ KadasItemLayer::ItemId KadasItemLayer::addItem( KadasMapItem *item )
   item->setOwnerLayer( this );
   mItems.insert( id, item );
   mItemOrder.append( id );
-  QgsCoordinateTransform trans( item->crs(), crs(), mTransformContext );
-  mItemBounds.insert( id, trans.transformBoundingBox( item->boundingBox() ) );
+  mItemBounds.insert( id, computeItemBounds( item ) );
   item->setSymbolScale( mSymbolScale );
+  trackItem( id, item );
   emit itemAdded( id );
   emit repaintRequested();
   return id;
@@ -112,6 +320,7 @@ void KadasItemLayer::lowerItem( const ItemId &itemId )
   int pos = mItemOrder.indexOf( itemId );
   mItemOrder.removeAt( pos );
   mItemOrder.insert( std::max( 0, pos - 1 ), itemId );
+  ++mPendingItemChanges;
   emit repaintRequested();
 }
 
@@ -120,6 +329,7 @@ void KadasItemLayer::raiseItem( const ItemId &itemId )
   int pos = mItemOrder.indexOf( itemId );
   mItemOrder.removeAt( pos );
   mItemOrder.insert( std::min( mItemOrder.length(), pos + 1 ), itemId );
+  ++mPendingItemChanges;
   emit repaintRequested();
 }
 
@@ -129,9 +339,20 @@ KadasMapItem *KadasItemLayer::takeItem( const ItemId &itemId )
   if ( item )
   {
     item->setOwnerLayer( nullptr );
+    disconnect( item, &KadasMapItem::changed, this, nullptr );
+    disconnect( item, &KadasMapItem::propertyChanged, this, nullptr );
     mFreeIds.append( itemId );
+    if ( mSpatialIndex )
+    {
+      QgsFeature feature( itemId );
+      feature.setGeometry( QgsGeometry::fromRect( mItemBounds[itemId] ) );
+      mSpatialIndex->deleteFeature( feature );
+    }
+    mDirtyItemBounds.remove( itemId );
     mItemBounds.remove( itemId );
     mItemOrder.removeOne( itemId );
+    invalidateItemXml( itemId );
+    mSearchIndex->remove( itemId );
     emit itemRemoved( itemId );
     emit repaintRequested();
   }
@@ -145,7 +366,9 @@ KadasItemLayer *KadasItemLayer::clone() const
   layer->mOpacity = mOpacity;
   for ( auto it = mItems.begin(), itEnd = mItems.end(); it != itEnd; ++it )
   {
-    layer->mItems.insert( it.key(), it.value()->clone() );
+    KadasMapItem *item = it.value()->clone();
+    layer->mItems.insert( it.key(), item );
+    layer->trackItem( it.key(), item );
   }
   return layer;
 }
@@ -177,8 +400,15 @@ bool KadasItemLayer::readXml( const QDomNode &layer_node, QgsReadWriteContext &c
 {
   qDeleteAll( mItems );
   mItems.clear();
+  mItemOrder.clear();
+  mItemBounds.clear();
   mIdCounter = 0;
   mFreeIds.clear();
+  mSpatialIndex.reset();
+  mDirtyItemBounds.clear();
+  mMaxItemMargin = 0;
+  mSearchIndex->clear();
+  clearItemXmlCache();
 
   QDomElement layerEl = layer_node.toElement();
   mLayerName = layerEl.attribute( "title" );
@@ -198,18 +428,31 @@ bool KadasItemLayer::readXml( const QDomNode &layer_node, QgsReadWriteContext &c
   }
 
   QDomNodeList itemEls = layerEl.elementsByTagName( "MapItem" );
+
+  // Parsing the item data does not touch any shared state and is done in parallel,
+  // the items themselves are then created on the thread owning the layer
+  QVector<QByteArray> itemData;
+  itemData.reserve( itemEls.size() );
   for ( int i = 0, n = itemEls.size(); i < n; ++i )
   {
-    KadasMapItem *item = KadasMapItem::fromXml( itemEls.at( i ).toElement() );
+    itemData.append( itemEls.at( i ).firstChild().toCDATASection().data().toLocal8Bit() );
+  }
+  QVector<QJsonObject> itemJson = QtConcurrent::blockingMapped<QVector<QJsonObject>>( itemData, parseItemData );
+  itemData.clear();
+
+  for ( int i = 0, n = itemEls.size(); i < n; ++i )
+  {
+    KadasMapItem *item = KadasMapItem::fromXml( itemEls.at( i ).toElement(), itemJson[i] );
     if ( item )
     {
       item->setOwnerLayer( this );
       mItems.insert( ++mIdCounter, item );
       mItemOrder.append( mIdCounter );
-      QgsCoordinateTransform trans( item->crs(), crs(), mTransformContext );
-      mItemBounds.insert( mIdCounter, trans.transformBoundingBox( item->boundingBox() ) );
+      mItemBounds.insert( mIdCounter, computeItemBounds( item ) );
+      trackItem( mIdCounter, item );
     }
   }
+  mPendingItemChanges = 0;
   return true;
 }
 
@@ -224,15 +467,95 @@ bool KadasItemLayer::writeXml( QDomNode &layer_node, QDomDocument &document, con
   layerEl.setAttribute( QStringLiteral( "minScale" ), minimumScale() );
   for ( auto it = mItemOrder.begin(), itEnd = mItemOrder.end(); it != itEnd; ++it )
   {
-    layerEl.appendChild( mItems[*it]->writeXml( document ) );
+    auto cacheIt = mItemXmlElements.find( *it );
+    if ( cacheIt == mItemXmlElements.end() )
+    {
+      cacheIt = mItemXmlElements.insert( *it, mItems[*it]->writeXml( mItemXmlCache ) );
+    }
+    layerEl.appendChild( document.importNode( cacheIt.value(), true ) );
   }
+  mPendingItemChanges = 0;
   return true;
 }
 
+void KadasItemLayer::trackItem( ItemId itemId, KadasMapItem *item )
+{
+  connect( item, &KadasMapItem::changed, this, [this, itemId, item] {
+    invalidateItemXml( itemId );
+    mDirtyItemBounds.insert( itemId );
+    indexItem( itemId, item );
+  } );
+  connect( item, &KadasMapItem::propertyChanged, this, [this, itemId, item] {
+    indexItem( itemId, item );
+  } );
+  mDirtyItemBounds.insert( itemId );
+  indexItem( itemId, item );
+  ++mPendingItemChanges;
+}
+
+void KadasItemLayer::indexItem( ItemId itemId, const KadasMapItem *item )
+{
+  const KadasSymbolItem *symbolItem = dynamic_cast<const KadasSymbolItem *>( item );
+  if ( symbolItem )
+  {
+    mSearchIndex->insert( { itemId, symbolItem->name(), symbolItem->remarks(), symbolItem->constState()->pos, symbolItem->crs().authid() } );
+  }
+}
+
+void KadasItemLayer::updateSpatialIndex() const
+{
+  if ( !mSpatialIndex )
+  {
+    mSpatialIndex = std::make_unique<QgsSpatialIndex>();
+    mDirtyItemBounds = QSet<ItemId>( mItems.keyBegin(), mItems.keyEnd() );
+  }
+  else
+  {
+    for ( ItemId itemId : std::as_const( mDirtyItemBounds ) )
+    {
+      QgsFeature feature( itemId );
+      feature.setGeometry( QgsGeometry::fromRect( mItemBounds[itemId] ) );
+      mSpatialIndex->deleteFeature( feature );
+    }
+  }
+  for ( ItemId itemId : std::as_const( mDirtyItemBounds ) )
+  {
+    const KadasMapItem *item = mItems.value( itemId );
+    QgsRectangle bounds = computeItemBounds( item );
+    mItemBounds[itemId] = bounds;
+    mSpatialIndex->addFeature( itemId, bounds );
+    KadasMapItem::Margin margin = item->margin();
+    mMaxItemMargin = std::max( mMaxItemMargin, std::max( std::max( margin.left, margin.right ), std::max( margin.top, margin.bottom ) ) );
+  }
+  mDirtyItemBounds.clear();
+}
+
+void KadasItemLayer::invalidateItemXml( ItemId itemId )
+{
+  mItemXmlElements.remove( itemId );
+  ++mPendingItemChanges;
+}
+
+void KadasItemLayer::clearItemXmlCache()
+{
+  mItemXmlElements.clear();
+  mItemXmlCache = QDomDocument();
+}
+
 KadasItemLayer::ItemId KadasItemLayer::pickItem( const KadasMapPos &mapPos, const QgsMapSettings &mapSettings, KadasItemLayer::PickObjective pickObjective ) const
 {
+  QgsRenderContext renderContext = QgsRenderContext::fromMapSettings( mapSettings );
+  double radiusmm = QgsSettings().value( "/Map/searchRadiusMM", Qgis::DEFAULT_SEARCH_RADIUS_MM ).toDouble();
+  radiusmm = radiusmm > 0 ? radiusmm : Qgis::DEFAULT_SEARCH_RADIUS_MM;
+  double radiusmu = radiusmm * renderContext.scaleFactor() * renderContext.mapToPixel().mapUnitsPerPixel();
+  const QSet<ItemId> candidates = candidateItems( KadasMapRect( mapPos, radiusmu ), mapSettings );
+
   for ( auto it = mItemOrder.rbegin(), itEnd = mItemOrder.rend(); it != itEnd; ++it )
   {
+    if ( !candidates.contains( *it ) )
+    {
+      continue;
+    }
     KadasMapItem *item = mItems[*it];
     if ( pickObjective == PickObjective::PICK_OBJECTIVE_TOOLTIP && item->tooltip().isEmpty() )
     {
@@ -251,6 +574,67 @@ KadasItemLayer::ItemId KadasItemLayer::pickItem( const QgsRectangle &pickRect, c
   return pickItem( KadasMapPos::fromPoint( pickRect.center() ), mapSettings );
 }
 
+QSet<KadasItemLayer::ItemId> KadasItemLayer::candidateItems( const KadasMapRect &mapRect, const QgsMapSettings &mapSettings ) const
+{
+  updateSpatialIndex();
+
+  // Items may extend beyond their bounding box by their screen margin, which grows with the output dpi
+  double dpiScale = std::max( 1., mapSettings.outputDpi() / KadasRenderSnapshot::capture().screenDpi );
+  QgsRectangle queryRect = mapRect;
+  queryRect.grow( mMaxItemMargin * dpiScale * mapSettings.mapUnitsPerPixel() );
+  queryRect = QgsCoordinateTransform( mapSettings.destinationCrs(), crs(), mTransformContext ).transformBoundingBox( queryRect );
+
+  QSet<ItemId> candidates;
+  for ( QgsFeatureId id : mSpatialIndex->intersects( queryRect ) )
+  {
+    candidates.insert( static_cast<ItemId>( id ) );
+  }
+  return candidates;
+}
+
+QList<KadasItemLayer::ItemId> KadasItemLayer::itemsInRect( const KadasMapRect &mapRect, const QgsMapSettings &mapSettings, bool contains ) const
+{
+  struct Candidate
+  {
+      ItemId id;
+      const KadasMapItem *item;
+      bool hit;
+  };
+  QVector<Candidate> candidates;
+  for ( ItemId itemId : candidateItems( mapRect, mapSettings ) )
+  {
+    candidates.append( { itemId, mItems.value( itemId ), false } );
+  }
+
+  auto hitTest = [&mapRect, &mapSettings, contains]( Candidate &candidate ) {
+    candidate.hit = candidate.item->intersects( mapRect, mapSettings, contains );
+  };
+  if ( candidates.size() > sParallelHitTestThreshold )
+  {
+    // Cached hit test state must not be built concurrently by the pool threads
+    for ( const Candidate &candidate : std::as_const( candidates ) )
+    {
+      candidate.item->prepareHitTest();
+    }
+    QtConcurrent::blockingMap( candidates, hitTest );
+  }
+  else
+  {
+    std::for_each( candidates.begin(), candidates.end(), hitTest );
+  }
+
+  QList<ItemId> result;
+  for ( const Candidate &candidate : std::as_const( candidates ) )
+  {
+    if ( candidate.hit )
+    {
+      result.append( candidate.id );
+    }
+  }
+  std::sort( result.begin(), result.end() );
+  return result;
+}
+
 QPair<QgsPointXY, double> KadasItemLayer::snapToVertex( const QgsPointXY &mapPos, const QgsMapSettings &settings, double tolPixels ) const
 {
   QgsCoordinateTransform crst( crs(), settings.destinationCrs(), mTransformContext );
@@ -300,9 +684,13 @@ QString KadasItemLayer::asKml( const QgsRenderContext &context, QuaZip *kmzZip,
 void KadasItemLayer::setSymbolScale( double scale )
 {
   mSymbolScale = scale;
+  // Item margins scale with the symbols, the maximum may shrink
+  mMaxItemMargin = 0;
   for ( KadasMapItem *item : mItems )
   {
     item->setSymbolScale( scale );
+    KadasMapItem::Margin margin = item->margin();
+    mMaxItemMargin = std::max( mMaxItemMargin, std::max( std::max( margin.left, margin.right ), std::max( margin.top, margin.bottom ) ) );
   }
   triggerRepaint();
 }
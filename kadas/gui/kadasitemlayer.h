@@ -17,6 +17,11 @@
 #ifndef KADASITEMLAYER_H
 #define KADASITEMLAYER_H
 
+#include <QDomDocument>
+#include <QSet>
+
+#include <memory>
+
 #include <qgis/qgspluginlayer.h>
 #include <qgis/qgspluginlayerregistry.h>
 
@@ -24,9 +29,12 @@
 #include "kadas/gui/kadas_gui.h"
 
 class QMenu;
+class KadasItemSearchIndex;
 class QuaZip;
+class QgsSpatialIndex;
 class KadasMapItem;
 class KadasMapPos;
+class KadasMapRect;
 
 #ifdef SIP_RUN
 // clang-format off
@@ -168,6 +176,8 @@ class KADAS_GUI_EXPORT KadasItemLayer : public KadasPluginLayer
 #ifndef SIP_RUN
     // TODO: SIP
     QPair<QgsPointXY, double> snapToVertex( const QgsPointXY &pos, const QgsMapSettings &settings, double tolPixels ) const;
+    //! Returns the items intersecting (or, if contains is true, contained in) the specified map rectangle
+    QList<KadasItemLayer::ItemId> itemsInRect( const KadasMapRect &mapRect, const QgsMapSettings &mapSettings, bool contains = false ) const;
 #endif
 
 #ifndef SIP_RUN
@@ -177,6 +187,14 @@ class KADAS_GUI_EXPORT KadasItemLayer : public KadasPluginLayer
     void setSymbolScale( double scale );
     double symbolScale() const { return mSymbolScale; }
 
+    //! Returns the number of item modifications since the layer was last written to a project
+    int pendingItemChanges() const { return mPendingItemChanges; }
+
+#ifndef SIP_RUN
+    //! Returns the name/remarks index of the searchable items, which can be queried from any thread
+    std::shared_ptr<KadasItemSearchIndex> searchIndex() const { return mSearchIndex; }
+#endif
+
   signals:
     void itemAdded( KadasItemLayer::ItemId itemId );
     void itemRemoved( KadasItemLayer::ItemId itemId );
@@ -191,6 +209,30 @@ class KADAS_GUI_EXPORT KadasItemLayer : public KadasPluginLayer
     ItemId mIdCounter = 0;
     QVector<ItemId> mFreeIds;
     double mSymbolScale = 1.0;
+
+  private:
+    // Serialized items are cached and only rebuilt for items which changed since the last write
+    mutable QDomDocument mItemXmlCache;
+    mutable QMap<ItemId, QDomElement> mItemXmlElements;
+    mutable int mPendingItemChanges = 0;
+
+    // Spatial index over the item bounds, built on first use and updated lazily for changed items
+    mutable std::unique_ptr<QgsSpatialIndex> mSpatialIndex;
+    mutable QSet<ItemId> mDirtyItemBounds;
+    mutable int mMaxItemMargin = 0;
+
+    // Shared with running searches, which may outlive the layer
+    std::shared_ptr<KadasItemSearchIndex> mSearchIndex;
+
+    void trackItem( ItemId itemId, KadasMapItem *item );
+    void indexItem( ItemId itemId, const KadasMapItem *item );
+    void invalidateItemXml( ItemId itemId );
+    QgsRectangle computeItemBounds( const KadasMapItem *item ) const;
+    void updateSpatialIndex() const;
+    QSet<ItemId> candidateItems( const KadasMapRect &mapRect, const QgsMapSettings &mapSettings ) const;
+
+  private slots:
+    void clearItemXmlCache();
 };
 
 class KADAS_GUI_EXPORT KadasItemLayerType : public KadasPluginLayerType
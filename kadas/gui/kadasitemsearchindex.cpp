@@ -0,0 +1,130 @@
+/***************************************************************************
+    kadasitemsearchindex.cpp
+    ------------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QMutexLocker>
+
+#include <qgis/qgsfeedback.h>
+
+#include "kadas/gui/kadasitemsearchindex.h"
+
+
+QVector<KadasItemSearchIndex::Entry> KadasItemSearchIndex::Snapshot::search( const QString &string, int limit, QgsFeedback *feedback ) const
+{
+  QVector<Entry> results;
+  QString folded = string.toCaseFolded();
+  if ( folded.isEmpty() )
+  {
+    return results;
+  }
+
+  // Prefix matches are a contiguous range of the sorted names
+  auto begin = std::lower_bound( mFoldedNames.begin(), mFoldedNames.end(), folded );
+  auto end = begin;
+  while ( end != mFoldedNames.end() && end->startsWith( folded ) && results.size() < limit )
+  {
+    results.append( mEntries[end - mFoldedNames.begin()] );
+    ++end;
+  }
+  int prefixBegin = begin - mFoldedNames.begin();
+  int prefixEnd = end - mFoldedNames.begin();
+
+  for ( int i = 0, n = mEntries.size(); i < n && results.size() < limit; ++i )
+  {
+    if ( i == prefixBegin && prefixEnd > prefixBegin )
+    {
+      i = prefixEnd - 1;
+      continue;
+    }
+    if ( ( i % 1024 ) == 0 && feedback && feedback->isCanceled() )
+    {
+      break;
+    }
+    if ( mFoldedNames[i].contains( folded ) || mFoldedRemarks[i].contains( folded ) )
+    {
+      results.append( mEntries[i] );
+    }
+  }
+  return results;
+}
+
+void KadasItemSearchIndex::insert( const Entry &entry )
+{
+  QMutexLocker locker( &mMutex );
+  mEntries.insert( entry.itemId, entry );
+  ++mRevision;
+  mSnapshot.reset();
+}
+
+void KadasItemSearchIndex::remove( unsigned itemId )
+{
+  QMutexLocker locker( &mMutex );
+  if ( mEntries.remove( itemId ) > 0 )
+  {
+    ++mRevision;
+    mSnapshot.reset();
+  }
+}
+
+void KadasItemSearchIndex::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mEntries.clear();
+  ++mRevision;
+  mSnapshot.reset();
+}
+
+std::shared_ptr<const KadasItemSearchIndex::Snapshot> KadasItemSearchIndex::snapshot() const
+{
+  // Only copy the entries under the lock, folding and sorting must not block insertions
+  QHash<unsigned, Entry> entries;
+  quint64 revision = 0;
+  {
+    QMutexLocker locker( &mMutex );
+    if ( mSnapshot )
+    {
+      return mSnapshot;
+    }
+    entries = mEntries;
+    revision = mRevision;
+  }
+
+  QVector<QPair<QString, const Entry *>> sorted;
+  sorted.reserve( entries.size() );
+  for ( auto it = entries.cbegin(), itEnd = entries.cend(); it != itEnd; ++it )
+  {
+    sorted.append( qMakePair( it.value().name.toCaseFolded(), &it.value() ) );
+  }
+  std::sort( sorted.begin(), sorted.end(), []( const QPair<QString, const Entry *> &a, const QPair<QString, const Entry *> &b ) { return a.first < b.first; } );
+
+  std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+  snapshot->mEntries.reserve( sorted.size() );
+  snapshot->mFoldedNames.reserve( sorted.size() );
+  snapshot->mFoldedRemarks.reserve( sorted.size() );
+  for ( const QPair<QString, const Entry *> &pair : std::as_const( sorted ) )
+  {
+    snapshot->mEntries.append( *pair.second );
+    snapshot->mFoldedNames.append( pair.first );
+    snapshot->mFoldedRemarks.append( pair.second->remarks.toCaseFolded() );
+  }
+
+  QMutexLocker locker( &mMutex );
+  // Don't cache a snapshot which the index changed since
+  if ( mRevision == revision && !mSnapshot )
+  {
+    mSnapshot = snapshot;
+  }
+  return snapshot;
+}
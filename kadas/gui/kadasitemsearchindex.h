@@ -0,0 +1,80 @@
+/***************************************************************************
+    kadasitemsearchindex.h
+    ----------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASITEMSEARCHINDEX_H
+#define KADASITEMSEARCHINDEX_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include <memory>
+
+#include <qgis/qgspointxy.h>
+
+#include "kadas/gui/kadas_gui.h"
+
+#define SIP_NO_FILE
+
+class QgsFeedback;
+
+/**
+ * Name/remarks index of the searchable items of an item layer.
+ * The index is updated by the thread owning the layer, searches run on
+ * immutable snapshots and hence never touch the live items.
+ */
+class KADAS_GUI_EXPORT KadasItemSearchIndex
+{
+  public:
+    struct Entry
+    {
+        unsigned itemId = 0;
+        QString name;
+        QString remarks;
+        QgsPointXY pos;
+        QString crs;
+    };
+
+    class KADAS_GUI_EXPORT Snapshot
+    {
+      public:
+        //! Returns the entries whose name starts with the string, followed by those whose name or remarks contain it (case insensitive)
+        QVector<Entry> search( const QString &string, int limit, QgsFeedback *feedback = nullptr ) const;
+        int size() const { return mEntries.size(); }
+
+      private:
+        friend class KadasItemSearchIndex;
+        // Sorted by folded name
+        QVector<Entry> mEntries;
+        QVector<QString> mFoldedNames;
+        QVector<QString> mFoldedRemarks;
+    };
+
+    void insert( const Entry &entry );
+    void remove( unsigned itemId );
+    void clear();
+
+    //! Returns a consistent snapshot of the index, rebuilt on demand if the index changed since the last call
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+  private:
+    mutable QMutex mMutex;
+    QHash<unsigned, Entry> mEntries;
+    quint64 mRevision = 0; // Incremented on every change of mEntries
+    mutable std::shared_ptr<const Snapshot> mSnapshot;
+};
+
+#endif // KADASITEMSEARCHINDEX_H
@@ -33,6 +33,7 @@
 #include "kadas/gui/kadasmapcanvasitem.h"
 #include "kadas/gui/kadasmapcanvasitemmanager.h"
 #include "kadas/gui/kadasmapwidget.h"
+#include "kadas/gui/kadassharedrendercache.h"
 #include "kadas/gui/mapitems/kadasmapitem.h"
 #include "kadas/gui/maptools/kadasmaptoolpan.h"
 
@@ -108,6 +109,7 @@ KadasMapWidget::KadasMapWidget( int number, const QString &id, const QString &ti
   }
 
   connect( mMasterCanvas, &QgsMapCanvas::extentsChanged, this, &KadasMapWidget::syncCanvasExtents );
+  connect( mMasterCanvas, &QgsMapCanvas::mapCanvasRefreshed, this, &KadasMapWidget::masterCanvasRefreshed );
   connect( mMasterCanvas, &QgsMapCanvas::destinationCrsChanged, this, &KadasMapWidget::updateMapProjection );
   connect( QgsProject::instance()->layerTreeRoot(), &QgsLayerTree::layerOrderChanged, this, &KadasMapWidget::updateLayerSelectionMenu );
   connect( mMapCanvas, &QgsMapCanvas::xyCoordinates, mMasterCanvas, &QgsMapCanvas::xyCoordinates );
@@ -198,10 +200,34 @@ void KadasMapWidget::syncCanvasExtents()
 {
   if ( mLockViewButton->isChecked() )
   {
+    double mupp = mMasterCanvas->mapUnitsPerPixel();
+    int w = mMapCanvas->width();
+    int h = mMapCanvas->height();
+    // Align to the pixel grid of the main view, so that its rendered layer images can be reused
+    QSize masterSize = mMasterCanvas->mapSettings().outputSize();
     QgsPointXY center = mMasterCanvas->extent().center();
-    double w = width() * mMasterCanvas->mapUnitsPerPixel();
-    double h = height() * mMasterCanvas->mapUnitsPerPixel();
-    setMapExtent( QgsRectangle( center.x() - .5 * w, center.y() - .5 * h, center.x() + .5 * w, center.y() + .5 * h ) );
+    center.setX( center.x() - ( ( masterSize.width() - w ) % 2 ) * 0.5 * mupp );
+    center.setY( center.y() + ( ( masterSize.height() - h ) % 2 ) * 0.5 * mupp );
+    mMapCanvas->setExtent( QgsRectangle( center.x() - .5 * w * mupp, center.y() - .5 * h * mupp, center.x() + .5 * w * mupp, center.y() + .5 * h * mupp ) );
+    if ( KadasSharedRenderCache::canShare( mMapCanvas, mMasterCanvas ) )
+    {
+      // Refreshed once the main view has rendered
+      mAwaitingMasterRender = true;
+    }
+    else
+    {
+      mMapCanvas->refresh();
+    }
+  }
+}
+
+void KadasMapWidget::masterCanvasRefreshed()
+{
+  if ( mAwaitingMasterRender )
+  {
+    mAwaitingMasterRender = false;
+    KadasSharedRenderCache::seed( mMapCanvas, mMasterCanvas );
+    mMapCanvas->refresh();
   }
 }
 
@@ -71,10 +71,12 @@ class KADAS_GUI_EXPORT KadasMapWidget : public QDockWidget
     QgsMapCanvas *mMapCanvas;
     QStringList mInitialLayers;
     bool mUnsetFixedSize = true;
+    bool mAwaitingMasterRender = false;
 
   private slots:
     void setCanvasLocked( bool locked );
     void syncCanvasExtents();
+    void masterCanvasRefreshed();
     void updateLayerSelectionMenu();
     void updateLayerSet();
     void updateMapProjection();
@@ -23,6 +23,9 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMap>
+#include <QTemporaryFile>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 #include <qgis/qgscircularstring.h>
 #include <qgis/qgslinestring.h>
@@ -48,6 +51,76 @@
 #include "kadas/gui/milx/kadasmilxlayer.h"
 
 
+static QDomElement readDomElement( QXmlStreamReader &reader, QDomDocument &doc )
+{
+  // Reads the element at the current reader position, including its children, into a DOM element
+  QDomElement el = doc.createElement( reader.qualifiedName().toString() );
+  for ( const QXmlStreamAttribute &attr : reader.attributes() )
+  {
+    el.setAttribute( attr.qualifiedName().toString(), attr.value().toString() );
+  }
+  while ( !reader.atEnd() )
+  {
+    switch ( reader.readNext() )
+    {
+      case QXmlStreamReader::StartElement:
+        el.appendChild( readDomElement( reader, doc ) );
+        break;
+      case QXmlStreamReader::EndElement:
+        return el;
+      case QXmlStreamReader::Characters:
+        if ( reader.isCDATA() )
+        {
+          el.appendChild( doc.createCDATASection( reader.text().toString() ) );
+        }
+        else if ( !reader.isWhitespace() )
+        {
+          el.appendChild( doc.createTextNode( reader.text().toString() ) );
+        }
+        break;
+      case QXmlStreamReader::Comment:
+        el.appendChild( doc.createComment( reader.text().toString() ) );
+        break;
+      default:
+        break;
+    }
+  }
+  return el;
+}
+
+static void writeDomNode( QXmlStreamWriter &writer, const QDomNode &node )
+{
+  if ( node.isElement() )
+  {
+    QDomElement el = node.toElement();
+    writer.writeStartElement( el.tagName() );
+    QDomNamedNodeMap attributes = el.attributes();
+    for ( int i = 0, n = attributes.size(); i < n; ++i )
+    {
+      QDomAttr attr = attributes.item( i ).toAttr();
+      writer.writeAttribute( attr.name(), attr.value() );
+    }
+    for ( QDomNode child = el.firstChild(); !child.isNull(); child = child.nextSibling() )
+    {
+      writeDomNode( writer, child );
+    }
+    writer.writeEndElement();
+  }
+  else if ( node.isCDATASection() )
+  {
+    writer.writeCDATA( node.nodeValue() );
+  }
+  else if ( node.isText() )
+  {
+    writer.writeCharacters( node.nodeValue() );
+  }
+  else if ( node.isComment() )
+  {
+    writer.writeComment( node.nodeValue() );
+  }
+}
+
+
 QString KadasProjectMigration::migrateProject( const QString &fileName, QStringList &filesToAttach )
 {
   QFile file( fileName );
@@ -55,28 +128,37 @@ QString KadasProjectMigration::migrateProject( const QString &fileName, QStringL
   {
     return fileName;
   }
+  QString basedir = QFileInfo( fileName ).path();
 
+  // Annotation items are stored outside of the layers they belong to, collect them first
   QDomDocument doc;
-  if ( !doc.setContent( &file ) )
+  QString gpsRoutesLayerId;
+  AnnotationItems annotationItems;
+  RedliningLayerHeaders redliningLayerHeaders;
+  QStringList annotationFiles;
+  if ( !scanKadas1xProject( &file, doc, basedir, gpsRoutesLayerId, annotationItems, redliningLayerHeaders, annotationFiles ) )
   {
-    QgsDebugMsgLevel( "Failed to parse project", 2 );
     return fileName;
   }
-  QString basedir = QFileInfo( fileName ).path();
 
-  if ( migrateProjectXml( basedir, doc, filesToAttach ) )
+  QTemporaryFile tempFile;
+  tempFile.setAutoRemove( false );
+  if ( !tempFile.open() )
   {
-    QTemporaryFile tempFile;
-    tempFile.setAutoRemove( false );
-    if ( tempFile.open() )
-    {
-      tempFile.write( doc.toString().toLocal8Bit() );
-      tempFile.close();
-      return tempFile.fileName();
-    }
+    return fileName;
   }
-
-  return fileName;
+  file.seek( 0 );
+  QStringList datasourceFiles;
+  if ( !writeKadas1xProject( &file, &tempFile, basedir, gpsRoutesLayerId, annotationItems, redliningLayerHeaders, datasourceFiles ) )
+  {
+    QgsDebugMsgLevel( "Failed to migrate project", 2 );
+    tempFile.remove();
+    return fileName;
+  }
+  tempFile.close();
+  filesToAttach.append( datasourceFiles );
+  filesToAttach.append( annotationFiles );
+  return tempFile.fileName();
 }
 
 bool KadasProjectMigration::migrateProjectXml( const QString &basedir, QDomDocument &doc, QStringList &filesToAttach )
@@ -153,334 +235,640 @@ void KadasProjectMigration::migrateKadas1xTo2x( QDomDocument &doc, QDomElement &
     QDomNodeList redliningItems = mapLayerEl.elementsByTagName( "RedliningItem" );
     for ( int i = 0, n = redliningItems.size(); i < n; ++i )
     {
-      QDomElement redliningItemEl = redliningItems.at( i ).toElement();
-      QMap<QString, QString> flags = deserializeLegacyRedliningFlags( redliningItemEl.attribute( "flags" ) );
+      QDomElement mapItemEl = migrateRedliningItem( doc, redliningItems.at( i ).toElement(), crs, isGps );
+      if ( !mapItemEl.isNull() )
+      {
+        newMapLayerEl.appendChild( mapItemEl );
+      }
+    }
+    root.firstChildElement( "projectlayers" ).replaceChild( newMapLayerEl, mapLayerEl );
+  }
+
+  // Annotation items: convert layers and items. A layer may contain annotation items of different types.
+  QMap<QString, QDomElement> newMapLayerEls;
+  for ( const QString &tagName : { QString( "SVGAnnotationItem" ), QString( "GeoImageAnnotationItem" ), QString( "PinAnnotationItem" ) } )
+  {
+    QDomNodeList annotationItems = root.elementsByTagName( tagName );
+    for ( int i = 0, n = annotationItems.size(); i < n; ++i )
+    {
+      QDomElement itemEl = annotationItems.at( i ).toElement();
+      QString layerId = itemEl.firstChildElement( "AnnotationItem" ).attribute( "layerId" );
 
-      KadasMapItem *item = nullptr;
-      if ( !redliningItemEl.attribute( "text" ).isEmpty() && flags["shape"] == "point" && flags["symbol"].isEmpty() )
+      if ( !newMapLayerEls.contains( layerId ) )
       {
-        QgsPoint point;
-        point.fromWkt( redliningItemEl.attribute( "geometry" ) );
-        QColor outline = QgsSymbolLayerUtils::decodeColor( redliningItemEl.attribute( "outline" ) );
-        outline.setAlpha( 255 ); // KADAS 1 ignored outline transparency;
-        QColor fill = QgsSymbolLayerUtils::decodeColor( redliningItemEl.attribute( "fill" ) );
-        fill.setAlpha( 255 ); // KADAS 1 ignored fill transparency;
-
-        KadasTextItem *textItem = new KadasTextItem( crs );
-        textItem->setText( redliningItemEl.attribute( "text" ) );
-        textItem->setPosition( KadasItemPos::fromPoint( point ) );
-        textItem->setAngle( flags["rotation"].toDouble() );
-        textItem->setOutlineColor( outline );
-        textItem->setFillColor( fill );
-        textItem->state()->mRectangleCenterPoint.setX( 0 );
-        textItem->state()->mRectangleCenterPoint.setY( 1. );
-
-        QFont font;
-        font.setBold( flags["bold"].toInt() != 0 );
-        font.setFamily( flags["family"] );
-        font.setPointSize( flags["fontSize"].toInt() );
-        font.setItalic( flags["italic"].toInt() != 0 );
-        textItem->setFont( font );
-
-        textItem->setEditor( "KadasRedliningTextEditor" );
-
-        item = textItem;
+        newMapLayerEls[layerId] = replaceAnnotationLayer( doc, root, layerId );
+      }
+      QDomElement newMapLayerEl = newMapLayerEls[layerId];
+      if ( newMapLayerEl.isNull() )
+      {
+        continue;
+      }
+
+      if ( tagName == "SVGAnnotationItem" )
+      {
+        newMapLayerEl.appendChild( migrateSvgAnnotationItem( doc, itemEl, basedir, filesToAttach ) );
+      }
+      else if ( tagName == "GeoImageAnnotationItem" )
+      {
+        newMapLayerEl.appendChild( migrateImageAnnotationItem( doc, itemEl, basedir, filesToAttach ) );
       }
       else
       {
-        KadasGeometryItem *geomItem = nullptr;
-        QgsAbstractGeometry *geom = nullptr;
+        newMapLayerEl.appendChild( migratePinAnnotationItem( doc, itemEl ) );
+      }
+    }
+  }
 
-        if ( flags["shape"] == "point" )
-        {
-          geom = new QgsPoint();
-          geom->fromWkt( redliningItemEl.attribute( "geometry" ) );
+  // MilX
+  for ( int i = 0, n = maplayers.size(); i < n; ++i )
+  {
+    QDomElement mapLayerEl = maplayers.at( i ).toElement();
+    if ( mapLayerEl.attribute( "type" ) != "plugin" || mapLayerEl.attribute( "name" ) != "MilX_Layer" )
+    {
+      continue;
+    }
+    projectLayersEl.replaceChild( migrateMilxLayer( doc, mapLayerEl ), mapLayerEl );
+  }
 
-          if ( isGps )
-          {
-            geomItem = new KadasGpxWaypointItem();
-            static_cast<KadasGpxWaypointItem *>( geomItem )->setName( redliningItemEl.attribute( "text" ) );
-          }
-          else
-          {
-            KadasPointItem::IconType iconType = KadasPointItem::IconType::ICON_CIRCLE;
-            if ( flags["symbol"] == "circle" )
-            {
-              iconType = KadasPointItem::IconType::ICON_CIRCLE;
-            }
-            else if ( flags["symbol"] == "rectangle" )
-            {
-              iconType = KadasPointItem::IconType::ICON_FULL_BOX;
-            }
-            else if ( flags["symbol"] == "triangle" )
-            {
-              iconType = KadasPointItem::IconType::ICON_FULL_TRIANGLE;
-            }
-
-            geomItem = new KadasPointItem( crs, iconType );
-            geomItem->setEditor( "KadasRedliningItemEditor" );
-          }
+  // Changes to guide grid etc?
+}
+
+bool KadasProjectMigration::scanKadas1xProject( QIODevice *in, QDomDocument &doc, const QString &basedir, QString &gpsRoutesLayerId, AnnotationItems &annotationItems, RedliningLayerHeaders &redliningLayerHeaders, QStringList &filesToAttach )
+{
+  QXmlStreamReader reader( in );
+  reader.setNamespaceProcessing( false );
+  if ( !reader.readNextStartElement() || reader.qualifiedName() != QLatin1String( "qgis" ) )
+  {
+    QgsDebugMsgLevel( "Invalid project (incorrect root tag name)", 2 );
+    return false;
+  }
+  if ( reader.attributes().value( "version" ) != QLatin1String( "2.15.2-KADAS" ) )
+  {
+    return false;
+  }
+
+  // Same item order as the DOM based migration: all svg items, then all image items, then all pins
+  AnnotationItems svgItems;
+  AnnotationItems imageItems;
+  AnnotationItems pinItems;
+  QStringList svgFiles;
+  QStringList imageFiles;
+  bool haveGpsRoutes = false;
+  bool projectLayersSeen = false;
+  bool inProjectLayers = false;
+  // Depth of the children of the current map layer, and the header of the current redlining layer
+  int mapLayerChildDepth = 0;
+  QDomElement redliningHeaderEl;
+  int depth = 1;
+  while ( depth > 0 && !reader.atEnd() )
+  {
+    reader.readNext();
+    if ( reader.isEndElement() )
+    {
+      --depth;
+      if ( depth < mapLayerChildDepth )
+      {
+        mapLayerChildDepth = 0;
+        redliningHeaderEl = QDomElement();
+      }
+      if ( depth == 1 )
+      {
+        inProjectLayers = false;
+      }
+      continue;
+    }
+    else if ( !reader.isStartElement() )
+    {
+      continue;
+    }
+    QStringRef name = reader.qualifiedName();
+    if ( depth == 1 && name == QLatin1String( "GpsRoutes" ) && !haveGpsRoutes )
+    {
+      gpsRoutesLayerId = reader.attributes().value( "layerid" ).toString();
+      haveGpsRoutes = true;
+    }
+    if ( depth == 1 && name == QLatin1String( "projectlayers" ) && !projectLayersSeen )
+    {
+      projectLayersSeen = true;
+      inProjectLayers = true;
+    }
+    if ( inProjectLayers && mapLayerChildDepth == 0 && name == QLatin1String( "maplayer" ) )
+    {
+      // Map layers are not nested, like the write pass which consumes each layer as a whole
+      mapLayerChildDepth = depth + 1;
+      if ( reader.attributes().value( "type" ) == QLatin1String( "redlining" ) )
+      {
+        redliningHeaderEl = doc.createElement( "maplayer" );
+        redliningLayerHeaders.append( redliningHeaderEl );
+      }
+    }
+    if ( !redliningHeaderEl.isNull() && name == QLatin1String( "RedliningItem" ) )
+    {
+      // Converted by the write pass
+      reader.skipCurrentElement();
+    }
+    else if (
+      !redliningHeaderEl.isNull() && depth == mapLayerChildDepth
+      && ( name == QLatin1String( "id" ) || name == QLatin1String( "layername" ) || name == QLatin1String( "srs" ) || name == QLatin1String( "globe" ) )
+      && redliningHeaderEl.firstChildElement( name.toString() ).isNull()
+    )
+    {
+      redliningHeaderEl.appendChild( readDomElement( reader, doc ) );
+    }
+    else if ( name == QLatin1String( "SVGAnnotationItem" ) )
+    {
+      QDomElement itemEl = readDomElement( reader, doc );
+      QString layerId = itemEl.firstChildElement( "AnnotationItem" ).attribute( "layerId" );
+      svgItems[layerId].append( migrateSvgAnnotationItem( doc, itemEl, basedir, svgFiles ) );
+    }
+    else if ( name == QLatin1String( "GeoImageAnnotationItem" ) )
+    {
+      QDomElement itemEl = readDomElement( reader, doc );
+      QString layerId = itemEl.firstChildElement( "AnnotationItem" ).attribute( "layerId" );
+      imageItems[layerId].append( migrateImageAnnotationItem( doc, itemEl, basedir, imageFiles ) );
+    }
+    else if ( name == QLatin1String( "PinAnnotationItem" ) )
+    {
+      QDomElement itemEl = readDomElement( reader, doc );
+      QString layerId = itemEl.firstChildElement( "AnnotationItem" ).attribute( "layerId" );
+      pinItems[layerId].append( migratePinAnnotationItem( doc, itemEl ) );
+    }
+    else
+    {
+      ++depth;
+    }
+  }
+  if ( reader.hasError() )
+  {
+    QgsDebugMsgLevel( QString( "Failed to parse project: %1" ).arg( reader.errorString() ), 2 );
+    return false;
+  }
+
+  for ( const AnnotationItems &items : { svgItems, imageItems, pinItems } )
+  {
+    for ( auto it = items.begin(), itEnd = items.end(); it != itEnd; ++it )
+    {
+      annotationItems[it.key()].append( it.value() );
+    }
+  }
+  filesToAttach.append( svgFiles );
+  filesToAttach.append( imageFiles );
+  return true;
+}
+
+bool KadasProjectMigration::writeKadas1xProject( QIODevice *in, QIODevice *out, const QString &basedir, const QString &gpsRoutesLayerId, const AnnotationItems &annotationItems, const RedliningLayerHeaders &redliningLayerHeaders, QStringList &filesToAttach )
+{
+  QXmlStreamReader reader( in );
+  reader.setNamespaceProcessing( false );
+  QXmlStreamWriter writer( out );
+
+  int depth = 0;
+  bool inProjectLayers = false;
+  bool projectLayersSeen = false;
+  bool redliningSeen = false;
+  bool gpsRoutesSeen = false;
+  int redliningLayerCount = 0;
+  while ( !reader.atEnd() )
+  {
+    switch ( reader.readNext() )
+    {
+      case QXmlStreamReader::StartDocument:
+        writer.writeStartDocument();
+        break;
+      case QXmlStreamReader::EndDocument:
+        writer.writeEndDocument();
+        break;
+      case QXmlStreamReader::DTD:
+        writer.writeDTD( reader.text().toString() );
+        break;
+      case QXmlStreamReader::Comment:
+        writer.writeComment( reader.text().toString() );
+        break;
+      case QXmlStreamReader::ProcessingInstruction:
+        writer.writeProcessingInstruction( reader.processingInstructionTarget().toString(), reader.processingInstructionData().toString() );
+        break;
+      case QXmlStreamReader::EntityReference:
+        writer.writeEntityReference( reader.name().toString() );
+        break;
+      case QXmlStreamReader::Characters:
+        if ( reader.isCDATA() )
+        {
+          writer.writeCDATA( reader.text().toString() );
         }
-        else if ( flags["shape"] == "line" )
+        else
         {
-          geom = new QgsLineString();
-          geom->fromWkt( redliningItemEl.attribute( "geometry" ) );
-          if ( isGps )
-          {
-            geomItem = new KadasGpxRouteItem();
-            static_cast<KadasGpxRouteItem *>( geomItem )->setName( redliningItemEl.attribute( "text" ) );
-            static_cast<KadasGpxRouteItem *>( geomItem )->setNumber( flags["routeNumber"] );
-          }
-          else
-          {
-            geomItem = new KadasLineItem( crs );
-            geomItem->setEditor( "KadasRedliningItemEditor" );
-          }
+          writer.writeCharacters( reader.text().toString() );
         }
-        else if ( flags["shape"] == "polygon" )
+        break;
+      case QXmlStreamReader::StartElement:
+      {
+        QStringRef name = reader.qualifiedName();
+        // Redlining / GPS routes project settings are dropped, the layers are converted to item layers
+        if ( depth == 1 && name == QLatin1String( "Redlining" ) && !redliningSeen )
         {
-          geom = new QgsPolygon();
-          geom->fromWkt( redliningItemEl.attribute( "geometry" ) );
-
-          geomItem = new KadasPolygonItem( crs );
-          geomItem->setEditor( "KadasRedliningItemEditor" );
+          redliningSeen = true;
+          reader.skipCurrentElement();
+          break;
         }
-        else if ( flags["shape"] == "rectangle" )
+        if ( depth == 1 && name == QLatin1String( "GpsRoutes" ) && !gpsRoutesSeen )
         {
-          geom = new QgsPolygon();
-          geom->fromWkt( redliningItemEl.attribute( "geometry" ) );
-
-          geomItem = new KadasRectangleItem( crs );
-          geomItem->setEditor( "KadasRedliningItemEditor" );
+          gpsRoutesSeen = true;
+          reader.skipCurrentElement();
+          break;
         }
-        else if ( flags["shape"] == "circle" )
+        if ( inProjectLayers && name == QLatin1String( "maplayer" ) )
         {
-          // Circular strings were incorrectly serialized to wkt as ringpoint - center - ringpoint instead of 3x ringpoint
-          QgsCurvePolygon curve;
-          curve.fromWkt( redliningItemEl.attribute( "geometry" ) );
-          QgsPointSequence points;
-          curve.exteriorRing()->points( points );
-          if ( points.size() == 3 )
+          if ( reader.attributes().value( "type" ) == QLatin1String( "redlining" ) )
           {
-            points[1].setX( points[1].x() - points[0].distance( points[1] ) );
+            // Redlining layers can be large, stream the items instead of reading the whole layer
+            writeRedliningLayer( reader, writer, basedir, gpsRoutesLayerId, redliningLayerHeaders.value( redliningLayerCount++ ), filesToAttach );
           }
-
-          QgsCircularString *ring = new QgsCircularString();
-          ring->setPoints( points );
-          geom = new QgsCurvePolygon();
-          static_cast<QgsCurvePolygon *>( geom )->setExteriorRing( ring );
-
-          geomItem = new KadasCircleItem( crs );
-          geomItem->setEditor( "KadasRedliningItemEditor" );
+          else
+          {
+            writeMapLayer( reader, writer, basedir, annotationItems, filesToAttach );
+          }
+          break;
         }
-
-        if ( geomItem && geom )
+        if ( depth == 1 && name == QLatin1String( "projectlayers" ) && !projectLayersSeen )
         {
-          geomItem->addPartFromGeometry( *geom );
+          projectLayersSeen = true;
+          inProjectLayers = true;
+        }
+        writer.writeStartElement( name.toString() );
+        writer.writeAttributes( reader.attributes() );
+        ++depth;
+        break;
+      }
+      case QXmlStreamReader::EndElement:
+        writer.writeEndElement();
+        if ( --depth == 1 )
+        {
+          inProjectLayers = false;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  if ( reader.hasError() )
+  {
+    QgsDebugMsgLevel( QString( "Failed to parse project: %1" ).arg( reader.errorString() ), 2 );
+    return false;
+  }
+  return !writer.hasError();
+}
 
-          QBrush brush;
-          brush.setColor( QgsSymbolLayerUtils::decodeColor( redliningItemEl.attribute( "fill" ) ) );
-          brush.setStyle( QgsSymbolLayerUtils::decodeBrushStyle( redliningItemEl.attribute( "fill_style" ) ) );
-          geomItem->setFill( brush );
+void KadasProjectMigration::writeMapLayer( QXmlStreamReader &reader, QXmlStreamWriter &writer, const QString &basedir, const AnnotationItems &annotationItems, QStringList &filesToAttach )
+{
+  QDomDocument doc;
+  QDomElement mapLayerEl = readDomElement( reader, doc );
 
-          QPen pen;
-          pen.setColor( QgsSymbolLayerUtils::decodeColor( redliningItemEl.attribute( "outline" ) ) );
-          pen.setStyle( QgsSymbolLayerUtils::decodePenStyle( redliningItemEl.attribute( "outline_style" ) ) );
-          pen.setWidth( redliningItemEl.attribute( "size" ).toInt() );
-          geomItem->setOutline( pen );
+  // If datasource is relative to basedir, mark it as to be attached
+  QDomElement datasourceEl = mapLayerEl.firstChildElement( "datasource" );
+  QString datasourceText = datasourceEl.text();
+  if ( shouldAttach( basedir, datasourceText ) )
+  {
+    QString fullPath = QDir( basedir ).absoluteFilePath( datasourceText );
+    QDomElement newDatasourceEl = doc.createElement( "datasource" );
+    newDatasourceEl.appendChild( doc.createTextNode( fullPath ) );
+    mapLayerEl.replaceChild( newDatasourceEl, datasourceEl );
+    filesToAttach.append( fullPath );
+  }
 
-          geomItem->setIconSize( 8 * pen.width() );
-          geomItem->setIconFill( brush );
-          geomItem->setIconOutline( QPen( pen.color(), pen.width(), pen.style() ) );
+  auto it = annotationItems.find( mapLayerEl.firstChildElement( "id" ).text() );
+  if ( it != annotationItems.end() )
+  {
+    writer.writeStartElement( "maplayer" );
+    writer.writeAttribute( "name", "KadasItemLayer" );
+    writer.writeAttribute( "type", "plugin" );
+    writer.writeAttribute( "title", mapLayerEl.firstChildElement( "layername" ).text() );
+    writeDomNode( writer, mapLayerEl.firstChildElement( "srs" ) );
+    writeDomNode( writer, mapLayerEl.firstChildElement( "id" ) );
+    writeDomNode( writer, mapLayerEl.firstChildElement( "layername" ) );
+    for ( const QDomElement &mapItemEl : it.value() )
+    {
+      writeDomNode( writer, mapItemEl );
+    }
+    writer.writeEndElement();
+  }
+  else if ( mapLayerEl.attribute( "type" ) == "plugin" && mapLayerEl.attribute( "name" ) == "MilX_Layer" )
+  {
+    writeDomNode( writer, migrateMilxLayer( doc, mapLayerEl ) );
+  }
+  else
+  {
+    writeDomNode( writer, mapLayerEl );
+  }
+}
 
-          item = geomItem;
-        }
-        delete geom;
-      }
-      if ( !item )
+void KadasProjectMigration::writeRedliningLayer( QXmlStreamReader &reader, QXmlStreamWriter &writer, const QString &basedir, const QString &gpsRoutesLayerId, const QDomElement &headerEl, QStringList &filesToAttach )
+{
+  QDomDocument doc;
+  QString layerId = headerEl.firstChildElement( "id" ).text();
+  QString layerName = headerEl.firstChildElement( "layername" ).text();
+  QDomElement srsEl = headerEl.firstChildElement( "srs" );
+  QgsCoordinateReferenceSystem crs( srsEl.firstChildElement( "spatialrefsys" ).firstChildElement( "authid" ).text() );
+  bool isGps = layerId == gpsRoutesLayerId;
+
+  // The header was collected by the first pass, so that it precedes the items as in the DOM based migration,
+  // wherever it is stored in the layer. Each item is written as soon as it is converted.
+  writer.writeStartElement( "maplayer" );
+  writer.writeAttribute( "name", "KadasItemLayer" );
+  writer.writeAttribute( "type", "plugin" );
+  writer.writeAttribute( "title", layerName );
+  writer.writeTextElement( "id", layerId );
+  writer.writeTextElement( "layername", layerName );
+  writeDomNode( writer, srsEl );
+  writeDomNode( writer, headerEl.firstChildElement( "globe" ) );
+
+  QString datasourceText;
+  bool haveDatasource = false;
+  int depth = 1;
+  while ( depth > 0 && !reader.atEnd() )
+  {
+    reader.readNext();
+    if ( reader.isEndElement() )
+    {
+      --depth;
+      continue;
+    }
+    else if ( !reader.isStartElement() )
+    {
+      continue;
+    }
+    QStringRef name = reader.qualifiedName();
+    if ( name == QLatin1String( "RedliningItem" ) )
+    {
+      QDomElement mapItemEl = migrateRedliningItem( doc, readDomElement( reader, doc ), crs, isGps );
+      if ( !mapItemEl.isNull() )
       {
-        continue;
+        writeDomNode( writer, mapItemEl );
       }
-
-      QDomElement mapItemEl = doc.createElement( "MapItem" );
-      mapItemEl.setAttribute( "name", item->metaObject()->className() );
-      mapItemEl.setAttribute( "crs", item->authId() );
-      QJsonDocument jsonDoc;
-      jsonDoc.setObject( item->serialize() );
-      mapItemEl.appendChild( doc.createCDATASection( jsonDoc.toJson( QJsonDocument::Compact ) ) );
-
-      newMapLayerEl.appendChild( mapItemEl );
-      delete item;
     }
-    root.firstChildElement( "projectlayers" ).replaceChild( newMapLayerEl, mapLayerEl );
+    else if ( depth == 1 && name == QLatin1String( "datasource" ) && !haveDatasource )
+    {
+      datasourceText = reader.readElementText( QXmlStreamReader::IncludeChildElements );
+      haveDatasource = true;
+    }
+    else
+    {
+      ++depth;
+    }
   }
 
-  // SVGAnnotationItem: Convert layer and items
-  QDomNodeList svgItems = root.elementsByTagName( "SVGAnnotationItem" );
-  if ( !svgItems.isEmpty() )
+  // If datasource is relative to basedir, mark it as to be attached
+  if ( shouldAttach( basedir, datasourceText ) )
   {
-    QMap<QString, QDomElement> newMapLayerEls;
-    for ( int i = 0, n = svgItems.size(); i < n; ++i )
+    filesToAttach.append( QDir( basedir ).absoluteFilePath( datasourceText ) );
+  }
+  writer.writeEndElement();
+}
+
+QDomElement KadasProjectMigration::migrateRedliningItem( QDomDocument &doc, const QDomElement &redliningItemEl, const QgsCoordinateReferenceSystem &crs, bool isGps )
+{
+  QMap<QString, QString> flags = deserializeLegacyRedliningFlags( redliningItemEl.attribute( "flags" ) );
+
+  KadasMapItem *item = nullptr;
+  if ( !redliningItemEl.attribute( "text" ).isEmpty() && flags["shape"] == "point" && flags["symbol"].isEmpty() )
+  {
+    QgsPoint point;
+    point.fromWkt( redliningItemEl.attribute( "geometry" ) );
+    QColor outline = QgsSymbolLayerUtils::decodeColor( redliningItemEl.attribute( "outline" ) );
+    outline.setAlpha( 255 ); // KADAS 1 ignored outline transparency;
+    QColor fill = QgsSymbolLayerUtils::decodeColor( redliningItemEl.attribute( "fill" ) );
+    fill.setAlpha( 255 ); // KADAS 1 ignored fill transparency;
+
+    KadasTextItem *textItem = new KadasTextItem( crs );
+    textItem->setText( redliningItemEl.attribute( "text" ) );
+    textItem->setPosition( KadasItemPos::fromPoint( point ) );
+    textItem->setAngle( flags["rotation"].toDouble() );
+    textItem->setOutlineColor( outline );
+    textItem->setFillColor( fill );
+    textItem->state()->mRectangleCenterPoint.setX( 0 );
+    textItem->state()->mRectangleCenterPoint.setY( 1. );
+
+    QFont font;
+    font.setBold( flags["bold"].toInt() != 0 );
+    font.setFamily( flags["family"] );
+    font.setPointSize( flags["fontSize"].toInt() );
+    font.setItalic( flags["italic"].toInt() != 0 );
+    textItem->setFont( font );
+
+    textItem->setEditor( "KadasRedliningTextEditor" );
+
+    item = textItem;
+  }
+  else
+  {
+    KadasGeometryItem *geomItem = nullptr;
+    QgsAbstractGeometry *geom = nullptr;
+
+    if ( flags["shape"] == "point" )
     {
-      QDomElement svgItemEl = svgItems.at( i ).toElement();
-      QDomElement annotationItemEl = svgItemEl.firstChildElement( "AnnotationItem" );
-      QString layerId = annotationItemEl.attribute( "layerId" );
+      geom = new QgsPoint();
+      geom->fromWkt( redliningItemEl.attribute( "geometry" ) );
 
-      if ( !newMapLayerEls.contains( layerId ) )
+      if ( isGps )
       {
-        newMapLayerEls[layerId] = replaceAnnotationLayer( doc, root, layerId );
+        geomItem = new KadasGpxWaypointItem();
+        static_cast<KadasGpxWaypointItem *>( geomItem )->setName( redliningItemEl.attribute( "text" ) );
       }
-      QDomElement newMapLayerEl = newMapLayerEls[layerId];
-      if ( newMapLayerEl.isNull() )
+      else
       {
-        continue;
-      }
+        KadasPointItem::IconType iconType = KadasPointItem::IconType::ICON_CIRCLE;
+        if ( flags["symbol"] == "circle" )
+        {
+          iconType = KadasPointItem::IconType::ICON_CIRCLE;
+        }
+        else if ( flags["symbol"] == "rectangle" )
+        {
+          iconType = KadasPointItem::IconType::ICON_FULL_BOX;
+        }
+        else if ( flags["symbol"] == "triangle" )
+        {
+          iconType = KadasPointItem::IconType::ICON_FULL_TRIANGLE;
+        }
 
-      // If file is relative to the basedir, mark it as to be attached
-      QString fileName = svgItemEl.attribute( "file" );
-      if ( shouldAttach( basedir, fileName ) )
-      {
-        fileName = QDir( basedir ).absoluteFilePath( fileName );
-        filesToAttach.append( fileName );
+        geomItem = new KadasPointItem( crs, iconType );
+        geomItem->setEditor( "KadasRedliningItemEditor" );
       }
-      int width = annotationItemEl.attribute( "frameWidth" ).toInt();
-      int height = annotationItemEl.attribute( "frameHeight" ).toInt();
-      double angle = annotationItemEl.attribute( "angle" ).toDouble();
-      double adjWidth = height * qAbs( std::sin( angle / 180. * M_PI ) ) + width * qAbs( std::cos( angle / 180. * M_PI ) );
-      double adjHeight = height * qAbs( std::cos( angle / 180. * M_PI ) ) + width * qAbs( std::sin( angle / 180. * M_PI ) );
-      double scale = std::min( width / adjWidth, height / adjHeight );
-
-      KadasSymbolItem symbolItem( ( QgsCoordinateReferenceSystem( annotationItemEl.attribute( "mapGeoPosAuthID" ) ) ) );
-      symbolItem.setup( fileName, 0.5, 0.5, width * scale );
-      symbolItem.setPosition( KadasItemPos::fromPoint( QgsPointXY( annotationItemEl.attribute( "geoPosX" ).toDouble(), annotationItemEl.attribute( "geoPosY" ).toDouble() ) ) );
-      symbolItem.setAngle( -angle );
-
-      QDomElement mapItemEl = doc.createElement( "MapItem" );
-      mapItemEl.setAttribute( "name", "KadasSymbolItem" );
-      mapItemEl.setAttribute( "crs", annotationItemEl.attribute( "mapGeoPosAuthID" ) );
-
-      QJsonDocument jsonDoc;
-      jsonDoc.setObject( symbolItem.serialize() );
-      mapItemEl.appendChild( doc.createCDATASection( jsonDoc.toJson( QJsonDocument::Compact ) ) );
-
-      newMapLayerEl.appendChild( mapItemEl );
     }
-  }
-
-  // GeoImageAnnotationItem: Convert layer and items
-  QDomNodeList imageItems = root.elementsByTagName( "GeoImageAnnotationItem" );
-  if ( !imageItems.isEmpty() )
-  {
-    QMap<QString, QDomElement> newMapLayerEls;
-    for ( int i = 0, n = imageItems.size(); i < n; ++i )
+    else if ( flags["shape"] == "line" )
     {
-      QDomElement imageItemEl = imageItems.at( i ).toElement();
-      QDomElement annotationItemEl = imageItemEl.firstChildElement( "AnnotationItem" );
-      QString layerId = annotationItemEl.attribute( "layerId" );
-
-      if ( !newMapLayerEls.contains( layerId ) )
+      geom = new QgsLineString();
+      geom->fromWkt( redliningItemEl.attribute( "geometry" ) );
+      if ( isGps )
       {
-        newMapLayerEls[layerId] = replaceAnnotationLayer( doc, root, layerId );
+        geomItem = new KadasGpxRouteItem();
+        static_cast<KadasGpxRouteItem *>( geomItem )->setName( redliningItemEl.attribute( "text" ) );
+        static_cast<KadasGpxRouteItem *>( geomItem )->setNumber( flags["routeNumber"] );
       }
-      QDomElement newMapLayerEl = newMapLayerEls[layerId];
-      if ( newMapLayerEl.isNull() )
+      else
       {
-        continue;
+        geomItem = new KadasLineItem( crs );
+        geomItem->setEditor( "KadasRedliningItemEditor" );
       }
+    }
+    else if ( flags["shape"] == "polygon" )
+    {
+      geom = new QgsPolygon();
+      geom->fromWkt( redliningItemEl.attribute( "geometry" ) );
 
-      // If file is relative to the basedir, mark it as to be attached
-      QString fileName = imageItemEl.attribute( "file" );
-      if ( shouldAttach( basedir, fileName ) )
+      geomItem = new KadasPolygonItem( crs );
+      geomItem->setEditor( "KadasRedliningItemEditor" );
+    }
+    else if ( flags["shape"] == "rectangle" )
+    {
+      geom = new QgsPolygon();
+      geom->fromWkt( redliningItemEl.attribute( "geometry" ) );
+
+      geomItem = new KadasRectangleItem( crs );
+      geomItem->setEditor( "KadasRedliningItemEditor" );
+    }
+    else if ( flags["shape"] == "circle" )
+    {
+      // Circular strings were incorrectly serialized to wkt as ringpoint - center - ringpoint instead of 3x ringpoint
+      QgsCurvePolygon curve;
+      curve.fromWkt( redliningItemEl.attribute( "geometry" ) );
+      QgsPointSequence points;
+      curve.exteriorRing()->points( points );
+      if ( points.size() == 3 )
       {
-        fileName = QDir( basedir ).absoluteFilePath( fileName );
-        filesToAttach.append( fileName );
+        points[1].setX( points[1].x() - points[0].distance( points[1] ) );
       }
 
-      QgsPointXY pos( annotationItemEl.attribute( "geoPosX" ).toDouble(), annotationItemEl.attribute( "geoPosY" ).toDouble() );
-      int width = annotationItemEl.attribute( "frameWidth" ).toInt();
-      int height = annotationItemEl.attribute( "frameHeight" ).toInt();
-      int offsetX = -annotationItemEl.attribute( "offsetX" ).toInt() - 0.5 * width;
-      int offsetY = -annotationItemEl.attribute( "offsetY" ).toInt() - 0.5 * height;
+      QgsCircularString *ring = new QgsCircularString();
+      ring->setPoints( points );
+      geom = new QgsCurvePolygon();
+      static_cast<QgsCurvePolygon *>( geom )->setExteriorRing( ring );
 
-      KadasPictureItem pictureItem( ( QgsCoordinateReferenceSystem( annotationItemEl.attribute( "mapGeoPosAuthID" ) ) ) );
-      pictureItem.setup( fileName, KadasItemPos::fromPoint( pos ), true, offsetX, offsetY, width );
+      geomItem = new KadasCircleItem( crs );
+      geomItem->setEditor( "KadasRedliningItemEditor" );
+    }
 
-      QDomElement mapItemEl = doc.createElement( "MapItem" );
-      mapItemEl.setAttribute( "name", "KadasPictureItem" );
-      mapItemEl.setAttribute( "crs", annotationItemEl.attribute( "mapGeoPosAuthID" ) );
+    if ( geomItem && geom )
+    {
+      geomItem->addPartFromGeometry( *geom );
+
+      QBrush brush;
+      brush.setColor( QgsSymbolLayerUtils::decodeColor( redliningItemEl.attribute( "fill" ) ) );
+      brush.setStyle( QgsSymbolLayerUtils::decodeBrushStyle( redliningItemEl.attribute( "fill_style" ) ) );
+      geomItem->setFill( brush );
 
-      QJsonDocument jsonDoc;
-      jsonDoc.setObject( pictureItem.serialize() );
-      mapItemEl.appendChild( doc.createCDATASection( jsonDoc.toJson( QJsonDocument::Compact ) ) );
+      QPen pen;
+      pen.setColor( QgsSymbolLayerUtils::decodeColor( redliningItemEl.attribute( "outline" ) ) );
+      pen.setStyle( QgsSymbolLayerUtils::decodePenStyle( redliningItemEl.attribute( "outline_style" ) ) );
+      pen.setWidth( redliningItemEl.attribute( "size" ).toInt() );
+      geomItem->setOutline( pen );
 
-      newMapLayerEl.appendChild( mapItemEl );
+      geomItem->setIconSize( 8 * pen.width() );
+      geomItem->setIconFill( brush );
+      geomItem->setIconOutline( QPen( pen.color(), pen.width(), pen.style() ) );
+
+      item = geomItem;
     }
+    delete geom;
   }
-
-  // PinAnnotationItem
-  QDomNodeList pinItems = root.elementsByTagName( "PinAnnotationItem" );
-  if ( !pinItems.isEmpty() )
+  if ( !item )
   {
-    QMap<QString, QDomElement> newMapLayerEls;
-    for ( int i = 0, n = pinItems.size(); i < n; ++i )
-    {
-      QDomElement pinItemEl = pinItems.at( i ).toElement();
-      QDomElement annotationItemEl = pinItemEl.firstChildElement( "AnnotationItem" );
-      QString layerId = annotationItemEl.attribute( "layerId" );
+    return QDomElement();
+  }
 
-      if ( !newMapLayerEls.contains( layerId ) )
-      {
-        newMapLayerEls[layerId] = replaceAnnotationLayer( doc, root, layerId );
-      }
-      QDomElement newMapLayerEl = newMapLayerEls[layerId];
-      if ( newMapLayerEl.isNull() )
-      {
-        continue;
-      }
+  QDomElement mapItemEl = createMapItemElement( doc, item->metaObject()->className(), item->authId(), item->serialize() );
+  delete item;
+  return mapItemEl;
+}
 
-      KadasPinItem pinItem( ( QgsCoordinateReferenceSystem( annotationItemEl.attribute( "mapGeoPosAuthID" ) ) ) );
-      QgsPointXY pos( annotationItemEl.attribute( "geoPosX" ).toDouble(), annotationItemEl.attribute( "geoPosY" ).toDouble() );
-      pinItem.setPosition( KadasItemPos::fromPoint( pos ) );
-      pinItem.setEditor( "KadasSymbolAttributesEditor" );
-      pinItem.setName( pinItemEl.attribute( "pinName" ) );
-      pinItem.setRemarks( pinItemEl.firstChildElement( "PinRemarks" ).text() );
+QDomElement KadasProjectMigration::migrateSvgAnnotationItem( QDomDocument &doc, const QDomElement &svgItemEl, const QString &basedir, QStringList &filesToAttach )
+{
+  QDomElement annotationItemEl = svgItemEl.firstChildElement( "AnnotationItem" );
 
-      QDomElement mapItemEl = doc.createElement( "MapItem" );
-      mapItemEl.setAttribute( "name", "KadasPinItem" );
-      mapItemEl.setAttribute( "crs", annotationItemEl.attribute( "mapGeoPosAuthID" ) );
-      mapItemEl.setAttribute( "editor", "KadasSymbolAttributesEditor" );
+  // If file is relative to the basedir, mark it as to be attached
+  QString fileName = svgItemEl.attribute( "file" );
+  if ( shouldAttach( basedir, fileName ) )
+  {
+    fileName = QDir( basedir ).absoluteFilePath( fileName );
+    filesToAttach.append( fileName );
+  }
+  int width = annotationItemEl.attribute( "frameWidth" ).toInt();
+  int height = annotationItemEl.attribute( "frameHeight" ).toInt();
+  double angle = annotationItemEl.attribute( "angle" ).toDouble();
+  double adjWidth = height * qAbs( std::sin( angle / 180. * M_PI ) ) + width * qAbs( std::cos( angle / 180. * M_PI ) );
+  double adjHeight = height * qAbs( std::cos( angle / 180. * M_PI ) ) + width * qAbs( std::sin( angle / 180. * M_PI ) );
+  double scale = std::min( width / adjWidth, height / adjHeight );
+
+  KadasSymbolItem symbolItem( ( QgsCoordinateReferenceSystem( annotationItemEl.attribute( "mapGeoPosAuthID" ) ) ) );
+  symbolItem.setup( fileName, 0.5, 0.5, width * scale );
+  symbolItem.setPosition( KadasItemPos::fromPoint( QgsPointXY( annotationItemEl.attribute( "geoPosX" ).toDouble(), annotationItemEl.attribute( "geoPosY" ).toDouble() ) ) );
+  symbolItem.setAngle( -angle );
+
+  return createMapItemElement( doc, "KadasSymbolItem", annotationItemEl.attribute( "mapGeoPosAuthID" ), symbolItem.serialize() );
+}
 
-      QJsonDocument jsonDoc;
-      jsonDoc.setObject( pinItem.serialize() );
-      mapItemEl.appendChild( doc.createCDATASection( jsonDoc.toJson( QJsonDocument::Compact ) ) );
+QDomElement KadasProjectMigration::migrateImageAnnotationItem( QDomDocument &doc, const QDomElement &imageItemEl, const QString &basedir, QStringList &filesToAttach )
+{
+  QDomElement annotationItemEl = imageItemEl.firstChildElement( "AnnotationItem" );
 
-      newMapLayerEl.appendChild( mapItemEl );
-    }
+  // If file is relative to the basedir, mark it as to be attached
+  QString fileName = imageItemEl.attribute( "file" );
+  if ( shouldAttach( basedir, fileName ) )
+  {
+    fileName = QDir( basedir ).absoluteFilePath( fileName );
+    filesToAttach.append( fileName );
   }
 
-  // MilX
-  for ( int i = 0, n = maplayers.size(); i < n; ++i )
-  {
-    QDomElement mapLayerEl = maplayers.at( i ).toElement();
-    if ( mapLayerEl.attribute( "type" ) != "plugin" || mapLayerEl.attribute( "name" ) != "MilX_Layer" )
-    {
-      continue;
-    }
-    KadasMilxLayer layer( mapLayerEl.firstChildElement( "layername" ).text() );
-    int dpi = qApp->desktop()->logicalDpiX();
-    QString err;
-    layer.importFromMilxly( mapLayerEl.firstChildElement( "MilXLayer" ), dpi, err );
+  QgsPointXY pos( annotationItemEl.attribute( "geoPosX" ).toDouble(), annotationItemEl.attribute( "geoPosY" ).toDouble() );
+  int width = annotationItemEl.attribute( "frameWidth" ).toInt();
+  int height = annotationItemEl.attribute( "frameHeight" ).toInt();
+  int offsetX = -annotationItemEl.attribute( "offsetX" ).toInt() - 0.5 * width;
+  int offsetY = -annotationItemEl.attribute( "offsetY" ).toInt() - 0.5 * height;
 
-    QDomElement newMapLayerEl = doc.createElement( "maplayer" );
-    QgsReadWriteContext context;
-    layer.writeXml( newMapLayerEl, doc, context );
-    newMapLayerEl.appendChild( mapLayerEl.firstChildElement( "id" ).cloneNode() );
-    newMapLayerEl.appendChild( mapLayerEl.firstChildElement( "layername" ).cloneNode() );
+  KadasPictureItem pictureItem( ( QgsCoordinateReferenceSystem( annotationItemEl.attribute( "mapGeoPosAuthID" ) ) ) );
+  pictureItem.setup( fileName, KadasItemPos::fromPoint( pos ), true, offsetX, offsetY, width );
 
-    projectLayersEl.replaceChild( newMapLayerEl, mapLayerEl );
-  }
+  return createMapItemElement( doc, "KadasPictureItem", annotationItemEl.attribute( "mapGeoPosAuthID" ), pictureItem.serialize() );
+}
 
-  // Changes to guide grid etc?
+QDomElement KadasProjectMigration::migratePinAnnotationItem( QDomDocument &doc, const QDomElement &pinItemEl )
+{
+  QDomElement annotationItemEl = pinItemEl.firstChildElement( "AnnotationItem" );
+
+  KadasPinItem pinItem( ( QgsCoordinateReferenceSystem( annotationItemEl.attribute( "mapGeoPosAuthID" ) ) ) );
+  QgsPointXY pos( annotationItemEl.attribute( "geoPosX" ).toDouble(), annotationItemEl.attribute( "geoPosY" ).toDouble() );
+  pinItem.setPosition( KadasItemPos::fromPoint( pos ) );
+  pinItem.setEditor( "KadasSymbolAttributesEditor" );
+  pinItem.setName( pinItemEl.attribute( "pinName" ) );
+  pinItem.setRemarks( pinItemEl.firstChildElement( "PinRemarks" ).text() );
+
+  QDomElement mapItemEl = createMapItemElement( doc, "KadasPinItem", annotationItemEl.attribute( "mapGeoPosAuthID" ), pinItem.serialize() );
+  mapItemEl.setAttribute( "editor", "KadasSymbolAttributesEditor" );
+  return mapItemEl;
+}
+
+QDomElement KadasProjectMigration::migrateMilxLayer( QDomDocument &doc, const QDomElement &mapLayerEl )
+{
+  KadasMilxLayer layer( mapLayerEl.firstChildElement( "layername" ).text() );
+  int dpi = qApp->desktop()->logicalDpiX();
+  QString err;
+  layer.importFromMilxly( mapLayerEl.firstChildElement( "MilXLayer" ), dpi, err );
+
+  QDomElement newMapLayerEl = doc.createElement( "maplayer" );
+  QgsReadWriteContext context;
+  layer.writeXml( newMapLayerEl, doc, context );
+  newMapLayerEl.appendChild( mapLayerEl.firstChildElement( "id" ).cloneNode() );
+  newMapLayerEl.appendChild( mapLayerEl.firstChildElement( "layername" ).cloneNode() );
+  return newMapLayerEl;
+}
+
+QDomElement KadasProjectMigration::createMapItemElement( QDomDocument &doc, const QString &name, const QString &crs, const QJsonObject &data )
+{
+  QDomElement mapItemEl = doc.createElement( "MapItem" );
+  mapItemEl.setAttribute( "name", name );
+  mapItemEl.setAttribute( "crs", crs );
+  QJsonDocument jsonDoc;
+  jsonDoc.setObject( data );
+  mapItemEl.appendChild( doc.createCDATASection( jsonDoc.toJson( QJsonDocument::Compact ) ) );
+  return mapItemEl;
 }
 
 QDomElement KadasProjectMigration::replaceAnnotationLayer( QDomDocument &doc, QDomElement &root, const QString &layerId )
@@ -18,10 +18,17 @@
 #define KADASPROJECTMIGRATION_H
 
 #include "kadas/gui/kadas_gui.h"
+#include <QList>
+#include <QMap>
 #include <QString>
 
 class QDomDocument;
 class QDomElement;
+class QIODevice;
+class QJsonObject;
+class QXmlStreamReader;
+class QXmlStreamWriter;
+class QgsCoordinateReferenceSystem;
 
 class KADAS_GUI_EXPORT KadasProjectMigration
 {
@@ -30,8 +37,26 @@ class KADAS_GUI_EXPORT KadasProjectMigration
     static bool migrateProjectXml( const QString &basedir, QDomDocument &doc, QStringList &filesToAttach );
 
   private:
+    typedef QMap<QString, QList<QDomElement>> AnnotationItems;
+    // Header elements (id, layername, srs, globe) of each redlining layer, in document order
+    typedef QList<QDomElement> RedliningLayerHeaders;
+
     static void migrateKadas1xTo2x( QDomDocument &doc, QDomElement &root, const QString &basedir, QStringList &filesToAttach );
     static QDomElement replaceAnnotationLayer( QDomDocument &doc, QDomElement &root, const QString &layerId );
+
+    // Streaming migration: a first pass collects the annotation items (which are stored outside of their layers)
+    // and the redlining layer headers, a second pass copies the project to the output, rewriting map layers on the fly
+    static bool scanKadas1xProject( QIODevice *in, QDomDocument &doc, const QString &basedir, QString &gpsRoutesLayerId, AnnotationItems &annotationItems, RedliningLayerHeaders &redliningLayerHeaders, QStringList &filesToAttach );
+    static bool writeKadas1xProject( QIODevice *in, QIODevice *out, const QString &basedir, const QString &gpsRoutesLayerId, const AnnotationItems &annotationItems, const RedliningLayerHeaders &redliningLayerHeaders, QStringList &filesToAttach );
+    static void writeMapLayer( QXmlStreamReader &reader, QXmlStreamWriter &writer, const QString &basedir, const AnnotationItems &annotationItems, QStringList &filesToAttach );
+    static void writeRedliningLayer( QXmlStreamReader &reader, QXmlStreamWriter &writer, const QString &basedir, const QString &gpsRoutesLayerId, const QDomElement &headerEl, QStringList &filesToAttach );
+
+    static QDomElement migrateRedliningItem( QDomDocument &doc, const QDomElement &redliningItemEl, const QgsCoordinateReferenceSystem &crs, bool isGps );
+    static QDomElement migrateSvgAnnotationItem( QDomDocument &doc, const QDomElement &svgItemEl, const QString &basedir, QStringList &filesToAttach );
+    static QDomElement migrateImageAnnotationItem( QDomDocument &doc, const QDomElement &imageItemEl, const QString &basedir, QStringList &filesToAttach );
+    static QDomElement migratePinAnnotationItem( QDomDocument &doc, const QDomElement &pinItemEl );
+    static QDomElement migrateMilxLayer( QDomDocument &doc, const QDomElement &mapLayerEl );
+    static QDomElement createMapItemElement( QDomDocument &doc, const QString &name, const QString &crs, const QJsonObject &data );
     static QMap<QString, QString> deserializeLegacyRedliningFlags( const QString &flagsStr );
     static bool shouldAttach( const QString &baseDir, const QString &filePath );
 };
@@ -0,0 +1,92 @@
+/***************************************************************************
+    kadasrendersnapshot.cpp
+    -----------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QApplication>
+#include <QDesktopWidget>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+
+#include <qgis/qgsrendercontext.h>
+#include <qgis/qgssettings.h>
+
+#include "kadas/gui/kadasrendersnapshot.h"
+
+static const QString sScreenDpiProperty = QStringLiteral( "kadas_screen_dpi" );
+static const QString sMeasurementColorProperty = QStringLiteral( "kadas_measurement_color" );
+
+
+KadasRenderSnapshot KadasRenderSnapshot::capture()
+{
+  checkGuiThread( "KadasRenderSnapshot::capture" );
+  KadasRenderSnapshot snapshot;
+  snapshot.screenDpi = QApplication::desktop()->logicalDpiX();
+  QgsSettings settings;
+  int red = settings.value( "/Qgis/default_measure_color_red", 255 ).toInt();
+  int green = settings.value( "/Qgis/default_measure_color_green", 0 ).toInt();
+  int blue = settings.value( "/Qgis/default_measure_color_blue", 0 ).toInt();
+  snapshot.measurementColor = QColor( red, green, blue );
+  return snapshot;
+}
+
+void KadasRenderSnapshot::store( QgsRenderContext &context ) const
+{
+  context.setCustomProperty( sScreenDpiProperty, screenDpi );
+  context.setCustomProperty( sMeasurementColorProperty, measurementColor );
+}
+
+KadasRenderSnapshot KadasRenderSnapshot::fromContext( const QgsRenderContext &context )
+{
+  const QVariantMap &properties = context.customProperties();
+  auto it = properties.constFind( sScreenDpiProperty );
+  if ( it == properties.constEnd() )
+  {
+    // I.e. items rendered directly by a canvas item or an export
+    return capture();
+  }
+  KadasRenderSnapshot snapshot;
+  snapshot.screenDpi = it->toDouble();
+  snapshot.measurementColor = properties.value( sMeasurementColorProperty ).value<QColor>();
+  return snapshot;
+}
+
+double KadasRenderSnapshot::outputDpiScale( const QgsRenderContext &context )
+{
+  const QVariantMap &properties = context.customProperties();
+  auto it = properties.constFind( sScreenDpiProperty );
+  double screenDpi = it != properties.constEnd() ? it->toDouble() : capture().screenDpi;
+  return context.painter()->device()->logicalDpiX() / screenDpi;
+}
+
+void KadasRenderSnapshot::checkGuiThread( const char *caller )
+{
+#ifndef NDEBUG
+  if ( QThread::currentThread() == QCoreApplication::instance()->thread() )
+  {
+    return;
+  }
+  static QMutex mutex;
+  static QSet<QByteArray> reported;
+  QMutexLocker locker( &mutex );
+  if ( !reported.contains( caller ) )
+  {
+    reported.insert( caller );
+    qWarning( "%s: GUI thread state accessed from a render thread, capture it in the layer renderer instead", caller );
+  }
+#else
+  Q_UNUSED( caller )
+#endif
+}
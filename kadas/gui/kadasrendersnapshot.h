@@ -0,0 +1,56 @@
+/***************************************************************************
+    kadasrendersnapshot.h
+    ---------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASRENDERSNAPSHOT_H
+#define KADASRENDERSNAPSHOT_H
+
+#include <QColor>
+
+#include "kadas/gui/kadas_gui.h"
+
+#define SIP_NO_FILE
+
+class QgsRenderContext;
+
+/**
+ * Application state needed by item and layer renderers. It is captured on the
+ * GUI thread when the layer renderer is created and stored in its render
+ * context, so that render() only depends on the render context and can run
+ * on any render thread.
+ */
+class KADAS_GUI_EXPORT KadasRenderSnapshot
+{
+  public:
+    //! Logical dpi of the screen, symbol and label sizes are specified at this dpi
+    double screenDpi = 96.;
+    //! Color of the measurement labels
+    QColor measurementColor = Qt::red;
+
+    //! Captures the current application state, must be called on the GUI thread
+    static KadasRenderSnapshot capture();
+    //! Stores the snapshot in the custom properties of the render context
+    void store( QgsRenderContext &context ) const;
+    //! Returns the snapshot stored in the render context, if none is stored it is captured
+    static KadasRenderSnapshot fromContext( const QgsRenderContext &context );
+
+    //! Ratio between the dpi of the render output and the screen dpi
+    static double outputDpiScale( const QgsRenderContext &context );
+
+    //! Debug builds warn (once per caller) if GUI thread state is accessed from another thread
+    static void checkGuiThread( const char *caller );
+};
+
+#endif // KADASRENDERSNAPSHOT_H
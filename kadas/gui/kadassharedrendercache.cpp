@@ -0,0 +1,106 @@
+/***************************************************************************
+    kadassharedrendercache.cpp
+    --------------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QAtomicInt>
+
+#include <qgis/qgslogger.h>
+#include <qgis/qgsmapcanvas.h>
+#include <qgis/qgsmaprenderercache.h>
+
+#include "kadas/gui/kadassharedrendercache.h"
+
+
+static QAtomicInt sHits;
+static QAtomicInt sMisses;
+
+// Rectangle of the source canvas output image covered by the canvas, in device pixels
+static QRect sourceRect( const QgsMapSettings &settings, const QgsMapSettings &sourceSettings )
+{
+  QgsRectangle extent = settings.visibleExtent();
+  QgsPointXY topLeft = sourceSettings.mapToPixel().transform( extent.xMinimum(), extent.yMaximum() );
+  double dpr = sourceSettings.devicePixelRatio();
+  return QRect( QPoint( qRound( topLeft.x() * dpr ), qRound( topLeft.y() * dpr ) ), settings.deviceOutputSize() );
+}
+
+bool KadasSharedRenderCache::canShare( const QgsMapCanvas *canvas, const QgsMapCanvas *source )
+{
+  if ( !canvas->isCachingEnabled() || !source->isCachingEnabled() )
+  {
+    return false;
+  }
+  const QgsMapSettings &settings = canvas->mapSettings();
+  const QgsMapSettings &sourceSettings = source->mapSettings();
+  if (
+    settings.destinationCrs() != sourceSettings.destinationCrs()
+    || !qgsDoubleNear( settings.mapUnitsPerPixel(), sourceSettings.mapUnitsPerPixel() )
+    || !qgsDoubleNear( settings.rotation(), sourceSettings.rotation() )
+    || !qgsDoubleNear( settings.outputDpi(), sourceSettings.outputDpi() )
+    || !qgsDoubleNear( settings.devicePixelRatio(), sourceSettings.devicePixelRatio() )
+  )
+  {
+    return false;
+  }
+  return QRect( QPoint( 0, 0 ), sourceSettings.deviceOutputSize() ).contains( sourceRect( settings, sourceSettings ) );
+}
+
+int KadasSharedRenderCache::seed( QgsMapCanvas *canvas, QgsMapCanvas *source )
+{
+  if ( !canShare( canvas, source ) || !canvas->cache() || !source->cache() )
+  {
+    return 0;
+  }
+  const QgsMapSettings &settings = canvas->mapSettings();
+  QRect rect = sourceRect( settings, source->mapSettings() );
+  QgsMapRendererCache *cache = canvas->cache();
+  QgsMapRendererCache *sourceCache = source->cache();
+
+  int hits = 0;
+  int misses = 0;
+  const QList<QgsMapLayer *> layers = settings.layers();
+  for ( QgsMapLayer *layer : layers )
+  {
+    if ( sourceCache->hasCacheImage( layer->id() ) )
+    {
+      QImage image = sourceCache->cacheImage( layer->id() ).copy( rect );
+      image.setDevicePixelRatio( settings.devicePixelRatio() );
+      // The cache entry is invalidated when the layer is repainted
+      cache->setCacheImageWithParameters( layer->id(), image, settings.visibleExtent(), settings.mapToPixel(), QList<QgsMapLayer *>() << layer );
+      ++hits;
+    }
+    else
+    {
+      ++misses;
+    }
+  }
+  sHits += hits;
+  sMisses += misses;
+  QgsDebugMsgLevel( QString( "Shared render cache: %1 layer images reused, %2 rendered (total %3 / %4)" ).arg( hits ).arg( misses ).arg( sHits.loadRelaxed() ).arg( sMisses.loadRelaxed() ), 2 );
+  return hits;
+}
+
+KadasSharedRenderCache::Stats KadasSharedRenderCache::stats()
+{
+  Stats stats;
+  stats.hits = sHits.loadRelaxed();
+  stats.misses = sMisses.loadRelaxed();
+  return stats;
+}
+
+void KadasSharedRenderCache::resetStats()
+{
+  sHits.storeRelaxed( 0 );
+  sMisses.storeRelaxed( 0 );
+}
@@ -0,0 +1,50 @@
+/***************************************************************************
+    kadassharedrendercache.h
+    ------------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASSHAREDRENDERCACHE_H
+#define KADASSHAREDRENDERCACHE_H
+
+#include "kadas/gui/kadas_gui.h"
+
+class QgsMapCanvas;
+
+/**
+ * Shares the per-layer rendered images of a canvas with other canvases.
+ *
+ * A canvas showing a part of the source canvas at the same scale, rotation and CRS
+ * is seeded with the corresponding crops of the cached layer images of the source
+ * canvas, so that these layers are not rendered again.
+ */
+class KADAS_GUI_EXPORT KadasSharedRenderCache
+{
+  public:
+    struct Stats
+    {
+        int hits = 0;   // Layer images reused from the source canvas
+        int misses = 0; // Layer images which had to be rendered again
+    };
+
+    //! Returns whether the canvas can reuse the rendered layer images of the source canvas
+    static bool canShare( const QgsMapCanvas *canvas, const QgsMapCanvas *source );
+
+    //! Seeds the render cache of the canvas with the cached layer images of the source canvas, returns the number of reused layer images
+    static int seed( QgsMapCanvas *canvas, QgsMapCanvas *source );
+
+    static Stats stats();
+    static void resetStats();
+};
+
+#endif // KADASSHAREDRENDERCACHE_H
@@ -35,6 +35,7 @@
 #include <qgis/qgssymbollayerutils.h>
 #include <qgis/qgsunittypes.h>
 
+#include "kadas/gui/kadasrendersnapshot.h"
 #include "kadas/gui/mapitems/kadasgeometryitem.h"
 
 static QFont measurementFont()
@@ -71,6 +72,7 @@ KadasGeometryItem::KadasGeometryItem( const QgsCoordinateReferenceSystem &crs )
   mDa.setSourceCrs( crs, QgsProject::instance()->transformContext() );
   mDa.setEllipsoid( QgsProject::instance()->readEntry( "Measure", "/Ellipsoid", "NONE" ) );
   connect( this, &KadasGeometryItem::geometryChanged, this, &KadasGeometryItem::updateMeasurements );
+  connect( this, &KadasMapItem::changed, this, &KadasGeometryItem::clearHitTestEngine );
 }
 
 KadasGeometryItem::~KadasGeometryItem()
@@ -123,12 +125,9 @@ void KadasGeometryItem::render( QgsRenderContext &context ) const
   }
 
   // Draw measurement labels
-  int red = QgsSettings().value( "/Qgis/default_measure_color_red", 255 ).toInt();
-  int green = QgsSettings().value( "/Qgis/default_measure_color_green", 0 ).toInt();
-  int blue = QgsSettings().value( "/Qgis/default_measure_color_blue", 0 ).toInt();
   QColor rectColor = QColor( 255, 255, 255, 192 );
 
-  context.painter()->setPen( QColor( red, green, blue ) );
+  context.painter()->setPen( KadasRenderSnapshot::fromContext( context ).measurementColor );
   context.painter()->setFont( measurementFont() );
   QFontMetrics metrics = context.painter()->fontMetrics();
 
@@ -264,6 +263,7 @@ void KadasGeometryItem::updateMeasurements()
 
 void KadasGeometryItem::setInternalGeometry( QgsAbstractGeometry *geom )
 {
+  clearHitTestEngine();
   delete mGeometry;
   mGeometry = geom;
   emit geometryChanged();
@@ -275,32 +275,64 @@ bool KadasGeometryItem::intersects( const KadasMapRect &rect, const QgsMapSettin
   {
     return false;
   }
-  QgsRectangle r = QgsCoordinateTransform( settings.destinationCrs(), crs(), QgsProject::instance() ).transform( rect );
+  QgsRectangle r = QgsCoordinateTransform( settings.destinationCrs(), crs(), settings.transformContext() ).transform( rect );
+
+  // The filter rect is axis aligned, so the bounding box alone decides containment
+  QgsRectangle bbox = mGeometry->boundingBox();
+  if ( contains || !r.intersects( bbox ) )
+  {
+    return r.contains( bbox );
+  }
+  if ( r.contains( bbox ) )
+  {
+    return true;
+  }
 
   QgsPolygon filterRect;
   QgsLineString *exterior = new QgsLineString();
   exterior->setPoints( QgsPointSequence() << QgsPoint( r.xMinimum(), r.yMinimum() ) << QgsPoint( r.xMaximum(), r.yMinimum() ) << QgsPoint( r.xMaximum(), r.yMaximum() ) << QgsPoint( r.xMinimum(), r.yMaximum() ) << QgsPoint( r.xMinimum(), r.yMinimum() ) );
   filterRect.setExteriorRing( exterior );
 
-  QgsGeometryEngine *geomEngine = QgsGeometry::createGeometryEngine( &filterRect );
-  bool intersects = false;
-  if ( ( mBrush.color().alpha() == 0 || mBrush.style() == Qt::NoBrush ) && dynamic_cast<QgsMultiSurface *>( mGeometry ) )
+  return hitTestEngine()->intersects( &filterRect );
+}
+
+void KadasGeometryItem::prepareHitTest() const
+{
+  hitTestEngine();
+}
+
+const QgsGeometryEngine *KadasGeometryItem::hitTestEngine() const
+{
+  // Unfilled polygons are only hit on their outline
+  bool outline = ( mBrush.color().alpha() == 0 || mBrush.style() == Qt::NoBrush ) && dynamic_cast<QgsMultiSurface *>( mGeometry );
+  if ( !mHitTestEngine || outline != mHitTestOutline )
   {
-    QgsMultiSurface *multiSurface = static_cast<QgsMultiSurface *>( mGeometry );
-    QgsMultiCurve multiCurve;
-    for ( int i = 0, n = multiSurface->numGeometries(); i < n; ++i )
+    if ( outline )
     {
-      QgsCurvePolygon *surface = dynamic_cast<QgsCurvePolygon *>( multiSurface->geometryN( i ) );
-      multiCurve.addGeometry( surface->exteriorRing()->clone() );
+      QgsMultiSurface *multiSurface = static_cast<QgsMultiSurface *>( mGeometry );
+      QgsMultiCurve *multiCurve = new QgsMultiCurve();
+      for ( int i = 0, n = multiSurface->numGeometries(); i < n; ++i )
+      {
+        QgsCurvePolygon *surface = dynamic_cast<QgsCurvePolygon *>( multiSurface->geometryN( i ) );
+        multiCurve->addGeometry( surface->exteriorRing()->clone() );
+      }
+      mHitTestGeometry.reset( multiCurve );
     }
-    intersects = contains ? geomEngine->contains( mGeometry ) : geomEngine->intersects( &multiCurve );
-  }
-  else
-  {
-    intersects = contains ? geomEngine->contains( mGeometry ) : geomEngine->intersects( mGeometry );
+    else
+    {
+      mHitTestGeometry.reset( mGeometry->clone() );
+    }
+    mHitTestEngine.reset( QgsGeometry::createGeometryEngine( mHitTestGeometry.get() ) );
+    mHitTestEngine->prepareGeometry();
+    mHitTestOutline = outline;
   }
-  delete geomEngine;
-  return intersects;
+  return mHitTestEngine.get();
+}
+
+void KadasGeometryItem::clearHitTestEngine()
+{
+  mHitTestEngine.reset();
+  mHitTestGeometry.reset();
 }
 
 QPair<KadasMapPos, double> KadasGeometryItem::closestPoint( const KadasMapPos &pos, const QgsMapSettings &settings ) const
@@ -20,12 +20,15 @@
 #include <QBrush>
 #include <QPen>
 
+#include <memory>
+
 #include <qgis/qgsabstractgeometry.h>
 #include <qgis/qgsdistancearea.h>
 
 #include "kadas/gui/mapitems/kadasmapitem.h"
 
 struct QgsVertexId;
+class QgsGeometryEngine;
 
 class KADAS_GUI_EXPORT KadasGeometryItem : public KadasMapItem SIP_ABSTRACT
 {
@@ -81,6 +84,7 @@ class KADAS_GUI_EXPORT KadasGeometryItem : public KadasMapItem SIP_ABSTRACT
     Margin margin() const override;
     QList<KadasMapItem::Node> nodes( const QgsMapSettings &settings ) const override;
     bool intersects( const KadasMapRect &rect, const QgsMapSettings &settings, bool contains = false ) const override;
+    void prepareHitTest() const override;
     QPair<KadasMapPos, double> closestPoint( const KadasMapPos &pos, const QgsMapSettings &settings ) const override;
     void render( QgsRenderContext &context ) const override;
 #ifndef SIP_RUN
@@ -162,6 +166,14 @@ class KADAS_GUI_EXPORT KadasGeometryItem : public KadasMapItem SIP_ABSTRACT
     };
     QList<MeasurementLabel> mMeasurementLabels;
 
+    // Prepared geometry used for hit tests, rebuilt lazily whenever the item changes
+    mutable std::unique_ptr<QgsAbstractGeometry> mHitTestGeometry;
+    mutable std::unique_ptr<QgsGeometryEngine> mHitTestEngine;
+    mutable bool mHitTestOutline = false;
+
+    const QgsGeometryEngine *hitTestEngine() const;
+    void clearHitTestEngine();
+
     static void registerMetaTypes();
 };
 
@@ -17,16 +17,13 @@
 #include <QMenu>
 #include <QJsonArray>
 
-#include <GeographicLib/Geodesic.hpp>
-#include <GeographicLib/GeodesicLine.hpp>
-#include <GeographicLib/Constants.hpp>
-
 #include <qgis/qgsgeometry.h>
 #include <qgis/qgslinestring.h>
 #include <qgis/qgsmapsettings.h>
 #include <qgis/qgsmultilinestring.h>
 #include <qgis/qgspoint.h>
 #include <qgis/qgsproject.h>
+#include <qgis/qgssettings.h>
 
 #include "kadas/gui/mapitems/kadaslineitem.h"
 
@@ -71,6 +68,17 @@ bool KadasLineItem::State::deserialize( const QJsonObject &json )
   return true;
 }
 
+qint64 KadasLineItem::State::memoryUsage( const KadasStateHistory::State *previous ) const
+{
+  const State *prev = dynamic_cast<const State *>( previous );
+  qint64 usage = sizeof( State );
+  for ( int i = 0, n = points.size(); i < n; ++i )
+  {
+    usage += pointsMemoryUsage( points[i], prev && i < prev->points.size() ? &prev->points[i] : nullptr );
+  }
+  return usage;
+}
+
 KadasLineItem::KadasLineItem( const QgsCoordinateReferenceSystem &crs, bool geodesic )
   : KadasGeometryItem( crs )
 {
@@ -351,6 +359,17 @@ void KadasLineItem::setMeasurementMode( MeasurementMode measurementMode, Qgis::A
 
 void KadasLineItem::measureGeometry()
 {
+  // Segment labels only depend on the segment end points and on the settings below, so only re-measure what changed
+  int decimals = QgsSettings().value( "/kadas/measure_decimals", "2" ).toInt();
+  QString cacheKey = QString( "%1:%2:%3:%4" ).arg( static_cast<int>( mMeasurementMode ) ).arg( static_cast<int>( mAngleUnit ) ).arg( static_cast<int>( distanceBaseUnit() ) ).arg( decimals );
+  if ( cacheKey != mMeasurementCacheKey )
+  {
+    mMeasurementCache.clear();
+    mMeasurementCacheKey = cacheKey;
+  }
+  mMeasurementCache.beginUpdate();
+
+  bool measureLength = mMeasurementMode != MeasurementMode::MeasureAzimuthGeoNorth && mMeasurementMode != MeasurementMode::MeasureAzimuthMapNorth;
   double totalLength = 0;
   for ( int iPart = 0, nParts = state()->points.size(); iPart < nParts; ++iPart )
   {
@@ -360,61 +379,60 @@ void KadasLineItem::measureGeometry()
       continue;
     }
 
-    switch ( mMeasurementMode )
+    double totLength = 0;
+    for ( int i = 1, n = part.size(); i < n; ++i )
     {
-      case MeasurementMode::MeasureLineAndSegments:
-      {
-        double totLength = 0;
-        for ( int i = 1, n = part.size(); i < n; ++i )
-        {
-          const KadasItemPos &p1 = part[i - 1];
-          const KadasItemPos &p2 = part[i];
-          double length = mDa.measureLine( p1, p2 );
-          totLength += length;
-          addMeasurements( QStringList() << formatLength( length, distanceBaseUnit() ), KadasItemPos( 0.5 * ( p1.x() + p2.x() ), 0.5 * ( p1.y() + p2.y() ) ) );
-        }
-        QString totLengthStr = tr( "Tot.: %1" ).arg( formatLength( totLength, distanceBaseUnit() ) );
-        addMeasurements( QStringList() << totLengthStr, KadasItemPos::fromPoint( part.last() ), false );
-        totalLength += totLength;
-        break;
-      }
-      case MeasurementMode::MeasureAzimuthGeoNorth:
-      case MeasurementMode::MeasureAzimuthMapNorth:
-      {
-        for ( int i = 1, n = part.size(); i < n; ++i )
-        {
-          const KadasItemPos &p1 = part[i - 1];
-          const KadasItemPos &p2 = part[i];
-          double angle = computeSegmentAzimut( p1, p2, mMeasurementMode == MeasurementMode::MeasureAzimuthGeoNorth );
-          QString segmentAngle = formatAngle( angle, mAngleUnit );
-          addMeasurements( QStringList() << segmentAngle, KadasItemPos( 0.5 * ( p1.x() + p2.x() ), 0.5 * ( p1.y() + p2.y() ) ) );
-        }
-        break;
-      }
-      case MeasurementMode::MeasureLineAndSegmentsAndAzimuthGeoNorth:
-      case MeasurementMode::MeasureLineAndSegmentsAndAzimuthMapNorth:
-      {
-        double totLength = 0;
-        for ( int i = 1, n = part.size(); i < n; ++i )
-        {
-          const KadasItemPos &p1 = part[i - 1];
-          const KadasItemPos &p2 = part[i];
-          double length = mDa.measureLine( p1, p2 );
-          double angle = computeSegmentAzimut( p1, p2, mMeasurementMode == MeasurementMode::MeasureLineAndSegmentsAndAzimuthGeoNorth );
-          totLength += length;
-          QString segmentAngle = formatAngle( angle, mAngleUnit );
-          addMeasurements( QStringList() << formatLength( length, distanceBaseUnit() ) << segmentAngle, KadasItemPos( 0.5 * ( p1.x() + p2.x() ), 0.5 * ( p1.y() + p2.y() ) ) );
-        }
-        QString totLengthStr = tr( "Tot.: %1" ).arg( formatLength( totLength, distanceBaseUnit() ) );
-        addMeasurements( QStringList() << totLengthStr, KadasItemPos::fromPoint( part.last() ), false );
-        totalLength += totLength;
-        break;
-      }
+      const KadasItemPos &p1 = part[i - 1];
+      const KadasItemPos &p2 = part[i];
+      const SegmentMeasurement &segment = measureSegment( p1, p2 );
+      totLength += segment.length;
+      addMeasurements( segment.labels, KadasItemPos( 0.5 * ( p1.x() + p2.x() ), 0.5 * ( p1.y() + p2.y() ) ) );
+    }
+    if ( measureLength )
+    {
+      QString totLengthStr = tr( "Tot.: %1" ).arg( formatLength( totLength, distanceBaseUnit() ) );
+      addMeasurements( QStringList() << totLengthStr, KadasItemPos::fromPoint( part.last() ), false );
+      totalLength += totLength;
     }
   }
   mTotalMeasurement = formatLength( totalLength, distanceBaseUnit() );
 }
 
+const KadasLineItem::SegmentMeasurement &KadasLineItem::measureSegment( const KadasItemPos &p1, const KadasItemPos &p2 )
+{
+  bool found = false;
+  SegmentMeasurement &segment = mMeasurementCache.lookup( p1, p2, found );
+  if ( found )
+  {
+    return segment;
+  }
+  switch ( mMeasurementMode )
+  {
+    case MeasurementMode::MeasureLineAndSegments:
+    {
+      segment.length = mDa.measureLine( p1, p2 );
+      segment.labels = QStringList() << formatLength( segment.length, distanceBaseUnit() );
+      break;
+    }
+    case MeasurementMode::MeasureAzimuthGeoNorth:
+    case MeasurementMode::MeasureAzimuthMapNorth:
+    {
+      double angle = computeSegmentAzimut( p1, p2, mMeasurementMode == MeasurementMode::MeasureAzimuthGeoNorth );
+      segment.labels = QStringList() << formatAngle( angle, mAngleUnit );
+      break;
+    }
+    case MeasurementMode::MeasureLineAndSegmentsAndAzimuthGeoNorth:
+    case MeasurementMode::MeasureLineAndSegmentsAndAzimuthMapNorth:
+    {
+      segment.length = mDa.measureLine( p1, p2 );
+      double angle = computeSegmentAzimut( p1, p2, mMeasurementMode == MeasurementMode::MeasureLineAndSegmentsAndAzimuthGeoNorth );
+      segment.labels = QStringList() << formatLength( segment.length, distanceBaseUnit() ) << formatAngle( angle, mAngleUnit );
+      break;
+    }
+  }
+  return segment;
+}
+
 double KadasLineItem::computeSegmentAzimut( const KadasItemPos &p1, const KadasItemPos &p2, bool geoNorth ) const
 {
   double angle = 0;
@@ -438,45 +456,17 @@ void KadasLineItem::recomputeDerived()
 
   if ( mGeodesic )
   {
-    QgsCoordinateTransform t1( mCrs, QgsCoordinateReferenceSystem( "EPSG:4326" ), QgsProject::instance() );
-    QgsCoordinateTransform t2( QgsCoordinateReferenceSystem( "EPSG:4326" ), mCrs, QgsProject::instance() );
-    GeographicLib::Geodesic geod( GeographicLib::Constants::WGS84_a(), GeographicLib::Constants::WGS84_f() );
-
+    // Densified segments are cached, only segments touched by the last edit are recomputed
+    mGeodesicSegments.beginUpdate( mCrs );
     for ( int iPart = 0, nParts = state()->points.size(); iPart < nParts; ++iPart )
     {
       const QList<KadasItemPos> &part = state()->points[iPart];
-      QgsLineString *ring = new QgsLineString();
-
-      int nPoints = part.size();
-      if ( nPoints >= 2 )
+      QVector<double> x, y;
+      for ( int i = 0, nPoints = part.size(); i < nPoints - 1; ++i )
       {
-        QList<QgsPointXY> wgsPoints;
-        for ( const KadasItemPos &point : part )
-        {
-          wgsPoints.append( t1.transform( point ) );
-        }
-
-        double sdist = 100000; // 100km segments
-        for ( int i = 0; i < nPoints - 1; ++i )
-        {
-          GeographicLib::GeodesicLine line = geod.InverseLine( wgsPoints[i].y(), wgsPoints[i].x(), wgsPoints[i + 1].y(), wgsPoints[i + 1].x() );
-          double dist = line.Distance();
-          int nIntervals = std::max( 1, int( std::ceil( dist / sdist ) ) );
-          for ( int j = 0; j < nIntervals; ++j )
-          {
-            double lat, lon;
-            line.Position( j * sdist, lat, lon );
-            ring->addVertex( QgsPoint( t2.transform( QgsPointXY( lon, lat ) ) ) );
-          }
-          if ( i == nPoints - 2 )
-          {
-            double lat, lon;
-            line.Position( dist, lat, lon );
-            ring->addVertex( QgsPoint( t2.transform( QgsPointXY( lon, lat ) ) ) );
-          }
-        }
+        mGeodesicSegments.append( x, y, part[i], part[i + 1], i == nPoints - 2 );
       }
-      multiGeom->addGeometry( ring );
+      multiGeom->addGeometry( new QgsLineString( x, y ) );
     }
   }
   else
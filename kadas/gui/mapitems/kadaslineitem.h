@@ -18,6 +18,9 @@
 #define KADASLINEITEM_H
 
 #include "kadas/gui/mapitems/kadasgeometryitem.h"
+#ifndef SIP_RUN
+#include "kadas/gui/mapitems/kadassegmentcache.h"
+#endif
 
 class QgsMultiLineString;
 
@@ -83,6 +86,7 @@ class KADAS_GUI_EXPORT KadasLineItem : public KadasGeometryItem
         State *clone() const override SIP_FACTORY { return new State( *this ); }
         QJsonObject serialize() const override;
         bool deserialize( const QJsonObject &json ) override;
+        qint64 memoryUsage( const KadasStateHistory::State *previous ) const override;
     };
     const State *constState() const { return static_cast<State *>( mState ); }
 
@@ -103,10 +107,20 @@ class KADAS_GUI_EXPORT KadasLineItem : public KadasGeometryItem
     MeasurementMode mMeasurementMode = MeasurementMode::MeasureLineAndSegments;
     Qgis::AngleUnit mAngleUnit = Qgis::AngleUnit::Degrees;
 
+    struct SegmentMeasurement
+    {
+        double length = 0;
+        QStringList labels;
+    };
+    KadasGeodesicSegments mGeodesicSegments;
+    KadasSegmentCache<SegmentMeasurement> mMeasurementCache;
+    QString mMeasurementCacheKey;
+
     QgsMultiLineString *geometry();
     State *state() { return static_cast<State *>( mState ); }
 
     double computeSegmentAzimut( const KadasItemPos &p1, const KadasItemPos &p2, bool geoNorth ) const;
+    const SegmentMeasurement &measureSegment( const KadasItemPos &p1, const KadasItemPos &p2 );
 };
 
 #endif // KADASLINEITEM_H
@@ -16,9 +16,6 @@
 
 #include <thread>
 
-#include <QApplication>
-#include <QDesktopWidget>
-
 #include <qgis/qgscoordinatetransform.h>
 #include <qgis/qgslogger.h>
 #include <qgis/qgsmaplayer.h>
@@ -28,6 +25,7 @@
 #include <qgis/qgssettings.h>
 #include <qgis/qgsunittypes.h>
 
+#include "kadas/gui/kadasrendersnapshot.h"
 #include "kadas/gui/mapitems/kadasmapitem.h"
 
 #include "kadas/gui/mapitems/kadascircleitem.h"
@@ -330,7 +328,7 @@ void KadasMapItem::anchorNodeRenderer( QPainter *painter, const QPointF &screenP
 
 double KadasMapItem::outputDpiScale( const QgsRenderContext &context )
 {
-  return double( context.painter()->device()->logicalDpiX() ) / qApp->desktop()->logicalDpiX();
+  return KadasRenderSnapshot::outputDpiScale( context );
 }
 
 double KadasMapItem::getTextRenderScale( const QgsRenderContext &context )
@@ -413,13 +411,18 @@ QDomElement KadasMapItem::writeXml( QDomDocument &document ) const
 }
 
 KadasMapItem *KadasMapItem::fromXml( const QDomElement &element )
+{
+  QJsonDocument data = QJsonDocument::fromJson( element.firstChild().toCDATASection().data().toLocal8Bit() );
+  return fromXml( element, data.object() );
+}
+
+KadasMapItem *KadasMapItem::fromXml( const QDomElement &element, const QJsonObject &data )
 {
   QDomElement itemEl = element;
   QString name = itemEl.attribute( "name" );
   QString crs = itemEl.attribute( "crs" );
   QString editor = itemEl.attribute( "editor" );
   QString layerId = itemEl.attribute( "associatedLayer" );
-  QJsonDocument data = QJsonDocument::fromJson( itemEl.firstChild().toCDATASection().data().toLocal8Bit() );
   KadasMapItem::RegistryItemFactory factory = KadasMapItem::registry()->value( name );
   if ( factory )
   {
@@ -429,7 +432,7 @@ KadasMapItem *KadasMapItem::fromXml( const QDomElement &element )
     {
       item->associateToLayer( QgsProject::instance()->mapLayer( layerId ) );
     }
-    if ( item->deserialize( data.object() ) )
+    if ( item->deserialize( data ) )
     {
       return item;
     }
@@ -326,6 +326,8 @@ class KADAS_GUI_EXPORT KadasMapItem : public QObject SIP_ABSTRACT
     /* Hit test, rect in item crs */
     virtual bool intersects( const KadasMapRect &rect, const QgsMapSettings &settings, bool contains = false ) const = 0;
     virtual bool hitTest( const KadasMapPos &pos, const QgsMapSettings &settings ) const;
+    /* Builds lazily cached hit test state, called before hit tests run concurrently */
+    virtual void prepareHitTest() const {}
 
     /* Return the item point to the specified one */
     virtual QPair<KadasMapPos, double> closestPoint( const KadasMapPos &pos, const QgsMapSettings &settings ) const;
@@ -395,6 +397,13 @@ class KADAS_GUI_EXPORT KadasMapItem : public QObject SIP_ABSTRACT
         virtual State *clone() const = 0 SIP_FACTORY;
         virtual QJsonObject serialize() const = 0;
         virtual bool deserialize( const QJsonObject &json ) = 0;
+
+      protected:
+        //! Returns the memory used by a list of points, zero if it is implicitly shared with the previous list
+        static qint64 pointsMemoryUsage( const QList<KadasItemPos> &points, const QList<KadasItemPos> *previous ) SIP_SKIP
+        {
+          return previous && points.isSharedWith( *previous ) ? 0 : points.size() * qint64( sizeof( KadasItemPos ) + sizeof( void * ) );
+        }
     };
     const State *constState() const { return mState; }
     virtual void setState( const State *state );
@@ -492,6 +501,10 @@ class KADAS_GUI_EXPORT KadasMapItem : public QObject SIP_ABSTRACT
 
     QDomElement writeXml( QDomDocument &document ) const;
     static KadasMapItem *fromXml( const QDomElement &element );
+#ifndef SIP_RUN
+    /* Create the item from its XML element and the already parsed item data */
+    static KadasMapItem *fromXml( const QDomElement &element, const QJsonObject &data );
+#endif
 
     void preventAttachmentCleanup()
     {
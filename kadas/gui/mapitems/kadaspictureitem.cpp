@@ -19,6 +19,7 @@
 #include <QImageReader>
 #include <QJsonArray>
 #include <QMenu>
+#include <QtConcurrentRun>
 
 #include <array>
 #include <exiv2/exiv2.hpp>
@@ -32,7 +33,7 @@
 
 #include <quazip/quazipfile.h>
 
-#include "kadas/core/kadascoordinateutils.h"
+#include "kadas/core/kadasheightmap.h"
 #include "kadas/analysis/kadaslineofsight.h"
 #include "kadas/gui/mapitems/kadaspictureitem.h"
 
@@ -85,6 +86,34 @@ KadasPictureItem::~KadasPictureItem()
 }
 
 void KadasPictureItem::setup( const QString &path, const KadasItemPos &fallbackPos, bool ignoreExiv, double offsetX, double offsetY, int width, int height )
+{
+  setupWithGeoPos( path, fallbackPos, ignoreExiv ? GeoPos() : readGeoPos( path, mCrs ), offsetX, offsetY, width, height );
+}
+
+QList<KadasPictureItem *> KadasPictureItem::createItems( const QStringList &paths, const QgsCoordinateReferenceSystem &crs, const KadasItemPos &fallbackPos )
+{
+  // Resolve the project heightmap on the main thread, each worker opens its own handle
+  KadasHeightmap::Source heightmapSource = KadasHeightmap().source();
+
+  QList<QFuture<GeoPos>> futures;
+  for ( const QString &path : paths )
+  {
+    futures.append( QtConcurrent::run( [path, crs, heightmapSource] {
+      return readGeoPos( path, crs, &heightmapSource );
+    } ) );
+  }
+
+  QList<KadasPictureItem *> items;
+  for ( int i = 0, n = paths.size(); i < n; ++i )
+  {
+    KadasPictureItem *item = new KadasPictureItem( crs );
+    item->setupWithGeoPos( paths[i], fallbackPos, futures[i].result(), 0, 50, 0, 0 );
+    items.append( item );
+  }
+  return items;
+}
+
+void KadasPictureItem::setupWithGeoPos( const QString &path, const KadasItemPos &fallbackPos, const GeoPos &geoPos, double offsetX, double offsetY, int width, int height )
 {
   cleanupAttachment( mFilePath );
 
@@ -121,14 +150,11 @@ void KadasPictureItem::setup( const QString &path, const KadasItemPos &fallbackP
   }
 
   state()->mPos = fallbackPos;
-  KadasItemPos cameraPos;
-  QList<KadasItemPos> footprint;
-  KadasItemPos cameraTarget;
-  if ( !ignoreExiv && readGeoPos( path, mCrs, cameraPos, footprint, cameraTarget ) )
+  if ( geoPos.valid )
   {
-    state()->mPos = cameraPos;
-    state()->mFootprint = footprint;
-    state()->mRectangleCenterPoint = cameraTarget;
+    state()->mPos = geoPos.cameraPos;
+    state()->mFootprint = geoPos.footprint;
+    state()->mRectangleCenterPoint = geoPos.cameraTarget;
     mPosLocked = true;
   }
 
@@ -277,8 +303,9 @@ static QMatrix3x3 rotAngleAxis( const std::array<float, 3> &u, float angle )
   );
 }
 
-bool KadasPictureItem::readGeoPos( const QString &filePath, const QgsCoordinateReferenceSystem &destCrs, KadasItemPos &cameraPos, QList<KadasItemPos> &footprint, KadasItemPos &cameraTarget )
+KadasPictureItem::GeoPos KadasPictureItem::readGeoPos( const QString &filePath, const QgsCoordinateReferenceSystem &destCrs, const KadasHeightmap::Source *heightmapSource )
 {
+  GeoPos geoPos;
   // Read EXIF position
   Exiv2::Image::UniquePtr image;
   try
@@ -287,19 +314,19 @@ bool KadasPictureItem::readGeoPos( const QString &filePath, const QgsCoordinateR
   }
   catch ( const Exiv2::Error & )
   {
-    return false;
+    return geoPos;
   }
 
   if ( image.get() == 0 )
   {
-    return false;
+    return geoPos;
   }
 
   image->readMetadata();
   Exiv2::ExifData &exifData = image->exifData();
   if ( exifData.empty() )
   {
-    return false;
+    return geoPos;
   }
 
   Exiv2::ExifData::iterator itLatRef = exifData.findKey( Exiv2::ExifKey( "Exif.GPSInfo.GPSLatitudeRef" ) );
@@ -309,7 +336,7 @@ bool KadasPictureItem::readGeoPos( const QString &filePath, const QgsCoordinateR
 
   if ( itLatRef == exifData.end() || itLatVal == exifData.end() || itLonRef == exifData.end() || itLonVal == exifData.end() )
   {
-    return false;
+    return geoPos;
   }
   QString latRef = QString::fromStdString( itLatRef->value().toString() );
   QString lonRef = QString::fromStdString( itLonRef->value().toString() );
@@ -329,11 +356,14 @@ bool KadasPictureItem::readGeoPos( const QString &filePath, const QgsCoordinateR
   if ( lon == 0 && lat == 0 )
   {
     // Assume 0, 0 is an invalid coordinate as it is pretty unlikely the image was captured at that position
-    return false;
+    return geoPos;
   }
 
+  // Workers use the transform context captured on the main thread
+  QgsCoordinateTransformContext transformContext = heightmapSource ? heightmapSource->transformContext : QgsProject::instance()->transformContext();
   QgsCoordinateReferenceSystem crs4326( "EPSG:4326" );
-  cameraPos = KadasItemPos::fromPoint( QgsCoordinateTransform( crs4326, destCrs, QgsProject::instance() ).transform( QgsPointXY( lon, lat ) ) );
+  geoPos.valid = true;
+  geoPos.cameraPos = KadasItemPos::fromPoint( QgsCoordinateTransform( crs4326, destCrs, transformContext ).transform( QgsPointXY( lon, lat ) ) );
 
   // Footprint
   Exiv2::ExifData::iterator itUserComment = exifData.findKey( Exiv2::ExifKey( "Exif.Photo.UserComment" ) );
@@ -381,33 +411,39 @@ bool KadasPictureItem::readGeoPos( const QString &filePath, const QgsCoordinateR
 
       // Terrain intersection: up to max 25km, binary search for terrain point from which camera becomes visible
       QgsCoordinateReferenceSystem crs3857( "EPSG:3857" );
-      QgsPointXY mrcPosXY = QgsCoordinateTransform( destCrs, crs3857, QgsProject::instance() ).transform( cameraPos );
+      QgsPointXY mrcPosXY = QgsCoordinateTransform( destCrs, crs3857, transformContext ).transform( geoPos.cameraPos );
+      // All corner rays are marched against the same heightmap instance, which caches the raster blocks
+      std::unique_ptr<KadasHeightmap> heightmap( heightmapSource ? new KadasHeightmap( *heightmapSource ) : new KadasHeightmap() );
+      QgsPointXY heightmapPos = QgsCoordinateTransform( crs3857, heightmap->crs(), transformContext ).transform( mrcPosXY );
+
       // Ensure altitude is at least 1m above terrain
-      double terrHeigth = KadasCoordinateUtils::getHeightAtPos( mrcPosXY, crs3857, Qgis::DistanceUnit::Meters );
+      double terrHeigth = heightmap->heightAt( heightmapPos );
       QgsPoint mrcPos( mrcPosXY.x(), mrcPosXY.y(), std::max( alt, terrHeigth + 1 ) );
 
+      // Ray march up to 2m resolution, 2m terrain resolution
       double d = 25000;
-      QgsPoint pTerrBottomLeft = findTerrainIntersection( mrcPos, mrcPos, QgsPoint( mrcPos.x() + rbottomleft[0] * d, mrcPos.y() + rbottomleft[1] * d, mrcPos.z() + rbottomleft[2] * d ), crs3857 );
-      QgsPoint pTerrBottomRight = findTerrainIntersection( mrcPos, mrcPos, QgsPoint( mrcPos.x() + rbottomright[0] * d, mrcPos.y() + rbottomright[1] * d, mrcPos.z() + rbottomright[2] * d ), crs3857 );
-      QgsPoint pTerrTopLeft = findTerrainIntersection( mrcPos, mrcPos, QgsPoint( mrcPos.x() + rtopleft[0] * d, mrcPos.y() + rtopleft[1] * d, mrcPos.z() + rtopleft[2] * d ), crs3857 );
-      QgsPoint pTerrTopRight = findTerrainIntersection( mrcPos, mrcPos, QgsPoint( mrcPos.x() + rtopright[0] * d, mrcPos.y() + rtopright[1] * d, mrcPos.z() + rtopright[2] * d ), crs3857 );
+      double resolution = 2;
+      QgsPoint pTerrBottomLeft = KadasLineOfSight::findTerrainIntersection( *heightmap, mrcPos, QgsPoint( mrcPos.x() + rbottomleft[0] * d, mrcPos.y() + rbottomleft[1] * d, mrcPos.z() + rbottomleft[2] * d ), crs3857, resolution );
+      QgsPoint pTerrBottomRight = KadasLineOfSight::findTerrainIntersection( *heightmap, mrcPos, QgsPoint( mrcPos.x() + rbottomright[0] * d, mrcPos.y() + rbottomright[1] * d, mrcPos.z() + rbottomright[2] * d ), crs3857, resolution );
+      QgsPoint pTerrTopLeft = KadasLineOfSight::findTerrainIntersection( *heightmap, mrcPos, QgsPoint( mrcPos.x() + rtopleft[0] * d, mrcPos.y() + rtopleft[1] * d, mrcPos.z() + rtopleft[2] * d ), crs3857, resolution );
+      QgsPoint pTerrTopRight = KadasLineOfSight::findTerrainIntersection( *heightmap, mrcPos, QgsPoint( mrcPos.x() + rtopright[0] * d, mrcPos.y() + rtopright[1] * d, mrcPos.z() + rtopright[2] * d ), crs3857, resolution );
 
       QVector3 reye = R * ey;
       // Point in camera direction 25km away to compute the camera direction
       QgsPoint target( mrcPos.x() + reye[0] * .75 * d, mrcPos.y() + reye[1] * .75 * d, mrcPos.z() + reye[2] * .75 * d );
 
-      QgsCoordinateTransform crst( crs3857, destCrs, QgsProject::instance() );
-      footprint = {
+      QgsCoordinateTransform crst( crs3857, destCrs, transformContext );
+      geoPos.footprint = {
         KadasItemPos::fromPoint( crst.transform( pTerrBottomLeft ) ),
         KadasItemPos::fromPoint( crst.transform( pTerrBottomRight ) ),
         KadasItemPos::fromPoint( crst.transform( pTerrTopRight ) ),
         KadasItemPos::fromPoint( crst.transform( pTerrTopLeft ) )
       };
-      cameraTarget = KadasItemPos::fromPoint( crst.transform( target ) );
+      geoPos.cameraTarget = KadasItemPos::fromPoint( crst.transform( target ) );
     }
   }
 
-  return true;
+  return geoPos;
 }
 
 double KadasPictureItem::parseExifRational( const QString &entry )
@@ -428,24 +464,3 @@ double KadasPictureItem::parseExifRational( const QString &entry )
   }
   return value;
 }
-
-QgsPoint KadasPictureItem::findTerrainIntersection( const QgsPoint &cameraPos, QgsPoint nearPos, QgsPoint farPos, const QgsCoordinateReferenceSystem &crs )
-{
-  // Binary search between cameraPos and farPos until farPos sees camera, up to 2m resolution, 2m terrain resolution
-  double resolution = 2;
-  while ( nearPos.distanceSquared( farPos ) > resolution * resolution )
-  {
-    QgsPoint midPos( 0.5 * ( nearPos.x() + farPos.x() ), 0.5 * ( nearPos.y() + farPos.y() ), 0.5 * ( nearPos.z() + farPos.z() ) );
-    double len = cameraPos.distance( midPos );
-    int samples = std::round( len / resolution );
-    if ( KadasLineOfSight::computeTargetVisibility( cameraPos, midPos, crs, samples, true, true ) )
-    {
-      nearPos = midPos;
-    }
-    else
-    {
-      farPos = midPos;
-    }
-  }
-  return QgsPoint( 0.5 * ( nearPos.x() + farPos.x() ), 0.5 * ( nearPos.y() + farPos.y() ), 0.5 * ( nearPos.z() + farPos.z() ) );
-}
@@ -17,6 +17,7 @@
 #ifndef KADASPICTUREITEM_H
 #define KADASPICTUREITEM_H
 
+#include "kadas/core/kadasheightmap.h"
 #include "kadas/gui/mapitems/kadasrectangleitembase.h"
 
 
@@ -30,6 +31,9 @@ class KADAS_GUI_EXPORT KadasPictureItem : public KadasRectangleItemBase
     ~KadasPictureItem();
     void setup( const QString &path, const KadasItemPos &fallbackPos, bool ignoreExiv = false, double offsetX = 0, double offsetY = 50, int width = 0, int height = 0 );
 
+    // Creates picture items for multiple files, the geotags and camera footprints are computed in parallel
+    static QList<KadasPictureItem *> createItems( const QStringList &paths, const QgsCoordinateReferenceSystem &crs, const KadasItemPos &fallbackPos );
+
     const QString &filePath() const { return mFilePath; }
     void setFilePath( const QString &filePath );
 
@@ -60,6 +64,15 @@ class KADAS_GUI_EXPORT KadasPictureItem : public KadasRectangleItemBase
     void editPrivate( const KadasMapPos &newPoint, const QgsMapSettings &mapSettings ) override;
 
   private:
+    struct GeoPos
+    {
+        bool valid = false;
+        KadasItemPos cameraPos;
+        QList<KadasItemPos> footprint;
+        KadasItemPos cameraTarget;
+    };
+
+    void setupWithGeoPos( const QString &path, const KadasItemPos &fallbackPos, const GeoPos &geoPos, double offsetX, double offsetY, int width, int height );
     QImage readImage( double dpiScale = 1 ) const;
     enum AttribIds
     {
@@ -74,9 +87,9 @@ class KADAS_GUI_EXPORT KadasPictureItem : public KadasRectangleItemBase
 
     State *state() { return static_cast<State *>( mState ); }
 
-    static bool readGeoPos( const QString &filePath, const QgsCoordinateReferenceSystem &destCrs, KadasItemPos &cameraPos, QList<KadasItemPos> &footprint, KadasItemPos &cameraTarget );
+    // If heightmapSource is null, the project heightmap is used, which is only allowed from the main thread
+    static GeoPos readGeoPos( const QString &filePath, const QgsCoordinateReferenceSystem &destCrs, const KadasHeightmap::Source *heightmapSource = nullptr );
     static double parseExifRational( const QString &rational );
-    static QgsPoint findTerrainIntersection( const QgsPoint &cameraPos, QgsPoint nearPos, QgsPoint farPos, const QgsCoordinateReferenceSystem &crs );
 };
 
 #endif // KADASPICTUREITEM_H
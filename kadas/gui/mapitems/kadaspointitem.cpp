@@ -52,6 +52,12 @@ bool KadasPointItem::State::deserialize( const QJsonObject &json )
   return true;
 }
 
+qint64 KadasPointItem::State::memoryUsage( const KadasStateHistory::State *previous ) const
+{
+  const State *prev = dynamic_cast<const State *>( previous );
+  return sizeof( State ) + pointsMemoryUsage( points, prev ? &prev->points : nullptr );
+}
+
 KadasPointItem::KadasPointItem( const QgsCoordinateReferenceSystem &crs, IconType icon )
   : KadasGeometryItem( crs )
 {
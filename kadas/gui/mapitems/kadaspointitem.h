@@ -61,6 +61,7 @@ class KADAS_GUI_EXPORT KadasPointItem : public KadasGeometryItem
         State *clone() const override SIP_FACTORY { return new State( *this ); }
         QJsonObject serialize() const override;
         bool deserialize( const QJsonObject &json ) override;
+        qint64 memoryUsage( const KadasStateHistory::State *previous ) const override;
     };
     const State *constState() const { return static_cast<State *>( mState ); }
 
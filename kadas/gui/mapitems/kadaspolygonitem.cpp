@@ -17,10 +17,6 @@
 #include <QMenu>
 #include <QJsonArray>
 
-#include <GeographicLib/Geodesic.hpp>
-#include <GeographicLib/GeodesicLine.hpp>
-#include <GeographicLib/Constants.hpp>
-
 #include <qgis/qgsgeometry.h>
 #include <qgis/qgslinestring.h>
 #include <qgis/qgspolygon.h>
@@ -28,6 +24,7 @@
 #include <qgis/qgsmultipolygon.h>
 #include <qgis/qgspoint.h>
 #include <qgis/qgsproject.h>
+#include <qgis/qgssettings.h>
 
 #include "kadas/gui/mapitems/kadaspolygonitem.h"
 
@@ -73,6 +70,17 @@ bool KadasPolygonItem::State::deserialize( const QJsonObject &json )
   return true;
 }
 
+qint64 KadasPolygonItem::State::memoryUsage( const KadasStateHistory::State *previous ) const
+{
+  const State *prev = dynamic_cast<const State *>( previous );
+  qint64 usage = sizeof( State );
+  for ( int i = 0, n = points.size(); i < n; ++i )
+  {
+    usage += pointsMemoryUsage( points[i], prev && i < prev->points.size() ? &prev->points[i] : nullptr );
+  }
+  return usage;
+}
+
 
 KadasPolygonItem::KadasPolygonItem( const QgsCoordinateReferenceSystem &crs, bool geodesic )
   : KadasGeometryItem( crs )
@@ -334,14 +342,33 @@ QgsMultiPolygon *KadasPolygonItem::geometry()
 
 void KadasPolygonItem::measureGeometry()
 {
-  double totalArea = 0;
-  for ( int i = 0, n = geometry()->numGeometries(); i < n; ++i )
+  // Parts whose points did not change since the last measurement keep their area and label
+  int decimals = QgsSettings().value( "/kadas/measure_decimals", "2" ).toInt();
+  QString cacheKey = QString( "%1:%2:%3" ).arg( static_cast<int>( areaBaseUnit() ) ).arg( decimals ).arg( mGeodesic );
+  if ( cacheKey != mMeasurementCacheKey )
   {
-    const QgsPolygon *polygon = static_cast<QgsPolygon *>( geometry()->geometryN( i ) );
+    mPartMeasurements.clear();
+    mMeasurementCacheKey = cacheKey;
+  }
 
-    double area = mDa.measureArea( QgsGeometry( polygon->clone() ) );
-    addMeasurements( QStringList() << formatArea( area, areaBaseUnit() ), KadasItemPos::fromPoint( polygon->centroid() ) );
-    totalArea += area;
+  double totalArea = 0;
+  int nParts = geometry()->numGeometries();
+  mPartMeasurements.resize( nParts );
+  for ( int i = 0; i < nParts; ++i )
+  {
+    const QList<KadasItemPos> &part = state()->points[i];
+    PartMeasurement &measurement = mPartMeasurements[i];
+    if ( !measurement.valid || ( !measurement.points.isSharedWith( part ) && measurement.points != part ) )
+    {
+      const QgsPolygon *polygon = static_cast<QgsPolygon *>( geometry()->geometryN( i ) );
+      measurement.points = part;
+      measurement.area = mDa.measureArea( QgsGeometry( polygon->clone() ) );
+      measurement.centroid = KadasItemPos::fromPoint( polygon->centroid() );
+      measurement.label = formatArea( measurement.area, areaBaseUnit() );
+      measurement.valid = true;
+    }
+    addMeasurements( QStringList() << measurement.label, measurement.centroid );
+    totalArea += measurement.area;
   }
   mTotalMeasurement = formatArea( totalArea, areaBaseUnit() );
 }
@@ -352,47 +379,22 @@ void KadasPolygonItem::recomputeDerived()
 
   if ( mGeodesic )
   {
-    QgsCoordinateTransform t1( mCrs, QgsCoordinateReferenceSystem( "EPSG:4326" ), QgsProject::instance() );
-    QgsCoordinateTransform t2( QgsCoordinateReferenceSystem( "EPSG:4326" ), mCrs, QgsProject::instance() );
-    GeographicLib::Geodesic geod( GeographicLib::Constants::WGS84_a(), GeographicLib::Constants::WGS84_f() );
-
+    // Densified segments are cached, only segments touched by the last edit are recomputed
+    mGeodesicSegments.beginUpdate( mCrs );
     for ( int iPart = 0, nParts = state()->points.size(); iPart < nParts; ++iPart )
     {
       const QList<KadasItemPos> &part = state()->points[iPart];
-      QgsLineString *ring = new QgsLineString();
-
+      QVector<double> x, y;
       int nPoints = part.size();
       if ( nPoints >= 2 )
       {
-        QList<QgsPointXY> wgsPoints;
-        for ( const KadasItemPos &point : part )
-        {
-          wgsPoints.append( t1.transform( point ) );
-        }
-        wgsPoints.append( t1.transform( part.front() ) );
-
-        double sdist = 100000; // 100km segments
         for ( int i = 0; i < nPoints; ++i )
         {
-          GeographicLib::GeodesicLine line = geod.InverseLine( wgsPoints[i].y(), wgsPoints[i].x(), wgsPoints[i + 1].y(), wgsPoints[i + 1].x() );
-          double dist = line.Distance();
-          int nIntervals = std::max( 1, int( std::ceil( dist / sdist ) ) );
-          for ( int j = 0; j < nIntervals; ++j )
-          {
-            double lat, lon;
-            line.Position( j * sdist, lat, lon );
-            ring->addVertex( QgsPoint( t2.transform( QgsPointXY( lon, lat ) ) ) );
-          }
-          if ( i == nPoints - 1 )
-          {
-            double lat, lon;
-            line.Position( dist, lat, lon );
-            ring->addVertex( QgsPoint( t2.transform( QgsPointXY( lon, lat ) ) ) );
-          }
+          mGeodesicSegments.append( x, y, part[i], part[( i + 1 ) % nPoints], i == nPoints - 1 );
         }
       }
       QgsPolygon *poly = new QgsPolygon();
-      poly->setExteriorRing( ring );
+      poly->setExteriorRing( new QgsLineString( x, y ) );
       multiGeom->addGeometry( poly );
     }
   }
@@ -18,6 +18,9 @@
 #define KADASPOLYGONITEM_H
 
 #include "kadas/gui/mapitems/kadasgeometryitem.h"
+#ifndef SIP_RUN
+#include "kadas/gui/mapitems/kadassegmentcache.h"
+#endif
 
 class QgsMultiPolygon;
 
@@ -70,6 +73,7 @@ class KADAS_GUI_EXPORT KadasPolygonItem : public KadasGeometryItem
         State *clone() const override SIP_FACTORY { return new State( *this ); }
         QJsonObject serialize() const override;
         bool deserialize( const QJsonObject &json ) override;
+        qint64 memoryUsage( const KadasStateHistory::State *previous ) const override;
     };
     const State *constState() const { return static_cast<State *>( mState ); }
 
@@ -88,6 +92,18 @@ class KADAS_GUI_EXPORT KadasPolygonItem : public KadasGeometryItem
 
     bool mGeodesic = false;
 
+    struct PartMeasurement
+    {
+        QList<KadasItemPos> points;
+        double area = 0;
+        KadasItemPos centroid;
+        QString label;
+        bool valid = false;
+    };
+    KadasGeodesicSegments mGeodesicSegments;
+    QVector<PartMeasurement> mPartMeasurements;
+    QString mMeasurementCacheKey;
+
     QgsMultiPolygon *geometry();
     State *state() { return static_cast<State *>( mState ); }
 };
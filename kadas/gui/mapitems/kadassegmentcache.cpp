@@ -0,0 +1,67 @@
+/***************************************************************************
+    kadassegmentcache.cpp
+    ---------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <GeographicLib/Geodesic.hpp>
+#include <GeographicLib/GeodesicLine.hpp>
+
+#include <qgis/qgsproject.h>
+
+#include "kadas/gui/mapitems/kadassegmentcache.h"
+
+
+void KadasGeodesicSegments::beginUpdate( const QgsCoordinateReferenceSystem &crs )
+{
+  if ( crs != mCrs || !mToWgs.isValid() )
+  {
+    mCrs = crs;
+    mToWgs = QgsCoordinateTransform( mCrs, QgsCoordinateReferenceSystem( "EPSG:4326" ), QgsProject::instance() );
+    mFromWgs = QgsCoordinateTransform( QgsCoordinateReferenceSystem( "EPSG:4326" ), mCrs, QgsProject::instance() );
+    mCache.clear();
+  }
+  mCache.beginUpdate();
+}
+
+void KadasGeodesicSegments::append( QVector<double> &x, QVector<double> &y, const KadasItemPos &p1, const KadasItemPos &p2, bool includeEnd )
+{
+  bool found = false;
+  QVector<QgsPointXY> &vertices = mCache.lookup( p1, p2, found );
+  if ( !found )
+  {
+    const GeographicLib::Geodesic &geod = GeographicLib::Geodesic::WGS84();
+    QgsPointXY wgs1 = mToWgs.transform( p1 );
+    QgsPointXY wgs2 = mToWgs.transform( p2 );
+
+    double sdist = 100000; // 100km segments
+    GeographicLib::GeodesicLine line = geod.InverseLine( wgs1.y(), wgs1.x(), wgs2.y(), wgs2.x() );
+    double dist = line.Distance();
+    int nIntervals = std::max( 1, int( std::ceil( dist / sdist ) ) );
+    vertices.reserve( nIntervals + 1 );
+    for ( int j = 0; j < nIntervals; ++j )
+    {
+      double lat, lon;
+      line.Position( j * sdist, lat, lon );
+      vertices.append( mFromWgs.transform( QgsPointXY( lon, lat ) ) );
+    }
+    double lat, lon;
+    line.Position( dist, lat, lon );
+    vertices.append( mFromWgs.transform( QgsPointXY( lon, lat ) ) );
+  }
+  for ( int i = 0, n = includeEnd ? vertices.size() : vertices.size() - 1; i < n; ++i )
+  {
+    x.append( vertices[i].x() );
+    y.append( vertices[i].y() );
+  }
+}
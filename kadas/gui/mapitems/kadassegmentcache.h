@@ -0,0 +1,105 @@
+/***************************************************************************
+    kadassegmentcache.h
+    -------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASSEGMENTCACHE_H
+#define KADASSEGMENTCACHE_H
+
+#include <QHash>
+#include <QVector>
+
+#include <qgis/qgscoordinatereferencesystem.h>
+#include <qgis/qgscoordinatetransform.h>
+
+#include "kadas/gui/kadas_gui.h"
+#include "kadas/gui/mapitems/kadasmapitem.h"
+
+#define SIP_NO_FILE
+
+
+struct KadasSegmentKey
+{
+    double x1, y1, x2, y2;
+
+    bool operator==( const KadasSegmentKey &other ) const
+    {
+      return x1 == other.x1 && y1 == other.y1 && x2 == other.x2 && y2 == other.y2;
+    }
+};
+
+inline uint qHash( const KadasSegmentKey &key, uint seed = 0 )
+{
+  return qHashBits( &key, sizeof( KadasSegmentKey ), seed );
+}
+
+/**
+ * Per-segment cache of derived data, keyed by the segment end points.
+ * Entries survive one generation: whatever was not looked up between two
+ * calls to beginUpdate() is dropped, so the cache stays proportional to the
+ * geometry while edits only recompute the segments they touched.
+ */
+template<class T>
+class KadasSegmentCache
+{
+  public:
+    void beginUpdate()
+    {
+      mPrevious = std::move( mCurrent );
+      mCurrent.clear();
+    }
+    void clear()
+    {
+      mPrevious.clear();
+      mCurrent.clear();
+    }
+    // Returns the entry of the segment p1-p2, found is set to false if a fresh entry was created
+    T &lookup( const KadasItemPos &p1, const KadasItemPos &p2, bool &found )
+    {
+      KadasSegmentKey key { p1.x(), p1.y(), p2.x(), p2.y() };
+      auto it = mCurrent.find( key );
+      found = it != mCurrent.end();
+      if ( found )
+      {
+        return it.value();
+      }
+      auto prevIt = mPrevious.find( key );
+      found = prevIt != mPrevious.end();
+      return mCurrent.insert( key, found ? std::move( prevIt.value() ) : T() ).value();
+    }
+
+  private:
+    QHash<KadasSegmentKey, T> mCurrent;
+    QHash<KadasSegmentKey, T> mPrevious;
+};
+
+/**
+ * Geodesic densification of item segments (100km steps), with the transforms
+ * kept across updates and the densified vertices cached per segment.
+ */
+class KADAS_GUI_EXPORT KadasGeodesicSegments
+{
+  public:
+    void beginUpdate( const QgsCoordinateReferenceSystem &crs );
+    // Appends the densified vertices of the geodesic p1-p2, the end point only if includeEnd is true
+    void append( QVector<double> &x, QVector<double> &y, const KadasItemPos &p1, const KadasItemPos &p2, bool includeEnd );
+
+  private:
+    QgsCoordinateReferenceSystem mCrs;
+    QgsCoordinateTransform mToWgs;
+    QgsCoordinateTransform mFromWgs;
+    KadasSegmentCache<QVector<QgsPointXY>> mCache;
+};
+
+#endif // KADASSEGMENTCACHE_H
@@ -483,7 +483,7 @@ void KadasMapToolCreateItem::acceptInput()
     }
     else
     {
-      mStateHistory->push( mItem->constState()->clone() );
+      mStateHistory->push( new ToolState( mItem->constState()->clone(), mCurrentItemData ) );
     }
   }
   else if ( mItem->constState()->drawStatus == KadasMapItem::State::DrawStatus::Finished )
@@ -151,6 +151,12 @@ class KADAS_GUI_EXPORT KadasMapToolCreateItem : public QgsMapTool
         ToolState( State *_itemState, QSharedPointer<ItemData> _itemData )
           : itemState( _itemState ), itemData( _itemData ) {}
         ~ToolState() { delete itemState; }
+        qint64 memoryUsage( const State *previous ) const override
+        {
+          // Without a previous tool state, the item state is counted in full
+          const ToolState *prev = dynamic_cast<const ToolState *>( previous );
+          return sizeof( ToolState ) + ( itemState ? itemState->memoryUsage( prev ? prev->itemState : nullptr ) : 0 );
+        }
         State *itemState = nullptr;
         QSharedPointer<ItemData> itemData;
     };
@@ -82,16 +82,13 @@ void KadasMapToolDeleteItems::deleteItems( const KadasMapRect &filterRect )
     {
       continue;
     }
-    for ( auto it = itemLayer->items().begin(), itEnd = itemLayer->items().end(); it != itEnd; ++it )
+    for ( KadasItemLayer::ItemId itemId : itemLayer->itemsInRect( filterRect, canvas()->mapSettings(), true ) )
     {
-      KadasMapItem *item = it.value();
-      if ( item->intersects( filterRect, canvas()->mapSettings(), true ) )
-      {
-        delItems[itemLayer].append( it.key() );
-        item->setSelected( true );
-        mapItems.append( item );
-        mapCanvasItems.append( new KadasMapCanvasItem( item, canvas() ) );
-      }
+      KadasMapItem *item = itemLayer->items()[itemId];
+      delItems[itemLayer].append( itemId );
+      item->setSelected( true );
+      mapItems.append( item );
+      mapCanvasItems.append( new KadasMapCanvasItem( item, canvas() ) );
     }
   }
 
@@ -29,6 +29,7 @@
 #include <qgis/qgssettings.h>
 
 #include "kadas/analysis/kadashillshadefilter.h"
+#include "kadas/analysis/kadasrasteroutput.h"
 #include "kadas/core/kadas.h"
 #include "kadas/gui/mapitems/kadasrectangleitem.h"
 #include "kadas/gui/maptools/kadasmaptoolhillshade.h"
@@ -135,7 +136,11 @@ void KadasMapToolHillshade::compute( const QgsRectangle &extent, const QgsCoordi
     if ( layer->isValid() && layer->renderer() )
     {
       layer->renderer()->setOpacity( 0.6 );
-      QgsProject::instance()->addMapLayer( layer );
+      KadasBuildOverviewsTask::start( layer );
+    }
+    else
+    {
+      delete layer;
     }
   }
 }
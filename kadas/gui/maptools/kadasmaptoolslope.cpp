@@ -24,6 +24,7 @@
 #include <qgis/qgssettings.h>
 #include <qgis/qgssinglebandpseudocolorrenderer.h>
 
+#include "kadas/analysis/kadasrasteroutput.h"
 #include "kadas/analysis/kadasslopefilter.h"
 #include "kadas/core/kadas.h"
 #include "kadas/gui/mapitems/kadasrectangleitem.h"
@@ -120,6 +121,6 @@ void KadasMapToolSlope::compute( const QgsRectangle &extent, const QgsCoordinate
     renderer->setClassificationMin( 0 );
     renderer->setClassificationMin( 255 );
     layer->setRenderer( renderer );
-    QgsProject::instance()->addMapLayer( layer );
+    KadasBuildOverviewsTask::start( layer );
   }
 }
@@ -17,14 +17,20 @@
 #include <QApplication>
 #include <QCheckBox>
 #include <QComboBox>
+#include <QKeyEvent>
 #include <QDialogButtonBox>
+#include <QDomDocument>
 #include <QDoubleSpinBox>
 #include <QGridLayout>
 #include <QLabel>
 #include <QMessageBox>
 #include <QProgressDialog>
 
+#include <cpl_vsi.h>
+
+#include <qgis/qgsapplication.h>
 #include <qgis/qgsmapcanvas.h>
+#include <qgis/qgsmapmouseevent.h>
 #include <qgis/qgsmultisurface.h>
 #include <qgis/qgspalettedrasterrenderer.h>
 #include <qgis/qgspolygon.h>
@@ -34,6 +40,7 @@
 
 #include "kadas/core/kadas.h"
 #include "kadas/core/kadascoordinateformat.h"
+#include "kadas/analysis/kadasrasteroutput.h"
 #include "kadas/analysis/kadasviewshedfilter.h"
 #include "kadas/gui/mapitems/kadascircularsectoritem.h"
 #include "kadas/gui/mapitems/kadassymbolitem.h"
@@ -120,10 +127,13 @@ KadasViewshedDialog::KadasViewshedDialog( double radius, QWidget *parent )
   labelWidget->layout()->addWidget( new QLabel( QString( "<small>%1</small>" ).arg( tr( "Fast" ) ) ) );
   heightDialogLayout->addWidget( labelWidget, 5, 1, 1, 2 );
 
+  mLiveUpdateCheckbox = new QCheckBox( tr( "Live update when moving the observer" ) );
+  heightDialogLayout->addWidget( mLiveUpdateCheckbox, 6, 0, 1, 3 );
+
   QDialogButtonBox *bbox = new QDialogButtonBox( QDialogButtonBox::Ok | QDialogButtonBox::Cancel, Qt::Horizontal );
   connect( bbox, &QDialogButtonBox::accepted, this, &QDialog::accept );
   connect( bbox, &QDialogButtonBox::rejected, this, &QDialog::reject );
-  heightDialogLayout->addWidget( bbox, 6, 0, 1, 3 );
+  heightDialogLayout->addWidget( bbox, 7, 0, 1, 3 );
 
   setLayout( heightDialogLayout );
   setFixedSize( sizeHint() );
@@ -164,6 +174,11 @@ int KadasViewshedDialog::accuracyFactor() const
   return mAccuracySlider->value();
 }
 
+bool KadasViewshedDialog::liveUpdate() const
+{
+  return mLiveUpdateCheckbox->isChecked();
+}
+
 void KadasViewshedDialog::adjustMaxAngle()
 {
   if ( mSpinBoxObserverMinAngle->value() >= mSpinBoxObserverMaxAngle->value() )
@@ -188,12 +203,70 @@ KadasMapItem *KadasMapToolViewshedItemInterface::createItem() const
   return item;
 }
 
+// Delay after the last observer move before a live update is started, in ms
+static constexpr int sLiveUpdateDelay = 100;
+
+// Live viewshed layers read from /vsimem, which does not outlive the session: drop them from saved projects
+static void removeLiveLayers( QDomDocument &doc )
+{
+  QStringList layerIds;
+  QDomNodeList layerEls = doc.elementsByTagName( "maplayer" );
+  for ( int i = layerEls.size() - 1; i >= 0; --i )
+  {
+    QDomElement layerEl = layerEls.at( i ).toElement();
+    if ( layerEl.firstChildElement( "datasource" ).text().startsWith( "/vsimem/kadas_viewshed_" ) )
+    {
+      layerIds.append( layerEl.firstChildElement( "id" ).text() );
+      layerEl.parentNode().removeChild( layerEl );
+    }
+  }
+  if ( layerIds.isEmpty() )
+  {
+    return;
+  }
+  // Layer tree, layer order and custom rendering order references
+  QList<QDomElement> refEls;
+  for ( const QString &tagName : { "layer-tree-layer", "layer", "item" } )
+  {
+    QDomNodeList els = doc.elementsByTagName( tagName );
+    for ( int i = 0, n = els.size(); i < n; ++i )
+    {
+      QDomElement el = els.at( i ).toElement();
+      QString id = tagName == QString( "item" ) ? el.text() : el.attribute( "id" );
+      if ( layerIds.contains( id ) )
+      {
+        refEls.append( el );
+      }
+    }
+  }
+  for ( QDomElement &el : refEls )
+  {
+    el.parentNode().removeChild( el );
+  }
+}
+
 KadasMapToolViewshed::KadasMapToolViewshed( QgsMapCanvas *mapCanvas )
   : KadasMapToolCreateItem( mapCanvas, std::move( std::make_unique<KadasMapToolViewshedItemInterface>( KadasMapToolViewshedItemInterface( mapCanvas ) ) ) )
 {
   setCursor( Qt::ArrowCursor );
   setToolLabel( tr( "Compute viewshed" ) );
   connect( this, &KadasMapToolCreateItem::partFinished, this, &KadasMapToolViewshed::drawFinished );
+
+  mLiveUpdateTimer.setSingleShot( true );
+  mLiveUpdateTimer.setInterval( sLiveUpdateDelay );
+  connect( &mLiveUpdateTimer, &QTimer::timeout, this, [this] {
+    if ( mLive )
+    {
+      requestLiveUpdate( std::min( 4 * mLive->settings.accuracyFactor, 20 ) );
+    }
+  } );
+  // Connected once and independently of the tool, which may be deleted while the project is written
+  static const QMetaObject::Connection sRemoveLiveLayersConnection = connect( QgsProject::instance(), &QgsProject::writeProject, QgsProject::instance(), removeLiveLayers );
+}
+
+static QgsPalettedRasterRenderer *createViewshedRenderer()
+{
+  return new QgsPalettedRasterRenderer( 0, 1, { QgsPalettedRasterRenderer::Class( 0, QColor( 255, 0, 0 ), QApplication::translate( "KadasMapToolViewshed", "Invisible" ) ), QgsPalettedRasterRenderer::Class( 255, QColor( 0, 255, 0 ), QApplication::translate( "KadasMapToolViewshed", "Visible" ) ) } );
 }
 
 void KadasMapToolViewshed::drawFinished()
@@ -214,13 +287,7 @@ void KadasMapToolViewshed::drawFinished()
     return;
   }
 
-  QgsPointXY center = item->constState()->centers.last();
-  double curRadius = item->constState()->radii.last();
-
-  QgsCoordinateReferenceSystem canvasCrs = canvas()->mapSettings().destinationCrs();
-  curRadius *= QgsUnitTypes::fromUnitToUnitFactor( canvasCrs.mapUnits(), Qgis::DistanceUnit::Meters );
-
-  KadasViewshedDialog viewshedDialog( curRadius );
+  KadasViewshedDialog viewshedDialog( radiusInMeters( item ) );
   connect( &viewshedDialog, &KadasViewshedDialog::radiusChanged, this, &KadasMapToolViewshed::adjustRadius );
   if ( viewshedDialog.exec() == QDialog::Rejected )
   {
@@ -228,76 +295,391 @@ void KadasMapToolViewshed::drawFinished()
     return;
   }
 
+  ViewshedSettings settings;
+  settings.observerHeight = viewshedDialog.observerHeight();
+  settings.targetHeight = viewshedDialog.targetHeight();
+  settings.observerHeightRelToTerr = viewshedDialog.observerHeightRelativeToGround();
+  settings.targetHeightRelToTerr = viewshedDialog.targetHeightRelativeToGround();
+  settings.observerMinVertAngle = viewshedDialog.observerMinVertAngle();
+  settings.observerMaxVertAngle = viewshedDialog.observerMaxVertAngle();
+  settings.accuracyFactor = viewshedDialog.accuracyFactor();
+
+  if ( viewshedDialog.liveUpdate() )
+  {
+    startLive( static_cast<QgsRasterLayer *>( layer ), settings );
+    return;
+  }
+
+  QgsPointXY center = item->constState()->centers.last();
+  double curRadius = radiusInMeters( item );
+  QgsCoordinateReferenceSystem canvasCrs = canvas()->mapSettings().destinationCrs();
+
   QString outputFileName = QString( "viewshed_%1,%2.tif" ).arg( center.x() ).arg( center.y() );
   QString outputFile = QgsProject::instance()->createAttachedFile( outputFileName );
 
-  QVector<QgsPointXY> filterRegion;
-  QgsPolygonXY poly = QgsGeometry( item->geometry()->geometryN( 0 )->clone() ).asPolygon();
-  if ( !poly.isEmpty() )
+  double heightConv = QgsUnitTypes::fromUnitToUnitFactor( KadasCoordinateFormat::instance()->getHeightDisplayUnit(), Qgis::DistanceUnit::Meters );
+
+  QProgressDialog p( tr( "Calculating viewshed..." ), tr( "Abort" ), 0, 0 );
+  p.setWindowTitle( tr( "Viewshed" ) );
+  p.setWindowModality( Qt::ApplicationModal );
+  QApplication::setOverrideCursor( Qt::WaitCursor );
+
+
+  QString errMsg;
+  bool success = KadasViewshedFilter::computeViewshed( static_cast<QgsRasterLayer *>( layer ), outputFile, "GTiff", center, canvasCrs, settings.observerHeight * heightConv, settings.targetHeight * heightConv, settings.observerHeightRelToTerr, settings.targetHeightRelToTerr, settings.observerMinVertAngle, settings.observerMaxVertAngle, curRadius, Qgis::DistanceUnit::Meters, &p, &errMsg, filterRegion( item ), settings.accuracyFactor );
+  QApplication::restoreOverrideCursor();
+  if ( success )
+  {
+    QgsRasterLayer *layer = new QgsRasterLayer( outputFile, tr( "Viewshed [%1]" ).arg( center.toString() ) );
+    layer->setRenderer( createViewshedRenderer() );
+    layer->setOpacity( 30 );
+    // Visibility classes must not be averaged
+    KadasBuildOverviewsTask::start( layer, "NEAREST" );
+    addObserverPin( layer, center, settings );
+  }
+  else if ( !errMsg.isEmpty() )
   {
-    filterRegion = poly.front();
+    QMessageBox::critical( 0, tr( "Error" ), tr( "Failed to compute viewshed: %1" ).arg( errMsg ) );
   }
-  center = item->constState()->centers.last();
-  curRadius = item->constState()->radii.last();
+  clear();
+}
 
+double KadasMapToolViewshed::radiusInMeters( const KadasCircularSectorItem *item ) const
+{
+  QgsPointXY center = item->constState()->centers.last();
+  double radius = item->constState()->radii.last();
   if ( mCanvas->mapSettings().mapUnits() == Qgis::DistanceUnit::Degrees )
   {
     // Need to compute radius in meters
     QgsDistanceArea da;
     da.setEllipsoid( QgsProject::instance()->readEntry( "Measure", "/Ellipsoid", "NONE" ) );
-    curRadius = da.measureLine( center, QgsPoint( center.x() + curRadius, center.y() ) );
-    curRadius = da.convertLengthMeasurement( curRadius, Qgis::DistanceUnit::Meters );
+    radius = da.measureLine( center, QgsPoint( center.x() + radius, center.y() ) );
+    return da.convertLengthMeasurement( radius, Qgis::DistanceUnit::Meters );
   }
+  return radius * QgsUnitTypes::fromUnitToUnitFactor( mCanvas->mapSettings().mapUnits(), Qgis::DistanceUnit::Meters );
+}
 
-  double heightConv = QgsUnitTypes::fromUnitToUnitFactor( KadasCoordinateFormat::instance()->getHeightDisplayUnit(), Qgis::DistanceUnit::Meters );
+QVector<QgsPointXY> KadasMapToolViewshed::filterRegion( const KadasCircularSectorItem *item ) const
+{
+  QgsPolygonXY poly = QgsGeometry( item->geometry()->geometryN( 0 )->clone() ).asPolygon();
+  return poly.isEmpty() ? QVector<QgsPointXY>() : poly.front();
+}
+
+void KadasMapToolViewshed::addObserverPin( QgsMapLayer *layer, const QgsPointXY &center, const ViewshedSettings &settings )
+{
+  KadasSymbolItem *pin = new KadasSymbolItem( canvas()->mapSettings().destinationCrs() );
+  pin->setup( ":/kadas/icons/pin_red", 0.5, 1.0 );
+  pin->associateToLayer( layer );
+  pin->setPosition( KadasItemPos::fromPoint( center ) );
+
+  pin->setTooltip(
+    tr( "<b>Observer position</b>: %1<br />" )
+      .arg( KadasCoordinateFormat::instance()->getDisplayString( pin->position(), pin->crs() ) )
+    + tr( "<b>Observer height</b>: %1 %2 %3<br />" )
+        .arg( settings.observerHeight )
+        .arg( QgsUnitTypes::toString( KadasCoordinateFormat::instance()->getHeightDisplayUnit() ) )
+        .arg( settings.observerHeightRelToTerr ? tr( "above ground" ) : tr( "above sea level" ) )
+    + tr( "<b>Observer vertical angle range</b>: %1° to %2°<br />" )
+        .arg( settings.observerMinVertAngle )
+        .arg( settings.observerMaxVertAngle )
+    + tr( "<b>Target height</b>: %1 %2 %3" )
+        .arg( settings.targetHeight )
+        .arg( QgsUnitTypes::toString( KadasCoordinateFormat::instance()->getHeightDisplayUnit() ) )
+        .arg( settings.targetHeightRelToTerr ? tr( "above ground" ) : tr( "above sea level" ) )
+  );
+  KadasMapCanvasItemManager::addItem( pin );
+}
+
+void KadasMapToolViewshed::startLive( QgsRasterLayer *heightmapLayer, const ViewshedSettings &settings )
+{
+  const KadasCircularSectorItem *item = dynamic_cast<const KadasCircularSectorItem *>( currentItem() );
+  mLive = std::make_unique<LiveState>();
+  mLive->heightmapLayer = heightmapLayer;
+  mLive->heightmap = std::make_shared<KadasViewshedFilter::Heightmap>();
+  mLive->settings = settings;
 
   QProgressDialog p( tr( "Calculating viewshed..." ), tr( "Abort" ), 0, 0 );
   p.setWindowTitle( tr( "Viewshed" ) );
   p.setWindowModality( Qt::ApplicationModal );
-  int accuracyFactor = viewshedDialog.accuracyFactor();
   QApplication::setOverrideCursor( Qt::WaitCursor );
 
-
+  // Load twice the radius, so that the observer can be moved without reloading the heightmap
   QString errMsg;
-  bool success = KadasViewshedFilter::computeViewshed( static_cast<QgsRasterLayer *>( layer ), outputFile, "GTiff", center, canvasCrs, viewshedDialog.observerHeight() * heightConv, viewshedDialog.targetHeight() * heightConv, viewshedDialog.observerHeightRelativeToGround(), viewshedDialog.targetHeightRelativeToGround(), viewshedDialog.observerMinVertAngle(), viewshedDialog.observerMaxVertAngle(), curRadius, Qgis::DistanceUnit::Meters, &p, &errMsg, filterRegion, accuracyFactor );
-  QApplication::restoreOverrideCursor();
+  bool success = KadasViewshedFilter::loadHeightmap( heightmapLayer, item->constState()->centers.last(), canvas()->mapSettings().destinationCrs(), 2 * radiusInMeters( item ), Qgis::DistanceUnit::Meters, *mLive->heightmap, &p, &errMsg );
   if ( success )
   {
-    QgsRasterLayer *layer = new QgsRasterLayer( outputFile, tr( "Viewshed [%1]" ).arg( center.toString() ) );
-    QgsPalettedRasterRenderer *renderer = new QgsPalettedRasterRenderer( 0, 1, { QgsPalettedRasterRenderer::Class( 0, QColor( 255, 0, 0 ), tr( "Invisible" ) ), QgsPalettedRasterRenderer::Class( 255, QColor( 0, 255, 0 ), tr( "Visible" ) ) } );
-    layer->setRenderer( renderer );
-    layer->setOpacity( 30 );
-    QgsProject::instance()->addMapLayer( layer );
-
-    KadasSymbolItem *pin = new KadasSymbolItem( canvasCrs );
-    pin->setup( ":/kadas/icons/pin_red", 0.5, 1.0 );
-    pin->associateToLayer( layer );
-    pin->setPosition( KadasItemPos::fromPoint( center ) );
-
-    pin->setTooltip(
-      tr( "<b>Observer position</b>: %1<br />" )
-        .arg( KadasCoordinateFormat::instance()->getDisplayString( pin->position(), pin->crs() ) )
-      + tr( "<b>Observer height</b>: %1 %2 %3<br />" )
-          .arg( viewshedDialog.observerHeight() )
-          .arg( QgsUnitTypes::toString( KadasCoordinateFormat::instance()->getHeightDisplayUnit() ) )
-          .arg( viewshedDialog.observerHeightRelativeToGround() ? tr( "above ground" ) : tr( "above sea level" ) )
-      + tr( "<b>Observer vertical angle range</b>: %1° to %2°<br />" )
-          .arg( viewshedDialog.observerMinVertAngle() )
-          .arg( viewshedDialog.observerMaxVertAngle() )
-      + tr( "<b>Target height</b>: %1 %2 %3" )
-          .arg( viewshedDialog.targetHeight() )
-          .arg( QgsUnitTypes::toString( KadasCoordinateFormat::instance()->getHeightDisplayUnit() ) )
-          .arg( viewshedDialog.targetHeightRelativeToGround() ? tr( "above ground" ) : tr( "above sea level" ) )
-    );
-    KadasMapCanvasItemManager::addItem( pin );
+    mLive->layer = new QgsRasterLayer( QString(), tr( "Viewshed [live]" ), "gdal" );
+    success = updateLive( settings.accuracyFactor, &p );
   }
-  else if ( !errMsg.isEmpty() )
+  QString dataSource = QString( "/vsimem/kadas_viewshed_%1_%2.tif" ).arg( reinterpret_cast<quintptr>( this ) ).arg( ++mLive->revision );
+  if ( success && !KadasViewshedFilter::writeViewshed( *mLive->heightmap, mLive->result, dataSource, "GTiff", &errMsg ) )
   {
-    QMessageBox::critical( 0, tr( "Error" ), tr( "Failed to compute viewshed: %1" ).arg( errMsg ) );
+    success = false;
+  }
+  QApplication::restoreOverrideCursor();
+  if ( !success )
+  {
+    if ( !errMsg.isEmpty() )
+    {
+      QMessageBox::critical( 0, tr( "Error" ), tr( "Failed to compute viewshed: %1" ).arg( errMsg ) );
+    }
+    delete mLive->layer;
+    mLive.reset();
+    clear();
+    return;
+  }
+  showLiveResult( dataSource );
+  mLive->layer->setOpacity( 30 );
+  QgsProject::instance()->addMapLayer( mLive->layer );
+  emit messageEmitted( tr( "Drag the observer to update the viewshed. Right-click or press Escape when done." ), Qgis::Info );
+}
+
+bool KadasMapToolViewshed::liveParameters( KadasViewshedFilter::Parameters &params, QProgressDialog *progress, QString *errMsg )
+{
+  const KadasCircularSectorItem *item = dynamic_cast<const KadasCircularSectorItem *>( currentItem() );
+  if ( !item || !mLive->heightmapLayer || !mLive->layer )
+  {
+    return false;
+  }
+  QgsPointXY center = item->constState()->centers.last();
+  QgsCoordinateReferenceSystem canvasCrs = canvas()->mapSettings().destinationCrs();
+  double radius = radiusInMeters( item );
+  double heightConv = QgsUnitTypes::fromUnitToUnitFactor( KadasCoordinateFormat::instance()->getHeightDisplayUnit(), Qgis::DistanceUnit::Meters );
+  const ViewshedSettings &settings = mLive->settings;
+
+  params = KadasViewshedFilter::heightmapParameters( *mLive->heightmap, center, canvasCrs, settings.observerHeight * heightConv, settings.targetHeight * heightConv, settings.observerHeightRelToTerr, settings.targetHeightRelToTerr, settings.observerMinVertAngle, settings.observerMaxVertAngle, radius, Qgis::DistanceUnit::Meters, filterRegion( item ) );
+  QgsRectangle region( params.observerPos.x() - params.radius, params.observerPos.y() - params.radius, params.observerPos.x() + params.radius, params.observerPos.y() + params.radius );
+  if ( !mLive->heightmap->covers( region ) )
+  {
+    // Load into a new heightmap, a finished task may still hold the previous one
+    std::shared_ptr<KadasViewshedFilter::Heightmap> heightmap = std::make_shared<KadasViewshedFilter::Heightmap>();
+    if ( !KadasViewshedFilter::loadHeightmap( mLive->heightmapLayer, center, canvasCrs, 2 * radius, Qgis::DistanceUnit::Meters, *heightmap, progress, errMsg ) )
+    {
+      return false;
+    }
+    mLive->heightmap = heightmap;
+  }
+  return true;
+}
+
+bool KadasMapToolViewshed::updateLive( int accuracyFactor, QProgressDialog *progress )
+{
+  QString errMsg;
+  KadasViewshedFilter::Parameters params;
+  if ( !liveParameters( params, progress, &errMsg ) || !KadasViewshedFilter::computeViewshed( *mLive->heightmap, params, accuracyFactor, mLive->result, progress, &errMsg ) )
+  {
+    if ( !errMsg.isEmpty() )
+    {
+      emit messageEmitted( tr( "Failed to compute viewshed: %1" ).arg( errMsg ), Qgis::Warning );
+    }
+    return false;
+  }
+  mLive->resultFinal = accuracyFactor == mLive->settings.accuracyFactor;
+  return true;
+}
+
+void KadasMapToolViewshed::requestLiveUpdate( int accuracyFactor )
+{
+  if ( mLive->task )
+  {
+    // Only one update runs at a time, the stale one is canceled and the latest request runs once it ended
+    mLive->pendingAccuracy = accuracyFactor;
+    mLive->task->cancel();
+    return;
+  }
+
+  QString errMsg;
+  KadasViewshedFilter::Parameters params;
+  if ( !liveParameters( params, nullptr, &errMsg ) )
+  {
+    if ( !errMsg.isEmpty() )
+    {
+      emit messageEmitted( tr( "Failed to compute viewshed: %1" ).arg( errMsg ), Qgis::Warning );
+    }
+    return;
+  }
+  // Write each update to a new in-memory file, so that no cached data of the previous one is shown
+  QString dataSource = QString( "/vsimem/kadas_viewshed_%1_%2.tif" ).arg( reinterpret_cast<quintptr>( this ) ).arg( ++mLive->revision );
+  KadasViewshedTask *task = new KadasViewshedTask( mLive->heightmap, params, accuracyFactor, dataSource );
+  connect( task, &QgsTask::taskCompleted, this, [this, task] { liveTaskFinished( task ); } );
+  connect( task, &QgsTask::taskTerminated, this, [this, task] { liveTaskFinished( task ); } );
+  mLive->task = task;
+  QgsApplication::taskManager()->addTask( task );
+}
+
+void KadasMapToolViewshed::liveTaskFinished( KadasViewshedTask *task )
+{
+  if ( !mLive || mLive->task != task )
+  {
+    // Live mode ended meanwhile
+    VSIUnlink( task->outputFile().toLocal8Bit().data() );
+    return;
+  }
+  mLive->task = nullptr;
+  if ( task->status() == QgsTask::Complete )
+  {
+    mLive->result = task->result();
+    mLive->resultFinal = task->accuracyFactor() == mLive->settings.accuracyFactor && mLive->pendingAccuracy == 0 && !mLive->dragging && !mLiveUpdateTimer.isActive();
+    showLiveResult( task->outputFile() );
+  }
+  else
+  {
+    VSIUnlink( task->outputFile().toLocal8Bit().data() );
+    if ( !task->isCanceled() && !task->errorMessage().isEmpty() )
+    {
+      emit messageEmitted( tr( "Failed to compute viewshed: %1" ).arg( task->errorMessage() ), Qgis::Warning );
+    }
+  }
+  if ( mLive->pendingAccuracy > 0 )
+  {
+    int accuracyFactor = mLive->pendingAccuracy;
+    mLive->pendingAccuracy = 0;
+    requestLiveUpdate( accuracyFactor );
+  }
+}
+
+void KadasMapToolViewshed::showLiveResult( const QString &dataSource )
+{
+  if ( !mLive->layer )
+  {
+    VSIUnlink( dataSource.toLocal8Bit().data() );
+    return;
+  }
+  mLive->layer->setDataSource( dataSource, mLive->layer->name(), "gdal", QgsDataProvider::ProviderOptions() );
+  mLive->layer->setRenderer( createViewshedRenderer() );
+  mLive->layer->triggerRepaint();
+  if ( !mLive->dataSource.isEmpty() )
+  {
+    VSIUnlink( mLive->dataSource.toLocal8Bit().data() );
+  }
+  mLive->dataSource = dataSource;
+}
+
+void KadasMapToolViewshed::finishLive()
+{
+  mLiveUpdateTimer.stop();
+  mLive->pendingAccuracy = 0;
+  if ( mLive->task )
+  {
+    // The running update is stale, its output is discarded once it ended
+    mLive->task->cancel();
+    mLive->task->waitForFinished();
+  }
+  const KadasCircularSectorItem *item = dynamic_cast<const KadasCircularSectorItem *>( currentItem() );
+  if ( item && mLive->layer && !mLive->resultFinal )
+  {
+    // Compute the persisted result at full accuracy for the final observer position
+    QProgressDialog p( tr( "Calculating viewshed..." ), tr( "Abort" ), 0, 0 );
+    p.setWindowTitle( tr( "Viewshed" ) );
+    p.setWindowModality( Qt::ApplicationModal );
+    QApplication::setOverrideCursor( Qt::WaitCursor );
+    updateLive( mLive->settings.accuracyFactor, &p );
+    QApplication::restoreOverrideCursor();
+  }
+
+  std::unique_ptr<LiveState> live = std::move( mLive );
+  if ( live->layer && item && !live->result.viewshed.isEmpty() )
+  {
+    // Persist the last result as a project attachment
+    QgsPointXY center = item->constState()->centers.last();
+    QString outputFileName = QString( "viewshed_%1,%2.tif" ).arg( center.x() ).arg( center.y() );
+    QString outputFile = QgsProject::instance()->createAttachedFile( outputFileName );
+    QString errMsg;
+    if ( KadasViewshedFilter::writeViewshed( *live->heightmap, live->result, outputFile, "GTiff", &errMsg ) )
+    {
+      QgsRasterLayer *layer = new QgsRasterLayer( outputFile, tr( "Viewshed [%1]" ).arg( center.toString() ) );
+      layer->setRenderer( createViewshedRenderer() );
+      layer->setOpacity( 30 );
+      // Visibility classes must not be averaged
+      KadasBuildOverviewsTask::start( layer, "NEAREST" );
+      addObserverPin( layer, center, live->settings );
+    }
+    else
+    {
+      QMessageBox::critical( 0, tr( "Error" ), tr( "Failed to compute viewshed: %1" ).arg( errMsg ) );
+    }
+  }
+  if ( live->layer )
+  {
+    QgsProject::instance()->removeMapLayer( live->layer );
+  }
+  if ( !live->dataSource.isEmpty() )
+  {
+    VSIUnlink( live->dataSource.toLocal8Bit().data() );
   }
   clear();
 }
 
+void KadasMapToolViewshed::deactivate()
+{
+  if ( mLive )
+  {
+    finishLive();
+  }
+  KadasMapToolCreateItem::deactivate();
+}
+
+void KadasMapToolViewshed::canvasPressEvent( QgsMapMouseEvent *e )
+{
+  if ( !mLive )
+  {
+    KadasMapToolCreateItem::canvasPressEvent( e );
+  }
+  else if ( e->button() == Qt::LeftButton )
+  {
+    mLive->dragging = true;
+    canvasMoveEvent( e );
+  }
+  else if ( e->button() == Qt::RightButton )
+  {
+    finishLive();
+  }
+}
+
+void KadasMapToolViewshed::canvasMoveEvent( QgsMapMouseEvent *e )
+{
+  if ( !mLive )
+  {
+    KadasMapToolCreateItem::canvasMoveEvent( e );
+    return;
+  }
+  KadasCircularSectorItem *item = dynamic_cast<KadasCircularSectorItem *>( mutableItem() );
+  if ( mLive->dragging && item )
+  {
+    item->setPosition( item->toItemPos( KadasMapPos::fromPoint( e->mapPoint() ), canvas()->mapSettings() ) );
+    mLive->resultFinal = false;
+    // Coarse preview once the observer rests
+    mLiveUpdateTimer.start();
+  }
+}
+
+void KadasMapToolViewshed::canvasReleaseEvent( QgsMapMouseEvent *e )
+{
+  if ( !mLive )
+  {
+    KadasMapToolCreateItem::canvasReleaseEvent( e );
+  }
+  else if ( mLive->dragging && e->button() == Qt::LeftButton )
+  {
+    mLive->dragging = false;
+    mLiveUpdateTimer.stop();
+    // Refine at full accuracy
+    requestLiveUpdate( mLive->settings.accuracyFactor );
+  }
+}
+
+void KadasMapToolViewshed::keyPressEvent( QKeyEvent *e )
+{
+  if ( mLive && e->key() == Qt::Key_Escape )
+  {
+    finishLive();
+  }
+  else if ( !mLive )
+  {
+    KadasMapToolCreateItem::keyPressEvent( e );
+  }
+}
+
 void KadasMapToolViewshed::adjustRadius( double newRadius )
 {
   Qgis::DistanceUnit measureUnit = Qgis::DistanceUnit::Meters;
@@ -18,7 +18,10 @@
 #define KADASMAPTOOLVIEWSHED_H
 
 #include <QDialog>
+#include <QPointer>
+#include <QTimer>
 
+#include "kadas/analysis/kadasviewshedfilter.h"
 #include "kadas/gui/kadas_gui.h"
 #include "kadas/gui/kadasmapiteminterface.h"
 #include "kadas/gui/maptools/kadasmaptoolcreateitem.h"
@@ -28,6 +31,8 @@ class QComboBox;
 class QDoubleSpinBox;
 class QSlider;
 class QSpinBox;
+class QgsRasterLayer;
+class KadasCircularSectorItem;
 
 class KADAS_GUI_EXPORT KadasViewshedDialog : public QDialog
 {
@@ -41,6 +46,7 @@ class KADAS_GUI_EXPORT KadasViewshedDialog : public QDialog
     double observerMinVertAngle() const;
     double observerMaxVertAngle() const;
     int accuracyFactor() const;
+    bool liveUpdate() const;
 
   signals:
     void radiusChanged( double radius );
@@ -59,6 +65,7 @@ class KADAS_GUI_EXPORT KadasViewshedDialog : public QDialog
     QComboBox *mComboTargetHeightMode = nullptr;
     QSlider *mAccuracySlider = nullptr;
     QCheckBox *mVertRangeCheckbox = nullptr;
+    QCheckBox *mLiveUpdateCheckbox = nullptr;
 
   private slots:
     void adjustMaxAngle();
@@ -82,6 +89,53 @@ class KADAS_GUI_EXPORT KadasMapToolViewshed : public KadasMapToolCreateItem
   public:
     KadasMapToolViewshed( QgsMapCanvas *mapCanvas );
 
+    void deactivate() override;
+    void canvasPressEvent( QgsMapMouseEvent *e ) override;
+    void canvasMoveEvent( QgsMapMouseEvent *e ) override;
+    void canvasReleaseEvent( QgsMapMouseEvent *e ) override;
+    void keyPressEvent( QKeyEvent *e ) override;
+
+  private:
+    struct ViewshedSettings
+    {
+        double observerHeight = 0; // In height display units
+        double targetHeight = 0;   // In height display units
+        bool observerHeightRelToTerr = true;
+        bool targetHeightRelToTerr = true;
+        double observerMinVertAngle = -90;
+        double observerMaxVertAngle = 90;
+        int accuracyFactor = 1;
+    };
+
+    // State of a live viewshed, recomputed in the background while the observer is dragged
+    struct LiveState
+    {
+        QPointer<QgsRasterLayer> heightmapLayer;
+        std::shared_ptr<KadasViewshedFilter::Heightmap> heightmap;
+        ViewshedSettings settings;
+        KadasViewshedFilter::Result result;
+        bool resultFinal = false; // Result is at full accuracy for the current observer position
+        QPointer<QgsRasterLayer> layer;
+        QString dataSource;
+        int revision = 0;
+        bool dragging = false;
+        QPointer<KadasViewshedTask> task; // Running update
+        int pendingAccuracy = 0;          // Accuracy of the update to run once the running one ended, 0 if none
+    };
+    std::unique_ptr<LiveState> mLive;
+    QTimer mLiveUpdateTimer;
+
+    double radiusInMeters( const KadasCircularSectorItem *item ) const;
+    QVector<QgsPointXY> filterRegion( const KadasCircularSectorItem *item ) const;
+    void startLive( QgsRasterLayer *heightmapLayer, const ViewshedSettings &settings );
+    bool liveParameters( KadasViewshedFilter::Parameters &params, QProgressDialog *progress, QString *errMsg );
+    bool updateLive( int accuracyFactor, QProgressDialog *progress );
+    void requestLiveUpdate( int accuracyFactor );
+    void liveTaskFinished( KadasViewshedTask *task );
+    void showLiveResult( const QString &dataSource );
+    void finishLive();
+    void addObserverPin( QgsMapLayer *layer, const QgsPointXY &center, const ViewshedSettings &settings );
+
   private slots:
     void drawFinished();
     void adjustRadius( double newRadius );
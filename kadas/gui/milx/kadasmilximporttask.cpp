@@ -0,0 +1,339 @@
+/***************************************************************************
+    kadasmilximporttask.cpp
+    -----------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QApplication>
+#include <QDesktopWidget>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <quazip/quazipfile.h>
+
+#include <memory>
+
+#include <qgis/qgsproject.h>
+#include <qgis/qgssettings.h>
+
+#include "kadas/gui/milx/kadasmilxclient.h"
+#include "kadas/gui/milx/kadasmilximporttask.h"
+#include "kadas/gui/milx/kadasmilxitem.h"
+#include "kadas/gui/milx/kadasmilxlayer.h"
+
+
+static QString elementXml( QXmlStreamReader &reader )
+{
+  // Serializes the element at the current reader position, including its children
+  QString xml;
+  QXmlStreamWriter writer( &xml );
+  writer.writeCurrentToken( reader );
+  int depth = 1;
+  while ( depth > 0 && !reader.atEnd() )
+  {
+    reader.readNext();
+    if ( reader.isStartElement() )
+    {
+      ++depth;
+    }
+    else if ( reader.isEndElement() )
+    {
+      --depth;
+    }
+    writer.writeCurrentToken( reader );
+  }
+  return xml;
+}
+
+KadasMilxImportTask::KadasMilxImportTask( const QString &filename, int dpi )
+  : QgsTask( tr( "Importing %1" ).arg( QFileInfo( filename ).fileName() ) )
+  , mFilename( filename )
+  , mDpi( dpi )
+  , mScreenDpi( QApplication::desktop()->logicalDpiX() )
+  , mChunkSize( std::max( 1, QgsSettings().value( "/milx/import_chunk_size", 200 ).toInt() ) )
+  , mTransformContext( QgsProject::instance()->transformContext() )
+{
+}
+
+KadasMilxImportTask::~KadasMilxImportTask()
+{
+  for ( const Chunk &chunk : std::as_const( mChunks ) )
+  {
+    qDeleteAll( chunk.items );
+  }
+}
+
+bool KadasMilxImportTask::run()
+{
+  KadasMilxClient::getCurrentLibraryVersionTag( mCurrentVersionTag );
+  return scanLayers() && importChunks();
+}
+
+KadasMilxImportTask::LayerInfo KadasMilxImportTask::layerInfo( int layer ) const
+{
+  QMutexLocker locker( &mMutex );
+  return mLayerInfos.value( layer );
+}
+
+QList<KadasMilxImportTask::Chunk> KadasMilxImportTask::takeChunks()
+{
+  QMutexLocker locker( &mMutex );
+  QList<Chunk> chunks;
+  chunks.swap( mChunks );
+  return chunks;
+}
+
+QIODevice *KadasMilxImportTask::openInput() const
+{
+  QIODevice *dev = nullptr;
+  if ( mFilename.endsWith( ".milxlyz", Qt::CaseInsensitive ) )
+  {
+    dev = new QuaZipFile( mFilename, "Layer.milxly", QuaZip::csInsensitive );
+  }
+  else
+  {
+    dev = new QFile( mFilename );
+  }
+  if ( !dev->open( QIODevice::ReadOnly ) )
+  {
+    delete dev;
+    return nullptr;
+  }
+  return dev;
+}
+
+bool KadasMilxImportTask::scanLayers()
+{
+  std::unique_ptr<QIODevice> dev( openInput() );
+  if ( !dev )
+  {
+    mErrorMsg = tr( "Failed to open the input file." );
+    return false;
+  }
+  QXmlStreamReader reader( dev.get() );
+  reader.setNamespaceProcessing( false );
+  if ( !reader.readNextStartElement() || reader.qualifiedName() != QLatin1String( "MilXDocument_Layer" ) )
+  {
+    mErrorMsg = tr( "The file could not be parsed." );
+    return false;
+  }
+  for ( const QXmlStreamAttribute &attr : reader.attributes() )
+  {
+    mDocumentAttributes += QString( " %1=\"%2\"" ).arg( attr.qualifiedName().toString(), attr.value().toString().toHtmlEscaped() );
+  }
+
+  // Collect the layer headers, the graphics are only counted
+  while ( reader.readNextStartElement() )
+  {
+    if ( isCanceled() )
+    {
+      return false;
+    }
+    if ( reader.qualifiedName() == QLatin1String( "MssLibraryVersionTag" ) )
+    {
+      mVersionTag = reader.readElementText();
+    }
+    else if ( reader.qualifiedName() == QLatin1String( "MilXLayer" ) )
+    {
+      LayerHeader header;
+      bool afterGraphics = false;
+      while ( reader.readNextStartElement() )
+      {
+        if ( reader.qualifiedName() == QLatin1String( "GraphicList" ) )
+        {
+          while ( reader.readNextStartElement() )
+          {
+            header.graphicCount += reader.qualifiedName() == QLatin1String( "MilXGraphic" );
+            reader.skipCurrentElement();
+          }
+          afterGraphics = true;
+        }
+        else
+        {
+          ( afterGraphics ? header.xmlAfter : header.xmlBefore ) += elementXml( reader );
+        }
+      }
+      mLayerHeaders.append( header );
+    }
+    else
+    {
+      reader.skipCurrentElement();
+    }
+  }
+  if ( reader.hasError() )
+  {
+    mErrorMsg = tr( "The file could not be parsed." );
+    return false;
+  }
+  return true;
+}
+
+bool KadasMilxImportTask::importChunks()
+{
+  std::unique_ptr<QIODevice> dev( openInput() );
+  if ( !dev )
+  {
+    mErrorMsg = tr( "Failed to open the input file." );
+    return false;
+  }
+  int total = 0;
+  for ( const LayerHeader &header : std::as_const( mLayerHeaders ) )
+  {
+    total += header.graphicCount;
+  }
+  int done = 0;
+
+  QXmlStreamReader reader( dev.get() );
+  reader.setNamespaceProcessing( false );
+  reader.readNextStartElement();
+  int layer = -1;
+  while ( reader.readNextStartElement() )
+  {
+    if ( reader.qualifiedName() != QLatin1String( "MilXLayer" ) )
+    {
+      reader.skipCurrentElement();
+      continue;
+    }
+    ++layer;
+    bool firstChunk = true;
+    QString graphicsXml;
+    int count = 0;
+    auto flush = [&] {
+      if ( !importChunk( layer, graphicsXml, firstChunk ) )
+      {
+        return false;
+      }
+      done += count;
+      if ( total > 0 )
+      {
+        setProgress( 100. * done / total );
+      }
+      graphicsXml.clear();
+      count = 0;
+      firstChunk = false;
+      return true;
+    };
+    while ( reader.readNextStartElement() )
+    {
+      if ( reader.qualifiedName() != QLatin1String( "GraphicList" ) )
+      {
+        reader.skipCurrentElement();
+        continue;
+      }
+      while ( reader.readNextStartElement() )
+      {
+        if ( isCanceled() )
+        {
+          return false;
+        }
+        if ( reader.qualifiedName() != QLatin1String( "MilXGraphic" ) )
+        {
+          reader.skipCurrentElement();
+          continue;
+        }
+        graphicsXml += elementXml( reader );
+        if ( ++count == mChunkSize && !flush() )
+        {
+          return false;
+        }
+      }
+    }
+    // Remaining graphics, or the empty chunk of a layer without graphics
+    if ( ( count > 0 || firstChunk ) && !flush() )
+    {
+      return false;
+    }
+  }
+  if ( reader.hasError() )
+  {
+    mErrorMsg = tr( "The file could not be parsed." );
+    return false;
+  }
+  return true;
+}
+
+bool KadasMilxImportTask::importChunk( int layer, const QString &graphicsXml, bool firstChunk )
+{
+  // Wrap the chunk in a single layer document for the MilX server
+  const LayerHeader &header = mLayerHeaders[layer];
+  QString inputXml = QString( "<?xml version=\"1.0\" encoding=\"UTF-8\"?><MilXDocument_Layer%1>" ).arg( mDocumentAttributes );
+  if ( !mVersionTag.isEmpty() )
+  {
+    inputXml += "<MssLibraryVersionTag>" + mVersionTag.toHtmlEscaped() + "</MssLibraryVersionTag>";
+  }
+  inputXml += "<MilXLayer>" + header.xmlBefore + "<GraphicList>" + graphicsXml + "</GraphicList>" + header.xmlAfter + "</MilXLayer></MilXDocument_Layer>";
+
+  QString outputXml;
+  bool valid = false;
+  QString messages;
+  if ( !KadasMilxClient::upgradeMilXFile( inputXml, outputXml, valid, messages ) )
+  {
+    mErrorMsg = tr( "Failed to read input file." );
+    return false;
+  }
+  if ( !messages.isEmpty() )
+  {
+    mMessages += ( mMessages.isEmpty() ? "" : "\n" ) + messages;
+  }
+  if ( !valid )
+  {
+    mErrorMsg = tr( "MilX upgrade failed" );
+    return false;
+  }
+
+  QDomDocument doc;
+  if ( !doc.setContent( outputXml ) )
+  {
+    mErrorMsg = tr( "The file could not be parsed." );
+    return false;
+  }
+  QDomElement milxDocumentEl = doc.firstChildElement( "MilXDocument_Layer" );
+  if ( milxDocumentEl.firstChildElement( "MssLibraryVersionTag" ).text() != mCurrentVersionTag )
+  {
+    mErrorMsg = tr( "Unexpected MSS library version tag." );
+    return false;
+  }
+  QDomElement milxLayerEl = milxDocumentEl.firstChildElement( "MilXLayer" );
+  Chunk chunk;
+  chunk.layer = layer;
+  if ( !KadasMilxLayer::itemsFromMilxly( milxLayerEl, mDpi, mScreenDpi, mTransformContext, chunk.items, mErrorMsg ) )
+  {
+    return false;
+  }
+  for ( KadasMilxItem *item : std::as_const( chunk.items ) )
+  {
+    item->moveToThread( QApplication::instance()->thread() );
+  }
+
+  QMutexLocker locker( &mMutex );
+  if ( firstChunk )
+  {
+    LayerInfo info;
+    info.name = milxLayerEl.firstChildElement( "Name" ).text();
+    info.approved = milxLayerEl.firstChildElement( "DisplayBW" ).text().toInt();
+    QDomNodeList cartoucheEls = milxLayerEl.elementsByTagName( "Legend" );
+    if ( !cartoucheEls.isEmpty() )
+    {
+      QTextStream ts( &info.cartouche );
+      cartoucheEls.at( 0 ).save( ts, 2 );
+    }
+    mLayerInfos.append( info );
+  }
+  mChunks.append( chunk );
+  locker.unlock();
+  emit chunksAvailable();
+  return true;
+}
@@ -0,0 +1,107 @@
+/***************************************************************************
+    kadasmilximporttask.h
+    ---------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASMILXIMPORTTASK_H
+#define KADASMILXIMPORTTASK_H
+
+#include <QMutex>
+
+#include <qgis/qgscoordinatetransformcontext.h>
+#include <qgis/qgstaskmanager.h>
+
+#include "kadas/gui/kadas_gui.h"
+
+#define SIP_NO_FILE
+
+class QIODevice;
+class QXmlStreamReader;
+class KadasMilxItem;
+
+/**
+ * Imports a .milxly or .milxlyz file in the background.
+ * The file is streamed rather than loaded as a whole: a first pass collects
+ * the layer headers, a second pass sends the graphics to the MilX server for
+ * upgrading in chunks and creates the items of each chunk. The items are
+ * handed over to the GUI thread chunk by chunk, see chunksAvailable().
+ */
+class KADAS_GUI_EXPORT KadasMilxImportTask : public QgsTask
+{
+    Q_OBJECT
+
+  public:
+    struct LayerInfo
+    {
+        QString name;
+        bool approved = false;
+        QString cartouche;
+    };
+    struct Chunk
+    {
+        int layer = 0;
+        QList<KadasMilxItem *> items;
+    };
+
+    KadasMilxImportTask( const QString &filename, int dpi );
+    ~KadasMilxImportTask();
+
+    bool run() override;
+
+    //! Returns the info of the layer with the specified index, available once the first chunk of the layer was taken
+    LayerInfo layerInfo( int layer ) const;
+    //! Takes the chunks imported so far, the items are owned by the caller and live in the GUI thread
+    QList<KadasMilxImportTask::Chunk> takeChunks();
+
+    const QString &errorMessage() const { return mErrorMsg; }
+    //! Returns the messages emitted by the MilX server while upgrading
+    const QString &messages() const { return mMessages; }
+
+  signals:
+    //! Emitted from the worker thread whenever chunks are ready to be taken
+    void chunksAvailable();
+
+  private:
+    struct LayerHeader
+    {
+        // Children of the MilXLayer element before and after the GraphicList
+        QString xmlBefore;
+        QString xmlAfter;
+        int graphicCount = 0;
+    };
+
+    QString mFilename;
+    int mDpi = 0;
+    int mScreenDpi = 0;
+    int mChunkSize = 0;
+    QgsCoordinateTransformContext mTransformContext;
+    QString mErrorMsg;
+    QString mMessages;
+
+    QString mDocumentAttributes;
+    QString mVersionTag;
+    QString mCurrentVersionTag;
+    QList<LayerHeader> mLayerHeaders;
+
+    mutable QMutex mMutex;
+    QList<LayerInfo> mLayerInfos;
+    QList<Chunk> mChunks;
+
+    QIODevice *openInput() const;
+    bool scanLayers();
+    bool importChunks();
+    bool importChunk( int layer, const QString &graphicsXml, bool firstChunk );
+};
+
+#endif // KADASMILXIMPORTTASK_H
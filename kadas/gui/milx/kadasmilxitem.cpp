@@ -135,6 +135,12 @@ bool KadasMilxItem::State::deserialize( const QJsonObject &json )
   return attributes.size() == attributePoints.size();
 }
 
+qint64 KadasMilxItem::State::memoryUsage( const KadasStateHistory::State *previous ) const
+{
+  const State *prev = dynamic_cast<const State *>( previous );
+  return sizeof( State ) + pointsMemoryUsage( points, prev ? &prev->points : nullptr ) + attributes.size() * sizeof( double ) + attributePoints.size() * sizeof( KadasItemPos ) + controlPoints.size() * sizeof( int );
+}
+
 
 KadasMilxItem::KadasMilxItem()
   : KadasMapItem( QgsCoordinateReferenceSystem( "EPSG:4326" ) )
@@ -313,6 +319,13 @@ bool KadasMilxItem::intersects( const KadasMapRect &rect, const QgsMapSettings &
 
 bool KadasMilxItem::hitTest( const KadasMapPos &pos, const QgsMapSettings &settings ) const
 {
+  // Positions the rendered symbol does not cover need no server request
+  bool covered = false;
+  if ( mOwnerLayer && static_cast<KadasMilxLayer *>( mOwnerLayer )->coversItem( this, pos, settings, covered ) && !covered )
+  {
+    return false;
+  }
+
   QPoint screenPos = settings.mapToPixel().transform( pos ).toQPointF().toPoint();
   int selectedSymbol = -1;
   QList<KadasMilxClient::NPointSymbol> symbols;
@@ -462,7 +475,9 @@ QString KadasMilxItem::asKml( const QgsRenderContext &context, QuaZip *kmzZip )
   }
   else
   {
-    QPoint offset = result.adjustedPoints.front() + result.offset;
+    // Symbols rendered without returning the adjusted points are anchored at the origin
+    QPoint anchor = result.adjustedPoints.isEmpty() ? QPoint( 0, 0 ) : result.adjustedPoints.front();
+    QPoint offset = anchor + result.offset;
 
     QgsPointXY pNW = exportContext.mapToPixel().toMapCoordinates( offset.x(), offset.y() );
     QgsPointXY pSE = exportContext.mapToPixel().toMapCoordinates( offset.x() + result.graphic.width(), offset.y() + result.graphic.height() );
@@ -926,6 +941,11 @@ void KadasMilxItem::writeMilx( QDomDocument &doc, QDomElement &itemElement ) con
 }
 
 KadasMilxItem *KadasMilxItem::fromMilx( const QDomElement &itemElement, const QgsCoordinateTransform &crst, int symbolSize )
+{
+  return fromMilx( itemElement, crst, symbolSize, false );
+}
+
+KadasMilxItem *KadasMilxItem::fromMilx( const QDomElement &itemElement, const QgsCoordinateTransform &crst, int symbolSize, bool batched )
 {
   KadasMilxItem *item = new KadasMilxItem();
 
@@ -954,7 +974,7 @@ KadasMilxItem *KadasMilxItem::fromMilx( const QDomElement &itemElement, const Qg
 
   item->state()->userOffset = QPoint( offsetX, offsetY );
 
-  finalize( item, isCorridor );
+  finalize( item, isCorridor, batched );
 
   return item;
 }
@@ -971,7 +991,49 @@ KadasMilxItem *KadasMilxItem::fromMssStringAndPoints( const QString &mssString,
   return item;
 }
 
-void KadasMilxItem::finalize( KadasMilxItem *item, bool isCorridor )
+void KadasMilxItem::updateMilitaryNames( const QList<KadasMilxItem *> &items )
+{
+  QList<KadasMilxItem *> unnamedItems;
+  QStringList symbolXmls;
+  for ( KadasMilxItem *item : items )
+  {
+    if ( item->mMilitaryName.isEmpty() )
+    {
+      unnamedItems.append( item );
+      symbolXmls.append( item->mMssString );
+    }
+  }
+  QList<KadasMilxSymbolDesc> symbolDescs;
+  if ( symbolXmls.isEmpty() || !KadasMilxClient::getSymbolsMetadata( symbolXmls, symbolDescs ) )
+  {
+    return;
+  }
+  for ( int i = 0, n = unnamedItems.size(); i < n; ++i )
+  {
+    unnamedItems[i]->mMilitaryName = symbolDescs[i].militaryName;
+  }
+}
+
+void KadasMilxItem::updateSymbolMargins( const QList<KadasMilxItem *> &items, int dpi )
+{
+  QList<KadasMilxClient::NPointSymbol> symbols;
+  for ( const KadasMilxItem *item : items )
+  {
+    symbols.append( KadasMilxClient::NPointSymbol( item->mMssString, QList<QPoint>() << QPoint( 0, 0 ), QList<int>(), QList<QPair<int, double>>(), true, true ) );
+  }
+  QRect screenExtent( 0, 0, 100, 100 );
+  QList<KadasMilxClient::NPointSymbolGraphic> result;
+  if ( symbols.isEmpty() || !KadasMilxClient::updateSymbols( screenExtent, dpi, symbols, KadasMilxClient::globalSymbolSettings(), result ) )
+  {
+    return;
+  }
+  for ( int i = 0, n = items.size(); i < n; ++i )
+  {
+    items[i]->updateSymbolMargin( result[i] );
+  }
+}
+
+void KadasMilxItem::finalize( KadasMilxItem *item, bool isCorridor, bool batched )
 {
   if ( item->state()->points.size() > 1 )
   {
@@ -1025,14 +1087,17 @@ void KadasMilxItem::finalize( KadasMilxItem *item, bool isCorridor )
     }
   }
 
+  item->state()->drawStatus = State::DrawStatus::Finished;
+  item->mIsPointSymbol = !item->isMultiPoint();
+
+  if ( batched )
+  {
+    return;
+  }
   if ( item->mMilitaryName.isEmpty() )
   {
     KadasMilxClient::getMilitaryName( item->mMssString, item->mMilitaryName );
   }
-
-  item->state()->drawStatus = State::DrawStatus::Finished;
-  item->mIsPointSymbol = !item->isMultiPoint();
-
   KadasMilxClient::NPointSymbol symbol( item->mMssString, QList<QPoint>() << QPoint( 0, 0 ), QList<int>(), QList<QPair<int, double>>(), true, true );
   QRect screenExtent( 0, 0, 100, 100 );
   KadasMilxClient::NPointSymbolGraphic result;
@@ -1137,7 +1202,9 @@ void KadasMilxItem::updateSymbol( const QgsMapSettings &mapSettings, const Kadas
 
 void KadasMilxItem::updateSymbolMargin( const KadasMilxClient::NPointSymbolGraphic &result )
 {
-  QRect pointBounds( result.adjustedPoints.front(), result.adjustedPoints.front() );
+  // Symbols rendered without returning the adjusted points are anchored at the origin
+  QPoint anchor = result.adjustedPoints.isEmpty() ? QPoint( 0, 0 ) : result.adjustedPoints.front();
+  QRect pointBounds( anchor, anchor );
   for ( int i = 1, n = result.adjustedPoints.size(); i < n; ++i )
   {
     const QPoint &p = result.adjustedPoints[i];
@@ -1147,7 +1214,7 @@ void KadasMilxItem::updateSymbolMargin( const KadasMilxClient::NPointSymbolGraph
     pointBounds.setBottom( std::max( pointBounds.bottom(), p.y() ) );
   }
 
-  QPoint offset = result.adjustedPoints.front() + result.offset;
+  QPoint offset = anchor + result.offset;
   QRect symbolBounds( offset.x(), offset.y(), result.graphic.width(), result.graphic.height() );
   state()->margin.left = std::max( 0, pointBounds.left() - symbolBounds.left() );
   state()->margin.top = std::max( 0, pointBounds.top() - symbolBounds.top() );
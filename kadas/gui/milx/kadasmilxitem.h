@@ -85,6 +85,7 @@ class KADAS_GUI_EXPORT KadasMilxItem : public KadasMapItem
         State *clone() const override SIP_FACTORY { return new State( *this ); }
         QJsonObject serialize() const override;
         bool deserialize( const QJsonObject &json ) override;
+        qint64 memoryUsage( const KadasStateHistory::State *previous ) const override;
     };
     void setState( const KadasMapItem::State *state ) override;
     const State *constState() const { return static_cast<State *>( mState ); }
@@ -164,7 +165,13 @@ class KADAS_GUI_EXPORT KadasMilxItem : public KadasMapItem
     void updateSymbolMargin( const KadasMilxClient::NPointSymbolGraphic &result );
     const KadasMilxSymbolSettings &symbolSettings() const;
 
-    static void finalize( KadasMilxItem *item, bool isCorridor );
+    //! Batched items are left without military name and symbol margin, see updateMilitaryNames and updateSymbolMargins
+    static KadasMilxItem *fromMilx( const QDomElement &itemElement, const QgsCoordinateTransform &crst, int symbolSize, bool batched );
+    //! Queries the missing military names of the items with a single server request
+    static void updateMilitaryNames( const QList<KadasMilxItem *> &items );
+    //! Computes the symbol margins of the items with a single server request
+    static void updateSymbolMargins( const QList<KadasMilxItem *> &items, int dpi );
+    static void finalize( KadasMilxItem *item, bool isCorridor, bool batched = false );
     static void posPointNodeRenderer( QPainter *painter, const QPointF &screenPoint, int nodeSize );
     static void ctrlPointNodeRenderer( QPainter *painter, const QPointF &screenPoint, int nodeSize );
 };
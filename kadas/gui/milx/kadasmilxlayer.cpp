@@ -22,11 +22,16 @@
 #include <qgis/qgsmaplayerrenderer.h>
 #include <qgis/qgsmapsettings.h>
 #include <qgis/qgsrendercontext.h>
+#include <qgis/qgssettings.h>
 
+#include "kadas/gui/kadasrendersnapshot.h"
 #include "kadas/gui/milx/kadasmilxclient.h"
 #include "kadas/gui/milx/kadasmilxitem.h"
 #include "kadas/gui/milx/kadasmilxlayer.h"
+#include "kadas/gui/milx/kadasmilxsymbolatlas.h"
 
+// Pick tolerance in pixels around the rendered symbols
+static constexpr int sPickTolerance = 3;
 
 class KadasMilxLayer::Renderer : public QgsMapLayerRenderer
 {
@@ -35,18 +40,27 @@ class KadasMilxLayer::Renderer : public QgsMapLayerRenderer
       : QgsMapLayerRenderer( layer->id(), &rendererContext )
     {
       bool omitSinglePoint = renderContext()->customProperties().contains( "globe" );
-      for ( const KadasMapItem *item : layer->items().values() )
+      if ( !omitSinglePoint )
       {
-        const KadasMilxItem *milxItem = dynamic_cast<const KadasMilxItem *>( item );
+        mPickIndex = layer->mPickIndex;
+        mPickFrame = std::make_shared<KadasMilxPickIndex::Frame>( renderContext()->mapToPixel(), mPickIndex->generation() );
+      }
+      mSymSettings = layer->milxSymbolSettings();
+      mRenderOpacity = layer->opacity();
+      mColored = !layer->mIsApproved;
+      KadasRenderSnapshot::capture().store( rendererContext );
+      // Small single point symbols are drawn from the symbol atlas
+      bool useAtlas = mSymSettings.symbolSize <= QgsSettings().value( "/milx/atlas_max_symbol_size", 64 ).toInt();
+      for ( auto it = layer->items().begin(), itEnd = layer->items().end(); it != itEnd; ++it )
+      {
+        const KadasMilxItem *milxItem = dynamic_cast<const KadasMilxItem *>( it.value() );
         if ( !milxItem || milxItem->constState()->points.isEmpty() || ( omitSinglePoint && !milxItem->isMultiPoint() ) )
         {
           // Skip symbols
           continue;
         }
-        mRenderSymbols.append( milxItem->toSymbol( renderContext()->mapToPixel(), renderContext()->coordinateTransform().destinationCrs(), !layer->mIsApproved ) );
-        mRenderItemData.append( { milxItem->constState()->userOffset, milxItem->isMultiPoint() } );
-        mSymSettings = layer->milxSymbolSettings();
-        mRenderOpacity = layer->opacity();
+        mRenderSymbols.append( milxItem->toSymbol( renderContext()->mapToPixel(), renderContext()->coordinateTransform().destinationCrs(), mColored ) );
+        mRenderItemData.append( { it.key(), milxItem->constState()->userOffset, milxItem->isMultiPoint(), useAtlas && !milxItem->isMultiPoint() } );
       }
     }
     bool render() override
@@ -56,51 +70,105 @@ class KadasMilxLayer::Renderer : public QgsMapLayerRenderer
         return true;
       }
       int dpi = renderContext()->painter()->device()->logicalDpiX();
-      double dpiScale = double( dpi ) / double( QApplication::desktop()->logicalDpiX() );
-      QList<KadasMilxClient::NPointSymbolGraphic> result;
+      double dpiScale = KadasRenderSnapshot::outputDpiScale( *renderContext() );
 #ifndef Q_OS_WIN
       // FIXME: Why only on non-windows?
       mSymSettings.lineWidth *= dpiScale;
       mSymSettings.symbolSize *= dpiScale;
 #endif
+      QList<KadasMilxClient::NPointSymbol> serverSymbols;
+      QStringList atlasSymbols;
+      for ( int i = 0, n = mRenderSymbols.size(); i < n; ++i )
+      {
+        if ( mRenderItemData[i].fromAtlas )
+        {
+          atlasSymbols.append( mRenderSymbols[i].xml );
+        }
+        else
+        {
+          serverSymbols.append( mRenderSymbols[i] );
+        }
+      }
+      QList<KadasMilxClient::NPointSymbolGraphic> result;
       QRect screenExtent = KadasMilxItem::computeScreenExtent( renderContext()->mapExtent(), renderContext()->mapToPixel() );
-      if ( !KadasMilxClient::updateSymbols( screenExtent, dpi, mRenderSymbols, mSymSettings, result ) )
+      if ( !serverSymbols.isEmpty() && !KadasMilxClient::updateSymbols( screenExtent, dpi, serverSymbols, mSymSettings, result ) )
       {
         return false;
       }
+      QList<KadasMilxSymbolAtlas::Sprite> sprites;
+      if ( !atlasSymbols.isEmpty() && !KadasMilxSymbolAtlas::instance()->sprites( atlasSymbols, dpi, mSymSettings, mColored, sprites ) )
+      {
+        return false;
+      }
+
       renderContext()->painter()->save();
       renderContext()->painter()->setOpacity( mRenderOpacity );
-      for ( int i = 0, n = result.size(); i < n; ++i )
+      auto resultIt = result.constBegin();
+      auto spriteIt = sprites.constBegin();
+      for ( int i = 0, n = mRenderSymbols.size(); i < n; ++i )
       {
         QPoint itemOrigin = mRenderSymbols[i].points.front();
-        QPoint renderPos = itemOrigin + result[i].offset + mRenderItemData[i].userOffset * dpiScale;
         if ( !mRenderItemData[i].isMultiPoint )
         {
           // Draw line from visual reference point to actual refrence point
           renderContext()->painter()->setPen( QPen( mSymSettings.leaderLineColor, mSymSettings.leaderLineWidth * dpiScale ) );
           renderContext()->painter()->drawLine( itemOrigin, itemOrigin + mRenderItemData[i].userOffset * dpiScale );
         }
-        renderContext()->painter()->drawImage( renderPos, result[i].graphic );
+        if ( mRenderItemData[i].fromAtlas )
+        {
+          const KadasMilxSymbolAtlas::Sprite &sprite = *spriteIt++;
+          QPoint renderPos = itemOrigin + sprite.offset + mRenderItemData[i].userOffset * dpiScale;
+          renderContext()->painter()->drawImage( renderPos, sprite.page, sprite.rect );
+          if ( mPickFrame )
+          {
+            mPickFrame->addSymbol( mRenderItemData[i].itemId, renderPos, sprite.page, sprite.rect );
+          }
+        }
+        else
+        {
+          const KadasMilxClient::NPointSymbolGraphic &graphic = *resultIt++;
+          QPoint renderPos = itemOrigin + graphic.offset + mRenderItemData[i].userOffset * dpiScale;
+          renderContext()->painter()->drawImage( renderPos, graphic.graphic );
+          if ( mPickFrame )
+          {
+            mPickFrame->addSymbol( mRenderItemData[i].itemId, renderPos, graphic.graphic, graphic.graphic.rect() );
+          }
+        }
       }
       renderContext()->painter()->restore();
+      // Only frames in screen pixels can answer picks
+      if ( mPickFrame && qgsDoubleNear( dpiScale, 1. ) && !renderContext()->renderingStopped() )
+      {
+        mPickIndex->addFrame( mPickFrame );
+      }
       return true;
     }
 
   private:
     struct RenderItemData
     {
+        ItemId itemId;
         QPoint userOffset;
         bool isMultiPoint;
+        bool fromAtlas;
     };
     QList<KadasMilxClient::NPointSymbol> mRenderSymbols;
     QList<RenderItemData> mRenderItemData;
     KadasMilxSymbolSettings mSymSettings;
     double mRenderOpacity = 1.;
+    bool mColored = true;
+    std::shared_ptr<KadasMilxPickIndex> mPickIndex;
+    std::shared_ptr<KadasMilxPickIndex::Frame> mPickFrame;
 };
 
 KadasMilxLayer::KadasMilxLayer( const QString &name )
   : KadasItemLayer( name, QgsCoordinateReferenceSystem( "EPSG:4326" ), layerType() )
+  , mPickIndex( std::make_shared<KadasMilxPickIndex>() )
 {
+  // Recorded frames are stale as soon as anything is redrawn differently
+  connect( this, &KadasMilxLayer::repaintRequested, this, [this] { mPickIndex->invalidate(); } );
+  connect( this, &KadasMilxLayer::itemAdded, this, [this] { mPickIndex->invalidate(); } );
+  connect( this, &KadasMilxLayer::itemRemoved, this, [this] { mPickIndex->invalidate(); } );
 }
 
 bool KadasMilxLayer::acceptsItem( const KadasMapItem *item ) const
@@ -121,16 +189,46 @@ KadasItemLayer::ItemId KadasMilxLayer::pickItem( const KadasMapPos &mapPos, cons
     return ITEM_ID_NULL;
   }
   QPoint screenPos = mapSettings.mapToPixel().transform( mapPos ).toQPointF().toPoint();
-  QList<KadasMilxClient::NPointSymbol> symbols;
-  QMap<int, ItemId> itemIdMap;
-  for ( auto it = mItems.begin(), itEnd = mItems.end(); it != itEnd; ++it )
+
+  // If the view was rendered, only the symbols covering the position in the rendered frame need an exact test
+  std::shared_ptr<const KadasMilxPickIndex::Frame> frame = mPickIndex->frame( mapSettings.mapToPixel() );
+  QList<ItemId> candidates;
+  if ( frame )
+  {
+    for ( ItemId itemId : frame->candidates( screenPos, sPickTolerance ) )
+    {
+      const KadasMilxItem *milxItem = dynamic_cast<const KadasMilxItem *>( mItems.value( itemId ) );
+      if ( milxItem && ( pickObjective != PickObjective::PICK_OBJECTIVE_TOOLTIP || !milxItem->tooltip().isEmpty() ) )
+      {
+        candidates.append( itemId );
+      }
+    }
+    if ( candidates.isEmpty() )
+    {
+      return ITEM_ID_NULL;
+    }
+    if ( pickObjective == PickObjective::PICK_OBJECTIVE_TOOLTIP )
+    {
+      // The coverage mask is accurate enough for tooltips, pick the topmost symbol
+      return candidates.last();
+    }
+  }
+  else
   {
-    const KadasMilxItem *milxItem = dynamic_cast<const KadasMilxItem *>( it.value() );
-    if ( !milxItem || ( pickObjective == PickObjective::PICK_OBJECTIVE_TOOLTIP && milxItem->tooltip().isEmpty() ) )
+    for ( auto it = mItems.begin(), itEnd = mItems.end(); it != itEnd; ++it )
     {
-      continue;
+      const KadasMilxItem *milxItem = dynamic_cast<const KadasMilxItem *>( it.value() );
+      if ( milxItem && ( pickObjective != PickObjective::PICK_OBJECTIVE_TOOLTIP || !milxItem->tooltip().isEmpty() ) )
+      {
+        candidates.append( it.key() );
+      }
     }
-    itemIdMap.insert( symbols.size(), it.key() );
+  }
+
+  QList<KadasMilxClient::NPointSymbol> symbols;
+  for ( ItemId itemId : std::as_const( candidates ) )
+  {
+    const KadasMilxItem *milxItem = static_cast<const KadasMilxItem *>( mItems[itemId] );
     symbols.append( milxItem->toSymbol( mapSettings.mapToPixel(), mapSettings.destinationCrs() ) );
     for ( int i = 0, n = symbols.last().points.size(); i < n; ++i )
     {
@@ -141,11 +239,24 @@ KadasItemLayer::ItemId KadasMilxLayer::pickItem( const KadasMapPos &mapPos, cons
   QRect bbox;
   if ( !symbols.isEmpty() && KadasMilxClient::pickSymbol( symbols, screenPos, milxSymbolSettings(), selectedSymbol, bbox ) && selectedSymbol >= 0 )
   {
-    return itemIdMap[selectedSymbol];
+    return candidates[selectedSymbol];
   }
   return ITEM_ID_NULL;
 }
 
+bool KadasMilxLayer::coversItem( const KadasMilxItem *item, const KadasMapPos &mapPos, const QgsMapSettings &mapSettings, bool &covered ) const
+{
+  std::shared_ptr<const KadasMilxPickIndex::Frame> frame = mPickIndex->frame( mapSettings.mapToPixel() );
+  ItemId itemId = mItems.key( const_cast<KadasMilxItem *>( item ), ITEM_ID_NULL );
+  if ( !frame || itemId == ITEM_ID_NULL )
+  {
+    return false;
+  }
+  QPoint screenPos = mapSettings.mapToPixel().transform( mapPos ).toQPointF().toPoint();
+  covered = frame->candidates( screenPos, sPickTolerance ).contains( itemId );
+  return true;
+}
+
 void KadasMilxLayer::setApproved( bool approved )
 {
   mIsApproved = approved;
@@ -210,6 +321,22 @@ void KadasMilxLayer::exportToMilxly( QDomElement &milxLayerEl, int dpi )
 bool KadasMilxLayer::importFromMilxly( const QDomElement &milxLayerEl, int dpi, QString &errorMsg )
 {
   setName( milxLayerEl.firstChildElement( "Name" ).text() );
+  mIsApproved = milxLayerEl.firstChildElement( "DisplayBW" ).text().toInt();
+
+  QList<KadasMilxItem *> items;
+  if ( !itemsFromMilxly( milxLayerEl, dpi, QApplication::desktop()->logicalDpiX(), mTransformContext, items, errorMsg ) )
+  {
+    return false;
+  }
+  for ( KadasMilxItem *item : items )
+  {
+    addItem( item );
+  }
+  return true;
+}
+
+bool KadasMilxLayer::itemsFromMilxly( const QDomElement &milxLayerEl, int dpi, int screenDpi, const QgsCoordinateTransformContext &transformContext, QList<KadasMilxItem *> &items, QString &errorMsg )
+{
   float symbolSize = milxLayerEl.firstChildElement( "SymbolSize" ).text().toFloat(); // This is in mm
   symbolSize = ( symbolSize * dpi ) / 25.4;                                          // mm to px
   QString crs = milxLayerEl.firstChildElement( "CoordSystemType" ).text();
@@ -235,16 +362,18 @@ bool KadasMilxLayer::importFromMilxly( const QDomElement &milxLayerEl, int dpi,
     QString projZone = zoneNumber + ( zoneLetter == "S" ? " +south" : "" );
     srcCrs.createFromProj( QString( "+proj=utm +zone=%1 +datum=WGS84 +units=m +no_defs" ).arg( projZone ) );
   }
-  QgsCoordinateTransform crst( srcCrs, QgsCoordinateReferenceSystem( "EPSG:4326" ), mTransformContext );
-
-  mIsApproved = milxLayerEl.firstChildElement( "DisplayBW" ).text().toInt();
+  QgsCoordinateTransform crst( srcCrs, QgsCoordinateReferenceSystem( "EPSG:4326" ), transformContext );
 
+  QList<KadasMilxItem *> graphicItems;
   QDomNodeList graphicEls = milxLayerEl.firstChildElement( "GraphicList" ).elementsByTagName( "MilXGraphic" );
   for ( int iGraphic = 0, nGraphics = graphicEls.count(); iGraphic < nGraphics; ++iGraphic )
   {
     QDomElement graphicEl = graphicEls.at( iGraphic ).toElement();
-    addItem( KadasMilxItem::fromMilx( graphicEl, crst, symbolSize ) );
+    graphicItems.append( KadasMilxItem::fromMilx( graphicEl, crst, symbolSize, true ) );
   }
+  KadasMilxItem::updateMilitaryNames( graphicItems );
+  KadasMilxItem::updateSymbolMargins( graphicItems, screenDpi );
+  items.append( graphicItems );
   return true;
 }
 
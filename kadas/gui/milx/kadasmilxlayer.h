@@ -20,7 +20,9 @@
 #include "kadas/core/kadaspluginlayer.h"
 #include "kadas/gui/kadasitemlayer.h"
 #include "kadas/gui/milx/kadasmilxclient.h"
+#include "kadas/gui/milx/kadasmilxpickindex.h"
 
+class KadasMilxItem;
 
 class KADAS_GUI_EXPORT KadasMilxLayer : public KadasItemLayer
 {
@@ -39,11 +41,23 @@ class KADAS_GUI_EXPORT KadasMilxLayer : public KadasItemLayer
     QgsMapLayerRenderer *createMapRenderer( QgsRenderContext &rendererContext ) override;
     ItemId pickItem( const KadasMapPos &mapPos, const QgsMapSettings &mapSettings, KadasItemLayer::PickObjective pickObjective = KadasItemLayer::PickObjective::PICK_OBJECTIVE_ANY ) const override;
 
+#ifndef SIP_RUN
+    /**
+     * Tests whether the rendered symbol of the item covers the position, using the frame recorded when the view was last rendered.
+     * Returns false if no frame of the view is available.
+     */
+    bool coversItem( const KadasMilxItem *item, const KadasMapPos &mapPos, const QgsMapSettings &mapSettings, bool &covered ) const;
+#endif
+
     void setApproved( bool approved );
     bool isApproved() const { return mIsApproved; }
 
     void exportToMilxly( QDomElement &milxLayerEl, int dpi );
     bool importFromMilxly( const QDomElement &milxLayerEl, int dpi, QString &errorMsg );
+#ifndef SIP_RUN
+    //! Creates the items of the graphics of a milxly layer element, can be called from any thread
+    static bool itemsFromMilxly( const QDomElement &milxLayerEl, int dpi, int screenDpi, const QgsCoordinateTransformContext &transformContext, QList<KadasMilxItem *> &items, QString &errorMsg );
+#endif
 
     void setOverrideMilxSymbolSettings( bool overrideSettings ) { mOverrideMilxSymbolSettings = overrideSettings; }
     bool overrideMilxSymbolSettings() const { return mOverrideMilxSymbolSettings; }
@@ -72,6 +86,8 @@ class KADAS_GUI_EXPORT KadasMilxLayer : public KadasItemLayer
     class Renderer;
 
     bool mIsApproved = false;
+    // Shared with running renderers, which record the rendered symbols
+    std::shared_ptr<KadasMilxPickIndex> mPickIndex;
     bool mOverrideMilxSymbolSettings = false;
     KadasMilxSymbolSettings mMilxSymbolSettings;
 };
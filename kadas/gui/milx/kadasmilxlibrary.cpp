@@ -15,16 +15,22 @@
  ***************************************************************************/
 
 #include <QApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QDomDocument>
 #include <QPainter>
+#include <QSaveFile>
 #include <QSortFilterProxyModel>
 #include <QStandardItemModel>
+#include <QStandardPaths>
 #include <QTreeView>
 #include <QVBoxLayout>
 #include <QtConcurrentRun>
 
 #include <qgis/qgsfilterlineedit.h>
+#include <qgis/qgslogger.h>
 #include <qgis/qgssettings.h>
 
 #include "kadas/gui/milx/kadasmilxlibrary.h"
@@ -214,6 +220,24 @@ QStandardItemModel *KadasMilxLibrary::loadLibrary( const QSize &viewIconSize )
   }
   QString lang = QgsSettings().value( "/locale/userLocale", "en" ).toString().left( 2 ).toUpper();
 
+  // Symbol metadata and icons are cached, the server is only queried if the library or the gallery files changed
+  QString cacheFile = QDir( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) ).absoluteFilePath( "milx_gallery.cache" );
+  QByteArray cacheKey = libraryCacheKey( galleryPath, lang, viewIconSize );
+  if ( cacheKey.isEmpty() || !readLibraryCache( cacheFile, cacheKey, model->invisibleRootItem() ) )
+  {
+    model->clear();
+    if ( loadGalleries( model, galleryPath, lang, viewIconSize ) && !cacheKey.isEmpty() )
+    {
+      writeLibraryCache( cacheFile, cacheKey, model->invisibleRootItem() );
+    }
+  }
+  addItem( model->invisibleRootItem(), tr( "More Symbols..." ), QImage( ":/images/themes/default/mActionAdd.svg" ), viewIconSize, true, "<custom>", tr( "More Symbols..." ) );
+  return model;
+}
+
+bool KadasMilxLibrary::loadGalleries( QStandardItemModel *model, const QString &galleryPath, const QString &lang, const QSize &viewIconSize )
+{
+  bool complete = true;
   QDir galleryDir( galleryPath );
   if ( galleryDir.exists() )
   {
@@ -263,11 +287,15 @@ QStandardItemModel *KadasMilxLibrary::loadLibrary( const QSize &viewIconSize )
               symbolXmls.append( memberNodes.at( iMember ).toElement().attribute( "MssStringXML" ) );
             }
             QList<KadasMilxSymbolDesc> symbolDescs;
-            KadasMilxClient::getSymbolsMetadata( symbolXmls, symbolDescs );
+            if ( !KadasMilxClient::getSymbolsMetadata( symbolXmls, symbolDescs ) )
+            {
+              // Don't cache incomplete galleries
+              complete = false;
+            }
             for ( const KadasMilxSymbolDesc &symbolDesc : symbolDescs )
             {
               if ( mLoaderAborted )
-                return model;
+                return false;
               addItem( subSectionItem, symbolDesc.name, symbolDesc.icon, viewIconSize, true, symbolDesc.symbolXml, symbolDesc.militaryName, symbolDesc.minNumPoints, symbolDesc.hasVariablePoints, symbolDesc.symbolType );
             }
           }
@@ -275,8 +303,152 @@ QStandardItemModel *KadasMilxLibrary::loadLibrary( const QSize &viewIconSize )
       }
     }
   }
-  addItem( model->invisibleRootItem(), tr( "More Symbols..." ), QImage( ":/images/themes/default/mActionAdd.svg" ), viewIconSize, true, "<custom>", tr( "More Symbols..." ) );
-  return model;
+  return complete;
+}
+
+QByteArray KadasMilxLibrary::libraryCacheKey( const QString &galleryPath, const QString &lang, const QSize &viewIconSize )
+{
+  QString versionTag;
+  if ( !KadasMilxClient::getCurrentLibraryVersionTag( versionTag ) )
+  {
+    return QByteArray();
+  }
+  QStringList keyParts = { versionTag, lang, QString( "%1x%2" ).arg( viewIconSize.width() ).arg( viewIconSize.height() ), galleryPath };
+  QDir galleryDir( galleryPath );
+  for ( const QFileInfo &info : galleryDir.entryInfoList( QStringList() << "*.xml" << "*.png", QDir::Files, QDir::Name ) )
+  {
+    keyParts.append( QString( "%1:%2:%3" ).arg( info.fileName() ).arg( info.lastModified().toMSecsSinceEpoch() ).arg( info.size() ) );
+  }
+  return QCryptographicHash::hash( keyParts.join( "\n" ).toUtf8(), QCryptographicHash::Sha1 );
+}
+
+bool KadasMilxLibrary::readLibraryCache( const QString &cacheFile, const QByteArray &cacheKey, QStandardItem *root )
+{
+  QFile file( cacheFile );
+  if ( !file.open( QIODevice::ReadOnly ) )
+  {
+    return false;
+  }
+  const uchar *data = file.map( 0, file.size() );
+  if ( !data )
+  {
+    return false;
+  }
+  QDataStream ds( QByteArray::fromRawData( reinterpret_cast<const char *>( data ), file.size() ) );
+  ds.setVersion( QDataStream::Qt_5_12 );
+
+  quint32 magic = 0;
+  quint32 version = 0;
+  QByteArray key;
+  ds >> magic >> version >> key;
+  if ( magic != sCacheMagic || version != sCacheFormatVersion || key != cacheKey )
+  {
+    QgsDebugMsgLevel( "MilX gallery cache is outdated", 2 );
+    return false;
+  }
+  qint32 nChildren = 0;
+  ds >> nChildren;
+  for ( int i = 0; i < nChildren && ds.status() == QDataStream::Ok; ++i )
+  {
+    readCacheItem( ds, data, root );
+  }
+  if ( ds.status() != QDataStream::Ok )
+  {
+    QgsDebugMsgLevel( "MilX gallery cache is corrupt", 2 );
+    return false;
+  }
+  return true;
+}
+
+void KadasMilxLibrary::writeLibraryCache( const QString &cacheFile, const QByteArray &cacheKey, const QStandardItem *root )
+{
+  QDir().mkpath( QFileInfo( cacheFile ).absolutePath() );
+  QSaveFile file( cacheFile );
+  if ( !file.open( QIODevice::WriteOnly ) )
+  {
+    return;
+  }
+  QDataStream ds( &file );
+  ds.setVersion( QDataStream::Qt_5_12 );
+  ds << sCacheMagic << sCacheFormatVersion << cacheKey;
+  ds << qint32( root->rowCount() );
+  for ( int i = 0, n = root->rowCount(); i < n; ++i )
+  {
+    writeCacheItem( ds, root->child( i ) );
+  }
+  file.commit();
+}
+
+void KadasMilxLibrary::readCacheItem( QDataStream &ds, const uchar *data, QStandardItem *parent )
+{
+  QString text;
+  bool isLeaf = false;
+  ds >> text >> isLeaf;
+  QStandardItem *item = new QStandardItem( text );
+  if ( isLeaf )
+  {
+    QString symbolXml;
+    QString symbolMilitaryName;
+    qint32 symbolPointCount = 0;
+    bool symbolHasVariablePoints = false;
+    QString symbolType;
+    ds >> symbolXml >> symbolMilitaryName >> symbolPointCount >> symbolHasVariablePoints >> symbolType;
+    item->setData( symbolXml, SymbolXmlRole );
+    item->setData( symbolMilitaryName, SymbolMilitaryNameRole );
+    item->setData( symbolPointCount, SymbolPointCountRole );
+    item->setData( symbolHasVariablePoints, SymbolVariablePointsRole );
+    item->setData( symbolType, SymbolTypeRole );
+    item->setToolTip( text );
+  }
+  else
+  {
+    item->setDragEnabled( false );
+  }
+
+  // Icons are stored as raw ARGB32 pixels, which are used directly from the mapped file
+  qint32 iconWidth = 0;
+  qint32 iconHeight = 0;
+  ds >> iconWidth >> iconHeight;
+  int iconBytes = iconWidth * iconHeight * 4;
+  qint64 pos = ds.device()->pos();
+  if ( ds.skipRawData( iconBytes ) == iconBytes && iconBytes > 0 )
+  {
+    QImage iconImage( data + pos, iconWidth, iconHeight, iconWidth * 4, QImage::Format_ARGB32 );
+    item->setIcon( QIcon( QPixmap::fromImage( iconImage.copy() ) ) );
+  }
+  parent->setChild( parent->rowCount(), item );
+
+  qint32 nChildren = 0;
+  ds >> nChildren;
+  for ( int i = 0; i < nChildren && ds.status() == QDataStream::Ok; ++i )
+  {
+    readCacheItem( ds, data, item );
+  }
+}
+
+void KadasMilxLibrary::writeCacheItem( QDataStream &ds, const QStandardItem *item )
+{
+  bool isLeaf = item->data( SymbolXmlRole ).isValid();
+  ds << item->text() << isLeaf;
+  if ( isLeaf )
+  {
+    ds << item->data( SymbolXmlRole ).toString() << item->data( SymbolMilitaryNameRole ).toString() << qint32( item->data( SymbolPointCountRole ).toInt() );
+    ds << item->data( SymbolVariablePointsRole ).toBool() << item->data( SymbolTypeRole ).toString();
+  }
+
+  QList<QSize> iconSizes = item->icon().availableSizes();
+  QImage iconImage = iconSizes.isEmpty() ? QImage() : item->icon().pixmap( iconSizes.first() ).toImage().convertToFormat( QImage::Format_ARGB32 );
+  ds << qint32( iconImage.width() ) << qint32( iconImage.height() );
+  for ( int y = 0, n = iconImage.height(); y < n; ++y )
+  {
+    ds.writeRawData( reinterpret_cast<const char *>( iconImage.constScanLine( y ) ), iconImage.width() * 4 );
+  }
+
+  ds << qint32( item->rowCount() );
+  for ( int i = 0, n = item->rowCount(); i < n; ++i )
+  {
+    writeCacheItem( ds, item->child( i ) );
+  }
 }
 
 QStandardItem *KadasMilxLibrary::addItem( QStandardItem *parent, const QString &value, const QImage &image, const QSize &viewIconSize, bool isLeaf, const QString &symbolXml, const QString &symbolMilitaryName, int symbolPointCount, bool symbolHasVariablePoints, const QString &symbolType )
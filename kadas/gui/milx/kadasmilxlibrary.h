@@ -21,6 +21,7 @@
 #include <QFutureWatcher>
 #include <QThread>
 
+class QDataStream;
 class QStandardItem;
 class QStandardItemModel;
 class QTreeView;
@@ -69,7 +70,16 @@ class KADAS_GUI_EXPORT KadasMilxLibrary : public QFrame
     void itemClicked( const QModelIndex &index );
 
   private:
+    static constexpr quint32 sCacheMagic = 0x4b4d4743; // KMGC
+    static constexpr quint32 sCacheFormatVersion = 1;
+
     QStandardItemModel *loadLibrary( const QSize &viewIconSize );
+    bool loadGalleries( QStandardItemModel *model, const QString &galleryPath, const QString &lang, const QSize &viewIconSize );
+    static QByteArray libraryCacheKey( const QString &galleryPath, const QString &lang, const QSize &viewIconSize );
+    static bool readLibraryCache( const QString &cacheFile, const QByteArray &cacheKey, QStandardItem *root );
+    static void writeLibraryCache( const QString &cacheFile, const QByteArray &cacheKey, const QStandardItem *root );
+    static void readCacheItem( QDataStream &ds, const uchar *data, QStandardItem *parent );
+    static void writeCacheItem( QDataStream &ds, const QStandardItem *item );
     static QStandardItem *addItem( QStandardItem *parent, const QString &value, const QImage &image = QImage(), const QSize &viewIconSize = QSize(), bool isLeaf = false, const QString &symbolXml = QString(), const QString &symbolMilitaryName = QString(), int symbolPointCount = 0, bool symbolHasVariablePoints = false, const QString &symbolType = QString() );
     void loaderFinished();
 };
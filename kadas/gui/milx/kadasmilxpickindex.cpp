@@ -0,0 +1,173 @@
+/***************************************************************************
+    kadasmilxpickindex.cpp
+    ----------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QImage>
+#include <QMutexLocker>
+
+#include <cmath>
+
+#include <qgis/qgis.h>
+
+#include "kadas/gui/milx/kadasmilxpickindex.h"
+
+// Mask cell and grid cell sizes in pixels
+static constexpr int sMaskCellSize = 4;
+static constexpr int sGridCellSize = 64;
+static constexpr int sMaxFrames = 4;
+
+
+KadasMilxPickIndex::Frame::Frame( const QgsMapToPixel &mapToPixel, int generation )
+  : mMapToPixel( mapToPixel )
+  , mGeneration( generation )
+{
+}
+
+void KadasMilxPickIndex::Frame::addSymbol( ItemId itemId, const QPoint &pos, const QImage &graphic, const QRect &sourceRect )
+{
+  if ( graphic.isNull() || sourceRect.isEmpty() )
+  {
+    return;
+  }
+  Symbol symbol;
+  symbol.itemId = itemId;
+  symbol.bounds = QRect( pos, sourceRect.size() );
+  symbol.maskColumns = ( sourceRect.width() + sMaskCellSize - 1 ) / sMaskCellSize;
+  int maskRows = ( sourceRect.height() + sMaskCellSize - 1 ) / sMaskCellSize;
+  symbol.mask = QBitArray( symbol.maskColumns * maskRows );
+  // Graphics are ARGB32, as rendered by the MilX client and stored in the symbol atlas
+  QImage image = graphic.format() == QImage::Format_ARGB32 ? graphic : graphic.convertToFormat( QImage::Format_ARGB32 );
+  for ( int y = 0, h = sourceRect.height(); y < h; ++y )
+  {
+    const QRgb *line = reinterpret_cast<const QRgb *>( image.constScanLine( sourceRect.top() + y ) ) + sourceRect.left();
+    for ( int x = 0, w = sourceRect.width(); x < w; ++x )
+    {
+      if ( qAlpha( line[x] ) > 0 )
+      {
+        symbol.mask.setBit( ( y / sMaskCellSize ) * symbol.maskColumns + x / sMaskCellSize );
+      }
+    }
+  }
+
+  int idx = mSymbols.size();
+  mSymbols.append( symbol );
+  for ( int row = std::floor( double( symbol.bounds.top() ) / sGridCellSize ), rowEnd = std::floor( double( symbol.bounds.bottom() ) / sGridCellSize ); row <= rowEnd; ++row )
+  {
+    for ( int col = std::floor( double( symbol.bounds.left() ) / sGridCellSize ), colEnd = std::floor( double( symbol.bounds.right() ) / sGridCellSize ); col <= colEnd; ++col )
+    {
+      mGrid[gridKey( col, row )].append( idx );
+    }
+  }
+}
+
+bool KadasMilxPickIndex::Frame::matches( const QgsMapToPixel &mapToPixel ) const
+{
+  return mMapToPixel.mapWidth() == mapToPixel.mapWidth() && mMapToPixel.mapHeight() == mapToPixel.mapHeight() && qgsDoubleNear( mMapToPixel.mapUnitsPerPixel(), mapToPixel.mapUnitsPerPixel() ) && qgsDoubleNear( mMapToPixel.mapRotation(), mapToPixel.mapRotation() ) && qgsDoubleNear( mMapToPixel.xCenter(), mapToPixel.xCenter() ) && qgsDoubleNear( mMapToPixel.yCenter(), mapToPixel.yCenter() );
+}
+
+QList<KadasMilxPickIndex::ItemId> KadasMilxPickIndex::Frame::candidates( const QPoint &screenPos, int tolerance ) const
+{
+  QRect rect( screenPos.x() - tolerance, screenPos.y() - tolerance, 2 * tolerance + 1, 2 * tolerance + 1 );
+  QVector<int> hits;
+  for ( int row = std::floor( double( rect.top() ) / sGridCellSize ), rowEnd = std::floor( double( rect.bottom() ) / sGridCellSize ); row <= rowEnd; ++row )
+  {
+    for ( int col = std::floor( double( rect.left() ) / sGridCellSize ), colEnd = std::floor( double( rect.right() ) / sGridCellSize ); col <= colEnd; ++col )
+    {
+      for ( int idx : mGrid.value( gridKey( col, row ) ) )
+      {
+        if ( !hits.contains( idx ) && covers( mSymbols[idx], rect ) )
+        {
+          hits.append( idx );
+        }
+      }
+    }
+  }
+  std::sort( hits.begin(), hits.end() );
+  QList<ItemId> result;
+  for ( int idx : std::as_const( hits ) )
+  {
+    result.append( mSymbols[idx].itemId );
+  }
+  return result;
+}
+
+bool KadasMilxPickIndex::Frame::covers( const Symbol &symbol, const QRect &rect ) const
+{
+  QRect overlap = symbol.bounds.intersected( rect ).translated( -symbol.bounds.topLeft() );
+  if ( overlap.isEmpty() )
+  {
+    return false;
+  }
+  for ( int row = overlap.top() / sMaskCellSize, rowEnd = overlap.bottom() / sMaskCellSize; row <= rowEnd; ++row )
+  {
+    for ( int col = overlap.left() / sMaskCellSize, colEnd = overlap.right() / sMaskCellSize; col <= colEnd; ++col )
+    {
+      if ( symbol.mask.testBit( row * symbol.maskColumns + col ) )
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+int KadasMilxPickIndex::generation() const
+{
+  QMutexLocker locker( &mMutex );
+  return mGeneration;
+}
+
+void KadasMilxPickIndex::invalidate()
+{
+  QMutexLocker locker( &mMutex );
+  ++mGeneration;
+  mFrames.clear();
+}
+
+void KadasMilxPickIndex::addFrame( const std::shared_ptr<const Frame> &frame )
+{
+  QMutexLocker locker( &mMutex );
+  if ( frame->generation() != mGeneration )
+  {
+    // The layer changed while the frame was rendered
+    return;
+  }
+  for ( auto it = mFrames.begin(); it != mFrames.end(); ++it )
+  {
+    if ( ( *it )->matches( frame->mapToPixel() ) )
+    {
+      mFrames.erase( it );
+      break;
+    }
+  }
+  mFrames.prepend( frame );
+  while ( mFrames.size() > sMaxFrames )
+  {
+    mFrames.removeLast();
+  }
+}
+
+std::shared_ptr<const KadasMilxPickIndex::Frame> KadasMilxPickIndex::frame( const QgsMapToPixel &mapToPixel ) const
+{
+  QMutexLocker locker( &mMutex );
+  for ( const std::shared_ptr<const Frame> &frame : mFrames )
+  {
+    if ( frame->matches( mapToPixel ) )
+    {
+      return frame;
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+    kadasmilxpickindex.h
+    --------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASMILXPICKINDEX_H
+#define KADASMILXPICKINDEX_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QMutex>
+#include <QRect>
+#include <QVector>
+
+#include <memory>
+
+#include <qgis/qgsmaptopixel.h>
+
+#include "kadas/gui/kadas_gui.h"
+
+#define SIP_NO_FILE
+
+class QImage;
+
+/**
+ * Client side pick accelerator of a MilX layer. The renderer records the
+ * screen bounds and a coarse coverage mask of each symbol it draws, indexed
+ * by a uniform screen grid. Picks at the same map view are answered from the
+ * recorded frame, only the remaining candidates need an exact test by the
+ * MilX server. Frames are recorded from render threads and dropped whenever
+ * the layer changes.
+ */
+class KADAS_GUI_EXPORT KadasMilxPickIndex
+{
+  public:
+    typedef unsigned ItemId;
+
+    class KADAS_GUI_EXPORT Frame
+    {
+      public:
+        Frame( const QgsMapToPixel &mapToPixel, int generation );
+
+        //! Adds the symbol drawn at pos from the sourceRect part of graphic
+        void addSymbol( ItemId itemId, const QPoint &pos, const QImage &graphic, const QRect &sourceRect );
+
+        const QgsMapToPixel &mapToPixel() const { return mMapToPixel; }
+        bool matches( const QgsMapToPixel &mapToPixel ) const;
+        int generation() const { return mGeneration; }
+
+        //! Returns the items whose symbol covers the screen position within the tolerance, in render order
+        QList<ItemId> candidates( const QPoint &screenPos, int tolerance ) const;
+
+      private:
+        struct Symbol
+        {
+            ItemId itemId;
+            QRect bounds;
+            // One bit per mask cell, set if any pixel of the cell is not transparent
+            QBitArray mask;
+            int maskColumns;
+        };
+
+        QgsMapToPixel mMapToPixel;
+        int mGeneration = 0;
+        QVector<Symbol> mSymbols;
+        QHash<quint64, QVector<int>> mGrid;
+
+        bool covers( const Symbol &symbol, const QRect &rect ) const;
+        static quint64 gridKey( int col, int row ) { return ( quint64( quint32( col ) ) << 32 ) | quint32( row ); }
+    };
+
+    //! Returns the generation new frames must be recorded for
+    int generation() const;
+    //! Drops all frames, frames still being recorded for earlier generations are discarded
+    void invalidate();
+
+    void addFrame( const std::shared_ptr<const Frame> &frame );
+    //! Returns the recorded frame of the map view, or null
+    std::shared_ptr<const Frame> frame( const QgsMapToPixel &mapToPixel ) const;
+
+  private:
+    mutable QMutex mMutex;
+    int mGeneration = 0;
+    // Most recent first, several views (i.e. main and overview canvas) are rendered concurrently
+    QList<std::shared_ptr<const Frame>> mFrames;
+};
+
+#endif // KADASMILXPICKINDEX_H
@@ -0,0 +1,159 @@
+/***************************************************************************
+    kadasmilxsymbolatlas.cpp
+    ------------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QMutexLocker>
+
+#include <cstring>
+
+#include "kadas/gui/milx/kadasmilxclient.h"
+#include "kadas/gui/milx/kadasmilxsymbolatlas.h"
+
+// Atlas page size in pixels, larger symbols get a page of their own
+static constexpr int sPageSize = 1024;
+// The atlas is cleared once its pages exceed this size
+static constexpr qint64 sMaxBytes = 64 * 1024 * 1024;
+
+
+KadasMilxSymbolAtlas *KadasMilxSymbolAtlas::instance()
+{
+  static KadasMilxSymbolAtlas atlas;
+  return &atlas;
+}
+
+QString KadasMilxSymbolAtlas::entryKey( const QString &symbolXml, int dpi, const KadasMilxSymbolSettings &settings, bool colored )
+{
+  return QString( "%1:%2:%3:%4:%5:" ).arg( dpi ).arg( settings.symbolSize ).arg( settings.lineWidth ).arg( static_cast<int>( settings.workMode ) ).arg( colored ) + symbolXml;
+}
+
+bool KadasMilxSymbolAtlas::sprites( const QStringList &symbolXmls, int dpi, const KadasMilxSymbolSettings &settings, bool colored, QList<Sprite> &result )
+{
+  QStringList keys;
+  QStringList missing;
+  {
+    QMutexLocker locker( &mMutex );
+    for ( const QString &symbolXml : symbolXmls )
+    {
+      keys.append( entryKey( symbolXml, dpi, settings, colored ) );
+      if ( !mEntries.contains( keys.last() ) && !missing.contains( symbolXml ) )
+      {
+        missing.append( symbolXml );
+      }
+    }
+  }
+
+  if ( !missing.isEmpty() )
+  {
+    // Single point symbols are rendered at the origin, as for the item symbol image
+    QList<KadasMilxClient::NPointSymbol> symbols;
+    for ( const QString &symbolXml : std::as_const( missing ) )
+    {
+      symbols.append( KadasMilxClient::NPointSymbol( symbolXml, QList<QPoint>() << QPoint( 0, 0 ), QList<int>(), QList<QPair<int, double>>(), true, colored ) );
+    }
+    QList<KadasMilxClient::NPointSymbolGraphic> graphics;
+    if ( !KadasMilxClient::updateSymbols( QRect( 0, 0, 100, 100 ), dpi, symbols, settings, graphics ) )
+    {
+      return false;
+    }
+    QMutexLocker locker( &mMutex );
+    if ( mBytes > sMaxBytes )
+    {
+      clearLocked();
+    }
+    for ( int i = 0, n = missing.size(); i < n; ++i )
+    {
+      insert( entryKey( missing[i], dpi, settings, colored ), graphics[i].graphic, graphics[i].offset );
+    }
+  }
+
+  QMutexLocker locker( &mMutex );
+  for ( const QString &key : std::as_const( keys ) )
+  {
+    auto it = mEntries.constFind( key );
+    if ( it == mEntries.constEnd() )
+    {
+      // Cleared meanwhile by another render job, draw nothing rather than refetching
+      result.append( Sprite() );
+      continue;
+    }
+    result.append( { it->page >= 0 ? mPages[it->page] : QImage(), it->rect, it->offset } );
+  }
+  return true;
+}
+
+void KadasMilxSymbolAtlas::clear()
+{
+  QMutexLocker locker( &mMutex );
+  clearLocked();
+}
+
+void KadasMilxSymbolAtlas::clearLocked()
+{
+  mPages.clear();
+  mEntries.clear();
+  mBytes = 0;
+  mPackPage = -1;
+}
+
+void KadasMilxSymbolAtlas::insert( const QString &key, const QImage &graphic, const QPoint &offset )
+{
+  if ( mEntries.contains( key ) )
+  {
+    return;
+  }
+  if ( graphic.isNull() )
+  {
+    mEntries.insert( key, { -1, QRect(), offset } );
+    return;
+  }
+  QImage image = graphic.convertToFormat( QImage::Format_ARGB32 );
+  if ( image.width() > sPageSize || image.height() > sPageSize )
+  {
+    mPages.append( image );
+    mBytes += image.sizeInBytes();
+    mEntries.insert( key, { mPages.size() - 1, image.rect(), offset } );
+    return;
+  }
+
+  if ( mPackPage >= 0 && mShelfX + image.width() > sPageSize )
+  {
+    // Next shelf
+    mShelfY += mShelfHeight;
+    mShelfX = 0;
+    mShelfHeight = 0;
+  }
+  if ( mPackPage < 0 || mShelfY + image.height() > sPageSize )
+  {
+    QImage page( sPageSize, sPageSize, QImage::Format_ARGB32 );
+    page.fill( Qt::transparent );
+    mPages.append( page );
+    mBytes += page.sizeInBytes();
+    mPackPage = mPages.size() - 1;
+    mShelfX = 0;
+    mShelfY = 0;
+    mShelfHeight = 0;
+  }
+
+  // Copy the rows, sprites handed out earlier keep their copy of the page
+  QImage &page = mPages[mPackPage];
+  QRect rect( mShelfX, mShelfY, image.width(), image.height() );
+  for ( int y = 0, h = image.height(); y < h; ++y )
+  {
+    std::memcpy( page.scanLine( rect.top() + y ) + 4 * rect.left(), image.constScanLine( y ), 4 * image.width() );
+  }
+  mShelfX += image.width();
+  mShelfHeight = std::max( mShelfHeight, image.height() );
+  mEntries.insert( key, { mPackPage, rect, offset } );
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+    kadasmilxsymbolatlas.h
+    ----------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASMILXSYMBOLATLAS_H
+#define KADASMILXSYMBOLATLAS_H
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+
+#include "kadas/gui/kadas_gui.h"
+
+#define SIP_NO_FILE
+
+class KadasMilxSymbolSettings;
+
+/**
+ * Texture atlas of single point MilX symbols. The graphic of a single point
+ * symbol only depends on its symbol XML and the render settings, so it is
+ * fetched from the MilX server once and packed into a shared atlas page,
+ * from which all layers and render jobs draw it. Thread-safe.
+ */
+class KADAS_GUI_EXPORT KadasMilxSymbolAtlas
+{
+  public:
+    struct Sprite
+    {
+        //! Atlas page, the sprite is the rect part of it
+        QImage page;
+        QRect rect;
+        //! Offset of the sprite from the symbol position
+        QPoint offset;
+    };
+
+    static KadasMilxSymbolAtlas *instance();
+
+    //! Returns the sprites of the symbols, missing symbols are fetched with a single server request. Returns false if the request failed.
+    bool sprites( const QStringList &symbolXmls, int dpi, const KadasMilxSymbolSettings &settings, bool colored, QList<KadasMilxSymbolAtlas::Sprite> &result );
+    void clear();
+
+  private:
+    struct Entry
+    {
+        int page;
+        QRect rect;
+        QPoint offset;
+    };
+
+    QMutex mMutex;
+    QList<QImage> mPages;
+    QHash<QString, Entry> mEntries;
+    qint64 mBytes = 0;
+    // Shelf packing position on the page being filled
+    int mPackPage = -1;
+    int mShelfX = 0;
+    int mShelfY = 0;
+    int mShelfHeight = 0;
+
+    void clearLocked();
+    void insert( const QString &key, const QImage &graphic, const QPoint &offset );
+    static QString entryKey( const QString &symbolXml, int dpi, const KadasMilxSymbolSettings &settings, bool colored );
+};
+
+#endif // KADASMILXSYMBOLATLAS_H
@@ -0,0 +1,432 @@
+/***************************************************************************
+    kadaslocationindex.cpp
+    ----------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+
+#include <QDir>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <qgis/qgslogger.h>
+#include <qgis/qgssettings.h>
+
+#include "kadas/core/kadas.h"
+#include "kadas/gui/search/kadaslocationindex.h"
+
+// On-disk layout (little endian), see scripts/build_location_index.py
+
+struct KadasLocationIndex::Header
+{
+    char magic[8];
+    quint32 entryCount;
+    quint32 wordCount;
+    quint32 trigramCount;
+    quint32 originCount;
+    quint64 entriesOffset;
+    quint64 wordsOffset;
+    quint64 trigramsOffset;
+    quint64 postingsOffset;
+    quint64 stringsOffset;
+    quint64 originsOffset;
+    quint64 fileSize;
+};
+
+struct KadasLocationIndex::Entry
+{
+    quint32 labelOffset;
+    quint32 detailOffset;
+    // GeoJSON geometry, empty if the location has none
+    quint32 geometryOffset;
+    quint32 geometryLength;
+    quint16 labelLength;
+    quint16 detailLength;
+    quint16 origin;
+    quint16 rank;
+    double lon;
+    double lat;
+    // NaN if the location has no bounding box
+    double bbox[4];
+};
+
+// A word of the normalized detail of an entry, sorted by word and entry
+struct KadasLocationIndex::Word
+{
+    quint32 offset;
+    quint16 length;
+    quint16 padding;
+    quint32 entry;
+};
+
+// Byte trigram of the normalized words, with the (sorted) ids of the entries containing it
+struct KadasLocationIndex::Trigram
+{
+    quint32 key;
+    quint32 postingsStart;
+    quint32 postingsCount;
+};
+
+struct KadasLocationIndex::Origin
+{
+    quint32 offset;
+    quint32 length;
+};
+
+static const char sMagic[8] = { 'K', 'L', 'O', 'C', 'I', 'D', 'X', '2' };
+
+// Whether the section [offset, offset + count * itemSize) is aligned for its items and ends before end
+static bool sectionFits( quint64 offset, quint64 count, quint64 itemSize, quint64 itemAlignment, quint64 end )
+{
+  return offset % itemAlignment == 0 && offset <= end && count <= ( end - offset ) / itemSize;
+}
+
+// Whether [offset, offset + length) lies within a section of the specified size
+static bool rangeFits( quint64 offset, quint64 length, quint64 size )
+{
+  return offset <= size && length <= size - offset;
+}
+
+static int compareBytes( const char *a, int na, const char *b, int nb )
+{
+  int cmp = std::memcmp( a, b, std::min( na, nb ) );
+  return cmp != 0 ? cmp : na - nb;
+}
+
+static quint32 trigramKey( const char *s )
+{
+  return ( quint32( uchar( s[0] ) ) << 16 ) | ( quint32( uchar( s[1] ) ) << 8 ) | quint32( uchar( s[2] ) );
+}
+
+// Whether every query word is the prefix of a word of the (normalized) detail
+static bool matchesWordPrefixes( const QByteArray &detail, const QList<QByteArray> &words )
+{
+  for ( const QByteArray &word : words )
+  {
+    int pos = 0;
+    bool found = false;
+    while ( pos < detail.size() && !found )
+    {
+      int end = detail.indexOf( ' ', pos );
+      end = end < 0 ? detail.size() : end;
+      found = end - pos >= word.size() && std::memcmp( detail.constData() + pos, word.constData(), word.size() ) == 0;
+      pos = end + 1;
+    }
+    if ( !found )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+KadasLocationIndex::KadasLocationIndex( const QString &path )
+  : mFile( path )
+{
+  if ( Q_BYTE_ORDER != Q_LITTLE_ENDIAN || !mFile.open( QIODevice::ReadOnly ) || mFile.size() < qint64( sizeof( Header ) ) )
+  {
+    return;
+  }
+  const uchar *data = mFile.map( 0, mFile.size() );
+  if ( !data )
+  {
+    return;
+  }
+  mData = data;
+  mHeader = reinterpret_cast<const Header *>( data );
+  if ( !validate() )
+  {
+    QgsDebugMsgLevel( QString( "Invalid location index %1" ).arg( path ), 2 );
+    mFile.unmap( const_cast<uchar *>( data ) );
+    mData = nullptr;
+    mHeader = nullptr;
+  }
+}
+
+KadasLocationIndex::~KadasLocationIndex()
+{
+  if ( mData )
+  {
+    mFile.unmap( const_cast<uchar *>( mData ) );
+  }
+}
+
+bool KadasLocationIndex::validate() const
+{
+  // The sections are stored in this order, each ends where the next one starts
+  const Header *header = mHeader;
+  quint64 size = mFile.size();
+  if (
+    std::memcmp( header->magic, sMagic, sizeof( sMagic ) ) != 0 || header->fileSize != size
+    || !sectionFits( header->entriesOffset, header->entryCount, sizeof( Entry ), alignof( Entry ), header->wordsOffset )
+    || header->entriesOffset < sizeof( Header )
+    || !sectionFits( header->wordsOffset, header->wordCount, sizeof( Word ), alignof( Word ), header->trigramsOffset )
+    || !sectionFits( header->trigramsOffset, header->trigramCount, sizeof( Trigram ), alignof( Trigram ), header->postingsOffset )
+    || !sectionFits( header->postingsOffset, 0, sizeof( quint32 ), alignof( quint32 ), header->stringsOffset )
+    || header->stringsOffset > header->originsOffset
+    || !sectionFits( header->originsOffset, header->originCount, sizeof( Origin ), alignof( Origin ), size )
+  )
+  {
+    return false;
+  }
+  const quint64 postingCount = ( header->stringsOffset - header->postingsOffset ) / sizeof( quint32 );
+  const quint64 stringsSize = header->originsOffset - header->stringsOffset;
+
+  // Every offset read by the searches must lie within its section
+  const Entry *entries = reinterpret_cast<const Entry *>( mData + header->entriesOffset );
+  for ( quint32 i = 0; i < header->entryCount; ++i )
+  {
+    const Entry &e = entries[i];
+    if ( !rangeFits( e.labelOffset, e.labelLength, stringsSize ) || !rangeFits( e.detailOffset, e.detailLength, stringsSize ) || !rangeFits( e.geometryOffset, e.geometryLength, stringsSize ) || e.origin >= header->originCount )
+    {
+      return false;
+    }
+  }
+  const Word *words = reinterpret_cast<const Word *>( mData + header->wordsOffset );
+  for ( quint32 i = 0; i < header->wordCount; ++i )
+  {
+    if ( !rangeFits( words[i].offset, words[i].length, stringsSize ) || words[i].entry >= header->entryCount )
+    {
+      return false;
+    }
+  }
+  const Trigram *trigrams = reinterpret_cast<const Trigram *>( mData + header->trigramsOffset );
+  for ( quint32 i = 0; i < header->trigramCount; ++i )
+  {
+    if ( !rangeFits( trigrams[i].postingsStart, trigrams[i].postingsCount, postingCount ) )
+    {
+      return false;
+    }
+  }
+  const quint32 *postings = reinterpret_cast<const quint32 *>( mData + header->postingsOffset );
+  if ( !std::all_of( postings, postings + postingCount, [header]( quint32 idx ) { return idx < header->entryCount; } ) )
+  {
+    return false;
+  }
+  const Origin *origins = reinterpret_cast<const Origin *>( mData + header->originsOffset );
+  for ( quint32 i = 0; i < header->originCount; ++i )
+  {
+    if ( !rangeFits( origins[i].offset, origins[i].length, stringsSize ) )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+int KadasLocationIndex::entryCount() const
+{
+  return mHeader ? mHeader->entryCount : 0;
+}
+
+const KadasLocationIndex::Entry *KadasLocationIndex::entry( quint32 idx ) const
+{
+  return reinterpret_cast<const Entry *>( mData + mHeader->entriesOffset ) + idx;
+}
+
+QByteArray KadasLocationIndex::entryDetail( const Entry *entry ) const
+{
+  return QByteArray::fromRawData( reinterpret_cast<const char *>( mData + mHeader->stringsOffset + entry->detailOffset ), entry->detailLength );
+}
+
+QString KadasLocationIndex::normalize( const QString &text )
+{
+  QString decomposed = text.normalized( QString::NormalizationForm_KD ).toLower();
+  QString normalized;
+  normalized.reserve( decomposed.size() );
+  bool space = true;
+  for ( const QChar &c : std::as_const( decomposed ) )
+  {
+    if ( c.category() == QChar::Mark_NonSpacing )
+    {
+      continue;
+    }
+    if ( c.isLetterOrNumber() )
+    {
+      normalized.append( c );
+      space = false;
+    }
+    else if ( !space )
+    {
+      normalized.append( ' ' );
+      space = true;
+    }
+  }
+  if ( normalized.endsWith( ' ' ) )
+  {
+    normalized.chop( 1 );
+  }
+  return normalized;
+}
+
+QVector<quint32> KadasLocationIndex::wordPrefixCandidates( const QList<QByteArray> &words ) const
+{
+  // Seed the candidates with the entries of the query word having the fewest prefix matches
+  const Word *begin = reinterpret_cast<const Word *>( mData + mHeader->wordsOffset );
+  const Word *end = begin + mHeader->wordCount;
+  const char *strings = reinterpret_cast<const char *>( mData + mHeader->stringsOffset );
+  const Word *bestBegin = nullptr;
+  const Word *bestEnd = nullptr;
+  for ( const QByteArray &word : words )
+  {
+    const Word *lower = std::lower_bound( begin, end, word, [strings]( const Word &w, const QByteArray &value ) {
+      return compareBytes( strings + w.offset, w.length, value.constData(), value.size() ) < 0;
+    } );
+    const Word *upper = std::upper_bound( lower, end, word, [strings]( const QByteArray &value, const Word &w ) {
+      return compareBytes( value.constData(), value.size(), strings + w.offset, std::min<int>( w.length, value.size() ) ) < 0;
+    } );
+    if ( lower == upper )
+    {
+      return QVector<quint32>();
+    }
+    if ( !bestBegin || upper - lower < bestEnd - bestBegin )
+    {
+      bestBegin = lower;
+      bestEnd = upper;
+    }
+  }
+  QVector<quint32> candidates;
+  candidates.reserve( bestEnd - bestBegin );
+  for ( const Word *w = bestBegin; w != bestEnd; ++w )
+  {
+    candidates.append( w->entry );
+  }
+  std::sort( candidates.begin(), candidates.end() );
+  candidates.erase( std::unique( candidates.begin(), candidates.end() ), candidates.end() );
+  return candidates;
+}
+
+QVector<quint32> KadasLocationIndex::trigramCandidates( const QList<QByteArray> &words ) const
+{
+  const Trigram *begin = reinterpret_cast<const Trigram *>( mData + mHeader->trigramsOffset );
+  const Trigram *end = begin + mHeader->trigramCount;
+  const quint32 *postings = reinterpret_cast<const quint32 *>( mData + mHeader->postingsOffset );
+
+  QList<const Trigram *> trigrams;
+  for ( const QByteArray &word : words )
+  {
+    for ( int i = 0; i + 3 <= word.size(); ++i )
+    {
+      quint32 key = trigramKey( word.constData() + i );
+      const Trigram *it = std::lower_bound( begin, end, key, []( const Trigram &t, quint32 value ) { return t.key < value; } );
+      if ( it == end || it->key != key )
+      {
+        return QVector<quint32>();
+      }
+      trigrams.append( it );
+    }
+  }
+  if ( trigrams.isEmpty() )
+  {
+    return QVector<quint32>();
+  }
+  // Intersect the posting lists, starting from the shortest
+  std::sort( trigrams.begin(), trigrams.end(), []( const Trigram *a, const Trigram *b ) { return a->postingsCount < b->postingsCount; } );
+  const quint32 *first = postings + trigrams[0]->postingsStart;
+  QVector<quint32> candidates( first, first + trigrams[0]->postingsCount );
+  for ( int i = 1, n = trigrams.size(); i < n && !candidates.isEmpty(); ++i )
+  {
+    const quint32 *list = postings + trigrams[i]->postingsStart;
+    QVector<quint32> intersection;
+    std::set_intersection( candidates.begin(), candidates.end(), list, list + trigrams[i]->postingsCount, std::back_inserter( intersection ) );
+    candidates = intersection;
+  }
+  return candidates;
+}
+
+QList<KadasLocationIndex::Result> KadasLocationIndex::search( const QString &text, int limit ) const
+{
+  QList<Result> results;
+  if ( !mData )
+  {
+    return results;
+  }
+  QByteArray query = normalize( text ).toUtf8();
+  QList<QByteArray> words = query.split( ' ' );
+  words.removeAll( QByteArray() );
+  if ( words.isEmpty() )
+  {
+    return results;
+  }
+
+  // Word prefix matches, falling back to infix matches of the query words
+  QVector<quint32> candidates = wordPrefixCandidates( words );
+  bool prefixMatch = true;
+  candidates.erase( std::remove_if( candidates.begin(), candidates.end(), [this, &words]( quint32 idx ) {
+                      return !matchesWordPrefixes( entryDetail( entry( idx ) ), words );
+                    } ),
+                    candidates.end() );
+  if ( candidates.isEmpty() )
+  {
+    prefixMatch = false;
+    candidates = trigramCandidates( words );
+    candidates.erase( std::remove_if( candidates.begin(), candidates.end(), [this, &words]( quint32 idx ) {
+                        QByteArray detail = entryDetail( entry( idx ) );
+                        return !std::all_of( words.begin(), words.end(), [&detail]( const QByteArray &word ) { return detail.contains( word ); } );
+                      } ),
+                      candidates.end() );
+  }
+
+  // Like the search server: by rank, then exact prefix matches of the whole query first, then shorter texts first
+  auto rankKey = [this, &query, prefixMatch]( quint32 idx ) {
+    const Entry *e = entry( idx );
+    bool startsWith = prefixMatch && entryDetail( e ).startsWith( query );
+    return std::make_tuple( e->rank, !startsWith, e->detailLength, idx );
+  };
+  auto middle = candidates.begin() + std::min( limit, candidates.size() );
+  std::partial_sort( candidates.begin(), middle, candidates.end(), [&rankKey]( quint32 a, quint32 b ) { return rankKey( a ) < rankKey( b ); } );
+
+  const char *strings = reinterpret_cast<const char *>( mData + mHeader->stringsOffset );
+  const Origin *origins = reinterpret_cast<const Origin *>( mData + mHeader->originsOffset );
+  for ( auto it = candidates.begin(); it != middle; ++it )
+  {
+    const Entry *e = entry( *it );
+    Result result;
+    result.origin = QString::fromUtf8( strings + origins[e->origin].offset, origins[e->origin].length );
+    result.label = QString::fromUtf8( strings + e->labelOffset, e->labelLength );
+    result.geometry = QString::fromUtf8( strings + e->geometryOffset, e->geometryLength );
+    result.rank = e->rank;
+    result.pos = QgsPointXY( e->lon, e->lat );
+    if ( !std::isnan( e->bbox[0] ) )
+    {
+      result.bbox = QgsRectangle( e->bbox[0], e->bbox[1], e->bbox[2], e->bbox[3] );
+    }
+    results.append( result );
+  }
+  return results;
+}
+
+std::shared_ptr<KadasLocationIndex> KadasLocationIndex::offlineIndex()
+{
+  static QMutex mutex;
+  static QString indexPath;
+  static std::shared_ptr<KadasLocationIndex> index;
+
+  QString path = QgsSettings().value( "search/locationofflineindex", QDir( Kadas::pkgDataPath() ).absoluteFilePath( "search/locations.kli" ) ).toString();
+  QMutexLocker locker( &mutex );
+  if ( path != indexPath )
+  {
+    indexPath = path;
+    index = std::make_shared<KadasLocationIndex>( path );
+    if ( !index->isValid() )
+    {
+      index.reset();
+    }
+  }
+  return index;
+}
@@ -0,0 +1,91 @@
+/***************************************************************************
+    kadaslocationindex.h
+    --------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASLOCATIONINDEX_H
+#define KADASLOCATIONINDEX_H
+
+#include <QFile>
+#include <QList>
+
+#include <memory>
+
+#include <qgis/qgspointxy.h>
+#include <qgis/qgsrectangle.h>
+
+#include "kadas/gui/kadas_gui.h"
+
+
+/**
+ * Memory-mapped offline gazetteer, as written by scripts/build_location_index.py.
+ * Query words are matched as prefixes of the words of the normalized search
+ * text of each location (like the location search server), with a trigram
+ * index for infix matches as fallback. Searches are thread-safe.
+ */
+class KADAS_GUI_EXPORT KadasLocationIndex
+{
+  public:
+    struct Result
+    {
+        QString origin;
+        QString label;
+        int rank = 0;
+        // WGS84
+        QgsPointXY pos;
+        QgsRectangle bbox;
+        // GeoJSON, empty if the location has no geometry
+        QString geometry;
+    };
+
+    KadasLocationIndex( const QString &path );
+    ~KadasLocationIndex();
+
+    bool isValid() const { return mData != nullptr; }
+    int entryCount() const;
+
+    //! Returns up to limit locations matching text, ordered by rank and match quality
+    QList<KadasLocationIndex::Result> search( const QString &text, int limit ) const;
+
+    //! Returns the lowercase, accent-folded text with all non-alphanumeric characters collapsed to single spaces
+    static QString normalize( const QString &text );
+
+#ifndef SIP_RUN
+    //! Returns the index configured for the offline location search, or null if none is available
+    static std::shared_ptr<KadasLocationIndex> offlineIndex();
+#endif
+
+  private:
+#ifdef SIP_RUN
+    KadasLocationIndex( const KadasLocationIndex &rh );
+#endif
+
+    struct Header;
+    struct Entry;
+    struct Word;
+    struct Trigram;
+    struct Origin;
+
+    QFile mFile;
+    const uchar *mData = nullptr;
+    const Header *mHeader = nullptr;
+
+    bool validate() const;
+    const Entry *entry( quint32 idx ) const;
+    QByteArray entryDetail( const Entry *entry ) const;
+    QVector<quint32> wordPrefixCandidates( const QList<QByteArray> &words ) const;
+    QVector<quint32> trigramCandidates( const QList<QByteArray> &words ) const;
+};
+
+#endif // KADASLOCATIONINDEX_H
@@ -25,7 +25,6 @@
 #include <qgis/qgscoordinatetransform.h>
 #include <qgis/qgslogger.h>
 #include <qgis/qgsmapcanvas.h>
-#include <qgis/qgsblockingnetworkrequest.h>
 #include <qgis/qgssettings.h>
 #include <qgis/qgsjsonutils.h>
 #include <qgis/qgsannotationmarkeritem.h>
@@ -39,7 +38,9 @@
 #include <qgis/qgscurve.h>
 #include <qgis/qgscurvepolygon.h>
 
+#include "kadas/gui/search/kadaslocationindex.h"
 #include "kadas/gui/search/kadaslocationsearchprovider.h"
+#include "kadas/gui/search/kadassearchcache.h"
 
 
 const int KadasLocationSearchFilter::sResultCountLimit = 50;
@@ -77,6 +78,32 @@ void KadasLocationSearchFilter::fetchResults( const QString &string, const QgsLo
   QString serviceUrl;
   if ( QgsSettings().value( "/kadas/isOffline" ).toBool() )
   {
+    // Query the embedded index if available, the offline search server is only needed without one
+    std::shared_ptr<KadasLocationIndex> index = KadasLocationIndex::offlineIndex();
+    if ( index )
+    {
+      const QList<KadasLocationIndex::Result> results = index->search( string, sResultCountLimit );
+      for ( const KadasLocationIndex::Result &location : results )
+      {
+        if ( feedback->isCanceled() )
+        {
+          break;
+        }
+        QVariantMap resultData;
+        if ( !location.bbox.isNull() )
+        {
+          resultData[QStringLiteral( "bbox" )] = location.bbox;
+        }
+        resultData[QStringLiteral( "pos" )] = location.pos;
+        resultData[QStringLiteral( "zoomScale" )] = location.origin == "address" ? 5000 : 25000;
+        if ( !location.geometry.isEmpty() )
+        {
+          resultData[QStringLiteral( "geometry" )] = location.geometry;
+        }
+        emit resultFetched( buildResult( location.origin, location.label, resultData ) );
+      }
+      return;
+    }
     serviceUrl = QgsSettings().value( "search/locationofflinesearchurl", "http://localhost:5000/SearchServerCh" ).toString();
   }
   else
@@ -87,6 +114,22 @@ void KadasLocationSearchFilter::fetchResults( const QString &string, const QgsLo
   // serviceUrl = "https://gist.githubusercontent.com/3nids/50a5e773ff18fe78a49edb7d7eb13e1d/raw/99aaacc67f3fbae773fdb088213aeb7cc9bfbb16/kadas-search-2";
   QgsDebugMsgLevel( serviceUrl, 2 );
 
+  KadasSearchCache *cache = KadasSearchCache::instance();
+  QString cacheProvider = name() + ":" + serviceUrl;
+  QList<QgsLocatorResult> cachedResults;
+  if ( cache->lookup( cacheProvider, string, QString(), cachedResults ) )
+  {
+    for ( const QgsLocatorResult &result : std::as_const( cachedResults ) )
+    {
+      emit resultFetched( result );
+    }
+    return;
+  }
+  if ( !KadasSearchCache::debounce( feedback ) )
+  {
+    return;
+  }
+
   QUrl url( serviceUrl );
   QUrlQuery query( url );
   query.removeAllQueryItems( "type" );
@@ -99,28 +142,27 @@ void KadasLocationSearchFilter::fetchResults( const QString &string, const QgsLo
   {
     query.addQueryItem( "limit", QString::number( sResultCountLimit ) );
   }
+  // The results are only complete if fewer than the limit the server applied were returned
+  const int resultCountLimit = query.queryItemValue( "limit" ).toInt();
   url.setQuery( query );
 
   QNetworkRequest req( url );
   req.setRawHeader( "Referer", QgsSettings().value( "search/referer", "http://localhost" ).toByteArray() );
 
 
-  QgsBlockingNetworkRequest bnr = QgsBlockingNetworkRequest();
-
-  connect( feedback, &QgsFeedback::canceled, &bnr, &QgsBlockingNetworkRequest::abort );
-  QgsBlockingNetworkRequest::ErrorCode errCode = bnr.get( req, false, feedback );
-  if ( errCode != QgsBlockingNetworkRequest::NoError )
+  QByteArray content;
+  if ( !cache->get( req, feedback, content ) )
     return;
 
-  QgsNetworkReplyContent reply = bnr.reply();
   QJsonParseError err;
-  QJsonDocument doc = QJsonDocument::fromJson( reply.content(), &err );
+  QJsonDocument doc = QJsonDocument::fromJson( content, &err );
   if ( doc.isNull() )
     QgsDebugMsgLevel( QString( "Parsing error:" ).arg( err.errorString() ), 2 );
 
   QJsonObject resultMap = doc.object();
   //bool fuzzy = resultMap["fuzzy"] == "true";
   const QJsonArray constResults = resultMap["results"].toArray();
+  QList<KadasSearchCache::Result> results;
   for ( const QJsonValue &item : constResults )
   {
     QJsonObject itemMap = item.toObject();
@@ -128,11 +170,6 @@ void KadasLocationSearchFilter::fetchResults( const QString &string, const QgsLo
 
     QString origin = itemAttrsMap["origin"].toString();
 
-    QgsLocatorResult result;
-    result.group = mCategoryMap.contains( origin ) ? mCategoryMap[origin].first : origin;
-    result.groupScore = mCategoryMap.contains( origin ) ? mCategoryMap[origin].second : 0;
-    result.displayString = itemAttrsMap["label"].toString().replace( QRegExp( "<[^>]+>" ), "" ); // Remove HTML tags
-
     QVariantMap resultData;
     if ( mPatBox.exactMatch( itemAttrsMap["geom_st_box2d"].toString() ) )
     {
@@ -154,9 +191,24 @@ void KadasLocationSearchFilter::fetchResults( const QString &string, const QgsLo
         resultData[QStringLiteral( "bbox" )] = QgsRectangle( match.captured( 1 ).toDouble(), match.captured( 2 ).toDouble(), match.captured( 3 ).toDouble(), match.captured( 4 ).toDouble() );
       }
     }
-    result.setUserData( resultData );
+    QgsLocatorResult result = buildResult( origin, itemAttrsMap["label"].toString(), resultData );
+    results.append( { result, itemAttrsMap.contains( "detail" ) ? itemAttrsMap["detail"].toString() : result.displayString } );
     emit resultFetched( result );
   }
+  if ( !feedback->isCanceled() )
+  {
+    cache->insert( cacheProvider, string, QString(), results, results.size() < resultCountLimit, KadasSearchCache::Matching::WordPrefix );
+  }
+}
+
+QgsLocatorResult KadasLocationSearchFilter::buildResult( const QString &origin, const QString &label, const QVariantMap &resultData ) const
+{
+  QgsLocatorResult result;
+  result.group = mCategoryMap.contains( origin ) ? mCategoryMap[origin].first : origin;
+  result.groupScore = mCategoryMap.contains( origin ) ? mCategoryMap[origin].second : 0;
+  result.displayString = QString( label ).replace( QRegExp( "<[^>]+>" ), "" ); // Remove HTML tags
+  result.setUserData( resultData );
+  return result;
 }
 
 void KadasLocationSearchFilter::triggerResult( const QgsLocatorResult &result )
@@ -54,6 +54,8 @@ class KADAS_GUI_EXPORT KadasLocationSearchFilter : public QgsLocatorFilter
 
     QString mPinItemId;
     QString mGeometryItemId;
+
+    QgsLocatorResult buildResult( const QString &origin, const QString &label, const QVariantMap &resultData ) const;
 };
 
 #endif // KADASLOCATIONSEARCHPROVIDER_H
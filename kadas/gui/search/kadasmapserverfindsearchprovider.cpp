@@ -19,6 +19,7 @@
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QUrlQuery>
+#include <QtConcurrentMap>
 
 #include <qgis/qgsannotationlayer.h>
 #include <qgis/qgsarcgisrestutils.h>
@@ -28,7 +29,6 @@
 #include <qgis/qgslogger.h>
 #include <qgis/qgsmapcanvas.h>
 #include <qgis/qgsmaplayer.h>
-#include <qgis/qgsnetworkaccessmanager.h>
 #include <qgis/qgsmultisurface.h>
 #include <qgis/qgspolygon.h>
 #include <qgis/qgsproject.h>
@@ -43,6 +43,7 @@
 
 
 #include "kadas/gui/search/kadasmapserverfindsearchprovider.h"
+#include "kadas/gui/search/kadassearchcache.h"
 
 
 const int KadasMapServerFindSearchProvider::sSearchTimeout = 10000;
@@ -111,71 +112,127 @@ void KadasMapServerFindSearchProvider::fetchResults( const QString &string, cons
     return;
   }
 
-  QString spatialFilter;
+  QgsRectangle box;
   if ( !context.targetExtent.isNull() )
   {
     QgsCoordinateTransform ct( QgsCoordinateReferenceSystem( context.targetExtentCrs ), QgsCoordinateReferenceSystem( "EPSG:4326" ), QgsProject::instance() );
-    QgsRectangle box = ct.transformBoundingBox( context.targetExtent );
-    spatialFilter = QString( "{\"spatialRel\": \"esriSpatialRelIntersects\", \"geometryType\": \"esriGeometryEnvelope\", \"geometry\": { \"xmin\": %1, \"ymin\": %2, \"xmax\": %3, \"ymax\": %4, \"spatialReference\": {\"wkid\": 4326}}}" )
-                      .arg( box.xMinimum(), 0, 'f', 4 )
-                      .arg( box.yMinimum(), 0, 'f', 4 )
-                      .arg( box.xMaximum(), 0, 'f', 4 )
-                      .arg( box.yMaximum(), 0, 'f', 4 );
+    box = ct.transformBoundingBox( context.targetExtent );
   }
 
+  // Requests are issued for the extent bucket, so that they can be cached, and the results filtered by the actual extent
+  KadasSearchCache *cache = KadasSearchCache::instance();
+  QString scope = KadasSearchCache::extentScope( box );
+  struct LayerQuery
+  {
+      LayerUrlName layer;
+      QList<QgsLocatorResult> results;
+  };
+  QVector<LayerQuery> layerQueries;
+  QList<QgsLocatorResult> results;
   for ( const LayerUrlName &ql : queryableLayers )
   {
-    QUrl url( ql.first + "/find" );
-    QUrlQuery query( url );
-    query.addQueryItem( "f", "json" );
-    query.addQueryItem( "searchText", string );
-    query.addQueryItem( "layers", ql.second );
-    query.addQueryItem( "spatialFilter", spatialFilter );
+    QList<QgsLocatorResult> cachedResults;
+    if ( cache->lookup( name() + ":" + ql.first + "?" + ql.second, string, scope, cachedResults ) )
+    {
+      results.append( cachedResults );
+    }
+    else
+    {
+      layerQueries.append( { ql, QList<QgsLocatorResult>() } );
+    }
+  }
+  if ( !layerQueries.isEmpty() && KadasSearchCache::debounce( feedback ) )
+  {
+    QtConcurrent::blockingMap( layerQueries, [&]( LayerQuery &layerQuery ) {
+      layerQuery.results = fetchLayerResults( layerQuery.layer.first, layerQuery.layer.second, string, box, feedback );
+    } );
+    for ( const LayerQuery &layerQuery : std::as_const( layerQueries ) )
+    {
+      results.append( layerQuery.results );
+    }
+  }
 
-    url.setQuery( query );
-    QNetworkRequest req( url );
-    req.setRawHeader( "Referer", QgsSettings().value( "search/referer", "http://localhost" ).toByteArray() );
-    QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( req );
-    connect( feedback, &QgsFeedback::canceled, reply, &QNetworkReply::abort );
-    connect( reply, &QNetworkReply::finished, this, [this, reply]() {
-      if ( reply->error() == QNetworkReply::NoError )
-      {
-        QByteArray replyText = reply->readAll();
-        QJsonParseError err;
-        QJsonDocument doc = QJsonDocument::fromJson( replyText, &err );
-        if ( doc.isNull() )
-        {
-          QgsDebugMsgLevel( QString( "Parsing error:" ).arg( err.errorString() ), 2 );
-        }
-        QVariantMap resultMap = doc.object().toVariantMap();
-        for ( const QVariant &item : resultMap["results"].toList() )
-        {
-          QVariantMap itemMap = item.toMap();
-          QVariantMap itemAttrsMap = itemMap["attributes"].toMap();
-          QString authid = QString( "EPSG:%1" ).arg( itemAttrsMap["spatialReference"].toMap()["wkid"].toString() );
-          QgsCoordinateReferenceSystem crs( authid );
-          QgsCoordinateReferenceSystem crsWgs84( "EPSG:4326" );
-          QgsAbstractGeometry *geom = QgsArcGisRestUtils::convertGeometry( itemMap["geometry"].toMap(), itemMap["geometryType"].toString(), false, false, &crs );
-          geom->transform( QgsCoordinateTransform( crs, crsWgs84, QgsProject::instance() ) );
+  for ( const QgsLocatorResult &result : std::as_const( results ) )
+  {
+    QgsRectangle resultBox = result.userData().value<QVariantMap>().value( QStringLiteral( "bbox" ) ).value<QgsRectangle>();
+    if ( box.isNull() || box.intersects( resultBox ) )
+    {
+      emit resultFetched( result );
+    }
+  }
+}
 
-          QgsLocatorResult result;
-          QVariantMap resultData;
+QList<QgsLocatorResult> KadasMapServerFindSearchProvider::fetchLayerResults( const QString &layerUrl, const QString &layers, const QString &string, const QgsRectangle &box, QgsFeedback *feedback ) const
+{
+  QList<QgsLocatorResult> results;
+  QString spatialFilter;
+  if ( !box.isNull() )
+  {
+    QgsRectangle requestBox = KadasSearchCache::bucketExtent( box );
+    spatialFilter = QString( "{\"spatialRel\": \"esriSpatialRelIntersects\", \"geometryType\": \"esriGeometryEnvelope\", \"geometry\": { \"xmin\": %1, \"ymin\": %2, \"xmax\": %3, \"ymax\": %4, \"spatialReference\": {\"wkid\": 4326}}}" )
+                      .arg( requestBox.xMinimum(), 0, 'f', 4 )
+                      .arg( requestBox.yMinimum(), 0, 'f', 4 )
+                      .arg( requestBox.xMaximum(), 0, 'f', 4 )
+                      .arg( requestBox.yMaximum(), 0, 'f', 4 );
+  }
 
-          resultData[QStringLiteral( "geometry" )] = geom->asJson( 5 );
-          resultData[QStringLiteral( "bbox" )] = geom->boundingBox();
-          resultData[QStringLiteral( "pos" )] = QgsPointXY( geom->centroid() );
-          // resultData[QStringLiteral( "zoomScale" )] = 1000;
-          result.group = tr( "Layer %1" ).arg( itemMap["layerName"].toString() );
-          result.displayString = QString( "%1: %2" ).arg( itemMap["foundFieldName"].toString(), itemMap["value"].toString() );
-          delete geom;
+  QUrl url( layerUrl + "/find" );
+  QUrlQuery query( url );
+  query.addQueryItem( "f", "json" );
+  query.addQueryItem( "searchText", string );
+  query.addQueryItem( "layers", layers );
+  query.addQueryItem( "spatialFilter", spatialFilter );
 
-          result.setUserData( resultData );
-          emit resultFetched( result );
-        }
-      }
-      reply->deleteLater();
-    } );
+  url.setQuery( query );
+  QNetworkRequest req( url );
+  req.setRawHeader( "Referer", QgsSettings().value( "search/referer", "http://localhost" ).toByteArray() );
+
+  QByteArray replyText;
+  if ( !KadasSearchCache::instance()->get( req, feedback, replyText ) )
+  {
+    return results;
+  }
+
+  QJsonParseError err;
+  QJsonDocument doc = QJsonDocument::fromJson( replyText, &err );
+  if ( doc.isNull() )
+  {
+    QgsDebugMsgLevel( QString( "Parsing error:" ).arg( err.errorString() ), 2 );
+  }
+  QList<KadasSearchCache::Result> cacheResults;
+  QVariantMap resultMap = doc.object().toVariantMap();
+  for ( const QVariant &item : resultMap["results"].toList() )
+  {
+    QVariantMap itemMap = item.toMap();
+    QVariantMap itemAttrsMap = itemMap["attributes"].toMap();
+    QString authid = QString( "EPSG:%1" ).arg( itemAttrsMap["spatialReference"].toMap()["wkid"].toString() );
+    QgsCoordinateReferenceSystem crs( authid );
+    QgsCoordinateReferenceSystem crsWgs84( "EPSG:4326" );
+    QgsAbstractGeometry *geom = QgsArcGisRestUtils::convertGeometry( itemMap["geometry"].toMap(), itemMap["geometryType"].toString(), false, false, &crs );
+    geom->transform( QgsCoordinateTransform( crs, crsWgs84, QgsProject::instance() ) );
+
+    QgsLocatorResult result;
+    QVariantMap resultData;
+
+    resultData[QStringLiteral( "geometry" )] = geom->asJson( 5 );
+    resultData[QStringLiteral( "bbox" )] = geom->boundingBox();
+    resultData[QStringLiteral( "pos" )] = QgsPointXY( geom->centroid() );
+    // resultData[QStringLiteral( "zoomScale" )] = 1000;
+    result.group = tr( "Layer %1" ).arg( itemMap["layerName"].toString() );
+    result.displayString = QString( "%1: %2" ).arg( itemMap["foundFieldName"].toString(), itemMap["value"].toString() );
+    delete geom;
+
+    result.setUserData( resultData );
+    results.append( result );
+    cacheResults.append( { result, itemMap["value"].toString() } );
+  }
+  if ( !feedback->isCanceled() )
+  {
+    // The find operation has no result limit parameter, the server truncates at its own maximum record count.
+    // The results are hence never known to be complete, and are only reused for the identical query.
+    KadasSearchCache::instance()->insert( name() + ":" + layerUrl + "?" + layers, string, KadasSearchCache::extentScope( box ), cacheResults, false, KadasSearchCache::Matching::Substring );
   }
+  return results;
 }
 
 void KadasMapServerFindSearchProvider::triggerResult( const QgsLocatorResult &result )
@@ -50,6 +50,8 @@ class KADAS_GUI_EXPORT KadasMapServerFindSearchProvider : public QgsLocatorFilte
 
     QString mGeometryItemId;
     QRegExp mPatBox;
+
+    QList<QgsLocatorResult> fetchLayerResults( const QString &layerUrl, const QString &layers, const QString &string, const QgsRectangle &box, QgsFeedback *feedback ) const;
 };
 
 #endif // KADASMAPSERVERFINDSEARCHPROVIDER_H
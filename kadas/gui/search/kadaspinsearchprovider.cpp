@@ -20,10 +20,13 @@
 #include <qgis/qgsmapcanvas.h>
 
 #include "kadas/gui/kadasitemlayer.h"
-#include "kadas/gui/mapitems/kadassymbolitem.h"
+#include "kadas/gui/kadasitemsearchindex.h"
 #include "kadas/gui/search/kadaspinsearchprovider.h"
 
 
+const int KadasPinSearchProvider::sResultCountLimit = 50;
+
+
 KadasPinSearchProvider::KadasPinSearchProvider( QgsMapCanvas *mapCanvas )
   : QgsLocatorFilter()
   , mMapCanvas( mapCanvas )
@@ -32,39 +35,54 @@ KadasPinSearchProvider::KadasPinSearchProvider( QgsMapCanvas *mapCanvas )
 
 QgsLocatorFilter *KadasPinSearchProvider::clone() const
 {
-  return new KadasPinSearchProvider( mMapCanvas );
+  KadasPinSearchProvider *filter = new KadasPinSearchProvider( mMapCanvas );
+  filter->captureIndexes();
+  return filter;
 }
 
-void KadasPinSearchProvider::fetchResults( const QString &string, const QgsLocatorContext &context, QgsFeedback *feedback )
+void KadasPinSearchProvider::captureIndexes()
 {
+  mIndexes.clear();
   const QList<QgsMapLayer *> layers = mMapCanvas->layers();
   for ( QgsMapLayer *layer : layers )
   {
     KadasItemLayer *itemLayer = dynamic_cast<KadasItemLayer *>( layer );
-    if ( !itemLayer )
+    if ( itemLayer )
     {
-      return;
+      mIndexes.append( itemLayer->searchIndex() );
+    }
+  }
+  mIndexesCaptured = true;
+}
+
+void KadasPinSearchProvider::fetchResults( const QString &string, const QgsLocatorContext &context, QgsFeedback *feedback )
+{
+  // Filters which were not cloned are run on the main thread
+  if ( !mIndexesCaptured )
+  {
+    captureIndexes();
+  }
+  int resultCount = 0;
+  for ( const std::shared_ptr<KadasItemSearchIndex> &index : std::as_const( mIndexes ) )
+  {
+    const QVector<KadasItemSearchIndex::Entry> entries = index->snapshot()->search( string, sResultCountLimit - resultCount, feedback );
+    for ( const KadasItemSearchIndex::Entry &entry : entries )
+    {
+      QgsLocatorResult result;
+      QVariantMap resultData;
+
+      //searchResult.zoomScale = 1000;
+      result.displayString = tr( "Pin %1" ).arg( entry.name );
+      resultData[QStringLiteral( "pos" )] = entry.pos;
+      resultData[QStringLiteral( "crs" )] = entry.crs;
+
+      result.setUserData( resultData );
+      emit resultFetched( result );
     }
-    for ( KadasMapItem *item : itemLayer->items() )
+    resultCount += entries.size();
+    if ( resultCount >= sResultCountLimit || ( feedback && feedback->isCanceled() ) )
     {
-      const KadasSymbolItem *symbolItem = dynamic_cast<KadasSymbolItem *>( item );
-      if ( !symbolItem )
-      {
-        continue;
-      }
-      if ( symbolItem->name().contains( string, Qt::CaseInsensitive ) || symbolItem->remarks().contains( string, Qt::CaseInsensitive ) )
-      {
-        QgsLocatorResult result;
-        QVariantMap resultData;
-
-        //searchResult.zoomScale = 1000;
-        result.displayString = tr( "Pin %1" ).arg( symbolItem->name() );
-        resultData[QStringLiteral( "pos" )] = QgsPointXY( symbolItem->constState()->pos );
-        resultData[QStringLiteral( "crs" )] = symbolItem->crs().authid();
-
-        result.setUserData( resultData );
-        emit resultFetched( result );
-      }
+      break;
     }
   }
 }
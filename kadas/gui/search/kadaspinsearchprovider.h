@@ -17,11 +17,14 @@
 #ifndef KADASPINSEARCHPROVIDER_H
 #define KADASPINSEARCHPROVIDER_H
 
+#include <memory>
+
 #include <qgis/qgslocatorfilter.h>
 
 #include "kadas/gui/kadas_gui.h"
 
 class QgsMapCanvas;
+class KadasItemSearchIndex;
 
 
 class KADAS_GUI_EXPORT KadasPinSearchProvider : public QgsLocatorFilter
@@ -39,6 +42,12 @@ class KADAS_GUI_EXPORT KadasPinSearchProvider : public QgsLocatorFilter
 
   private:
     QgsMapCanvas *mMapCanvas = nullptr;
+    // Indexes of the visible item layers, captured on the main thread when the filter is cloned for a search
+    QList<std::shared_ptr<KadasItemSearchIndex>> mIndexes;
+    bool mIndexesCaptured = false;
+    static const int sResultCountLimit;
+
+    void captureIndexes();
 };
 
 #endif // KADASPINSEARCHPROVIDER_H
@@ -19,6 +19,7 @@
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QUrlQuery>
+#include <QtConcurrentMap>
 
 #include <qgis/qgsannotationlayer.h>
 #include <qgis/qgsdatasourceuri.h>
@@ -26,7 +27,6 @@
 #include <qgis/qgslinestring.h>
 #include <qgis/qgslogger.h>
 #include <qgis/qgsmaplayer.h>
-#include <qgis/qgsnetworkaccessmanager.h>
 #include <qgis/qgspolygon.h>
 #include <qgis/qgsproject.h>
 #include <qgis/qgsrasterlayer.h>
@@ -37,6 +37,7 @@
 #include <qgis/qgsmarkersymbol.h>
 
 #include "kadas/gui/search/kadasremotedatasearchprovider.h"
+#include "kadas/gui/search/kadassearchcache.h"
 
 
 const int KadasRemoteDataSearchProvider::sSearchTimeout = 10000;
@@ -119,72 +120,129 @@ void KadasRemoteDataSearchProvider::fetchResults( const QString &string, const Q
   if ( !context.targetExtent.isNull() )
     bbox = ct.transformBoundingBox( context.targetExtent );
 
+  // Requests are issued for the extent bucket, so that they can be cached, and the results filtered by the actual extent
+  KadasSearchCache *cache = KadasSearchCache::instance();
+  QString scope = KadasSearchCache::extentScope( bbox );
+  struct LayerQuery
+  {
+      LayerIdName layer;
+      QList<QgsLocatorResult> results;
+  };
+  QVector<LayerQuery> layerQueries;
+  QList<QgsLocatorResult> results;
   for ( const LayerIdName &ql : queryableLayers )
   {
-    QUrl url( remoteDataSearchUrl );
-    QUrlQuery query( url );
-    query.addQueryItem( "type", "featuresearch" );
-    query.addQueryItem( "searchText", string );
-    query.addQueryItem( "features", ql.first );
-    QgsRectangle bbox;
-    if ( !bbox.isNull() )
+    QList<QgsLocatorResult> cachedResults;
+    if ( cache->lookup( name() + ":" + ql.first, string, scope, cachedResults ) )
     {
-      query.addQueryItem( "bbox", QString( "%1,%2,%3,%4" ).arg( bbox.xMinimum(), 0, 'f', 4 ).arg( bbox.yMinimum(), 0, 'f', 4 ).arg( bbox.xMaximum(), 0, 'f', 4 ).arg( bbox.yMaximum(), 0, 'f', 4 ) );
+      results.append( cachedResults );
     }
-    url.setQuery( query );
-    QNetworkRequest req( url );
-    req.setRawHeader( "Referer", QgsSettings().value( "search/referer", "http://localhost" ).toByteArray() );
-    QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( req );
-    reply->setProperty( "layerName", ql.second );
-
-    connect( feedback, &QgsFeedback::canceled, reply, &QNetworkReply::abort );
-    connect( reply, &QNetworkReply::finished, this, [this, reply, &bbox]() {
-      if ( reply->error() == QNetworkReply::NoError )
-      {
-        QString layerName = reply->property( "layerName" ).toString();
-        layerName.replace( QRegExp( "<[^>]+>" ), "" ); // Remove HTML tags
+    else
+    {
+      layerQueries.append( { ql, QList<QgsLocatorResult>() } );
+    }
+  }
+  if ( !layerQueries.isEmpty() && KadasSearchCache::debounce( feedback ) )
+  {
+    QtConcurrent::blockingMap( layerQueries, [&]( LayerQuery &layerQuery ) {
+      layerQuery.results = fetchLayerResults( layerQuery.layer.first, layerQuery.layer.second, string, bbox, feedback );
+    } );
+    for ( const LayerQuery &layerQuery : std::as_const( layerQueries ) )
+    {
+      results.append( layerQuery.results );
+    }
+  }
 
-        QByteArray replyText = reply->readAll();
-        QJsonParseError err;
-        QJsonDocument doc = QJsonDocument::fromJson( replyText, &err );
-        if ( doc.isNull() )
-        {
-          QgsDebugMsgLevel( QString( "Parsing error:" ).arg( err.errorString() ), 2 );
-        }
-        QVariantMap resultMap = doc.object().toVariantMap();
-        for ( const QVariant &item : resultMap["results"].toList() )
-        {
-          QVariantMap itemMap = item.toMap();
-          QVariantMap itemAttrsMap = itemMap["attrs"].toMap();
+  for ( const QgsLocatorResult &result : std::as_const( results ) )
+  {
+    QgsPointXY pos = result.userData().value<QVariantMap>().value( QStringLiteral( "pos" ) ).value<QgsPointXY>();
+    if ( bbox.isNull() || bbox.contains( pos ) )
+    {
+      emit resultFetched( result );
+    }
+  }
+}
+
+QList<QgsLocatorResult> KadasRemoteDataSearchProvider::fetchLayerResults( const QString &layerId, const QString &layerName, const QString &string, const QgsRectangle &bbox, QgsFeedback *feedback ) const
+{
+  QList<QgsLocatorResult> results;
+  QString remoteDataSearchUrl = QgsSettings().value( "search/remotedatasearchurl", "" ).toString();
+  QUrl url( remoteDataSearchUrl );
+  QUrlQuery query( url );
+  query.addQueryItem( "type", "featuresearch" );
+  query.addQueryItem( "searchText", string );
+  query.addQueryItem( "features", layerId );
+  if ( !query.hasQueryItem( "limit" ) )
+  {
+    query.addQueryItem( "limit", QString::number( sResultCountLimit ) );
+  }
+  // The results are only complete if fewer than the limit the server applied were returned
+  const int resultCountLimit = query.queryItemValue( "limit" ).toInt();
+  if ( !bbox.isNull() )
+  {
+    QgsRectangle requestBox = KadasSearchCache::bucketExtent( bbox );
+    query.addQueryItem( "bbox", QString( "%1,%2,%3,%4" ).arg( requestBox.xMinimum(), 0, 'f', 4 ).arg( requestBox.yMinimum(), 0, 'f', 4 ).arg( requestBox.xMaximum(), 0, 'f', 4 ).arg( requestBox.yMaximum(), 0, 'f', 4 ) );
+  }
+  url.setQuery( query );
+  QNetworkRequest req( url );
+  req.setRawHeader( "Referer", QgsSettings().value( "search/referer", "http://localhost" ).toByteArray() );
+
+  QByteArray replyText;
+  if ( !KadasSearchCache::instance()->get( req, feedback, replyText ) )
+  {
+    return results;
+  }
+
+  QString groupName = layerName;
+  groupName.replace( QRegExp( "<[^>]+>" ), "" ); // Remove HTML tags
 
-          if ( !mPatBox.exactMatch( itemAttrsMap["geom_st_box2d"].toString() ) )
-          {
-            QgsDebugMsgLevel( "Box RegEx did not match " + itemAttrsMap["geom_st_box2d"].toString(), 2 );
-            continue;
-          }
+  QJsonParseError err;
+  QJsonDocument doc = QJsonDocument::fromJson( replyText, &err );
+  if ( doc.isNull() )
+  {
+    QgsDebugMsgLevel( QString( "Parsing error:" ).arg( err.errorString() ), 2 );
+  }
+  // Layers are queried concurrently, don't share the (stateful) regexp
+  QRegExp patBox = mPatBox;
+  QList<KadasSearchCache::Result> cacheResults;
+  QVariantMap resultMap = doc.object().toVariantMap();
+  // All results count towards the server limit, including those skipped below
+  const QVariantList items = resultMap["results"].toList();
+  const bool complete = items.size() < resultCountLimit;
+  for ( const QVariant &item : items )
+  {
+    QVariantMap itemMap = item.toMap();
+    QVariantMap itemAttrsMap = itemMap["attrs"].toMap();
 
-          QgsLocatorResult result;
-          QVariantMap resultData;
+    if ( !patBox.exactMatch( itemAttrsMap["geom_st_box2d"].toString() ) )
+    {
+      QgsDebugMsgLevel( "Box RegEx did not match " + itemAttrsMap["geom_st_box2d"].toString(), 2 );
+      continue;
+    }
 
-          const QString crs = itemAttrsMap["sr"].toString();
-          QgsPointXY pos( itemAttrsMap["lon"].toDouble(), itemAttrsMap["lat"].toDouble() );
-          resultData[QStringLiteral( "crs" )] = crs;
-          resultData[QStringLiteral( "bbox" )] = QgsRectangle( mPatBox.cap( 1 ).toDouble(), mPatBox.cap( 2 ).toDouble(), mPatBox.cap( 3 ).toDouble(), mPatBox.cap( 4 ).toDouble() );
-          if ( !bbox.isNull() && !bbox.contains( pos ) )
-            continue;
+    QgsLocatorResult result;
+    QVariantMap resultData;
 
-          resultData[QStringLiteral( "pos" )] = pos;
+    const QString crs = itemAttrsMap["sr"].toString();
+    QgsPointXY pos( itemAttrsMap["lon"].toDouble(), itemAttrsMap["lat"].toDouble() );
+    resultData[QStringLiteral( "crs" )] = crs;
+    resultData[QStringLiteral( "bbox" )] = QgsRectangle( patBox.cap( 1 ).toDouble(), patBox.cap( 2 ).toDouble(), patBox.cap( 3 ).toDouble(), patBox.cap( 4 ).toDouble() );
+    resultData[QStringLiteral( "pos" )] = pos;
 
-          result.group = tr( "Layer %1" ).arg( layerName );
-          result.displayString = itemAttrsMap["label"].toString() + " (" + itemAttrsMap["detail"].toString() + ")";
+    result.group = tr( "Layer %1" ).arg( groupName );
+    result.displayString = itemAttrsMap["label"].toString() + " (" + itemAttrsMap["detail"].toString() + ")";
 
-          result.setUserData( resultData );
-          emit resultFetched( result );
-        }
-      }
-      reply->deleteLater();
-    } );
+    result.setUserData( resultData );
+    results.append( result );
+    cacheResults.append( { result, result.displayString } );
+  }
+  // A truncated response is never complete: the server may have filled the limit with hits of the bucketed extent
+  // outside of the view and dropped hits inside it. It is then only reused for the identical request.
+  if ( !feedback->isCanceled() )
+  {
+    KadasSearchCache::instance()->insert( name() + ":" + layerId, string, KadasSearchCache::extentScope( bbox ), cacheResults, complete, KadasSearchCache::Matching::WordPrefix );
   }
+  return results;
 }
 
 void KadasRemoteDataSearchProvider::triggerResult( const QgsLocatorResult &result )
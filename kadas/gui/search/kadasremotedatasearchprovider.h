@@ -52,6 +52,8 @@ class KADAS_GUI_EXPORT KadasRemoteDataSearchProvider : public QgsLocatorFilter
     QgsMapCanvas *mMapCanvas = nullptr;
     QString mPinItemId;
     QRegExp mPatBox;
+
+    QList<QgsLocatorResult> fetchLayerResults( const QString &layerId, const QString &layerName, const QString &string, const QgsRectangle &bbox, QgsFeedback *feedback ) const;
 };
 
 #endif // KADASREMOTEDATASEARCHPROVIDER_H
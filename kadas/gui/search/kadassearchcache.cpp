@@ -0,0 +1,232 @@
+/***************************************************************************
+    kadassearchcache.cpp
+    --------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QNetworkRequest>
+#include <QThread>
+
+#include <cmath>
+
+#include <qgis/qgsblockingnetworkrequest.h>
+#include <qgis/qgsfeedback.h>
+#include <qgis/qgslogger.h>
+#include <qgis/qgsrectangle.h>
+#include <qgis/qgssettings.h>
+
+#include "kadas/gui/search/kadaslocationindex.h"
+#include "kadas/gui/search/kadassearchcache.h"
+
+// Maximum number of cached queries, the oldest are dropped first
+static constexpr int sMaxEntries = 512;
+
+
+KadasSearchCache *KadasSearchCache::instance()
+{
+  static KadasSearchCache cache;
+  return &cache;
+}
+
+QgsRectangle KadasSearchCache::bucketExtent( const QgsRectangle &extent )
+{
+  if ( extent.isNull() )
+  {
+    return extent;
+  }
+  // Snap outwards to a grid a quarter of the power of two above the extent size
+  double size = std::max( extent.width(), extent.height() );
+  double cell = size > 0 ? std::pow( 2., std::ceil( std::log2( size ) ) ) / 4. : 1e-4;
+  return QgsRectangle(
+    std::floor( extent.xMinimum() / cell ) * cell,
+    std::floor( extent.yMinimum() / cell ) * cell,
+    std::ceil( extent.xMaximum() / cell ) * cell,
+    std::ceil( extent.yMaximum() / cell ) * cell
+  );
+}
+
+QString KadasSearchCache::extentScope( const QgsRectangle &extent )
+{
+  if ( extent.isNull() )
+  {
+    return QString();
+  }
+  QgsRectangle bucket = bucketExtent( extent );
+  return QString( "%1,%2,%3,%4" ).arg( bucket.xMinimum(), 0, 'g', 12 ).arg( bucket.yMinimum(), 0, 'g', 12 ).arg( bucket.xMaximum(), 0, 'g', 12 ).arg( bucket.yMaximum(), 0, 'g', 12 );
+}
+
+bool KadasSearchCache::debounce( QgsFeedback *feedback )
+{
+  // The locator cancels the running search on every keystroke, so requests are only sent once typing pauses
+  int remaining = QgsSettings().value( "search/debounce_ms", 150 ).toInt();
+  while ( remaining > 0 )
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      return false;
+    }
+    QThread::msleep( std::min( remaining, 20 ) );
+    remaining -= 20;
+  }
+  return !feedback || !feedback->isCanceled();
+}
+
+QString KadasSearchCache::normalizeQuery( const QString &query )
+{
+  return query.simplified().toLower();
+}
+
+QString KadasSearchCache::entryKey( const QString &provider, const QString &query, const QString &scope )
+{
+  return provider + '\n' + scope + '\n' + query;
+}
+
+bool KadasSearchCache::matches( const QString &matchText, const QString &query, Matching matching )
+{
+  if ( matching == Matching::Substring )
+  {
+    return matchText.contains( query, Qt::CaseInsensitive );
+  }
+  const QStringList textWords = KadasLocationIndex::normalize( matchText ).split( ' ', Qt::SkipEmptyParts );
+  const QStringList queryWords = KadasLocationIndex::normalize( query ).split( ' ', Qt::SkipEmptyParts );
+  for ( const QString &queryWord : queryWords )
+  {
+    if ( std::none_of( textWords.begin(), textWords.end(), [&queryWord]( const QString &word ) { return word.startsWith( queryWord ); } ) )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool KadasSearchCache::lookup( const QString &provider, const QString &query, const QString &scope, QList<QgsLocatorResult> &results )
+{
+  QString normalized = normalizeQuery( query );
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  QMutexLocker locker( &mMutex );
+
+  auto it = mEntries.constFind( entryKey( provider, normalized, scope ) );
+  if ( it != mEntries.constEnd() && it->expires > now )
+  {
+    results.clear();
+    for ( const Result &result : it->results )
+    {
+      results.append( result.result );
+    }
+    return true;
+  }
+
+  // Refine the complete results of a shorter query
+  for ( int len = normalized.length() - 1; len > 0; --len )
+  {
+    it = mEntries.constFind( entryKey( provider, normalized.left( len ), scope ) );
+    if ( it != mEntries.constEnd() && it->expires > now && it->complete )
+    {
+      results.clear();
+      for ( const Result &result : it->results )
+      {
+        if ( matches( result.matchText, normalized, it->matching ) )
+        {
+          results.append( result.result );
+        }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+void KadasSearchCache::insert( const QString &provider, const QString &query, const QString &scope, const QList<Result> &results, bool complete, Matching matching )
+{
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  qint64 ttl = QgsSettings().value( "search/cache_ttl_s", 300 ).toLongLong() * 1000;
+  QMutexLocker locker( &mMutex );
+
+  if ( mEntries.size() >= sMaxEntries )
+  {
+    // Drop expired entries, or else the one expiring first
+    for ( auto it = mEntries.begin(); it != mEntries.end(); )
+    {
+      it = it->expires <= now ? mEntries.erase( it ) : it + 1;
+    }
+    if ( mEntries.size() >= sMaxEntries )
+    {
+      mEntries.erase( std::min_element( mEntries.begin(), mEntries.end(), []( const Entry &a, const Entry &b ) { return a.expires < b.expires; } ) );
+    }
+  }
+  mEntries.insert( entryKey( provider, normalizeQuery( query ), scope ), Entry { results, complete, matching, now + ttl } );
+}
+
+void KadasSearchCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mEntries.clear();
+}
+
+bool KadasSearchCache::get( const QNetworkRequest &request, QgsFeedback *feedback, QByteArray &content, QString *errorMsg )
+{
+  QString key = request.url().toString();
+  std::shared_ptr<PendingRequest> pending;
+  bool leader = false;
+  {
+    QMutexLocker locker( &mMutex );
+    pending = mPendingRequests.value( key );
+    if ( !pending )
+    {
+      pending = std::make_shared<PendingRequest>();
+      mPendingRequests.insert( key, pending );
+      leader = true;
+    }
+  }
+
+  if ( leader )
+  {
+    QgsBlockingNetworkRequest bnr;
+    QgsBlockingNetworkRequest::ErrorCode errCode = bnr.get( request, false, feedback );
+    QMutexLocker locker( &mMutex );
+    pending->done = true;
+    pending->canceled = feedback && feedback->isCanceled();
+    pending->ok = errCode == QgsBlockingNetworkRequest::NoError && !pending->canceled;
+    pending->content = bnr.reply().content();
+    pending->errorMsg = bnr.errorMessage();
+    mPendingRequests.remove( key );
+    pending->finished.wakeAll();
+  }
+  else
+  {
+    QgsDebugMsgLevel( QString( "Sharing in-flight request %1" ).arg( key ), 2 );
+    QMutexLocker locker( &mMutex );
+    while ( !pending->done )
+    {
+      if ( feedback && feedback->isCanceled() )
+      {
+        return false;
+      }
+      pending->finished.wait( &mMutex, 50 );
+    }
+    if ( pending->canceled )
+    {
+      // The search which issued the request was canceled, issue our own
+      locker.unlock();
+      return get( request, feedback, content, errorMsg );
+    }
+  }
+  content = pending->content;
+  if ( errorMsg )
+  {
+    *errorMsg = pending->errorMsg;
+  }
+  return pending->ok;
+}
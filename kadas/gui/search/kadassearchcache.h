@@ -0,0 +1,101 @@
+/***************************************************************************
+    kadassearchcache.h
+    ------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASSEARCHCACHE_H
+#define KADASSEARCHCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <memory>
+
+#include <qgis/qgslocatorfilter.h>
+
+#include "kadas/gui/kadas_gui.h"
+
+#define SIP_NO_FILE
+
+class QNetworkRequest;
+class QgsFeedback;
+
+/**
+ * Result cache shared by the remote search providers, keyed by provider,
+ * normalized query and scope (i.e. the extent bucket), with a TTL.
+ * Queries extending a cached query whose results were complete (fewer than
+ * the result limit) are answered by filtering the cached results locally.
+ * Identical requests in flight are shared between the locator workers.
+ */
+class KADAS_GUI_EXPORT KadasSearchCache
+{
+  public:
+    enum class Matching
+    {
+      WordPrefix, //!< Every query word is the prefix of a word of the match text
+      Substring   //!< The match text contains the query
+    };
+    struct Result
+    {
+        QgsLocatorResult result;
+        //! Text the query is matched against when refining results locally
+        QString matchText;
+    };
+
+    static KadasSearchCache *instance();
+
+    //! Returns the extent grown to the bucket grid, requests for nearby extents share the same bucket
+    static QgsRectangle bucketExtent( const QgsRectangle &extent );
+    //! Returns the scope key of the bucket of the specified extent
+    static QString extentScope( const QgsRectangle &extent );
+    //! Waits for the debounce interval, returns false if the search was canceled meanwhile
+    static bool debounce( QgsFeedback *feedback );
+
+    //! Looks up the results for the query, returns false on a cache miss
+    bool lookup( const QString &provider, const QString &query, const QString &scope, QList<QgsLocatorResult> &results );
+    void insert( const QString &provider, const QString &query, const QString &scope, const QList<Result> &results, bool complete, Matching matching );
+    void clear();
+
+    //! Performs a blocking GET request, sharing the reply with identical requests already in flight
+    bool get( const QNetworkRequest &request, QgsFeedback *feedback, QByteArray &content, QString *errorMsg = nullptr );
+
+  private:
+    struct Entry
+    {
+        QList<Result> results;
+        bool complete = false;
+        Matching matching = Matching::WordPrefix;
+        qint64 expires = 0;
+    };
+    struct PendingRequest
+    {
+        bool done = false;
+        bool canceled = false;
+        bool ok = false;
+        QByteArray content;
+        QString errorMsg;
+        QWaitCondition finished;
+    };
+
+    QMutex mMutex;
+    QHash<QString, Entry> mEntries;
+    QHash<QString, std::shared_ptr<PendingRequest>> mPendingRequests;
+
+    static QString normalizeQuery( const QString &query );
+    static bool matches( const QString &matchText, const QString &query, Matching matching );
+    static QString entryKey( const QString &provider, const QString &query, const QString &scope );
+};
+
+#endif // KADASSEARCHCACHE_H
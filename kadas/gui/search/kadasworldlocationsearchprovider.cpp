@@ -24,7 +24,6 @@
 #include <qgis/qgsannotationlayer.h>
 #include <qgis/qgscoordinatetransform.h>
 #include <qgis/qgslogger.h>
-#include <qgis/qgsnetworkaccessmanager.h>
 #include <qgis/qgssettings.h>
 #include <qgis/qgsfeedback.h>
 #include <qgis/qgsmapcanvas.h>
@@ -40,6 +39,7 @@
 #include <qgis/qgscurve.h>
 #include <qgis/qgscurvepolygon.h>
 
+#include "kadas/gui/search/kadassearchcache.h"
 #include "kadas/gui/search/kadasworldlocationsearchprovider.h"
 
 
@@ -75,6 +75,22 @@ void KadasWorldLocationSearchProvider::fetchResults( const QString &string, cons
   if ( serviceUrl.isEmpty() )
     return;
 
+  KadasSearchCache *cache = KadasSearchCache::instance();
+  QString cacheProvider = name() + ":" + serviceUrl;
+  QList<QgsLocatorResult> cachedResults;
+  if ( cache->lookup( cacheProvider, string, QString(), cachedResults ) )
+  {
+    for ( const QgsLocatorResult &result : std::as_const( cachedResults ) )
+    {
+      emit resultFetched( result );
+    }
+    return;
+  }
+  if ( !KadasSearchCache::debounce( feedback ) )
+  {
+    return;
+  }
+
   QUrl url( serviceUrl );
   QUrlQuery query( url );
   query.removeAllQueryItems( "type" );
@@ -87,15 +103,16 @@ void KadasWorldLocationSearchProvider::fetchResults( const QString &string, cons
   {
     query.addQueryItem( "limit", QString::number( sResultCountLimit ) );
   }
+  // The results are only complete if fewer than the limit the server applied were returned
+  const int resultCountLimit = query.queryItemValue( "limit" ).toInt();
   url.setQuery( query );
 
   QNetworkRequest req( url );
   req.setRawHeader( "Referer", QgsSettings().value( "search/referer", "http://localhost" ).toByteArray() );
-  QgsNetworkReplyContent rep = QgsNetworkAccessManager::blockingGet( req, QString(), false, feedback );
-
-  if ( rep.error() == QNetworkReply::NoError )
+  QByteArray replyText;
+  QString errorMsg;
+  if ( cache->get( req, feedback, replyText, &errorMsg ) )
   {
-    QByteArray replyText = rep.content();
     QJsonParseError err;
     QJsonDocument doc = QJsonDocument::fromJson( replyText, &err );
     if ( doc.isNull() )
@@ -104,6 +121,7 @@ void KadasWorldLocationSearchProvider::fetchResults( const QString &string, cons
     }
     QJsonObject resultMap = doc.object();
     const QJsonArray constResults = resultMap["results"].toArray();
+    QList<KadasSearchCache::Result> results;
     for ( const QJsonValue &item : constResults )
     {
       QJsonObject itemMap = item.toObject();
@@ -136,12 +154,17 @@ void KadasWorldLocationSearchProvider::fetchResults( const QString &string, cons
         }
       }
       result.setUserData( resultData );
+      results.append( { result, itemAttrsMap.contains( "detail" ) ? itemAttrsMap["detail"].toString() : label } );
       emit resultFetched( result );
     }
+    if ( !feedback->isCanceled() )
+    {
+      cache->insert( cacheProvider, string, QString(), results, results.size() < resultCountLimit, KadasSearchCache::Matching::WordPrefix );
+    }
   }
-  else
+  else if ( !feedback->isCanceled() )
   {
-    QgsDebugMsgLevel( QString( "Could not fetch %1: %2" ).arg( url.toString(), rep.errorString() ), 1 );
+    QgsDebugMsgLevel( QString( "Could not fetch %1: %2" ).arg( url.toString(), errorMsg ), 1 );
   }
 }
 
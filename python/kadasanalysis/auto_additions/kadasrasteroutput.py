@@ -0,0 +1,9 @@
+# The following has been generated automatically from kadas/analysis/kadasrasteroutput.h
+try:
+    KadasRasterOutput.createDataset = staticmethod(KadasRasterOutput.createDataset)
+except AttributeError:
+    pass
+try:
+    KadasBuildOverviewsTask.start = staticmethod(KadasBuildOverviewsTask.start)
+except AttributeError:
+    pass
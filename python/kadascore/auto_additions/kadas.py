@@ -5,6 +5,7 @@ try:
     Kadas.pkgResourcePath = staticmethod(Kadas.pkgResourcePath)
     Kadas.projectTemplatesPath = staticmethod(Kadas.projectTemplatesPath)
     Kadas.gdalOpenForLayer = staticmethod(Kadas.gdalOpenForLayer)
+    Kadas.gdalOpenLayerSource = staticmethod(Kadas.gdalOpenLayerSource)
     Kadas.importSslCertificates = staticmethod(Kadas.importSslCertificates)
 except AttributeError:
     pass
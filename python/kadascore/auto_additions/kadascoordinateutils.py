@@ -1,6 +1,8 @@
 # The following has been generated automatically from kadas/core/kadascoordinateutils.h
 try:
     KadasCoordinateUtils.getHeightAtPos = staticmethod(KadasCoordinateUtils.getHeightAtPos)
+    KadasCoordinateUtils.getHeightsAtPos = staticmethod(KadasCoordinateUtils.getHeightsAtPos)
     KadasCoordinateUtils.getTimezoneAtPos = staticmethod(KadasCoordinateUtils.getTimezoneAtPos)
+    KadasCoordinateUtils.getTimezonesAtPos = staticmethod(KadasCoordinateUtils.getTimezonesAtPos)
 except AttributeError:
     pass
@@ -0,0 +1,5 @@
+# The following has been generated automatically from kadas/gui/search/kadaslocationindex.h
+try:
+    KadasLocationIndex.normalize = staticmethod(KadasLocationIndex.normalize)
+except AttributeError:
+    pass
@@ -0,0 +1,5 @@
+# The following has been generated automatically from kadas/gui/mapitems/kadaspictureitem.h
+try:
+    KadasPictureItem.createItems = staticmethod(KadasPictureItem.createItems)
+except AttributeError:
+    pass
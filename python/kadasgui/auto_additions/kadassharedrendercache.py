@@ -0,0 +1,8 @@
+# The following has been generated automatically from kadas/gui/kadassharedrendercache.h
+try:
+    KadasSharedRenderCache.canShare = staticmethod(KadasSharedRenderCache.canShare)
+    KadasSharedRenderCache.seed = staticmethod(KadasSharedRenderCache.seed)
+    KadasSharedRenderCache.stats = staticmethod(KadasSharedRenderCache.stats)
+    KadasSharedRenderCache.resetStats = staticmethod(KadasSharedRenderCache.resetStats)
+except AttributeError:
+    pass
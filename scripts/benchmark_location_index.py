@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+
+"""
+Measures the lookup latency of the offline location index through the KADAS
+python bindings (run with the KADAS python environment, e.g. from the KADAS
+python console or with PYTHONPATH pointing to the KADAS python directory).
+
+Queries are derived from the indexed labels (prefixes of increasing length,
+like typed in the search box) unless a query file is given.
+
+Usage: benchmark_location_index.py locations.kli [queries.txt]
+"""
+
+import random
+import re
+import statistics
+import sys
+import time
+
+from kadas.kadasgui import KadasLocationIndex
+
+TAG_RE = re.compile(r"<[^>]+>")
+
+
+def sample_queries(index, count):
+    labels = set()
+    for prefix in "abcdefghijklmnopqrstuvwxyz":
+        for result in index.search(prefix, 50):
+            labels.add(TAG_RE.sub("", result.label))
+    labels = sorted(labels)
+    random.seed(0)
+    queries = []
+    for label in random.sample(labels, min(count, len(labels))):
+        for length in range(3, min(len(label), 12) + 1):
+            queries.append(label[:length])
+    return queries
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    index = KadasLocationIndex(sys.argv[1])
+    if not index.isValid():
+        print("Invalid index %s" % sys.argv[1])
+        return 1
+    if len(sys.argv) > 2:
+        with open(sys.argv[2], encoding="utf-8") as fh:
+            queries = [line.strip() for line in fh if line.strip()]
+    else:
+        queries = sample_queries(index, 200)
+
+    timings = []
+    for query in queries:
+        start = time.perf_counter()
+        index.search(query, 50)
+        timings.append((time.perf_counter() - start) * 1000)
+    timings.sort()
+    print("%d locations, %d queries" % (index.entryCount(), len(timings)))
+    print("mean %.3f ms, median %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms" % (
+        statistics.mean(timings),
+        timings[len(timings) // 2],
+        timings[int(len(timings) * 0.95)],
+        timings[int(len(timings) * 0.99)],
+        timings[-1],
+    ))
+    return 0 if timings[int(len(timings) * 0.99)] < 10 else 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+
+"""
+Builds the offline location index read by KadasLocationIndex.
+
+The input are the locations served by the location search server, either as
+JSON lines (one location per line) or as JSON documents with a "results"
+array as returned by the SearchServer API. Each location is an object
+(optionally wrapped in "attrs") with the fields
+  origin, label, rank, lon, lat, and optionally detail, geom_st_box2d,
+  boundingBox (preferred over geom_st_box2d) and geometryGeoJSON.
+
+Usage: build_location_index.py -o locations.kli input.jsonl [input2.json ...]
+"""
+
+import argparse
+import json
+import math
+import re
+import struct
+import sys
+import unicodedata
+from collections import defaultdict
+
+MAGIC = b"KLOCIDX2"
+HEADER = struct.Struct("<8s4I7Q")
+ENTRY = struct.Struct("<4I4H6d")
+WORD = struct.Struct("<IHHI")
+TRIGRAM = struct.Struct("<3I")
+ORIGIN = struct.Struct("<2I")
+
+BOX_RE = re.compile(r"^BOX\s*\(\s*(-?\d+\.?\d*)\s+(-?\d+\.?\d*)\s*,\s*(-?\d+\.?\d*)\s+(-?\d+\.?\d*)\s*\)$", re.IGNORECASE)
+TAG_RE = re.compile(r"<[^>]+>")
+
+
+def normalize(text):
+    """Must match KadasLocationIndex::normalize"""
+    out = []
+    space = True
+    for c in unicodedata.normalize("NFKD", text).lower():
+        category = unicodedata.category(c)
+        if category == "Mn":
+            continue
+        if category[0] in "LN":
+            out.append(c)
+            space = False
+        elif not space:
+            out.append(" ")
+            space = True
+    return "".join(out).rstrip(" ")
+
+
+def read_locations(path):
+    with open(path, encoding="utf-8") as fh:
+        data = fh.read()
+    try:
+        doc = json.loads(data)
+        records = doc["results"] if isinstance(doc, dict) else doc
+    except json.JSONDecodeError:
+        records = [json.loads(line) for line in data.splitlines() if line.strip()]
+    for record in records:
+        yield record.get("attrs", record)
+
+
+def align(buf, alignment=8):
+    buf.extend(b"\0" * (-len(buf) % alignment))
+
+
+def build(paths, output):
+    strings = bytearray()
+    string_offsets = {}
+
+    def add_string(value):
+        data = value.encode("utf-8")
+        if data not in string_offsets:
+            string_offsets[data] = len(strings)
+            strings.extend(data)
+        return string_offsets[data], len(data)
+
+    origins = {}
+    entries = []
+    for path in paths:
+        for attrs in read_locations(path):
+            label = attrs.get("label", "")
+            detail = normalize(attrs.get("detail") or TAG_RE.sub("", label)).encode("utf-8")[:0xFFFF].decode("utf-8", "ignore")
+            origin = attrs.get("origin", "")
+            if origin not in origins:
+                origins[origin] = len(origins)
+            bbox = (math.nan,) * 4
+            match = BOX_RE.match(attrs.get("boundingBox") or attrs.get("geom_st_box2d") or "")
+            if match:
+                bbox = tuple(float(match.group(i)) for i in range(1, 5))
+            geometry = attrs.get("geometryGeoJSON")
+            geometry = json.dumps(geometry, separators=(",", ":")) if geometry else ""
+            # Ranks are stored as unsigned 16 bit values
+            rank = max(0, min(int(attrs.get("rank", 0)), 0xFFFF))
+            entries.append((label, detail, geometry, origins[origin], rank, float(attrs.get("lon", 0)), float(attrs.get("lat", 0)), bbox))
+
+    entry_data = bytearray()
+    words = []
+    postings = defaultdict(set)
+    for idx, (label, detail, geometry, origin, rank, lon, lat, bbox) in enumerate(entries):
+        label_offset, label_length = add_string(label[:0xFFFF])
+        detail_offset, detail_length = add_string(detail)
+        geometry_offset, geometry_length = add_string(geometry)
+        entry_data.extend(ENTRY.pack(label_offset, detail_offset, geometry_offset, geometry_length, label_length, detail_length, origin, rank, lon, lat, *bbox))
+        pos = 0
+        for word in detail.split(" "):
+            data = word.encode("utf-8")
+            if data:
+                words.append((data, detail_offset + pos, len(data), idx))
+                for i in range(len(data) - 2):
+                    postings[data[i:i + 3]].add(idx)
+            pos += len(data) + 1
+
+    words.sort(key=lambda w: (w[0], w[3]))
+    word_data = bytearray()
+    for _, offset, length, idx in words:
+        word_data.extend(WORD.pack(offset, length, 0, idx))
+
+    trigram_data = bytearray()
+    posting_data = bytearray()
+    for key in sorted(postings, key=lambda k: (k[0] << 16) | (k[1] << 8) | k[2]):
+        ids = sorted(postings[key])
+        trigram_data.extend(TRIGRAM.pack((key[0] << 16) | (key[1] << 8) | key[2], len(posting_data) // 4, len(ids)))
+        posting_data.extend(struct.pack("<%dI" % len(ids), *ids))
+
+    origin_data = bytearray()
+    for origin in sorted(origins, key=origins.get):
+        origin_data.extend(ORIGIN.pack(*add_string(origin)))
+
+    body = bytearray()
+    offsets = []
+    for section in (entry_data, word_data, trigram_data, posting_data, strings, origin_data):
+        align(body)
+        offsets.append(HEADER.size + len(body))
+        body.extend(section)
+    header = HEADER.pack(MAGIC, len(entries), len(words), len(trigram_data) // TRIGRAM.size, len(origins), *offsets, HEADER.size + len(body))
+
+    with open(output, "wb") as fh:
+        fh.write(header)
+        fh.write(body)
+    print("Wrote %d locations, %d words, %d trigrams to %s" % (len(entries), len(words), len(postings), output))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the KADAS offline location index")
+    parser.add_argument("-o", "--output", required=True, help="output index file (.kli)")
+    parser.add_argument("inputs", nargs="+", help="location data (JSON or JSON lines)")
+    args = parser.parse_args()
+    build(args.inputs, args.output)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,270 @@
+/***************************************************************************
+    kadasanalysisbench.cpp
+    ----------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cmath>
+#include <memory>
+
+#include <qgis/qgspoint.h>
+#include <qgis/qgsproject.h>
+#include <qgis/qgsrasterlayer.h>
+
+#include "kadas/analysis/kadashillshadefilter.h"
+#include "kadas/analysis/kadaslineofsight.h"
+#include "kadas/analysis/kadasslopefilter.h"
+#include "kadas/analysis/kadasviewshedfilter.h"
+#include "kadas/core/kadasheightmap.h"
+#include "tests/bench/kadasbench.h"
+#include "tests/bench/kadasbenchdem.h"
+
+// Size of the DEMs of the checks
+static constexpr int sCheckSize = 256;
+// Number of lines of sight per run
+static constexpr int sLineOfSightTargets = 64;
+
+
+static void setProjectHeightmap( const QgsRasterLayer *layer )
+{
+  QgsProject::instance()->writeEntry( "Heightmap", "layer", layer->id() );
+}
+
+static QString checkValue( const QString &what, double value, double expected, double tolerance )
+{
+  if ( std::isnan( value ) || std::fabs( value - expected ) > tolerance )
+  {
+    return QString( "%1 is %2, expected %3" ).arg( what ).arg( value ).arg( expected );
+  }
+  return QString();
+}
+
+// Outputs known analytically, on a flat plane, an inclined plane and a plane with a ridge
+static void registerChecks( KadasBench &bench )
+{
+  const QgsCoordinateReferenceSystem crs = KadasBenchDem::crs();
+  const double cellSize = KadasBenchDem::sCellSize;
+  const QgsPointXY center = KadasBenchDem::pixelCenter( sCheckSize / 2, sCheckSize / 2 );
+
+  bench.addCheck( "viewshed_flat_all_visible", [=] {
+    QgsRasterLayer *layer = KadasBenchDem::createLayer( "/vsimem/kadas_bench_flat.tif", sCheckSize, KadasBenchDem::terrain( sCheckSize, []( int, int ) { return 500.f; } ) );
+    QString output = "/vsimem/kadas_bench_check_viewshed_flat.tif";
+    QString errMsg;
+    if ( !layer || !KadasViewshedFilter::computeViewshed( layer, output, "GTiff", center, crs, 2, 0, true, true, -90, 90, 100 * cellSize, Qgis::DistanceUnit::Meters, nullptr, &errMsg ) )
+    {
+      return QString( "computation failed: %1" ).arg( errMsg );
+    }
+    int hidden = KadasBenchDem::count( output, 0 );
+    return hidden == 0 ? QString() : QString( "%1 pixels are hidden" ).arg( hidden );
+  } );
+
+  // Ridge of 200 m across all rows, the observer is left of it
+  auto ridge = []( int x, int ) { return x == 128 || x == 129 ? 700.f : 500.f; };
+  const QgsPointXY observer = KadasBenchDem::pixelCenter( 64, sCheckSize / 2 );
+  const QgsPointXY beforeRidge = KadasBenchDem::pixelCenter( 100, sCheckSize / 2 );
+  const QgsPointXY behindRidge = KadasBenchDem::pixelCenter( 180, sCheckSize / 2 );
+
+  bench.addCheck( "viewshed_ridge_hides", [=] {
+    QgsRasterLayer *layer = KadasBenchDem::createLayer( "/vsimem/kadas_bench_ridge.tif", sCheckSize, KadasBenchDem::terrain( sCheckSize, ridge ) );
+    QString output = "/vsimem/kadas_bench_check_viewshed_ridge.tif";
+    QString errMsg;
+    if ( !layer || !KadasViewshedFilter::computeViewshed( layer, output, "GTiff", observer, crs, 2, 0, true, true, -90, 90, 120 * cellSize, Qgis::DistanceUnit::Meters, nullptr, &errMsg ) )
+    {
+      return QString( "computation failed: %1" ).arg( errMsg );
+    }
+    QString error = checkValue( "Visibility before the ridge", KadasBenchDem::sample( output, beforeRidge ), 255, 0 );
+    return error.isEmpty() ? checkValue( "Visibility behind the ridge", KadasBenchDem::sample( output, behindRidge ), 0, 0 ) : error;
+  } );
+
+  bench.addCheck( "lineofsight_ridge_hides", [=] {
+    QgsRasterLayer *layer = KadasBenchDem::createLayer( "/vsimem/kadas_bench_ridge_los.tif", sCheckSize, KadasBenchDem::terrain( sCheckSize, ridge ) );
+    if ( !layer )
+    {
+      return QString( "computation failed" );
+    }
+    setProjectHeightmap( layer );
+    QgsPoint observerPos( observer.x(), observer.y(), 2 );
+    if ( !KadasLineOfSight::computeTargetVisibility( observerPos, QgsPoint( beforeRidge.x(), beforeRidge.y(), 2 ), crs, 1000 ) )
+    {
+      return QString( "Target before the ridge is hidden" );
+    }
+    if ( KadasLineOfSight::computeTargetVisibility( observerPos, QgsPoint( behindRidge.x(), behindRidge.y(), 2 ), crs, 1000 ) )
+    {
+      return QString( "Target behind the ridge is visible" );
+    }
+    return QString();
+  } );
+
+  bench.addCheck( "slope_inclined_plane", [=] {
+    // Rises by half a cell size per cell
+    QgsRasterLayer *layer = KadasBenchDem::createLayer( "/vsimem/kadas_bench_plane.tif", sCheckSize, KadasBenchDem::terrain( sCheckSize, [cellSize]( int x, int ) { return 500.f + 0.5f * cellSize * x; } ) );
+    QString output = "/vsimem/kadas_bench_check_slope.tif";
+    QString errMsg;
+    if ( !layer || KadasSlopeFilter( layer, output, "GTiff" ).processRaster( nullptr, errMsg ) != 0 )
+    {
+      return QString( "computation failed: %1" ).arg( errMsg );
+    }
+    return checkValue( "Slope", KadasBenchDem::sample( output, center ), std::atan( 0.5 ) * 180. / M_PI, 0.01 );
+  } );
+
+  bench.addCheck( "hillshade_flat", [=] {
+    QgsRasterLayer *layer = KadasBenchDem::createLayer( "/vsimem/kadas_bench_flat_hillshade.tif", sCheckSize, KadasBenchDem::terrain( sCheckSize, []( int, int ) { return 500.f; } ) );
+    QString output = "/vsimem/kadas_bench_check_hillshade.tif";
+    QString errMsg;
+    if ( !layer || KadasHillshadeFilter( layer, output, "GTiff", 300, 40 ).processRaster( nullptr, errMsg ) != 0 )
+    {
+      return QString( "computation failed: %1" ).arg( errMsg );
+    }
+    return checkValue( "Hillshade", KadasBenchDem::sample( output, center ), 255. * std::cos( 40. * M_PI / 180. ), 0.01 );
+  } );
+}
+
+void registerAnalysisBenchmarks( KadasBench &bench, const QList<int> &sizes )
+{
+  registerChecks( bench );
+  bench.addTeardown( &KadasBenchDem::cleanup );
+
+  const QgsCoordinateReferenceSystem crs = KadasBenchDem::crs();
+  const double cellSize = KadasBenchDem::sCellSize;
+  for ( int size : sizes )
+  {
+    // Shared by the benchmarks of this size, created by the first setup
+    std::shared_ptr<QgsRasterLayer *> layer = std::make_shared<QgsRasterLayer *>( nullptr );
+    auto setupLayer = [layer, size] {
+      if ( !*layer )
+      {
+        *layer = KadasBenchDem::createLayer( QString( "/vsimem/kadas_bench_fractal_%1.tif" ).arg( size ), size, KadasBenchDem::fractalTerrain( size, 1 ) );
+      }
+      return *layer != nullptr;
+    };
+    const QgsPointXY center = KadasBenchDem::pixelCenter( size / 2, size / 2 );
+    const double radius = 0.45 * size * cellSize;
+    const double viewshedPixels = std::pow( 2 * radius / cellSize, 2 );
+    const double observerHeight = 10;
+
+    bench.addBenchmark(
+      "viewshed", size, viewshedPixels, [=] {
+        QString output = QString( "/vsimem/kadas_bench_viewshed_%1.tif" ).arg( size );
+        QString errMsg;
+        if ( !KadasViewshedFilter::computeViewshed( *layer, output, "GTiff", center, crs, observerHeight, 0, true, true, -90, 90, radius, Qgis::DistanceUnit::Meters, nullptr, &errMsg ) )
+        {
+          return QByteArray();
+        }
+        return KadasBenchDem::digest( output );
+      },
+      setupLayer
+    );
+
+    // The computation alone, on a resident heightmap, at full and at reduced accuracy
+    for ( int accuracyFactor : { 1, 4 } )
+    {
+      std::shared_ptr<KadasViewshedFilter::Heightmap> heightmap = std::make_shared<KadasViewshedFilter::Heightmap>();
+      std::shared_ptr<KadasViewshedFilter::Parameters> params = std::make_shared<KadasViewshedFilter::Parameters>();
+      bench.addBenchmark(
+        QString( "viewshed_compute_accuracy%1" ).arg( accuracyFactor ), size, viewshedPixels / ( accuracyFactor * accuracyFactor ), [=] {
+          // Downscaling is part of the computation
+          heightmap->scaledData.clear();
+          KadasViewshedFilter::Result result;
+          QString errMsg;
+          if ( !KadasViewshedFilter::computeViewshed( *heightmap, *params, accuracyFactor, result, nullptr, &errMsg ) )
+          {
+            return QByteArray();
+          }
+          return KadasBench::digest( result.viewshed.constData(), result.viewshed.size() );
+        },
+        [=] {
+          QString errMsg;
+          if ( !setupLayer() || !KadasViewshedFilter::loadHeightmap( *layer, center, crs, radius, Qgis::DistanceUnit::Meters, *heightmap, nullptr, &errMsg ) )
+          {
+            return false;
+          }
+          *params = KadasViewshedFilter::heightmapParameters( *heightmap, center, crs, observerHeight, 0, true, true, -90, 90, radius, Qgis::DistanceUnit::Meters );
+          return true;
+        }
+      );
+    }
+
+    bench.addBenchmark(
+      "hillshade", size, size * size, [=] {
+        QString output = QString( "/vsimem/kadas_bench_hillshade_%1.tif" ).arg( size );
+        QString errMsg;
+        if ( KadasHillshadeFilter( *layer, output, "GTiff" ).processRaster( nullptr, errMsg ) != 0 )
+        {
+          return QByteArray();
+        }
+        return KadasBenchDem::digest( output );
+      },
+      setupLayer
+    );
+
+    bench.addBenchmark(
+      "slope", size, size * size, [=] {
+        QString output = QString( "/vsimem/kadas_bench_slope_%1.tif" ).arg( size );
+        QString errMsg;
+        if ( KadasSlopeFilter( *layer, output, "GTiff" ).processRaster( nullptr, errMsg ) != 0 )
+        {
+          return QByteArray();
+        }
+        return KadasBenchDem::digest( output );
+      },
+      setupLayer
+    );
+
+    // Lines of sight from the center to targets on a circle
+    QVector<QgsPointXY> targets;
+    for ( int i = 0; i < sLineOfSightTargets; ++i )
+    {
+      double angle = 2 * M_PI * i / sLineOfSightTargets;
+      targets.append( QgsPointXY( center.x() + radius * std::cos( angle ), center.y() + radius * std::sin( angle ) ) );
+    }
+    auto setupHeightmap = [layer, setupLayer] {
+      if ( !setupLayer() )
+      {
+        return false;
+      }
+      setProjectHeightmap( *layer );
+      return true;
+    };
+
+    bench.addBenchmark(
+      "lineofsight", size, sLineOfSightTargets, [=] {
+        QByteArray visible;
+        for ( const QgsPointXY &target : targets )
+        {
+          visible.append( KadasLineOfSight::computeTargetVisibility( QgsPoint( center.x(), center.y(), observerHeight ), QgsPoint( target.x(), target.y(), 2 ), crs, radius / cellSize ) ? '1' : '0' );
+        }
+        return KadasBench::digest( visible.constData(), visible.size() );
+      },
+      setupHeightmap
+    );
+
+    bench.addBenchmark(
+      "lineofsight_intersection", size, sLineOfSightTargets, [=] {
+        KadasHeightmap heightmap;
+        if ( !heightmap.isValid() )
+        {
+          return QByteArray();
+        }
+        // From high above the terrain down to below it, so that each ray hits the terrain
+        QVector<double> intersections;
+        for ( const QgsPointXY &target : targets )
+        {
+          QgsPoint hit = KadasLineOfSight::findTerrainIntersection( heightmap, QgsPoint( center.x(), center.y(), 5000 ), QgsPoint( target.x(), target.y(), -5000 ), crs, cellSize );
+          intersections << hit.x() << hit.y() << hit.z();
+        }
+        return KadasBench::digest( intersections.constData(), intersections.size() * sizeof( double ) );
+      },
+      setupHeightmap
+    );
+  }
+}
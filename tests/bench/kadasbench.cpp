@@ -0,0 +1,260 @@
+/***************************************************************************
+    kadasbench.cpp
+    --------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QThread>
+
+#include <algorithm>
+#include <cstdio>
+
+#include <gdal.h>
+
+#include <qgis/qgsapplication.h>
+
+#include "kadas/core/kadas.h"
+#include "tests/bench/kadasbench.h"
+
+
+void KadasBench::addBenchmark( const QString &name, int size, double workItems, const Function &run, const std::function<bool()> &setup )
+{
+  mBenchmarks.append( { name, size, workItems, run, setup } );
+}
+
+void KadasBench::addCheck( const QString &name, const Check &check )
+{
+  mChecks.append( qMakePair( name, check ) );
+}
+
+void KadasBench::addTeardown( const std::function<void()> &teardown )
+{
+  mTeardowns.append( teardown );
+}
+
+QByteArray KadasBench::digest( const void *data, qint64 size )
+{
+  return QCryptographicHash::hash( QByteArray::fromRawData( static_cast<const char *>( data ), size ), QCryptographicHash::Sha1 ).toHex();
+}
+
+int KadasBench::exec( const Options &options )
+{
+  bool failed = false;
+  QJsonObject golden = options.updateGolden ? QJsonObject() : readJson( options.goldenFile );
+  if ( golden.isEmpty() && !options.updateGolden )
+  {
+    if ( options.requireGolden )
+    {
+      fprintf( stderr, "No golden digests in %s, record them with --update-golden\n", qPrintable( options.goldenFile ) );
+      return 1;
+    }
+    fprintf( stderr, "No golden digests in %s, outputs are not compared\n", qPrintable( options.goldenFile ) );
+  }
+  QJsonObject baseline = readJson( options.baselineFile );
+
+  QJsonArray checkResults;
+  for ( const QPair<QString, Check> &check : std::as_const( mChecks ) )
+  {
+    if ( !check.first.contains( options.filter ) )
+    {
+      continue;
+    }
+    QString error = check.second();
+    fprintf( stderr, "check %-40s %s\n", qPrintable( check.first ), error.isEmpty() ? "ok" : qPrintable( "FAILED: " + error ) );
+    failed |= !error.isEmpty();
+    checkResults.append( QJsonObject { { "name", check.first }, { "passed", error.isEmpty() }, { "message", error } } );
+  }
+
+  QJsonArray benchmarkResults;
+  QJsonObject newGolden;
+  for ( const Benchmark &benchmark : std::as_const( mBenchmarks ) )
+  {
+    if ( !benchmark.name.contains( options.filter ) )
+    {
+      continue;
+    }
+    QString key = QString( "%1@%2" ).arg( benchmark.name ).arg( benchmark.size );
+    if ( benchmark.setup && !benchmark.setup() )
+    {
+      fprintf( stderr, "bench %-40s FAILED: setup failed\n", qPrintable( key ) );
+      failed = true;
+      continue;
+    }
+
+    QList<double> timings;
+    QByteArray digest;
+    QString error;
+    for ( int i = 0; i < options.repetitions && error.isEmpty(); ++i )
+    {
+      QElapsedTimer timer;
+      timer.start();
+      QByteArray runDigest = benchmark.run();
+      timings.append( timer.nsecsElapsed() / 1E6 );
+      if ( runDigest.isEmpty() )
+      {
+        error = "computation failed";
+      }
+      else if ( !digest.isEmpty() && runDigest != digest )
+      {
+        error = "output differs between repetitions";
+      }
+      digest = runDigest;
+    }
+    if ( error.isEmpty() && golden.contains( key ) && golden[key].toString().toLatin1() != digest )
+    {
+      error = QString( "output differs from golden digest %1" ).arg( golden[key].toString() );
+    }
+    newGolden[key] = QString::fromLatin1( digest );
+
+    std::sort( timings.begin(), timings.end() );
+    double median = timings[timings.size() / 2];
+    QJsonObject result {
+      { "name", benchmark.name },
+      { "size", benchmark.size },
+      { "repetitions", timings.size() },
+      { "min_ms", timings.front() },
+      { "median_ms", median },
+      { "throughput", benchmark.workItems / median * 1000. },
+      { "digest", QString::fromLatin1( digest ) },
+      { "passed", error.isEmpty() }
+    };
+    benchmarkResults.append( result );
+
+    QString comparison;
+    for ( const QJsonValue &value : baseline["benchmarks"].toArray() )
+    {
+      QJsonObject base = value.toObject();
+      if ( base["name"].toString() == benchmark.name && base["size"].toInt() == benchmark.size )
+      {
+        comparison = QString( " (%1x baseline)" ).arg( base["median_ms"].toDouble() / median, 0, 'f', 2 );
+      }
+    }
+    fprintf( stderr, "bench %-40s %10.3f ms%s %s\n", qPrintable( key ), median, qPrintable( comparison ), error.isEmpty() ? "" : qPrintable( "FAILED: " + error ) );
+    failed |= !error.isEmpty();
+  }
+
+  for ( const std::function<void()> &teardown : std::as_const( mTeardowns ) )
+  {
+    teardown();
+  }
+
+  if ( options.updateGolden && !writeJson( options.goldenFile, newGolden ) )
+  {
+    fprintf( stderr, "Failed to write golden digests to %s\n", qPrintable( options.goldenFile ) );
+    failed = true;
+  }
+
+  QJsonObject output {
+    { "version", Kadas::KADAS_FULL_RELEASE_NAME },
+    { "timestamp", QDateTime::currentDateTimeUtc().toString( Qt::ISODate ) },
+    { "threads", QThread::idealThreadCount() },
+    { "checks", checkResults },
+    { "benchmarks", benchmarkResults }
+  };
+  if ( !options.outputFile.isEmpty() && !writeJson( options.outputFile, output ) )
+  {
+    fprintf( stderr, "Failed to write results to %s\n", qPrintable( options.outputFile ) );
+    failed = true;
+  }
+  else if ( options.outputFile.isEmpty() )
+  {
+    printf( "%s", QJsonDocument( output ).toJson().constData() );
+  }
+  return failed ? 1 : 0;
+}
+
+QJsonObject KadasBench::readJson( const QString &fileName )
+{
+  QFile file( fileName );
+  if ( fileName.isEmpty() || !file.open( QIODevice::ReadOnly ) )
+  {
+    return QJsonObject();
+  }
+  return QJsonDocument::fromJson( file.readAll() ).object();
+}
+
+bool KadasBench::writeJson( const QString &fileName, const QJsonObject &json )
+{
+  QFile file( fileName );
+  if ( !file.open( QIODevice::WriteOnly ) )
+  {
+    return false;
+  }
+  file.write( QJsonDocument( json ).toJson() );
+  return true;
+}
+
+
+int main( int argc, char *argv[] )
+{
+  QgsApplication app( argc, argv, false );
+  QgsApplication::initQgis();
+  GDALAllRegister();
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription( "Benchmarks and regression checks of the KADAS libraries" );
+  parser.addHelpOption();
+  QCommandLineOption outputOption( { "o", "output" }, "Write the results as JSON to <file> instead of stdout.", "file" );
+  QCommandLineOption repetitionsOption( { "r", "repetitions" }, "Timed runs per benchmark.", "n", "5" );
+  QCommandLineOption sizesOption( "sizes", "Comma separated problem sizes, i.e. DEM and image edge lengths in pixels.", "sizes", "512,2048" );
+  QCommandLineOption filterOption( "filter", "Only run benchmarks and checks matching <regexp>.", "regexp" );
+  QCommandLineOption goldenOption( "golden", "Golden output digests.", "file", KADAS_BENCH_GOLDEN );
+  QCommandLineOption updateGoldenOption( "update-golden", "Record the output digests as golden digests." );
+  QCommandLineOption baselineOption( "baseline", "Results of a previous run to compare the timings against.", "file" );
+  QCommandLineOption checkOption( "check", "Quick regression run: a single repetition at the smallest size." );
+  parser.addOptions( { outputOption, repetitionsOption, sizesOption, filterOption, goldenOption, updateGoldenOption, baselineOption, checkOption } );
+  parser.process( app );
+
+  KadasBench::Options options;
+  options.repetitions = std::max( 1, parser.value( repetitionsOption ).toInt() );
+  options.filter = QRegularExpression( parser.value( filterOption ) );
+  options.outputFile = parser.value( outputOption );
+  options.goldenFile = parser.value( goldenOption );
+  options.updateGolden = parser.isSet( updateGoldenOption );
+  options.baselineFile = parser.value( baselineOption );
+
+  QList<int> sizes;
+  for ( const QString &size : parser.value( sizesOption ).split( ',', Qt::SkipEmptyParts ) )
+  {
+    sizes.append( size.toInt() );
+  }
+  if ( sizes.isEmpty() || *std::min_element( sizes.begin(), sizes.end() ) <= 0 )
+  {
+    fprintf( stderr, "--sizes must list one or more positive sizes\n" );
+    QgsApplication::exitQgis();
+    return 1;
+  }
+  if ( parser.isSet( checkOption ) )
+  {
+    options.repetitions = 1;
+    options.requireGolden = true;
+    sizes = { *std::min_element( sizes.begin(), sizes.end() ) };
+  }
+
+  KadasBench bench;
+  registerAnalysisBenchmarks( bench, sizes );
+  registerLatLonToUTMBenchmarks( bench, sizes );
+  registerItemLayerBenchmarks( bench, sizes );
+  registerProjectMigrationBenchmarks( bench, sizes );
+  int result = bench.exec( options );
+
+  QgsApplication::exitQgis();
+  return result;
+}
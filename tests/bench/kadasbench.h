@@ -0,0 +1,92 @@
+/***************************************************************************
+    kadasbench.h
+    ------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASBENCH_H
+#define KADASBENCH_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QRegularExpression>
+#include <QString>
+
+#include <functional>
+
+/**
+ * Minimal benchmark and regression harness.
+ *
+ * Benchmarks are run repeatedly and their timings are reported as JSON. Each
+ * benchmark returns a digest of its output, which must be identical for all
+ * repetitions and is compared against the recorded golden digests. Checks
+ * verify outputs which are known analytically, and run alongside.
+ */
+class KadasBench
+{
+  public:
+    //! Runs the computation once and returns a digest of its output, or an empty digest on failure
+    typedef std::function<QByteArray()> Function;
+    //! Verifies an output, returns an empty string on success or a description of the failure
+    typedef std::function<QString()> Check;
+
+    struct Options
+    {
+        int repetitions = 5;
+        QRegularExpression filter;
+        QString outputFile;
+        QString goldenFile;
+        //! Fail if there are no golden digests to compare the outputs against
+        bool requireGolden = false;
+        bool updateGolden = false;
+        QString baselineFile;
+    };
+
+    //! Adds a benchmark. Setup runs once before the timed repetitions, workItems is the amount of work per run (i.e. pixels) used to report the throughput
+    void addBenchmark( const QString &name, int size, double workItems, const Function &run, const std::function<bool()> &setup = nullptr );
+    //! Adds a correctness check
+    void addCheck( const QString &name, const Check &check );
+    //! Adds a teardown, run once all benchmarks and checks ran, i.e. to free what their setups created
+    void addTeardown( const std::function<void()> &teardown );
+
+    //! Runs all benchmarks and checks matching the filter, returns the process exit code
+    int exec( const Options &options );
+
+    //! Digest of a block of memory
+    static QByteArray digest( const void *data, qint64 size );
+
+  private:
+    struct Benchmark
+    {
+        QString name;
+        int size = 0;
+        double workItems = 0;
+        Function run;
+        std::function<bool()> setup;
+    };
+    QList<Benchmark> mBenchmarks;
+    QList<QPair<QString, Check>> mChecks;
+    QList<std::function<void()>> mTeardowns;
+
+    static QJsonObject readJson( const QString &fileName );
+    static bool writeJson( const QString &fileName, const QJsonObject &json );
+};
+
+// Benchmark suites, each registers its benchmarks for the specified problem sizes
+void registerAnalysisBenchmarks( KadasBench &bench, const QList<int> &sizes );
+void registerLatLonToUTMBenchmarks( KadasBench &bench, const QList<int> &sizes );
+void registerItemLayerBenchmarks( KadasBench &bench, const QList<int> &sizes );
+void registerProjectMigrationBenchmarks( KadasBench &bench, const QList<int> &sizes );
+
+#endif // KADASBENCH_H
@@ -0,0 +1,251 @@
+/***************************************************************************
+    kadasbenchdem.cpp
+    -----------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <cpl_string.h>
+#include <cpl_vsi.h>
+#include <gdal.h>
+
+#include <qgis/qgsproject.h>
+#include <qgis/qgsrasterlayer.h>
+
+#include "tests/bench/kadasbench.h"
+#include "tests/bench/kadasbenchdem.h"
+
+// Top left corner of the DEMs
+static const QgsPointXY sOrigin( 2600000, 1200000 );
+// Prefix of the DEMs and outputs of the benchmarks
+static const QString sFilePrefix = QStringLiteral( "/vsimem/kadas_bench_" );
+
+
+QgsCoordinateReferenceSystem KadasBenchDem::crs()
+{
+  return QgsCoordinateReferenceSystem( "EPSG:2056" );
+}
+
+QgsPointXY KadasBenchDem::pixelCenter( double x, double y )
+{
+  return QgsPointXY( sOrigin.x() + ( x + 0.5 ) * sCellSize, sOrigin.y() - ( y + 0.5 ) * sCellSize );
+}
+
+QVector<float> KadasBenchDem::fractalTerrain( int size, unsigned int seed, double roughness, double amplitude )
+{
+  // Diamond-square on the smallest 2^n + 1 grid covering the DEM
+  int n = 1;
+  while ( n < size )
+  {
+    n *= 2;
+  }
+  int dim = n + 1;
+  QVector<float> grid( dim * dim, 0.f );
+  auto at = [&grid, dim]( int x, int y ) -> float & { return grid[y * dim + x]; };
+
+  // The mt19937 sequence is standardized, unlike the standard distributions
+  std::mt19937 rng( seed );
+  auto random = [&rng] { return rng() / double( std::mt19937::max() ) * 2. - 1.; };
+
+  double scale = amplitude;
+  at( 0, 0 ) = amplitude + scale * random();
+  at( n, 0 ) = amplitude + scale * random();
+  at( 0, n ) = amplitude + scale * random();
+  at( n, n ) = amplitude + scale * random();
+  for ( int step = n; step > 1; step /= 2 )
+  {
+    int half = step / 2;
+    scale *= roughness;
+    // Diamond step
+    for ( int y = half; y < dim; y += step )
+    {
+      for ( int x = half; x < dim; x += step )
+      {
+        at( x, y ) = ( at( x - half, y - half ) + at( x + half, y - half ) + at( x - half, y + half ) + at( x + half, y + half ) ) / 4. + scale * random();
+      }
+    }
+    // Square step
+    for ( int y = 0; y < dim; y += half )
+    {
+      for ( int x = ( y + half ) % step; x < dim; x += step )
+      {
+        double sum = 0;
+        int count = 0;
+        if ( x >= half )
+        {
+          sum += at( x - half, y );
+          ++count;
+        }
+        if ( x + half < dim )
+        {
+          sum += at( x + half, y );
+          ++count;
+        }
+        if ( y >= half )
+        {
+          sum += at( x, y - half );
+          ++count;
+        }
+        if ( y + half < dim )
+        {
+          sum += at( x, y + half );
+          ++count;
+        }
+        at( x, y ) = sum / count + scale * random();
+      }
+    }
+  }
+  return terrain( size, [&at]( int x, int y ) { return at( x, y ); } );
+}
+
+QVector<float> KadasBenchDem::terrain( int size, const std::function<float( int x, int y )> &height )
+{
+  QVector<float> heights( size * size );
+  for ( int y = 0; y < size; ++y )
+  {
+    for ( int x = 0; x < size; ++x )
+    {
+      heights[y * size + x] = height( x, y );
+    }
+  }
+  return heights;
+}
+
+bool KadasBenchDem::write( const QString &path, int size, const QVector<float> &heights )
+{
+  GDALDriverH driver = GDALGetDriverByName( "GTiff" );
+  GDALDatasetH dataset = GDALCreate( driver, path.toUtf8().constData(), size, size, 1, GDT_Float32, nullptr );
+  if ( !dataset )
+  {
+    return false;
+  }
+  double gtrans[6] = { sOrigin.x(), sCellSize, 0, sOrigin.y(), 0, -sCellSize };
+  GDALSetGeoTransform( dataset, gtrans );
+  GDALSetProjection( dataset, crs().toWkt().toLocal8Bit().data() );
+  GDALRasterBandH band = GDALGetRasterBand( dataset, 1 );
+  GDALSetRasterNoDataValue( band, sNoDataValue );
+  CPLErr err = GDALRasterIO( band, GF_Write, 0, 0, size, size, const_cast<float *>( heights.constData() ), size, size, GDT_Float32, 0, 0 );
+  GDALClose( dataset );
+  return err == CE_None;
+}
+
+QgsRasterLayer *KadasBenchDem::createLayer( const QString &path, int size, const QVector<float> &heights )
+{
+  if ( !write( path, size, heights ) )
+  {
+    return nullptr;
+  }
+  QgsRasterLayer *layer = new QgsRasterLayer( path, QFileInfo( path ).baseName(), "gdal" );
+  if ( !layer->isValid() )
+  {
+    delete layer;
+    return nullptr;
+  }
+  QgsProject::instance()->addMapLayer( layer, false );
+  return layer;
+}
+
+void KadasBenchDem::cleanup()
+{
+  QList<QgsMapLayer *> layers;
+  const QList<QgsRasterLayer *> rasterLayers = QgsProject::instance()->layers<QgsRasterLayer *>();
+  for ( QgsRasterLayer *layer : rasterLayers )
+  {
+    if ( layer->source().startsWith( sFilePrefix ) )
+    {
+      layers.append( layer );
+    }
+  }
+  QgsProject::instance()->removeMapLayers( layers );
+
+  char **files = VSIReadDir( "/vsimem/" );
+  for ( int i = 0, n = CSLCount( files ); i < n; ++i )
+  {
+    QString path = QString( "/vsimem/%1" ).arg( QString::fromUtf8( files[i] ) );
+    if ( path.startsWith( sFilePrefix ) )
+    {
+      VSIUnlink( path.toUtf8().constData() );
+    }
+  }
+  CSLDestroy( files );
+}
+
+QByteArray KadasBenchDem::digest( const QString &path )
+{
+  GDALDatasetH dataset = GDALOpen( path.toUtf8().constData(), GA_ReadOnly );
+  if ( !dataset )
+  {
+    return QByteArray();
+  }
+  GDALRasterBandH band = GDALGetRasterBand( dataset, 1 );
+  int width = GDALGetRasterXSize( dataset );
+  int height = GDALGetRasterYSize( dataset );
+  GDALDataType type = GDALGetRasterDataType( band );
+  QByteArray data( width * height * GDALGetDataTypeSizeBytes( type ), Qt::Uninitialized );
+  CPLErr err = GDALRasterIO( band, GF_Read, 0, 0, width, height, data.data(), width, height, type, 0, 0 );
+  double gtrans[6] = {};
+  GDALGetGeoTransform( dataset, gtrans );
+  GDALClose( dataset );
+  if ( err != CE_None )
+  {
+    return QByteArray();
+  }
+  // The georeferencing is part of the output
+  data.append( reinterpret_cast<const char *>( gtrans ), sizeof( gtrans ) );
+  return KadasBench::digest( data.constData(), data.size() );
+}
+
+double KadasBenchDem::sample( const QString &path, const QgsPointXY &pos )
+{
+  double value = std::numeric_limits<double>::quiet_NaN();
+  GDALDatasetH dataset = GDALOpen( path.toUtf8().constData(), GA_ReadOnly );
+  if ( !dataset )
+  {
+    return value;
+  }
+  double gtrans[6] = {};
+  GDALGetGeoTransform( dataset, gtrans );
+  int x = static_cast<int>( std::floor( ( pos.x() - gtrans[0] ) / gtrans[1] ) );
+  int y = static_cast<int>( std::floor( ( pos.y() - gtrans[3] ) / gtrans[5] ) );
+  if ( x >= 0 && y >= 0 && x < GDALGetRasterXSize( dataset ) && y < GDALGetRasterYSize( dataset ) )
+  {
+    double pixel = 0;
+    if ( GDALRasterIO( GDALGetRasterBand( dataset, 1 ), GF_Read, x, y, 1, 1, &pixel, 1, 1, GDT_Float64, 0, 0 ) == CE_None )
+    {
+      value = pixel;
+    }
+  }
+  GDALClose( dataset );
+  return value;
+}
+
+int KadasBenchDem::count( const QString &path, double value )
+{
+  GDALDatasetH dataset = GDALOpen( path.toUtf8().constData(), GA_ReadOnly );
+  if ( !dataset )
+  {
+    return -1;
+  }
+  int width = GDALGetRasterXSize( dataset );
+  int height = GDALGetRasterYSize( dataset );
+  QVector<double> data( width * height );
+  CPLErr err = GDALRasterIO( GDALGetRasterBand( dataset, 1 ), GF_Read, 0, 0, width, height, data.data(), width, height, GDT_Float64, 0, 0 );
+  GDALClose( dataset );
+  return err == CE_None ? static_cast<int>( std::count( data.begin(), data.end(), value ) ) : -1;
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+    kadasbenchdem.h
+    ---------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KADASBENCHDEM_H
+#define KADASBENCHDEM_H
+
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+#include <qgis/qgscoordinatereferencesystem.h>
+#include <qgis/qgspointxy.h>
+
+class QgsRasterLayer;
+
+/**
+ * Synthetic elevation models in GDAL /vsimem/ files. The DEMs are square,
+ * in LV95 with a fixed origin, so that geographic positions can be derived
+ * from pixel positions.
+ */
+class KadasBenchDem
+{
+  public:
+    static constexpr double sCellSize = 10.;
+    static constexpr float sNoDataValue = -9999.f;
+
+    //! Returns the CRS of the DEMs
+    static QgsCoordinateReferenceSystem crs();
+    //! Returns the position of the center of pixel (x, y)
+    static QgsPointXY pixelCenter( double x, double y );
+
+    //! Fractal terrain generated with the diamond-square algorithm, identical for a given seed on all platforms
+    static QVector<float> fractalTerrain( int size, unsigned int seed, double roughness = 0.55, double amplitude = 1000. );
+    //! Samples the height function at every pixel
+    static QVector<float> terrain( int size, const std::function<float( int x, int y )> &height );
+
+    //! Writes the heights to a Float32 GeoTIFF at path
+    static bool write( const QString &path, int size, const QVector<float> &heights );
+    //! Writes the heights to a GeoTIFF at path and returns a raster layer for it, owned by the project
+    static QgsRasterLayer *createLayer( const QString &path, int size, const QVector<float> &heights );
+    //! Removes the layers created by createLayer from the project and deletes all /vsimem/kadas_bench_* files
+    static void cleanup();
+
+    //! Digest of band 1 of the raster at path, empty if it cannot be read
+    static QByteArray digest( const QString &path );
+    //! Value of band 1 of the raster at path at the specified position, NaN if it cannot be read
+    static double sample( const QString &path, const QgsPointXY &pos );
+    //! Counts the pixels of band 1 of the raster at path having the specified value, -1 if it cannot be read
+    static int count( const QString &path, double value );
+};
+
+#endif // KADASBENCHDEM_H
@@ -0,0 +1,203 @@
+/***************************************************************************
+    kadasitemlayerbench.cpp
+    -----------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QImage>
+#include <QPainter>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <random>
+
+#include <qgis/qgslinestring.h>
+#include <qgis/qgsmaplayerrenderer.h>
+#include <qgis/qgsmapsettings.h>
+#include <qgis/qgspoint.h>
+#include <qgis/qgspolygon.h>
+#include <qgis/qgsproject.h>
+#include <qgis/qgsrendercontext.h>
+
+#include "kadas/gui/kadasitemlayer.h"
+#include "kadas/gui/mapitems/kadaslineitem.h"
+#include "kadas/gui/mapitems/kadaspointitem.h"
+#include "kadas/gui/mapitems/kadaspolygonitem.h"
+#include "tests/bench/kadasbench.h"
+#include "tests/bench/kadasbenchdem.h"
+
+// Number of items, above the threshold for rendering in parallel bands
+static constexpr int sItemCount = 5000;
+// Edge length of the rendered extent in meters
+static constexpr double sExtentSize = 10000.;
+// Image size of the check
+static constexpr int sCheckSize = 512;
+
+
+static QgsRectangle itemExtent()
+{
+  QgsPointXY origin = KadasBenchDem::pixelCenter( 0, 0 );
+  return QgsRectangle( origin.x(), origin.y() - sExtentSize, origin.x() + sExtentSize, origin.y() );
+}
+
+// Random points, lines and polygons, identical for a given seed on all platforms
+static KadasItemLayer *createItemLayer()
+{
+  KadasItemLayer *layer = new KadasItemLayer( "kadas_bench_items", KadasBenchDem::crs() );
+  const QgsRectangle extent = itemExtent();
+  std::mt19937 rng( 1 );
+  auto random = [&rng]( double min, double max ) { return min + rng() / double( std::mt19937::max() ) * ( max - min ); };
+  for ( int i = 0; i < sItemCount; ++i )
+  {
+    QgsPoint center( random( extent.xMinimum(), extent.xMaximum() ), random( extent.yMinimum(), extent.yMaximum() ) );
+    switch ( i % 3 )
+    {
+      case 0:
+      {
+        KadasPointItem *item = new KadasPointItem( layer->crs() );
+        item->addPartFromGeometry( center );
+        layer->addItem( item );
+        break;
+      }
+      case 1:
+      {
+        QgsLineString line;
+        QgsPoint p = center;
+        for ( int j = 0; j < 5; ++j )
+        {
+          line.addVertex( p );
+          p = QgsPoint( p.x() + random( -300, 300 ), p.y() + random( -300, 300 ) );
+        }
+        KadasLineItem *item = new KadasLineItem( layer->crs() );
+        item->addPartFromGeometry( line );
+        layer->addItem( item );
+        break;
+      }
+      case 2:
+      {
+        QgsLineString ring;
+        for ( int j = 0; j < 6; ++j )
+        {
+          double angle = 2 * M_PI * j / 6;
+          double radius = random( 50, 300 );
+          ring.addVertex( QgsPoint( center.x() + radius * std::cos( angle ), center.y() + radius * std::sin( angle ) ) );
+        }
+        ring.close();
+        QgsPolygon polygon;
+        polygon.setExteriorRing( ring.clone() );
+        KadasPolygonItem *item = new KadasPolygonItem( layer->crs() );
+        item->addPartFromGeometry( polygon );
+        layer->addItem( item );
+        break;
+      }
+    }
+  }
+  QgsProject::instance()->addMapLayer( layer, false );
+  return layer;
+}
+
+// Renders the layer with at most the specified number of pool threads, a single thread renders serially
+static QImage renderItemLayer( KadasItemLayer *layer, int size, int threads )
+{
+  QThreadPool *pool = QThreadPool::globalInstance();
+  int maxThreadCount = pool->maxThreadCount();
+  pool->setMaxThreadCount( threads );
+
+  QgsMapSettings settings;
+  settings.setDestinationCrs( layer->crs() );
+  settings.setOutputSize( QSize( size, size ) );
+  settings.setOutputDpi( 96 );
+  settings.setExtent( itemExtent() );
+
+  QImage image( size, size, QImage::Format_ARGB32_Premultiplied );
+  image.fill( Qt::transparent );
+  QPainter painter( &image );
+  painter.setRenderHint( QPainter::Antialiasing );
+  QgsRenderContext context = QgsRenderContext::fromMapSettings( settings );
+  context.setPainter( &painter );
+  context.setCoordinateTransform( QgsCoordinateTransform( layer->crs(), settings.destinationCrs(), settings.transformContext() ) );
+  // Bands are laid out when the renderer is created
+  std::unique_ptr<QgsMapLayerRenderer> renderer( layer->createMapRenderer( context ) );
+  renderer->render();
+  renderer.reset();
+  painter.end();
+
+  pool->setMaxThreadCount( maxThreadCount );
+  return image;
+}
+
+static QByteArray imageDigest( const QImage &image )
+{
+  return KadasBench::digest( image.constBits(), image.sizeInBytes() );
+}
+
+void registerItemLayerBenchmarks( KadasBench &bench, const QList<int> &sizes )
+{
+  // Shared by all benchmarks, created by the first setup
+  std::shared_ptr<KadasItemLayer *> layer = std::make_shared<KadasItemLayer *>( nullptr );
+  auto setup = [layer] {
+    if ( !*layer )
+    {
+      *layer = createItemLayer();
+    }
+    return true;
+  };
+  bench.addTeardown( [layer] {
+    if ( *layer )
+    {
+      QgsProject::instance()->removeMapLayer( *layer );
+      *layer = nullptr;
+    }
+  } );
+
+  // Parallel bands must paint exactly the pixels of serial painting
+  bench.addCheck( "itemlayer_bands_match_serial", [=] {
+    setup();
+    QImage serial = renderItemLayer( *layer, sCheckSize, 1 );
+    QImage parallel = renderItemLayer( *layer, sCheckSize, std::max( 4, QThread::idealThreadCount() ) );
+    if ( serial.isNull() || parallel.isNull() || serial.size() != parallel.size() )
+    {
+      return QString( "rendering failed" );
+    }
+    int differing = 0;
+    for ( int y = 0; y < serial.height(); ++y )
+    {
+      const QRgb *serialLine = reinterpret_cast<const QRgb *>( serial.constScanLine( y ) );
+      const QRgb *parallelLine = reinterpret_cast<const QRgb *>( parallel.constScanLine( y ) );
+      differing += static_cast<int>( std::inner_product( serialLine, serialLine + serial.width(), parallelLine, 0, std::plus<>(), std::not_equal_to<>() ) );
+    }
+    return differing == 0 ? QString() : QString( "%1 pixels differ from serial rendering" ).arg( differing );
+  } );
+
+  // Scaling with the number of threads, the output is the same for all thread counts
+  QList<int> threadCounts { 1, 2, 4, QThread::idealThreadCount() };
+  std::sort( threadCounts.begin(), threadCounts.end() );
+  threadCounts.erase( std::unique( threadCounts.begin(), threadCounts.end() ), threadCounts.end() );
+  for ( int size : sizes )
+  {
+    for ( int threads : std::as_const( threadCounts ) )
+    {
+      bench.addBenchmark(
+        QString( "itemlayer_render_threads%1" ).arg( threads ), size, sItemCount, [=] {
+          return imageDigest( renderItemLayer( *layer, size, threads ) );
+        },
+        setup
+      );
+    }
+  }
+}
@@ -0,0 +1,241 @@
+/***************************************************************************
+    kadaslatlontoutmbench.cpp
+    -------------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QString>
+#include <QVector>
+
+#include <cmath>
+#include <memory>
+#include <random>
+
+#include <qgis/qgspointxy.h>
+#include <qgis/qgsrectangle.h>
+
+#include "kadas/core/kadaslatlontoutm.h"
+#include "tests/bench/kadasbench.h"
+
+// Number of points of the parity check, above the chunk size of the batch conversions
+static constexpr int sCheckPoints = 100000;
+
+struct Positions
+{
+    QVector<double> lon;
+    QVector<double> lat;
+    QVector<double> easting;
+    QVector<double> northing;
+    QVector<int> zoneNumbers;
+    QVector<char> zoneLetters;
+};
+
+// Random positions within the UTM latitude band, and their UTM coordinates truncated to whole meters like UTMCoo
+static void createPositions( int count, Positions &positions )
+{
+  std::mt19937 rng( 1 );
+  auto random = [&rng]( double min, double max ) { return min + rng() / double( std::mt19937::max() ) * ( max - min ); };
+  positions.lon.resize( count );
+  positions.lat.resize( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    positions.lon[i] = random( -180, 180 );
+    positions.lat[i] = random( -80, 84 );
+  }
+  positions.easting.resize( count );
+  positions.northing.resize( count );
+  positions.zoneNumbers.resize( count );
+  positions.zoneLetters.resize( count );
+  KadasLatLonToUTM::LL2UTM( positions.lon.constData(), positions.lat.constData(), count, positions.easting.data(), positions.northing.data(), positions.zoneNumbers.data(), positions.zoneLetters.data() );
+  for ( int i = 0; i < count; ++i )
+  {
+    positions.easting[i] = std::trunc( positions.easting[i] );
+    positions.northing[i] = std::trunc( positions.northing[i] );
+  }
+}
+
+static KadasLatLonToUTM::UTMCoo utmCoo( const Positions &positions, int i )
+{
+  KadasLatLonToUTM::UTMCoo coo;
+  coo.easting = positions.easting[i];
+  coo.northing = positions.northing[i];
+  coo.zoneNumber = positions.zoneNumbers[i];
+  coo.zoneLetter = QString( QChar( positions.zoneLetters[i] ) );
+  return coo;
+}
+
+// The batch conversions must return the same coordinates as the scalar conversions. The floating point
+// results may differ in the last bits where the compiler contracts the series differently, hence the tolerances.
+static QString checkBatchMatchesScalar()
+{
+  Positions positions;
+  createPositions( sCheckPoints, positions );
+  QVector<int> mgrsEasting( sCheckPoints );
+  QVector<int> mgrsNorthing( sCheckPoints );
+  QVector<char> letter100kIDs( 2 * sCheckPoints );
+  KadasLatLonToUTM::UTM2MGRS( positions.easting.constData(), positions.northing.constData(), positions.zoneNumbers.constData(), sCheckPoints, mgrsEasting.data(), mgrsNorthing.data(), letter100kIDs.data() );
+  QVector<double> lon( sCheckPoints );
+  QVector<double> lat( sCheckPoints );
+  KadasLatLonToUTM::UTM2LL( positions.easting.constData(), positions.northing.constData(), positions.zoneNumbers.constData(), positions.zoneLetters.constData(), sCheckPoints, lon.data(), lat.data() );
+
+  for ( int i = 0; i < sCheckPoints; ++i )
+  {
+    QgsPointXY pos( positions.lon[i], positions.lat[i] );
+    KadasLatLonToUTM::UTMCoo utm = KadasLatLonToUTM::LL2UTM( pos );
+    if ( utm.zoneNumber != positions.zoneNumbers[i] || utm.zoneLetter != QChar( positions.zoneLetters[i] ) || std::abs( utm.easting - positions.easting[i] ) > 1 || std::abs( utm.northing - positions.northing[i] ) > 1 )
+    {
+      return QString( "LL2UTM of %1 is %2 %3 %4%5, batch returned %6 %7 %8%9" ).arg( pos.toString( 6 ) ).arg( utm.easting ).arg( utm.northing ).arg( utm.zoneNumber ).arg( utm.zoneLetter ).arg( positions.easting[i], 0, 'f', 3 ).arg( positions.northing[i], 0, 'f', 3 ).arg( positions.zoneNumbers[i] ).arg( QChar( positions.zoneLetters[i] ) );
+    }
+
+    // From here on, the scalar conversions work on the same input as the batch conversions
+    utm = utmCoo( positions, i );
+    KadasLatLonToUTM::MGRSCoo mgrs = KadasLatLonToUTM::UTM2MGRS( utm );
+    QString letter100kID = letter100kIDs[2 * i] ? QString::fromLatin1( letter100kIDs.constData() + 2 * i, 2 ) : QString();
+    if ( mgrs.easting != mgrsEasting[i] || mgrs.northing != mgrsNorthing[i] || mgrs.letter100kID != letter100kID )
+    {
+      return QString( "UTM2MGRS of %1 %2 %3 is %4 %5 %6, batch returned %7 %8 %9" ).arg( utm.easting ).arg( utm.northing ).arg( utm.zoneNumber ).arg( mgrs.letter100kID ).arg( mgrs.easting ).arg( mgrs.northing ).arg( letter100kID ).arg( mgrsEasting[i] ).arg( mgrsNorthing[i] );
+    }
+
+    bool ok = false;
+    QgsPointXY ll = KadasLatLonToUTM::UTM2LL( utm, ok );
+    if ( !ok || std::fabs( ll.x() - lon[i] ) > 1E-9 || std::fabs( ll.y() - lat[i] ) > 1E-9 )
+    {
+      return QString( "UTM2LL of %1 %2 %3%4 is %5, batch returned %6 %7" ).arg( utm.easting ).arg( utm.northing ).arg( utm.zoneNumber ).arg( utm.zoneLetter ).arg( ll.toString( 6 ) ).arg( lon[i], 0, 'f', 6 ).arg( lat[i], 0, 'f', 6 );
+    }
+  }
+  return QString();
+}
+
+static QByteArray gridDigest( const KadasLatLonToUTM::Grid &grid )
+{
+  QByteArray data;
+  for ( const KadasLatLonToUTM::LineLevel &line : grid.lines )
+  {
+    data.append( static_cast<char>( line.level ) );
+    data.append( reinterpret_cast<const char *>( line.line.constData() ), line.line.size() * sizeof( QPointF ) );
+  }
+  for ( const KadasLatLonToUTM::GridLabel &label : grid.gridLabels )
+  {
+    data.append( QString( "%1 %2 %3" ).arg( label.label ).arg( label.lineIdx ).arg( label.horiz ).toUtf8() );
+  }
+  for ( const KadasLatLonToUTM::ZoneLabel &label : grid.zoneLabels )
+  {
+    data.append( label.label.toUtf8() );
+    data.append( reinterpret_cast<const char *>( &label.pos ), sizeof( QPointF ) );
+    data.append( reinterpret_cast<const char *>( &label.maxPos ), sizeof( QPointF ) );
+  }
+  return KadasBench::digest( data.constData(), data.size() );
+}
+
+void registerLatLonToUTMBenchmarks( KadasBench &bench, const QList<int> &sizes )
+{
+  bench.addCheck( "latlontoutm_batch_matches_scalar", checkBatchMatchesScalar );
+
+  for ( int size : sizes )
+  {
+    // size * size positions, shared by the benchmarks of this size and created by the first setup
+    const int count = size * size;
+    std::shared_ptr<Positions> positions = std::make_shared<Positions>();
+    auto setup = [positions, count] {
+      if ( positions->lon.isEmpty() )
+      {
+        createPositions( count, *positions );
+      }
+      return true;
+    };
+
+    bench.addBenchmark(
+      "latlontoutm_ll2utm_scalar", size, count, [=] {
+        QVector<int> utm( 3 * count );
+        for ( int i = 0; i < count; ++i )
+        {
+          KadasLatLonToUTM::UTMCoo coo = KadasLatLonToUTM::LL2UTM( QgsPointXY( positions->lon[i], positions->lat[i] ) );
+          utm[3 * i] = coo.easting;
+          utm[3 * i + 1] = coo.northing;
+          utm[3 * i + 2] = coo.zoneNumber;
+        }
+        return KadasBench::digest( utm.constData(), utm.size() * sizeof( int ) );
+      },
+      setup
+    );
+    bench.addBenchmark(
+      "latlontoutm_ll2utm_batch", size, count, [=] {
+        QVector<double> easting( count );
+        QVector<double> northing( count );
+        QVector<int> zoneNumbers( count );
+        KadasLatLonToUTM::LL2UTM( positions->lon.constData(), positions->lat.constData(), count, easting.data(), northing.data(), zoneNumbers.data() );
+        return KadasBench::digest( easting.constData(), count * sizeof( double ) ) + KadasBench::digest( northing.constData(), count * sizeof( double ) ) + KadasBench::digest( zoneNumbers.constData(), count * sizeof( int ) );
+      },
+      setup
+    );
+
+    bench.addBenchmark(
+      "latlontoutm_utm2mgrs_scalar", size, count, [=] {
+        QByteArray ids;
+        ids.reserve( 2 * count );
+        for ( int i = 0; i < count; ++i )
+        {
+          ids.append( KadasLatLonToUTM::UTM2MGRS( utmCoo( *positions, i ) ).letter100kID.toLatin1() );
+        }
+        return KadasBench::digest( ids.constData(), ids.size() );
+      },
+      setup
+    );
+    bench.addBenchmark(
+      "latlontoutm_utm2mgrs_batch", size, count, [=] {
+        QVector<int> mgrsEasting( count );
+        QVector<int> mgrsNorthing( count );
+        QVector<char> letter100kIDs( 2 * count );
+        KadasLatLonToUTM::UTM2MGRS( positions->easting.constData(), positions->northing.constData(), positions->zoneNumbers.constData(), count, mgrsEasting.data(), mgrsNorthing.data(), letter100kIDs.data() );
+        return KadasBench::digest( letter100kIDs.constData(), letter100kIDs.size() );
+      },
+      setup
+    );
+
+    bench.addBenchmark(
+      "latlontoutm_utm2ll_scalar", size, count, [=] {
+        QVector<double> ll( 2 * count );
+        bool ok = false;
+        for ( int i = 0; i < count; ++i )
+        {
+          QgsPointXY pos = KadasLatLonToUTM::UTM2LL( utmCoo( *positions, i ), ok );
+          ll[2 * i] = pos.x();
+          ll[2 * i + 1] = pos.y();
+        }
+        return KadasBench::digest( ll.constData(), ll.size() * sizeof( double ) );
+      },
+      setup
+    );
+    bench.addBenchmark(
+      "latlontoutm_utm2ll_batch", size, count, [=] {
+        QVector<double> lon( count );
+        QVector<double> lat( count );
+        KadasLatLonToUTM::UTM2LL( positions->easting.constData(), positions->northing.constData(), positions->zoneNumbers.constData(), positions->zoneLetters.constData(), count, lon.data(), lat.data() );
+        return KadasBench::digest( lon.constData(), count * sizeof( double ) ) + KadasBench::digest( lat.constData(), count * sizeof( double ) );
+      },
+      setup
+    );
+  }
+
+  // The map grid, which converts the grid line vertices in batches, over Switzerland at the scales of the 1 km and 5 km grids
+  const QgsRectangle gridExtent( 5.5, 45.5, 10.5, 48 );
+  for ( int scale : { 25000, 250000 } )
+  {
+    for ( KadasLatLonToUTM::GridMode mode : { KadasLatLonToUTM::GridMode::GridUTM, KadasLatLonToUTM::GridMode::GridMGRS } )
+    {
+      bench.addBenchmark( mode == KadasLatLonToUTM::GridMode::GridUTM ? "latlontoutm_grid_utm" : "latlontoutm_grid_mgrs", scale, 1, [=] {
+        return gridDigest( KadasLatLonToUTM::computeGrid( gridExtent, scale, mode, 0 ) );
+      } );
+    }
+  }
+}
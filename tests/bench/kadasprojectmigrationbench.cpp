@@ -0,0 +1,326 @@
+/***************************************************************************
+    kadasprojectmigrationbench.cpp
+    ------------------------------
+    copyright            : (C) 2026 by Sandro Mani
+    email                : smani at sourcepole dot ch
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
+#include <memory>
+
+#include "kadas/gui/kadasprojectmigration.h"
+#include "tests/bench/kadasbench.h"
+
+// Redlining items of the projects of the parity check
+static constexpr int sCheckItems = 20;
+
+enum class HeaderLayout
+{
+  BeforeItems,
+  // Layer name, globe and srs following the items, which the DOM based migration still writes first
+  AfterItems
+};
+
+static void writeSrs( QXmlStreamWriter &writer )
+{
+  writer.writeStartElement( "srs" );
+  writer.writeStartElement( "spatialrefsys" );
+  writer.writeTextElement( "authid", "EPSG:3857" );
+  writer.writeEndElement();
+  writer.writeEndElement();
+}
+
+static void writeRedliningLayer( QXmlStreamWriter &writer, const QString &id, const QString &name, int itemCount, HeaderLayout layout )
+{
+  auto writeHeader = [&] {
+    writer.writeTextElement( "layername", name );
+    writeSrs( writer );
+    writer.writeStartElement( "globe" );
+    writer.writeAttribute( "enabled", "1" );
+    writer.writeEndElement();
+  };
+  writer.writeStartElement( "maplayer" );
+  writer.writeAttribute( "type", "redlining" );
+  writer.writeTextElement( "id", id );
+  writer.writeTextElement( "datasource", "redlining" );
+  if ( layout == HeaderLayout::BeforeItems )
+  {
+    writeHeader();
+  }
+  for ( int i = 0; i < itemCount; ++i )
+  {
+    double x = 828000 + 100 * i;
+    double y = 5934000 + 50 * ( i % 7 );
+    writer.writeStartElement( "RedliningItem" );
+    writer.writeAttribute( "outline", "255,0,0,255" );
+    writer.writeAttribute( "fill", "0,0,255,128" );
+    writer.writeAttribute( "outline_style", "solid" );
+    writer.writeAttribute( "fill_style", "solid" );
+    switch ( i % 4 )
+    {
+      case 0:
+        writer.writeAttribute( "flags", "shape=point,symbol=circle,w=2" );
+        writer.writeAttribute( "geometry", QString( "Point (%1 %2)" ).arg( x ).arg( y ) );
+        writer.writeAttribute( "text", QString( "Point %1" ).arg( i ) );
+        break;
+      case 1:
+        writer.writeAttribute( "flags", "shape=line,w=3,routeNumber=7" );
+        writer.writeAttribute( "geometry", QString( "LineString (%1 %2, %3 %4, %5 %6)" ).arg( x ).arg( y ).arg( x + 40 ).arg( y + 60 ).arg( x + 90 ).arg( y + 20 ) );
+        writer.writeAttribute( "text", QString( "Route %1" ).arg( i ) );
+        break;
+      case 2:
+        writer.writeAttribute( "flags", "shape=polygon,w=1" );
+        writer.writeAttribute( "geometry", QString( "Polygon ((%1 %2, %3 %2, %3 %4, %1 %2))" ).arg( x ).arg( y ).arg( x + 80 ).arg( y + 80 ) );
+        break;
+      case 3:
+        writer.writeAttribute( "flags", "shape=point,family=Arial,fontSize=12,bold=1,italic=0,rotation=15" );
+        writer.writeAttribute( "geometry", QString( "Point (%1 %2)" ).arg( x ).arg( y ) );
+        writer.writeAttribute( "text", QString( "Label %1" ).arg( i ) );
+        break;
+    }
+    writer.writeEndElement();
+  }
+  if ( layout == HeaderLayout::AfterItems )
+  {
+    writeHeader();
+  }
+  writer.writeEndElement();
+}
+
+// A KADAS 1.x project with a raster layer attached from the project dir, a redlining layer,
+// a GPS routes layer and an annotation layer with pins
+static QByteArray createLegacyProject( int itemCount, HeaderLayout layout )
+{
+  QByteArray data;
+  QXmlStreamWriter writer( &data );
+  writer.setAutoFormatting( true );
+  writer.writeStartDocument();
+  writer.writeStartElement( "qgis" );
+  writer.writeAttribute( "version", "2.15.2-KADAS" );
+  writer.writeAttribute( "projectname", "" );
+  writer.writeTextElement( "title", "Migration" );
+  writer.writeStartElement( "projectlayers" );
+
+  writer.writeStartElement( "maplayer" );
+  writer.writeAttribute( "type", "raster" );
+  writer.writeTextElement( "id", "raster_1" );
+  writer.writeTextElement( "datasource", "data/dem.tif" );
+  writer.writeTextElement( "layername", "DEM" );
+  writeSrs( writer );
+  writer.writeEndElement();
+
+  writeRedliningLayer( writer, "redlining_1", "Redlining", itemCount, layout );
+  writeRedliningLayer( writer, "gps_1", "GPS Routes", itemCount / 2, layout );
+
+  writer.writeStartElement( "maplayer" );
+  writer.writeAttribute( "type", "vector" );
+  writer.writeTextElement( "id", "annotations_1" );
+  writer.writeTextElement( "datasource", "memory" );
+  writer.writeTextElement( "layername", "Pins" );
+  writeSrs( writer );
+  writer.writeEndElement();
+
+  writer.writeEndElement(); // projectlayers
+
+  writer.writeStartElement( "Redlining" );
+  writer.writeAttribute( "layerid", "redlining_1" );
+  writer.writeEndElement();
+  writer.writeStartElement( "GpsRoutes" );
+  writer.writeAttribute( "layerid", "gps_1" );
+  writer.writeEndElement();
+
+  writer.writeStartElement( "Annotations" );
+  for ( int i = 0; i < 3; ++i )
+  {
+    writer.writeStartElement( "PinAnnotationItem" );
+    writer.writeAttribute( "pinName", QString( "Pin %1" ).arg( i ) );
+    writer.writeStartElement( "AnnotationItem" );
+    writer.writeAttribute( "layerId", "annotations_1" );
+    writer.writeAttribute( "mapGeoPosAuthID", "EPSG:4326" );
+    writer.writeAttribute( "geoPosX", QString::number( 7.4 + 0.1 * i ) );
+    writer.writeAttribute( "geoPosY", QString::number( 46.9 + 0.1 * i ) );
+    writer.writeEndElement();
+    writer.writeTextElement( "PinRemarks", QString( "Remarks %1" ).arg( i ) );
+    writer.writeEndElement();
+  }
+  writer.writeEndElement(); // Annotations
+
+  writer.writeEndElement(); // qgis
+  writer.writeEndDocument();
+  return data;
+}
+
+// Element tree with sorted attributes, without whitespace and empty text nodes
+static QString canonicalXml( const QDomNode &node )
+{
+  if ( node.isElement() )
+  {
+    QDomElement el = node.toElement();
+    QStringList attributes;
+    QDomNamedNodeMap attributeMap = el.attributes();
+    for ( int i = 0, n = attributeMap.size(); i < n; ++i )
+    {
+      QDomAttr attr = attributeMap.item( i ).toAttr();
+      attributes.append( QString( "%1=\"%2\"" ).arg( attr.name(), attr.value() ) );
+    }
+    attributes.sort();
+    QString xml = QString( "<%1 %2>" ).arg( el.tagName(), attributes.join( ' ' ) );
+    for ( QDomNode child = el.firstChild(); !child.isNull(); child = child.nextSibling() )
+    {
+      xml += canonicalXml( child );
+    }
+    return xml + QString( "</%1>\n" ).arg( el.tagName() );
+  }
+  else if ( node.isCDATASection() )
+  {
+    return QString( "<![CDATA[%1]]>" ).arg( node.nodeValue() );
+  }
+  else if ( node.isText() )
+  {
+    return node.nodeValue().trimmed();
+  }
+  return QString();
+}
+
+static bool writeFile( const QString &path, const QByteArray &data )
+{
+  QFile file( path );
+  return file.open( QIODevice::WriteOnly ) && file.write( data ) == data.size();
+}
+
+// Migrates the project with the streaming migration, returns the migrated project
+static QString migrateStreaming( const QString &projectFile, QStringList &filesToAttach )
+{
+  QString migratedFile = KadasProjectMigration::migrateProject( projectFile, filesToAttach );
+  if ( migratedFile == projectFile )
+  {
+    return QString();
+  }
+  QFile file( migratedFile );
+  QDomDocument doc;
+  bool ok = file.open( QIODevice::ReadOnly ) && doc.setContent( &file );
+  file.remove();
+  return ok ? canonicalXml( doc.documentElement() ) : QString();
+}
+
+// Migrates the project with the DOM based migration, returns the migrated project
+static QString migrateDom( const QString &projectFile, QStringList &filesToAttach )
+{
+  QFile file( projectFile );
+  QDomDocument doc;
+  if ( !file.open( QIODevice::ReadOnly ) || !doc.setContent( &file ) || !KadasProjectMigration::migrateProjectXml( QFileInfo( projectFile ).path(), doc, filesToAttach ) )
+  {
+    return QString();
+  }
+  return canonicalXml( doc.documentElement() );
+}
+
+// Writes the project and the files it references to dir, returns the project file
+static QString createProjectDir( const QTemporaryDir &dir, const QString &name, const QByteArray &project )
+{
+  QDir( dir.path() ).mkpath( "data" );
+  QString projectFile = QDir( dir.path() ).absoluteFilePath( name );
+  if ( !writeFile( QDir( dir.path() ).absoluteFilePath( "data/dem.tif" ), "dem" ) || !writeFile( projectFile, project ) )
+  {
+    return QString();
+  }
+  return projectFile;
+}
+
+// Digest of a migrated project, independent of the temporary directory holding it
+static QByteArray projectDigest( const QString &project, const QTemporaryDir &dir )
+{
+  if ( project.isEmpty() )
+  {
+    return QByteArray();
+  }
+  QByteArray data = QString( project ).replace( dir.path(), "$DIR" ).toUtf8();
+  return KadasBench::digest( data.constData(), data.size() );
+}
+
+// Both migrations must produce the same project and attach the same files
+static QString checkStreamingMatchesDom()
+{
+  QTemporaryDir dir;
+  for ( HeaderLayout layout : { HeaderLayout::BeforeItems, HeaderLayout::AfterItems } )
+  {
+    const QString layoutName = layout == HeaderLayout::BeforeItems ? "header before items" : "header after items";
+    QString projectFile = createProjectDir( dir, "project.qgs", createLegacyProject( sCheckItems, layout ) );
+    if ( projectFile.isEmpty() )
+    {
+      return QString( "failed to write the project" );
+    }
+    QStringList streamingFiles;
+    QString streaming = migrateStreaming( projectFile, streamingFiles );
+    QStringList domFiles;
+    QString dom = migrateDom( projectFile, domFiles );
+    if ( streaming.isEmpty() || dom.isEmpty() )
+    {
+      return QString( "%1: migration failed" ).arg( layoutName );
+    }
+    if ( streaming != dom )
+    {
+      QStringList streamingLines = streaming.split( '\n' );
+      QStringList domLines = dom.split( '\n' );
+      int line = std::mismatch( streamingLines.begin(), streamingLines.end(), domLines.begin(), domLines.end() ).first - streamingLines.begin();
+      return QString( "%1: migrated projects differ at line %2: %3 != %4" ).arg( layoutName ).arg( line ).arg( streamingLines.value( line ), domLines.value( line ) );
+    }
+    streamingFiles.sort();
+    domFiles.sort();
+    if ( streamingFiles != domFiles )
+    {
+      return QString( "%1: attached files differ: %2 != %3" ).arg( layoutName, streamingFiles.join( ", " ), domFiles.join( ", " ) );
+    }
+  }
+  return QString();
+}
+
+void registerProjectMigrationBenchmarks( KadasBench &bench, const QList<int> &sizes )
+{
+  bench.addCheck( "projectmigration_streaming_matches_dom", checkStreamingMatchesDom );
+
+  for ( int size : sizes )
+  {
+    // A redlining layer with size * 4 items and a GPS routes layer with half as many, written by the first setup
+    const int itemCount = 4 * size;
+    std::shared_ptr<QTemporaryDir> dir = std::make_shared<QTemporaryDir>();
+    std::shared_ptr<QString> projectFile = std::make_shared<QString>();
+    auto setup = [dir, projectFile, itemCount] {
+      if ( projectFile->isEmpty() )
+      {
+        *projectFile = createProjectDir( *dir, "project.qgs", createLegacyProject( itemCount, HeaderLayout::BeforeItems ) );
+      }
+      return !projectFile->isEmpty();
+    };
+
+    bench.addBenchmark(
+      "projectmigration_streaming", size, itemCount, [=] {
+        QStringList filesToAttach;
+        return projectDigest( migrateStreaming( *projectFile, filesToAttach ), *dir );
+      },
+      setup
+    );
+    bench.addBenchmark(
+      "projectmigration_dom", size, itemCount, [=] {
+        QStringList filesToAttach;
+        return projectDigest( migrateDom( *projectFile, filesToAttach ), *dir );
+      },
+      setup
+    );
+  }
+}